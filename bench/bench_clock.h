@@ -0,0 +1,20 @@
+/*
+ *  Monotonic nanosecond clock shared by the host benchmarks, finer than
+ *  dispatcher_PortTimeUs for per post latencies.
+ */
+
+#ifndef __BENCH_CLOCK_H__
+#define __BENCH_CLOCK_H__
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t BenchNow(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+#endif //__BENCH_CLOCK_H__
@@ -0,0 +1,652 @@
+/*
+ *  Host benchmark for dispatcher_Post -> dispatcher_EventLoop -> state handler.
+ *
+ *  Every run drives one dispatcher from N producer threads, the main thread
+ *  runs the event loop. Latency is measured from just before dispatcher_Post
+ *  to the entry of the state handler, using a per producer timestamp table
+ *  (the producer id travels in the event signal and every producer is fifo)
+ *  so even bare dispatcher_eventBase_t events can be measured.
+ *
+ *  With zero producers the event loop thread itself posts a burst of
+ *  queue depth events and then drains it, which isolates the cpu cost of
+ *  post + dispatch from thread wake ups.
+ *
+ *  Every run also verifies delivery : events at least 8 bytes large carry a
+ *  per producer sequence number which must arrive in order, and a sentinel
+ *  posted after the last producer finished must find every event delivered.
+ *  With more than one producer, odd producers post through
+ *  dispatcher_PostFromIsr. Any loss or reordering fails the run.
+ *
+ *  With -z, ring backend runs build events in place with
+ *  dispatcher_PostReserve / dispatcher_PostCommit and the event loop runs
+ *  without an event storage buffer. With -b the event loop drains up to N
+ *  queued events per dispatcher_EventLoopBatch call, with -B producers post
+ *  N events per dispatcher_PostBatch (or dispatcher_PostBatchFromIsr) call.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "bench_clock.h"
+
+#define BENCH_MAX_PRODUCERS (64)
+#define BENCH_HISTOGRAM_BUCKETS (40)
+#define BENCH_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + BENCH_MAX_PRODUCERS)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq; /* per producer sequence number. */
+} benchEvent_t;
+
+typedef struct
+{
+    uint32_t eventSize;       /* bytes per event, >= sizeof(dispatcher_eventBase_t). */
+    uint32_t queueDepth;      /* queue item count. */
+    uint32_t producers;       /* number of producer threads, 0 posts inline. */
+    uint32_t transitionEvery; /* transition after every N user events, 0 disables. */
+    uint32_t events;          /* total events per run. */
+    dispatcher_queueType_t queueType;
+    bool zeroCopy;            /* post through reserve / commit. */
+    uint32_t batch;           /* max events per event loop call. */
+    uint32_t postBatch;       /* events per post call. */
+} benchConfig_t;
+
+static char const *const gQueueNames[DISPATCHER_QUEUE_TYPE_MAX] = {
+    [DISPATCHER_QUEUE_TYPE_DEFAULT] = "default",
+    [DISPATCHER_QUEUE_TYPE_SPSC] = "spsc",
+    [DISPATCHER_QUEUE_TYPE_MPSC] = "mpsc",
+    [DISPATCHER_QUEUE_TYPE_VARIABLE] = "var",
+};
+
+typedef struct
+{
+    double eventsPerSec;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+    uint64_t transitions;
+    uint32_t lost;
+    uint32_t reordered;
+    uint64_t histogram[BENCH_HISTOGRAM_BUCKETS];
+} benchResult_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    benchConfig_t const *pConfig;
+    uint64_t *stamps[BENCH_MAX_PRODUCERS]; /* post timestamps per producer. */
+    uint32_t seq[BENCH_MAX_PRODUCERS];     /* next sequence expected per producer. */
+    uint32_t *latencies;
+    uint32_t received;
+    uint32_t reordered;
+    uint32_t finished; /* producers done posting. */
+    bool done;         /* sentinel received. */
+    uint32_t sinceTransition;
+    uint64_t transitions;
+} benchDispatcher_t;
+
+typedef struct
+{
+    benchDispatcher_t *pDispatcher;
+    uint32_t id;
+    uint32_t count;
+} benchProducer_t;
+
+static uint8_t BenchStateA(benchDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+static uint8_t BenchStateB(benchDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+static uint8_t BenchUserEvent(benchDispatcher_t *const pDispatcher,
+                              dispatcher_eventBase_t const *const pEvent,
+                              dispatcher_stateHandler_t other)
+{
+    uint64_t now = BenchNow();
+    uint32_t id = (uint32_t)(DISPATCHER_GET_SIGNAL(pEvent) - DISPATCHER_SIGNAL_USER);
+
+    if (DISPATCHER_GET_SIGNAL(pEvent) == BENCH_SIGNAL_DONE)
+    {
+        pDispatcher->done = true;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+
+    if (pDispatcher->pConfig->eventSize >= sizeof(benchEvent_t) &&
+        ((benchEvent_t const *)pEvent)->seq != pDispatcher->seq[id])
+    {
+        pDispatcher->reordered++;
+    }
+
+    uint64_t stamp = pDispatcher->stamps[id][pDispatcher->seq[id]++];
+
+    pDispatcher->latencies[pDispatcher->received++] = (uint32_t)(now - stamp);
+
+    if (pDispatcher->pConfig->transitionEvery != 0 &&
+        ++pDispatcher->sinceTransition == pDispatcher->pConfig->transitionEvery)
+    {
+        pDispatcher->sinceTransition = 0;
+        return DISPATCHER_TRANSITION(pDispatcher, other);
+    }
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+static uint8_t BenchStateA(benchDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (DISPATCHER_GET_SIGNAL(pEvent))
+    {
+    case DISPATCHER_SIGNAL_ENTRY:
+        pDispatcher->transitions++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case DISPATCHER_SIGNAL_EXIT:
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return BenchUserEvent(pDispatcher, pEvent, (dispatcher_stateHandler_t)BenchStateB);
+    }
+}
+
+static uint8_t BenchStateB(benchDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (DISPATCHER_GET_SIGNAL(pEvent))
+    {
+    case DISPATCHER_SIGNAL_ENTRY:
+        pDispatcher->transitions++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case DISPATCHER_SIGNAL_EXIT:
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return BenchUserEvent(pDispatcher, pEvent, (dispatcher_stateHandler_t)BenchStateA);
+    }
+}
+
+static void BenchStampSequence(benchDispatcher_t *const pDispatcher, uint8_t *pEvent, uint32_t seq)
+{
+    if (pDispatcher->pConfig->eventSize >= sizeof(benchEvent_t))
+    {
+        ((benchEvent_t *)(void *)pEvent)->seq = seq;
+    }
+}
+
+/*
+ *  Build the event straight in the queue slot, only the fields the
+ *  handler reads are written.
+ */
+static void BenchPostInPlace(benchDispatcher_t *const pDispatcher, uint32_t id, uint32_t seq)
+{
+    uint8_t *pSlot = NULL;
+
+    while (DISPATCHER_POST_RESERVE(pDispatcher, &pSlot) != DISPATCHER_ERR_CLEAR)
+    {
+        /* queue stayed full for the whole post timeout, retry. */
+    }
+    DISPATCHER_SET_EVENT(pSlot, DISPATCHER_SIGNAL_USER + id);
+    BenchStampSequence(pDispatcher, pSlot, seq);
+    (void)DISPATCHER_POST_COMMIT(pDispatcher, pSlot);
+}
+
+/*
+ *  Post count events of one producer, starting at sequence first, with
+ *  batch posts. Whatever did not fit is posted again.
+ */
+static void BenchPostGroup(benchDispatcher_t *const pDispatcher,
+                           uint8_t *pEvents,
+                           uint32_t id,
+                           uint32_t first,
+                           uint32_t count,
+                           bool fromIsr)
+{
+    uint32_t size = pDispatcher->pConfig->eventSize;
+    uint32_t attempt = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        DISPATCHER_SET_EVENT(&pEvents[i * size], DISPATCHER_SIGNAL_USER + id);
+        BenchStampSequence(pDispatcher, &pEvents[i * size], first + i);
+        pDispatcher->stamps[id][first + i] = BenchNow();
+    }
+
+    for (uint32_t posted = 0; posted < count;)
+    {
+        uint16_t accepted = 0;
+
+        if (fromIsr)
+        {
+            (void)DISPATCHER_POST_BATCH_FROM_ISR(pDispatcher, &pEvents[posted * size], count - posted, &accepted, false);
+            if (accepted == 0)
+            {
+                dispatcher_PortBackoff(attempt++);
+            }
+        }
+        else
+        {
+            (void)DISPATCHER_POST_BATCH(pDispatcher, &pEvents[posted * size], count - posted, &accepted);
+        }
+        posted += accepted;
+    }
+}
+
+static void BenchPostDone(benchDispatcher_t *const pDispatcher)
+{
+    uint8_t *pEvent = calloc(1, pDispatcher->pConfig->eventSize);
+
+    DISPATCHER_SET_EVENT(pEvent, BENCH_SIGNAL_DONE);
+    while (DISPATCHER_POST_EVENT(pDispatcher, pEvent) != DISPATCHER_ERR_CLEAR)
+    {
+    }
+    free(pEvent);
+}
+
+static void *BenchProducer(void *pArg)
+{
+    benchProducer_t *pProducer = pArg;
+    benchDispatcher_t *pDispatcher = pProducer->pDispatcher;
+    uint32_t group = pDispatcher->pConfig->postBatch;
+    uint8_t *pEvent = calloc(group, pDispatcher->pConfig->eventSize);
+    bool fromIsr = (pDispatcher->pConfig->producers > 1u) && (pProducer->id & 1u);
+
+    DISPATCHER_SET_EVENT(pEvent, DISPATCHER_SIGNAL_USER + pProducer->id);
+    for (uint32_t i = 0; i < pProducer->count; i++)
+    {
+        if (group > 1u && !pDispatcher->pConfig->zeroCopy)
+        {
+            uint32_t count = (pProducer->count - i < group) ? (pProducer->count - i) : group;
+
+            BenchPostGroup(pDispatcher, pEvent, pProducer->id, i, count, fromIsr);
+            i += count - 1u;
+            continue;
+        }
+
+        BenchStampSequence(pDispatcher, pEvent, i);
+        pDispatcher->stamps[pProducer->id][i] = BenchNow();
+        if (fromIsr)
+        {
+            uint32_t attempt = 0;
+
+            while (DISPATCHER_POST_EVENT_FROM_ISR(pDispatcher, pEvent, false) != DISPATCHER_ERR_CLEAR)
+            {
+                /* an ISR can not wait, retry until the consumer made room. */
+                dispatcher_PortBackoff(attempt++);
+            }
+        }
+        else if (pDispatcher->pConfig->zeroCopy)
+        {
+            BenchPostInPlace(pDispatcher, pProducer->id, i);
+        }
+        else
+        {
+            while (DISPATCHER_POST_EVENT(pDispatcher, pEvent) != DISPATCHER_ERR_CLEAR)
+            {
+                /* queue stayed full for the whole post timeout, retry. */
+            }
+        }
+    }
+    free(pEvent);
+
+    /* every other producer published all its events before counting itself
+       finished, so the sentinel is queued behind all of them. */
+    if (__atomic_add_fetch(&pDispatcher->finished, 1u, __ATOMIC_ACQ_REL) == pDispatcher->pConfig->producers)
+    {
+        BenchPostDone(pDispatcher);
+    }
+    return NULL;
+}
+
+static void BenchInline(benchDispatcher_t *const pDispatcher, uint32_t total)
+{
+    uint32_t group = pDispatcher->pConfig->postBatch;
+    uint8_t *pEvent = calloc(group, pDispatcher->pConfig->eventSize);
+    uint32_t posted = 0;
+
+    DISPATCHER_SET_EVENT(pEvent, DISPATCHER_SIGNAL_USER);
+    while (posted < total)
+    {
+        uint32_t burst = pDispatcher->pConfig->queueDepth;
+
+        if (burst > total - posted)
+        {
+            burst = total - posted;
+        }
+        for (uint32_t i = 0; i < burst; i++)
+        {
+            if (group > 1u && !pDispatcher->pConfig->zeroCopy)
+            {
+                uint32_t count = (burst - i < group) ? (burst - i) : group;
+
+                BenchPostGroup(pDispatcher, pEvent, 0, posted, count, false);
+                posted += count;
+                i += count - 1u;
+                continue;
+            }
+            pDispatcher->stamps[0][posted] = BenchNow();
+            if (pDispatcher->pConfig->zeroCopy)
+            {
+                BenchPostInPlace(pDispatcher, 0, posted++);
+                continue;
+            }
+            BenchStampSequence(pDispatcher, pEvent, posted++);
+            (void)DISPATCHER_POST_EVENT(pDispatcher, pEvent);
+        }
+        for (uint32_t drained = 0; drained < burst;)
+        {
+            uint16_t processed = 0;
+
+            (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, pDispatcher->pConfig->batch, 0, &processed);
+            drained += processed;
+        }
+    }
+    free(pEvent);
+    BenchPostDone(pDispatcher);
+}
+
+static int BenchCompare(void const *pA, void const *pB)
+{
+    uint32_t a = *(uint32_t const *)pA;
+    uint32_t b = *(uint32_t const *)pB;
+
+    return (a > b) - (a < b);
+}
+
+static uint64_t BenchPercentile(uint32_t const *sorted, uint32_t count, double percentile)
+{
+    uint32_t index = (uint32_t)(percentile / 100.0 * (double)(count - 1) + 0.5);
+
+    return sorted[index];
+}
+
+static int BenchRun(benchConfig_t const *pConfig, benchResult_t *pResult)
+{
+    benchDispatcher_t *pDispatcher = aligned_alloc(DISPATCHER_PORT_CACHE_LINE_SIZE, sizeof(benchDispatcher_t));
+    size_t storageSize = DISPATCHER_QUEUE_STORAGE_SIZE(pConfig->queueType, pConfig->eventSize, pConfig->queueDepth);
+    uint8_t *queueStorage = aligned_alloc(DISPATCHER_PORT_CACHE_LINE_SIZE,
+                                          (storageSize + DISPATCHER_PORT_CACHE_LINE_SIZE - 1u) &
+                                              ~(size_t)(DISPATCHER_PORT_CACHE_LINE_SIZE - 1u));
+    uint8_t *eventStorage = pConfig->zeroCopy ? NULL : calloc(1, pConfig->eventSize);
+    benchProducer_t producers[BENCH_MAX_PRODUCERS];
+    pthread_t threads[BENCH_MAX_PRODUCERS];
+    uint32_t lanes = (pConfig->producers != 0) ? pConfig->producers : 1u;
+    uint32_t perProducer = pConfig->events / lanes;
+    uint32_t total = perProducer * lanes;
+
+    (void)memset(pDispatcher, 0, sizeof(benchDispatcher_t));
+    pDispatcher->pConfig = pConfig;
+    pDispatcher->latencies = calloc(total, sizeof(uint32_t));
+    for (uint32_t i = 0; i < lanes; i++)
+    {
+        pDispatcher->stamps[i] = calloc(perProducer, sizeof(uint64_t));
+    }
+
+    dispatcher_config_t config = {
+        .itemSize = (uint16_t)pConfig->eventSize,
+        .itemCount = (uint16_t)pConfig->queueDepth,
+        .queueStorage = queueStorage,
+        .eventStorage = eventStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)BenchStateA,
+        .queueType = pConfig->queueType,
+    };
+
+    if (dispatcher_InitWithConfig(&pDispatcher->base, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        return -1;
+    }
+    (void)DISPATCHER_START(pDispatcher, false);
+    pDispatcher->transitions = 0;
+
+    uint64_t start = BenchNow();
+    for (uint32_t i = 0; i < pConfig->producers; i++)
+    {
+        producers[i].pDispatcher = pDispatcher;
+        producers[i].id = i;
+        producers[i].count = perProducer;
+        (void)pthread_create(&threads[i], NULL, BenchProducer, &producers[i]);
+    }
+
+    if (pConfig->producers == 0)
+    {
+        BenchInline(pDispatcher, total);
+    }
+
+    while (!pDispatcher->done)
+    {
+        (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, pConfig->batch, 0, NULL);
+    }
+    uint64_t elapsed = BenchNow() - start;
+
+    for (uint32_t i = 0; i < pConfig->producers; i++)
+    {
+        (void)pthread_join(threads[i], NULL);
+    }
+
+    uint32_t received = pDispatcher->received;
+
+    (void)memset(pResult, 0, sizeof(benchResult_t));
+    for (uint32_t i = 0; i < received; i++)
+    {
+        uint32_t value = pDispatcher->latencies[i];
+        uint32_t bucket = 0;
+
+        while (value > 1u && bucket < BENCH_HISTOGRAM_BUCKETS - 1u)
+        {
+            value >>= 1;
+            bucket++;
+        }
+        pResult->histogram[bucket]++;
+    }
+
+    if (received != 0)
+    {
+        qsort(pDispatcher->latencies, received, sizeof(uint32_t), BenchCompare);
+        pResult->p50 = BenchPercentile(pDispatcher->latencies, received, 50.0);
+        pResult->p99 = BenchPercentile(pDispatcher->latencies, received, 99.0);
+        pResult->p999 = BenchPercentile(pDispatcher->latencies, received, 99.9);
+        pResult->max = pDispatcher->latencies[received - 1u];
+    }
+    pResult->eventsPerSec = (double)received * 1e9 / (double)elapsed;
+    pResult->transitions = pDispatcher->transitions;
+    pResult->lost = total - received;
+    pResult->reordered = pDispatcher->reordered;
+
+    for (uint32_t i = 0; i < lanes; i++)
+    {
+        free(pDispatcher->stamps[i]);
+    }
+    free(pDispatcher->latencies);
+    free(eventStorage);
+    free(queueStorage);
+    free(pDispatcher);
+    return 0;
+}
+
+static void BenchReport(benchConfig_t const *pConfig, benchResult_t const *pResult)
+{
+    printf("{\"bench\":\"post_dispatch\",\"queue\":\"%s\",\"zero_copy\":%s,\"batch\":%u,\"post_batch\":%u,\"event_size\":%u,\"queue_depth\":%u,\"producers\":%u,"
+           "\"transition_every\":%u,\"events\":%u,\"events_per_sec\":%.0f,"
+           "\"latency_ns\":{\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu},"
+           "\"transitions\":%llu,\"lost\":%u,\"reordered\":%u,\"histogram_log2_ns\":[",
+           gQueueNames[pConfig->queueType], pConfig->zeroCopy ? "true" : "false", pConfig->batch, pConfig->postBatch,
+           pConfig->eventSize, pConfig->queueDepth, pConfig->producers, pConfig->transitionEvery, pConfig->events, pResult->eventsPerSec,
+           (unsigned long long)pResult->p50, (unsigned long long)pResult->p99,
+           (unsigned long long)pResult->p999, (unsigned long long)pResult->max,
+           (unsigned long long)pResult->transitions, pResult->lost, pResult->reordered);
+    for (uint32_t i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++)
+    {
+        printf("%s%llu", i ? "," : "", (unsigned long long)pResult->histogram[i]);
+    }
+    printf("]}\n");
+    fflush(stdout);
+
+    fprintf(stderr, "%-8s%s batch=%-3u post=%-3u size=%-4u depth=%-5u producers=%-2u transition=%-4u %12.0f ev/s  p50=%llu p99=%llu p99.9=%llu ns\n",
+            gQueueNames[pConfig->queueType], pConfig->zeroCopy ? "+zc" : "   ", pConfig->batch, pConfig->postBatch,
+            pConfig->eventSize,
+            pConfig->queueDepth, pConfig->producers, pConfig->transitionEvery, pResult->eventsPerSec, (unsigned long long)pResult->p50,
+            (unsigned long long)pResult->p99, (unsigned long long)pResult->p999);
+}
+
+static int BenchRunAndReport(benchConfig_t const *pConfig)
+{
+    benchResult_t result;
+
+    if (BenchRun(pConfig, &result) != 0)
+    {
+        fprintf(stderr, "dispatcher initialization failed\n");
+        return -1;
+    }
+    BenchReport(pConfig, &result);
+
+    if (result.lost != 0 || result.reordered != 0)
+    {
+        fprintf(stderr, "delivery check failed : lost=%u reordered=%u\n", result.lost, result.reordered);
+        return -1;
+    }
+    return 0;
+}
+
+static void BenchUsage(char const *pName)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -s bytes   event size (default sweep 2,16,64,256)\n"
+            "  -d count   queue depth (default sweep 16,256)\n"
+            "  -p count   producer threads, 0 posts inline (default sweep 0,1,4)\n"
+            "  -t count   transition every N events, 0 disables (default sweep 0,16)\n"
+            "  -n count   events per run (default 200000)\n"
+            "  -q name    queue backend default|spsc|mpsc|var (default sweep all)\n"
+            "             spsc runs are skipped for more than one producer\n"
+            "  -b count   max events per event loop call (default 1)\n"
+            "  -B count   events per post call (default 1)\n"
+            "  -z         post in place with reserve / commit (ring backends only)\n"
+            "any option given pins that dimension of the sweep.\n",
+            pName);
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultSizes[] = {sizeof(dispatcher_eventBase_t), 16, 64, 256};
+    static uint32_t const defaultDepths[] = {16, 256};
+    static uint32_t const defaultProducers[] = {0, 1, 4};
+    static uint32_t const defaultTransitions[] = {0, 16};
+    static uint32_t const defaultQueues[] = {DISPATCHER_QUEUE_TYPE_DEFAULT,
+                                             DISPATCHER_QUEUE_TYPE_SPSC,
+                                             DISPATCHER_QUEUE_TYPE_MPSC,
+                                             DISPATCHER_QUEUE_TYPE_VARIABLE};
+
+    uint32_t const *sizes = defaultSizes, *depths = defaultDepths;
+    uint32_t const *producers = defaultProducers, *transitions = defaultTransitions;
+    uint32_t const *queues = defaultQueues;
+    uint32_t sizeCount = 4, depthCount = 2, producerCount = 3, transitionCount = 2, queueCount = 4;
+    uint32_t size = 0, depth = 0, producer = 0, transition = 0, queue = 0;
+    uint32_t events = 200000;
+    bool zeroCopy = false;
+    uint32_t batch = 1;
+    uint32_t postBatch = 1;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:d:p:t:n:q:b:B:zh")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            size = (uint32_t)strtoul(optarg, NULL, 0);
+            sizes = &size;
+            sizeCount = 1;
+            break;
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            depths = &depth;
+            depthCount = 1;
+            break;
+        case 'p':
+            producer = (uint32_t)strtoul(optarg, NULL, 0);
+            producers = &producer;
+            producerCount = 1;
+            break;
+        case 't':
+            transition = (uint32_t)strtoul(optarg, NULL, 0);
+            transitions = &transition;
+            transitionCount = 1;
+            break;
+        case 'b':
+            batch = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'B':
+            postBatch = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'z':
+            zeroCopy = true;
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            while (queue < DISPATCHER_QUEUE_TYPE_MAX && strcmp(optarg, gQueueNames[queue]) != 0)
+            {
+                queue++;
+            }
+            if (queue == DISPATCHER_QUEUE_TYPE_MAX)
+            {
+                BenchUsage(argv[0]);
+                return 1;
+            }
+            queues = &queue;
+            queueCount = 1;
+            break;
+        default:
+            BenchUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (size != 0 && size < sizeof(dispatcher_eventBase_t))
+    {
+        size = sizeof(dispatcher_eventBase_t);
+    }
+    if ((producers == &producer && producer > BENCH_MAX_PRODUCERS) ||
+        (depths == &depth && depth == 0) || events == 0 ||
+        batch == 0 || batch > UINT16_MAX || postBatch == 0 || postBatch > UINT16_MAX)
+    {
+        BenchUsage(argv[0]);
+        return 1;
+    }
+
+    for (uint32_t q = 0; q < queueCount; q++)
+    {
+        for (uint32_t s = 0; s < sizeCount; s++)
+        {
+            for (uint32_t d = 0; d < depthCount; d++)
+            {
+                for (uint32_t p = 0; p < producerCount; p++)
+                {
+                    for (uint32_t t = 0; t < transitionCount; t++)
+                    {
+                        benchConfig_t config = {
+                            .eventSize = sizes[s],
+                            .queueDepth = depths[d],
+                            .producers = producers[p],
+                            .transitionEvery = transitions[t],
+                            .events = events,
+                            .queueType = (dispatcher_queueType_t)queues[q],
+                            .zeroCopy = zeroCopy,
+                            .batch = batch,
+                            .postBatch = postBatch,
+                        };
+
+                        if ((config.queueType == DISPATCHER_QUEUE_TYPE_SPSC && config.producers > 1) ||
+                            (config.zeroCopy && config.queueType == DISPATCHER_QUEUE_TYPE_DEFAULT))
+                        {
+                            continue;
+                        }
+                        if (BenchRunAndReport(&config) != 0)
+                        {
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ *  Host coalescing benchmark : a bursty producer posts bursts of events on
+ *  a set of signals faster than the event loop handles them. Every signal
+ *  is queued as usual (none), keeps only its newest event (latest) or
+ *  merges its events into the pending one (merge).
+ *
+ *  After every burst the producer waits for the event loop to catch up. A
+ *  run checks that no event is reordered, that latest delivers the newest
+ *  value of every signal and that merge delivers the count of every
+ *  accepted post. Uncoalesced runs drop the posts of a full queue, the
+ *  coalesced ones need one queue slot per signal only.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include "bench_clock.h"
+
+#define COALESCE_MAX_SIGNALS (32)
+#define COALESCE_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define COALESCE_SIGNAL_SYNC (COALESCE_SIGNAL_DATA + COALESCE_MAX_SIGNALS)
+#define COALESCE_SIGNAL_DONE (COALESCE_SIGNAL_SYNC + 1)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;   /* sequence number of the newest post of the signal. */
+    uint32_t count; /* posts folded into the event. */
+} coalesceEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t workNs;
+    uint32_t signals;
+    uint32_t const *pPosted;              /* newest posted sequence number per signal. */
+    uint32_t last[COALESCE_MAX_SIGNALS];  /* newest delivered sequence number per signal. */
+    uint32_t count[COALESCE_MAX_SIGNALS]; /* posts delivered per signal. */
+    uint64_t staleness;                   /* posts behind the newest one, summed. */
+    uint32_t handled;
+    uint32_t reordered;
+    uint32_t synced;
+    bool stop;
+} coalesceDispatcher_t;
+
+static char const *const gPolicyNames[DISPATCHER_COALESCE_MAX] = {
+    [DISPATCHER_COALESCE_NONE] = "none",
+    [DISPATCHER_COALESCE_LATEST] = "latest",
+    [DISPATCHER_COALESCE_MERGE] = "merge",
+};
+
+static void CoalesceMerge(coalesceEvent_t *const pPending, coalesceEvent_t const *const pEvent)
+{
+    pPending->seq = (pEvent->seq > pPending->seq) ? pEvent->seq : pPending->seq;
+    pPending->count += pEvent->count;
+}
+
+static uint8_t CoalesceHandler(coalesceDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    if (pEvent->sig >= COALESCE_SIGNAL_DATA && pEvent->sig < COALESCE_SIGNAL_DATA + pDispatcher->signals)
+    {
+        coalesceEvent_t const *pData = (coalesceEvent_t const *)pEvent;
+        uint32_t signal = pEvent->sig - COALESCE_SIGNAL_DATA;
+
+        if (pData->seq <= pDispatcher->last[signal])
+        {
+            pDispatcher->reordered++;
+        }
+        pDispatcher->last[signal] = pData->seq;
+        pDispatcher->count[signal] += pData->count;
+        pDispatcher->staleness += __atomic_load_n(&pDispatcher->pPosted[signal], __ATOMIC_RELAXED) - pData->seq;
+        pDispatcher->handled++;
+
+        uint64_t until = BenchNow() + pDispatcher->workNs;
+
+        while (BenchNow() < until)
+        {
+        }
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+
+    switch (pEvent->sig)
+    {
+    case COALESCE_SIGNAL_SYNC:
+        __atomic_fetch_add(&pDispatcher->synced, 1u, __ATOMIC_RELEASE);
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case COALESCE_SIGNAL_DONE:
+        pDispatcher->stop = true;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static void *CoalesceLoop(void *pArg)
+{
+    coalesceDispatcher_t *pDispatcher = pArg;
+
+    while (!pDispatcher->stop)
+    {
+        (void)DISPATCHER_EVENT_LOOP(pDispatcher);
+    }
+    return NULL;
+}
+
+static void CoalescePostControl(coalesceDispatcher_t *const pDispatcher, dispatcher_eventSignal_t signal)
+{
+    coalesceEvent_t event = {0};
+
+    DISPATCHER_SET_EVENT(&event, signal);
+    while (DISPATCHER_POST_EVENT_FROM_ISR(pDispatcher, &event, false) != DISPATCHER_ERR_CLEAR)
+    {
+        (void)sched_yield();
+    }
+}
+
+static int CoalesceRun(dispatcher_coalescePolicy_t policy,
+                       uint32_t signals,
+                       uint32_t depth,
+                       uint32_t burst,
+                       uint32_t rounds,
+                       uint32_t workNs)
+{
+    static coalesceDispatcher_t gDispatcher;
+    static dispatcher_coalesce_t gCells[COALESCE_SIGNAL_SYNC];
+    static uint32_t gPosted[COALESCE_MAX_SIGNALS];
+    uint32_t accepted[COALESCE_MAX_SIGNALS] = {0};
+    uint32_t drops = 0, lost = 0;
+    uint8_t *pStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                      DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_MPSC,
+                                                                                              sizeof(coalesceEvent_t),
+                                                                                              depth)));
+
+    (void)memset(&gDispatcher, 0, sizeof(gDispatcher));
+    (void)memset(gPosted, 0, sizeof(gPosted));
+    gDispatcher.workNs = workNs;
+    gDispatcher.signals = signals;
+    gDispatcher.pPosted = gPosted;
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(coalesceEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = pStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)CoalesceHandler,
+        .queueType = DISPATCHER_QUEUE_TYPE_MPSC,
+        .coalesce = gCells,
+        .coalesceCount = COALESCE_SIGNAL_SYNC,
+    };
+
+    if (pStorage == NULL || dispatcher_InitWithConfig(&gDispatcher.base, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        free(pStorage);
+        return -1;
+    }
+    for (uint32_t i = 0; i < signals; i++)
+    {
+        if (DISPATCHER_COALESCE(&gDispatcher, COALESCE_SIGNAL_DATA + i, policy, CoalesceMerge) != DISPATCHER_ERR_CLEAR)
+        {
+            fprintf(stderr, "coalescing setup failed\n");
+            free(pStorage);
+            return -1;
+        }
+    }
+
+    pthread_t thread;
+    uint64_t start = BenchNow();
+
+    (void)pthread_create(&thread, NULL, CoalesceLoop, &gDispatcher);
+
+    // a burst posts every signal in turn, then waits for the event loop
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (uint32_t i = 0; i < burst * signals; i++)
+        {
+            uint32_t signal = i % signals;
+            coalesceEvent_t event = {.seq = gPosted[signal] + 1u, .count = 1};
+
+            DISPATCHER_SET_EVENT(&event, COALESCE_SIGNAL_DATA + signal);
+            __atomic_store_n(&gPosted[signal], event.seq, __ATOMIC_RELAXED);
+            if (DISPATCHER_POST_EVENT_FROM_ISR(&gDispatcher, &event, false) == DISPATCHER_ERR_CLEAR)
+            {
+                accepted[signal]++;
+            }
+            else
+            {
+                drops++;
+            }
+        }
+
+        CoalescePostControl(&gDispatcher, COALESCE_SIGNAL_SYNC);
+        while (__atomic_load_n(&gDispatcher.synced, __ATOMIC_ACQUIRE) != round + 1u)
+        {
+            (void)sched_yield();
+        }
+
+        for (uint32_t signal = 0; signal < signals; signal++)
+        {
+            if (policy == DISPATCHER_COALESCE_LATEST && accepted[signal] != 0 &&
+                gDispatcher.last[signal] != gPosted[signal])
+            {
+                lost++;
+            }
+        }
+    }
+
+    uint64_t elapsed = BenchNow() - start;
+
+    CoalescePostControl(&gDispatcher, COALESCE_SIGNAL_DONE);
+    (void)pthread_join(thread, NULL);
+
+    for (uint32_t signal = 0; signal < signals; signal++)
+    {
+        // latest may drop anything but the newest event, the rest sees every accepted post
+        if (policy != DISPATCHER_COALESCE_LATEST && gDispatcher.count[signal] != accepted[signal])
+        {
+            lost++;
+        }
+    }
+
+    uint32_t posts = burst * signals * rounds;
+    double rate = (double)posts * 1e9 / (double)elapsed;
+    double staleness = (double)gDispatcher.staleness / (gDispatcher.handled + 1u);
+
+    printf("{\"bench\":\"coalesce\",\"policy\":\"%s\",\"signals\":%u,\"depth\":%u,\"burst\":%u,\"rounds\":%u,"
+           "\"work_ns\":%u,\"posts_per_s\":%.0f,\"posts\":%u,\"dropped\":%u,\"handled\":%u,\"staleness\":%.2f,"
+           "\"lost\":%u,\"reordered\":%u}\n",
+           gPolicyNames[policy], signals, depth, burst, rounds, workNs, rate, posts, drops, gDispatcher.handled,
+           staleness, lost, gDispatcher.reordered);
+    fflush(stdout);
+    fprintf(stderr, "%-6s %10.0f posts/s dropped=%-8u handled=%-8u staleness=%8.2f%s\n",
+            gPolicyNames[policy], rate, drops, gDispatcher.handled, staleness,
+            (lost != 0 || gDispatcher.reordered != 0) ? " ERRORS" : "");
+
+    free(pStorage);
+    return (lost == 0 && gDispatcher.reordered == 0) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    static dispatcher_pool_t gPool;
+    uint32_t signals = 8, depth = 16, burst = 64, rounds = 500, workNs = 1000;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:d:b:r:u:h")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            signals = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            burst = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rounds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            workNs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -s count   signals (default 8, max %u)\n"
+                    "  -d count   queue depth, above the signal count (default 16)\n"
+                    "  -b count   posts per signal and burst (default 64)\n"
+                    "  -r count   bursts (default 500)\n"
+                    "  -u ns      handler cost (default 1000)\n",
+                    argv[0], COALESCE_MAX_SIGNALS);
+            return 1;
+        }
+    }
+
+    if (signals == 0 || signals > COALESCE_MAX_SIGNALS || depth <= signals || depth > UINT16_MAX ||
+        burst == 0 || rounds == 0)
+    {
+        return 1;
+    }
+
+    /* pending, posting and dispatched event of every signal. */
+    uint8_t *pPoolStorage = aligned_alloc(DISPATCHER_POOL_ALIGN,
+                                          DISPATCHER_POOL_STORAGE_SIZE(sizeof(coalesceEvent_t), 3u * signals));
+
+    if (pPoolStorage == NULL ||
+        DISPATCHER_EVENT_POOL_INIT(&gPool, sizeof(coalesceEvent_t), 3u * signals, pPoolStorage) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "pool initialization failed\n");
+        return 1;
+    }
+
+    for (uint32_t policy = 0; policy < DISPATCHER_COALESCE_MAX; policy++)
+    {
+        if (CoalesceRun((dispatcher_coalescePolicy_t)policy, signals, depth, burst, rounds, workNs) != 0)
+        {
+            return 1;
+        }
+    }
+    free(pPoolStorage);
+    return 0;
+}
@@ -0,0 +1,292 @@
+/*
+ *  Host C++ dispatcher benchmark : the same three event types go through a
+ *  C dispatcher (handler called through the active state pointer, a switch
+ *  on the signal and a cast of dispatcher_eventBase_t per event) and through
+ *  dispatcher::Dispatcher from dispatcher.hpp (handler overloads resolved at
+ *  compile time), both on the mpsc ring and handed to the handler in place.
+ *
+ *  A single thread posts a burst of events and runs the event loop until
+ *  the queue is empty, the cost per event covers the post and the dispatch.
+ *  Every run takes the best of several passes and checks both dispatchers
+ *  handled every event with the same handler hash.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include "bench_clock.h"
+
+#define CPP_CAPACITY (256u)
+
+#define CPP_SIGNAL_PRESS (DISPATCHER_SIGNAL_USER)
+#define CPP_SIGNAL_TICK (DISPATCHER_SIGNAL_USER + 1)
+#define CPP_SIGNAL_SAMPLE (DISPATCHER_SIGNAL_USER + 2)
+
+struct Press
+{
+    uint8_t button;
+};
+
+struct Tick
+{
+    uint32_t now;
+};
+
+struct Sample
+{
+    int32_t value;
+    uint16_t channel;
+};
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint8_t button;
+} cppPressEvent_t;
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t now;
+} cppTickEvent_t;
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    int32_t value;
+    uint16_t channel;
+} cppSampleEvent_t;
+
+typedef union
+{
+    cppPressEvent_t press;
+    cppTickEvent_t tick;
+    cppSampleEvent_t sample;
+} cppEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint64_t hash;
+    uint32_t handled;
+} cppDispatcher_t;
+
+/* the handler of both dispatchers, the hash depends on the event order. */
+struct CppMachine
+{
+    uint64_t hash = 0;
+    uint32_t handled = 0;
+
+    void Mix(uint64_t value)
+    {
+        hash = (hash ^ value) * 0x100000001b3ull;
+        handled++;
+    }
+
+    void On(Press const &event)
+    {
+        Mix(event.button);
+    }
+
+    void On(Tick const &event)
+    {
+        Mix(event.now);
+    }
+
+    void On(Sample const &event)
+    {
+        Mix(((uint64_t)event.channel << 32) ^ (uint32_t)event.value);
+    }
+};
+
+static CppMachine gMachine;
+
+static uint8_t CppHandler(cppDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    (void)pDispatcher;
+    switch (pEvent->sig)
+    {
+    case CPP_SIGNAL_PRESS:
+        gMachine.On(Press{((cppPressEvent_t const *)pEvent)->button});
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case CPP_SIGNAL_TICK:
+        gMachine.On(Tick{((cppTickEvent_t const *)pEvent)->now});
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case CPP_SIGNAL_SAMPLE:
+    {
+        cppSampleEvent_t const *pSample = (cppSampleEvent_t const *)pEvent;
+
+        gMachine.On(Sample{pSample->value, pSample->channel});
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+/* one burst through the C dispatcher, event i of every run is the same in both. */
+static bool CppBurstC(cppDispatcher_t *pDispatcher, uint32_t first, uint32_t burst)
+{
+    for (uint32_t i = first; i < first + burst; i++)
+    {
+        cppEvent_t event;
+
+        switch (i % 3u)
+        {
+        case 0:
+            DISPATCHER_SET_EVENT(&event.press, CPP_SIGNAL_PRESS);
+            event.press.button = (uint8_t)i;
+            break;
+        case 1:
+            DISPATCHER_SET_EVENT(&event.tick, CPP_SIGNAL_TICK);
+            event.tick.now = i;
+            break;
+        default:
+            DISPATCHER_SET_EVENT(&event.sample, CPP_SIGNAL_SAMPLE);
+            event.sample.value = -(int32_t)i;
+            event.sample.channel = (uint16_t)(i & 7u);
+            break;
+        }
+        if (DISPATCHER_POST_EVENT(pDispatcher, &event) != DISPATCHER_ERR_CLEAR)
+        {
+            return false;
+        }
+    }
+    while (DISPATCHER_EVENT_LOOP_TIMEOUT(pDispatcher, 0) == DISPATCHER_ERR_CLEAR)
+    {
+    }
+    return true;
+}
+
+template <typename Typed>
+static bool CppBurstTyped(Typed &dispatcher, uint32_t first, uint32_t burst)
+{
+    for (uint32_t i = first; i < first + burst; i++)
+    {
+        uint8_t ret;
+
+        switch (i % 3u)
+        {
+        case 0:
+            ret = dispatcher.Post(Press{(uint8_t)i});
+            break;
+        case 1:
+            ret = dispatcher.Post(Tick{i});
+            break;
+        default:
+            ret = dispatcher.Post(Sample{-(int32_t)i, (uint16_t)(i & 7u)});
+            break;
+        }
+        if (ret != DISPATCHER_ERR_CLEAR)
+        {
+            return false;
+        }
+    }
+    while (dispatcher.EventLoop(gMachine, 0) == DISPATCHER_ERR_CLEAR)
+    {
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t events = 1000000, burst = 64, passes = 5;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:b:r:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            burst = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            passes = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -n count   events per pass (default 1000000)\n"
+                    "  -b count   events per burst, at most %u (default 64)\n"
+                    "  -r count   passes, the best one is reported (default 5)\n",
+                    argv[0], CPP_CAPACITY);
+            return 1;
+        }
+    }
+
+    if (events == 0 || burst == 0 || burst > CPP_CAPACITY || passes == 0)
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    static cppDispatcher_t gC;
+    static dispatcher::Dispatcher<CPP_CAPACITY, Press, Tick, Sample> gTyped;
+    static uint8_t gStorage[DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_MPSC, sizeof(cppEvent_t), CPP_CAPACITY)]
+        __attribute__((aligned(DISPATCHER_QUEUE_ALIGN)));
+
+    dispatcher_config_t config = {};
+
+    config.itemSize = sizeof(cppEvent_t);
+    config.itemCount = CPP_CAPACITY;
+    config.queueStorage = gStorage;
+    config.eventStorage = NULL;
+    config.defaultHandler = (dispatcher_stateHandler_t)CppHandler;
+    config.queueType = DISPATCHER_QUEUE_TYPE_MPSC;
+
+    if (dispatcher_InitWithConfig(&gC.base, &config) != DISPATCHER_ERR_CLEAR || gTyped.Init() != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        return 1;
+    }
+
+    static char const *const names[] = {"c", "cpp"};
+    uint64_t best[2] = {UINT64_MAX, UINT64_MAX}, hash[2] = {0, 0};
+    uint32_t handled[2] = {0, 0};
+    bool failed = false;
+
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        for (uint32_t mode = 0; mode < 2u; mode++)
+        {
+            uint64_t start = BenchNow();
+
+            gMachine = CppMachine{};
+            for (uint32_t first = 0; first < events && !failed; first += burst)
+            {
+                uint32_t count = (events - first < burst) ? events - first : burst;
+
+                failed = (mode == 0) ? !CppBurstC(&gC, first, count) : !CppBurstTyped(gTyped, first, count);
+            }
+
+            uint64_t elapsed = BenchNow() - start;
+
+            best[mode] = (elapsed < best[mode]) ? elapsed : best[mode];
+            hash[mode] = gMachine.hash;
+            handled[mode] = gMachine.handled;
+        }
+    }
+
+    bool errors = failed || hash[0] != hash[1] || handled[0] != events || handled[1] != events;
+
+    for (uint32_t mode = 0; mode < 2u; mode++)
+    {
+        printf("{\"bench\":\"cpp\",\"api\":\"%s\",\"events\":%u,\"burst\":%u,\"passes\":%u,\"event_ns\":%.2f,"
+               "\"handled\":%u,\"hash\":\"%016llx\",\"slot_bytes\":%u}\n",
+               names[mode], events, burst, passes, (double)best[mode] / events, handled[mode],
+               (unsigned long long)hash[mode],
+               (mode == 0) ? (unsigned)sizeof(cppEvent_t) : (unsigned)sizeof(decltype(gTyped)::Slot));
+        fprintf(stderr, "%-4s post + dispatch %6.2f ns/event handled=%u%s\n", names[mode], (double)best[mode] / events,
+                handled[mode], errors ? " ERRORS" : "");
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+/*
+ *  Host deferral benchmark : requests reaching a dispatcher while its busy
+ *  state can not handle them, until another thread posts the ready event
+ *  after the given busy time.
+ *
+ *  The repost mode is the usual workaround, the busy state posts every
+ *  request back to the tail of its own queue, so the event loop keeps
+ *  cycling them for the whole busy time. The defer mode returns
+ *  DISPATCHER_DEFER, the idle state recalls them on ENTRY.
+ *
+ *  Every run counts handler calls, the time from the ready post to the
+ *  last request handled and requests handled out of order.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include "bench_clock.h"
+
+#define DEFER_SIGNAL_REQUEST (DISPATCHER_SIGNAL_USER)
+#define DEFER_SIGNAL_READY (DISPATCHER_SIGNAL_USER + 1)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+} deferEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    bool repost;         /* repost to the queue tail instead of deferring. */
+    uint32_t expected;   /* next request sequence number. */
+    uint32_t reordered;
+    uint32_t lost;       /* reposts which found the queue full. */
+    uint64_t dispatches; /* handler calls with a request or ready event. */
+    uint64_t ready;      /* ready post time in ns. */
+    uint64_t drained;    /* last request handled time in ns. */
+} deferDispatcher_t;
+
+typedef struct
+{
+    deferDispatcher_t *pDispatcher;
+    uint32_t busyUs;
+} deferReady_t;
+
+static char const *const gQueueNames[DISPATCHER_QUEUE_TYPE_MAX] = {
+    [DISPATCHER_QUEUE_TYPE_DEFAULT] = "default",
+    [DISPATCHER_QUEUE_TYPE_SPSC] = "spsc",
+    [DISPATCHER_QUEUE_TYPE_MPSC] = "mpsc",
+    [DISPATCHER_QUEUE_TYPE_VARIABLE] = "var",
+};
+
+static uint8_t DeferIdle(deferDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+static uint8_t DeferBusy(deferDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case DEFER_SIGNAL_REQUEST:
+        pDispatcher->dispatches++;
+        if (!pDispatcher->repost)
+        {
+            return DISPATCHER_DEFER(pDispatcher);
+        }
+        if (DISPATCHER_POST_EVENT_FROM_ISR(pDispatcher, pEvent, false) != DISPATCHER_ERR_CLEAR)
+        {
+            pDispatcher->lost++;
+        }
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case DEFER_SIGNAL_READY:
+        pDispatcher->dispatches++;
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)DeferIdle);
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static uint8_t DeferIdle(deferDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case DISPATCHER_SIGNAL_ENTRY:
+        if (!pDispatcher->repost)
+        {
+            (void)DISPATCHER_RECALL(pDispatcher);
+        }
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case DEFER_SIGNAL_REQUEST:
+    {
+        deferEvent_t const *pRequest = (deferEvent_t const *)pEvent;
+
+        pDispatcher->dispatches++;
+        if (pRequest->seq != pDispatcher->expected)
+        {
+            pDispatcher->reordered++;
+        }
+        pDispatcher->expected++;
+        pDispatcher->drained = BenchNow();
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static void *DeferReady(void *pArg)
+{
+    deferReady_t *pReady = pArg;
+    struct timespec busy = {.tv_sec = pReady->busyUs / 1000000u, .tv_nsec = (pReady->busyUs % 1000000u) * 1000L};
+    deferEvent_t event = {0};
+
+    (void)nanosleep(&busy, NULL);
+    DISPATCHER_SET_EVENT(&event, DEFER_SIGNAL_READY);
+    __atomic_store_n(&pReady->pDispatcher->ready, BenchNow(), __ATOMIC_RELAXED);
+    while (DISPATCHER_POST_EVENT_FROM_ISR(pReady->pDispatcher, &event, false) != DISPATCHER_ERR_CLEAR)
+    {
+    }
+    return NULL;
+}
+
+static int DeferRun(dispatcher_queueType_t type, uint32_t requests, uint32_t busyUs, bool repost)
+{
+    uint32_t depth = 1;
+    uint8_t *queueStorage = NULL, *eventStorage = NULL, *deferStorage = NULL;
+    deferDispatcher_t dispatcher = {.repost = repost};
+    deferReady_t ready = {.pDispatcher = &dispatcher, .busyUs = busyUs};
+    pthread_t thread;
+    int ret = -1;
+
+    // room for every request, the ready event and the repost of a held slot
+    while (depth < requests + 2u)
+    {
+        depth <<= 1;
+    }
+
+    queueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                 DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(type, sizeof(deferEvent_t), depth)));
+    eventStorage = calloc(1, sizeof(deferEvent_t));
+    deferStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN, DISPATCHER_DEFER_STORAGE_SIZE(sizeof(deferEvent_t), requests));
+    if (queueStorage == NULL || eventStorage == NULL || deferStorage == NULL)
+    {
+        goto cleanup;
+    }
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(deferEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = queueStorage,
+        .eventStorage = eventStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)DeferBusy,
+        .queueType = type,
+        .deferStorage = repost ? NULL : deferStorage,
+        .deferCount = repost ? 0 : (uint16_t)requests,
+    };
+
+    if (dispatcher_InitWithConfig(&dispatcher.base, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < requests; i++)
+    {
+        deferEvent_t event = {.seq = i};
+
+        DISPATCHER_SET_EVENT(&event, DEFER_SIGNAL_REQUEST);
+        if (DISPATCHER_POST_EVENT_FROM_ISR(&dispatcher, &event, false) != DISPATCHER_ERR_CLEAR)
+        {
+            goto cleanup;
+        }
+    }
+
+    if (pthread_create(&thread, NULL, DeferReady, &ready) != 0)
+    {
+        goto cleanup;
+    }
+    while (dispatcher.expected + dispatcher.lost < requests)
+    {
+        (void)DISPATCHER_EVENT_LOOP_BATCH(&dispatcher, 32, 0, NULL);
+    }
+    (void)pthread_join(thread, NULL);
+
+    uint64_t drainNs = dispatcher.drained - __atomic_load_n(&dispatcher.ready, __ATOMIC_RELAXED);
+
+    printf("{\"bench\":\"defer\",\"queue\":\"%s\",\"mode\":\"%s\",\"requests\":%u,\"busy_us\":%u,"
+           "\"dispatches\":%llu,\"drain_ns\":%llu,\"reordered\":%u,\"lost\":%u}\n",
+           gQueueNames[type], repost ? "repost" : "defer", requests, busyUs,
+           (unsigned long long)dispatcher.dispatches, (unsigned long long)drainNs, dispatcher.reordered,
+           dispatcher.lost);
+    fflush(stdout);
+    fprintf(stderr, "%-7s %-6s requests=%-4u busy=%6u us dispatches=%10llu drain=%9.2f us reordered=%u%s\n",
+            gQueueNames[type], repost ? "repost" : "defer", requests, busyUs,
+            (unsigned long long)dispatcher.dispatches, (double)drainNs / 1000.0, dispatcher.reordered,
+            dispatcher.lost ? " LOST" : "");
+    // the defer mode must keep every request in order, reposting may not
+    ret = (dispatcher.lost == 0 && (repost || dispatcher.reordered == 0)) ? 0 : -1;
+
+cleanup:
+    free(deferStorage);
+    free(eventStorage);
+    free(queueStorage);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultRequests[] = {4, 32, 256};
+    uint32_t const *requests = defaultRequests;
+    uint32_t requestCount = 3, request = 0, busyUs = 1000;
+    dispatcher_queueType_t type = DISPATCHER_QUEUE_TYPE_MPSC;
+    int option;
+
+    while ((option = getopt(argc, argv, "r:w:q:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'r':
+            request = (uint32_t)strtoul(optarg, NULL, 0);
+            requests = &request;
+            requestCount = 1;
+            break;
+        case 'w':
+            busyUs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            type = DISPATCHER_QUEUE_TYPE_MAX;
+            for (uint32_t q = 0; q < DISPATCHER_QUEUE_TYPE_MAX; q++)
+            {
+                if (strcmp(optarg, gQueueNames[q]) == 0)
+                {
+                    type = (dispatcher_queueType_t)q;
+                }
+            }
+            // spsc has one producer, the ready thread and the reposting handler would be two
+            if (type == DISPATCHER_QUEUE_TYPE_MAX || type == DISPATCHER_QUEUE_TYPE_SPSC)
+            {
+                fprintf(stderr, "unsupported queue %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -r events  requests queued while busy (default sweep 4,32,256)\n"
+                    "  -w us      busy time before the ready event (default 1000)\n"
+                    "  -q queue   default|mpsc|var (default mpsc)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (requests == &request && (request == 0 || request > 16384u))
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < requestCount * 2u; i++)
+    {
+        if (DeferRun(type, requests[i / 2u], busyUs, (i % 2u) == 0) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
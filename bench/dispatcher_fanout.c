@@ -0,0 +1,400 @@
+/*
+ *  Host fan out benchmark : the same event delivered to N dispatchers,
+ *  copied into every queue (dispatcher_Post) or allocated once from an
+ *  event pool and queued by reference (dispatcher_PostRef). With -P the
+ *  event is routed by a publish / subscribe bus (dispatcher_Publish,
+ *  dispatcher_PublishRef) instead of a chain of post calls.
+ *
+ *  Events carry a sequence number every dispatcher checks, a run fails on
+ *  any loss or reordering. Inline runs (default) post a burst of queue
+ *  depth events to every dispatcher and then drain them one after the
+ *  other on the same thread, which isolates the cpu cost. With -T every
+ *  dispatcher runs its event loop on its own thread, so pool references
+ *  are dropped concurrently.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include "bench_clock.h"
+
+#define FANOUT_MAX_DISPATCHERS (32)
+#define FANOUT_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define FANOUT_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + 1)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+} fanoutEvent_t;
+
+typedef struct
+{
+    uint32_t eventSize;   /* bytes per event, >= sizeof(fanoutEvent_t). */
+    uint32_t queueDepth;  /* queue item count. */
+    uint32_t dispatchers; /* number of receiving dispatchers. */
+    uint32_t events;      /* events per run, each one delivered to every dispatcher. */
+    dispatcher_queueType_t queueType;
+    bool byRef;           /* post through the event pool. */
+    bool threaded;        /* one event loop thread per dispatcher. */
+    bool publish;         /* route through a bus instead of a post chain. */
+} fanoutConfig_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint8_t *queueStorage;
+    uint8_t *eventStorage;
+    uint32_t expected; /* next sequence number. */
+    uint32_t reordered;
+    bool done;
+    pthread_t thread;
+} fanoutDispatcher_t;
+
+static char const *const gQueueNames[DISPATCHER_QUEUE_TYPE_MAX] = {
+    [DISPATCHER_QUEUE_TYPE_DEFAULT] = "default",
+    [DISPATCHER_QUEUE_TYPE_SPSC] = "spsc",
+    [DISPATCHER_QUEUE_TYPE_MPSC] = "mpsc",
+    [DISPATCHER_QUEUE_TYPE_VARIABLE] = "var",
+};
+
+static uint8_t FanoutHandler(fanoutDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    if (pEvent->sig == FANOUT_SIGNAL_DATA)
+    {
+        fanoutEvent_t const *pData = (fanoutEvent_t const *)pEvent;
+
+        if (pData->seq != pDispatcher->expected)
+        {
+            pDispatcher->reordered++;
+        }
+        pDispatcher->expected = pData->seq + 1u;
+    }
+    else if (pEvent->sig == FANOUT_SIGNAL_DONE)
+    {
+        pDispatcher->done = true;
+    }
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+static void *FanoutLoop(void *pArg)
+{
+    fanoutDispatcher_t *pDispatcher = pArg;
+
+    while (!pDispatcher->done)
+    {
+        (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, 32, 0, NULL);
+    }
+    return NULL;
+}
+
+/*
+ *  Posts one event to every dispatcher, retries while queues or the pool
+ *  are full (threaded runs only, inline bursts never exceed the depth).
+ */
+static void FanoutPost(fanoutConfig_t const *pConfig,
+                       fanoutDispatcher_t *dispatchers,
+                       dispatcher_bus_t *pBus,
+                       uint8_t *pScratch,
+                       uint32_t seq)
+{
+    fanoutEvent_t *pEvent = (fanoutEvent_t *)pScratch;
+
+    if (pConfig->byRef)
+    {
+        while (DISPATCHER_EVENT_NEW(pConfig->eventSize, &pEvent) != DISPATCHER_ERR_CLEAR)
+        {
+            (void)sched_yield();
+        }
+    }
+
+    DISPATCHER_SET_EVENT(pEvent, FANOUT_SIGNAL_DATA);
+    pEvent->seq = seq;
+
+    if (pBus != NULL)
+    {
+        /* a partial publish can not be retried, the missing events count as lost. */
+        (void)(pConfig->byRef ? DISPATCHER_PUBLISH_REF(pBus, pEvent, NULL)
+                              : DISPATCHER_PUBLISH(pBus, pEvent, pConfig->eventSize, NULL));
+    }
+
+    for (uint32_t i = 0; pBus == NULL && i < pConfig->dispatchers; i++)
+    {
+        uint8_t ret;
+
+        do
+        {
+            ret = pConfig->byRef ? DISPATCHER_POST_REF(&dispatchers[i], pEvent)
+                                 : DISPATCHER_POST_EVENT(&dispatchers[i], pEvent);
+        } while (ret == DISPATCHER_ERR_QUEUE_FULL);
+    }
+
+    if (pConfig->byRef)
+    {
+        (void)DISPATCHER_EVENT_RELEASE(pEvent);
+    }
+}
+
+static int FanoutRun(fanoutConfig_t const *pConfig)
+{
+    uint32_t itemSize = pConfig->byRef ? sizeof(dispatcher_eventRef_t) : pConfig->eventSize;
+    uint32_t storageSize = DISPATCHER_QUEUE_STORAGE_SIZE(pConfig->queueType, itemSize, pConfig->queueDepth);
+    fanoutDispatcher_t *dispatchers = calloc(pConfig->dispatchers, sizeof(fanoutDispatcher_t));
+    uint8_t *pScratch = calloc(1, itemSize > pConfig->eventSize ? itemSize : pConfig->eventSize);
+    uint32_t reordered = 0, lost = 0;
+    uint32_t subscriptions[FANOUT_SIGNAL_DONE + 1];
+    dispatcher_bus_t bus;
+    dispatcher_bus_t *pBus = pConfig->publish ? &bus : NULL;
+    int ret = 0;
+
+    (void)dispatcher_BusInit(&bus, subscriptions, FANOUT_SIGNAL_DONE + 1);
+
+    if (dispatchers == NULL || pScratch == NULL)
+    {
+        free(dispatchers);
+        free(pScratch);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < pConfig->dispatchers; i++)
+    {
+        fanoutDispatcher_t *pDispatcher = &dispatchers[i];
+
+        pDispatcher->queueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN, DISPATCHER_QUEUE_ALIGN_UP(storageSize));
+        pDispatcher->eventStorage = calloc(1, itemSize);
+
+        dispatcher_config_t config = {
+            .itemSize = (uint16_t)itemSize,
+            .itemCount = (uint16_t)pConfig->queueDepth,
+            .queueStorage = pDispatcher->queueStorage,
+            .eventStorage = pDispatcher->eventStorage,
+            .defaultHandler = (dispatcher_stateHandler_t)FanoutHandler,
+            .queueType = pConfig->queueType,
+        };
+
+        if (pDispatcher->queueStorage == NULL || pDispatcher->eventStorage == NULL ||
+            dispatcher_InitWithConfig(&pDispatcher->base, &config) != DISPATCHER_ERR_CLEAR ||
+            dispatcher_BusAttach(&bus, &pDispatcher->base, (uint8_t)(pConfig->dispatchers - 1u - i)) != DISPATCHER_ERR_CLEAR ||
+            DISPATCHER_SUBSCRIBE(&bus, pDispatcher, FANOUT_SIGNAL_DATA) != DISPATCHER_ERR_CLEAR)
+        {
+            ret = -1;
+        }
+    }
+
+    uint64_t start = BenchNow();
+
+    if (ret == 0 && pConfig->threaded)
+    {
+        for (uint32_t i = 0; i < pConfig->dispatchers; i++)
+        {
+            (void)pthread_create(&dispatchers[i].thread, NULL, FanoutLoop, &dispatchers[i]);
+        }
+        for (uint32_t seq = 0; seq < pConfig->events; seq++)
+        {
+            FanoutPost(pConfig, dispatchers, pBus, pScratch, seq);
+        }
+        (void)memset(pScratch, 0, itemSize);
+        DISPATCHER_SET_EVENT(pScratch, FANOUT_SIGNAL_DONE);
+        for (uint32_t i = 0; i < pConfig->dispatchers; i++)
+        {
+            while (DISPATCHER_POST_EVENT(&dispatchers[i], pScratch) != DISPATCHER_ERR_CLEAR)
+            {
+            }
+            (void)pthread_join(dispatchers[i].thread, NULL);
+        }
+    }
+    else if (ret == 0)
+    {
+        for (uint32_t seq = 0; seq < pConfig->events;)
+        {
+            uint32_t burst = pConfig->events - seq;
+
+            burst = (burst > pConfig->queueDepth) ? pConfig->queueDepth : burst;
+            for (uint32_t j = 0; j < burst; j++)
+            {
+                FanoutPost(pConfig, dispatchers, pBus, pScratch, seq + j);
+            }
+            for (uint32_t i = 0; i < pConfig->dispatchers; i++)
+            {
+                uint16_t processed = 0;
+
+                (void)DISPATCHER_EVENT_LOOP_BATCH(&dispatchers[i], burst, 0, &processed);
+            }
+            seq += burst;
+        }
+    }
+
+    double seconds = (double)(BenchNow() - start) / 1e9;
+
+    for (uint32_t i = 0; i < pConfig->dispatchers; i++)
+    {
+        reordered += dispatchers[i].reordered;
+        lost += pConfig->events - dispatchers[i].expected;
+        free(dispatchers[i].queueStorage);
+        free(dispatchers[i].eventStorage);
+    }
+    free(dispatchers);
+    free(pScratch);
+
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    double deliveries = (double)pConfig->events * (double)pConfig->dispatchers;
+
+    printf("{\"bench\":\"fanout\",\"queue\":\"%s\",\"route\":\"%s\",\"by_ref\":%s,\"threaded\":%s,\"event_size\":%u,"
+           "\"queue_depth\":%u,\"dispatchers\":%u,\"events\":%u,\"deliveries_per_sec\":%.0f,"
+           "\"queue_bytes\":%u,\"lost\":%u,\"reordered\":%u}\n",
+           gQueueNames[pConfig->queueType], pConfig->publish ? "publish" : "post", pConfig->byRef ? "true" : "false",
+           pConfig->threaded ? "true" : "false", pConfig->eventSize, pConfig->queueDepth,
+           pConfig->dispatchers, pConfig->events, deliveries / seconds,
+           storageSize * pConfig->dispatchers, lost, reordered);
+    fflush(stdout);
+
+    fprintf(stderr, "%-8s %-7s %-4s size=%-4u depth=%-4u dispatchers=%-3u %12.0f deliveries/s  queues=%u bytes\n",
+            gQueueNames[pConfig->queueType], pConfig->publish ? "publish" : "post",
+            pConfig->byRef ? "ref" : "copy", pConfig->eventSize,
+            pConfig->queueDepth, pConfig->dispatchers, deliveries / seconds, storageSize * pConfig->dispatchers);
+
+    return (lost != 0 || reordered != 0) ? 1 : 0;
+}
+
+static void FanoutUsage(char const *pName)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -s bytes   event size (default sweep 16,64,256)\n"
+            "  -d depth   queue depth (default 32)\n"
+            "  -f count   dispatchers (default sweep 1,4,8,16,32)\n"
+            "  -n events  events per run (default 100000)\n"
+            "  -q queue   default|spsc|mpsc|var (default mpsc)\n"
+            "  -T         one event loop thread per dispatcher\n"
+            "  -P         publish through a bus instead of posting to every dispatcher\n",
+            pName);
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultSizes[] = {16, 64, 256};
+    static uint32_t const defaultFanout[] = {1, 4, 8, 16, 32};
+    static dispatcher_pool_t pools[DISPATCHER_POOL_MAX];
+    uint32_t const *sizes = defaultSizes, *fanout = defaultFanout;
+    uint32_t sizeCount = 3, fanoutCount = 5, size = 0, count = 0;
+    uint32_t queueDepth = 32, events = 100000;
+    dispatcher_queueType_t queueType = DISPATCHER_QUEUE_TYPE_MPSC;
+    bool threaded = false, publish = false;
+    int option, failed = 0;
+
+    while ((option = getopt(argc, argv, "s:d:f:n:q:TPh")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            size = (uint32_t)strtoul(optarg, NULL, 0);
+            sizes = &size;
+            sizeCount = 1;
+            break;
+        case 'd':
+            queueDepth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            count = (uint32_t)strtoul(optarg, NULL, 0);
+            fanout = &count;
+            fanoutCount = 1;
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            for (queueType = 0; queueType < DISPATCHER_QUEUE_TYPE_MAX; queueType++)
+            {
+                if (strcmp(optarg, gQueueNames[queueType]) == 0)
+                {
+                    break;
+                }
+            }
+            if (queueType == DISPATCHER_QUEUE_TYPE_MAX)
+            {
+                FanoutUsage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'T':
+            threaded = true;
+            break;
+        case 'P':
+            publish = true;
+            break;
+        default:
+            FanoutUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((sizes == &size && (size < sizeof(fanoutEvent_t) || size > UINT16_MAX)) ||
+        (fanout == &count && (count == 0 || count > FANOUT_MAX_DISPATCHERS)) ||
+        queueDepth == 0 || queueDepth > UINT16_MAX || events == 0)
+    {
+        FanoutUsage(argv[0]);
+        return 1;
+    }
+
+    /* one size class per event size, enough blocks for a full queue plus
+       the one being posted. */
+    for (uint32_t i = 0; i < sizeCount; i++)
+    {
+        uint8_t *pStorage = aligned_alloc(DISPATCHER_POOL_ALIGN,
+                                          DISPATCHER_POOL_STORAGE_SIZE(sizes[i], 2u * queueDepth));
+
+        if (pStorage == NULL ||
+            DISPATCHER_EVENT_POOL_INIT(&pools[i], sizes[i], 2u * queueDepth, pStorage) != DISPATCHER_ERR_CLEAR)
+        {
+            fprintf(stderr, "pool initialization failed\n");
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < sizeCount; i++)
+    {
+        for (uint32_t f = 0; f < fanoutCount; f++)
+        {
+            for (int byRef = 0; byRef < 2; byRef++)
+            {
+                fanoutConfig_t config = {
+                    .eventSize = sizes[i],
+                    .queueDepth = queueDepth,
+                    .dispatchers = fanout[f],
+                    .events = events,
+                    .queueType = queueType,
+                    .byRef = byRef != 0,
+                    .threaded = threaded,
+                    .publish = publish,
+                };
+                int ret = FanoutRun(&config);
+
+                if (ret < 0)
+                {
+                    fprintf(stderr, "%s initialization failed\n", gQueueNames[queueType]);
+                    return 1;
+                }
+                failed |= ret;
+            }
+        }
+
+        if (dispatcher_PoolFreeCount(&pools[i]) != pools[i].blockCount)
+        {
+            fprintf(stderr, "pool of %u bytes leaked events\n", sizes[i]);
+            failed = 1;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,258 @@
+/*
+ *  Host signal filter benchmark : a producer posts a stream of noise events
+ *  and toggles the state machine between an idle state, which ignores the
+ *  noise, and a busy state handling it at a given cost. The same stream is
+ *  run without filters, with a declared filter of the idle state (accepts
+ *  the toggle and stop signals only) and with a learning one.
+ *
+ *  The producer waits for every toggle to be handled, posts are filtered
+ *  against the state active at the post. A run reports the post cost, how
+ *  many noise events took a queue slot and reached a handler and how many
+ *  the filter dropped in the producer. It checks that the busy state got
+ *  every noise event posted while it was active, that the idle state got
+ *  none with a declared filter and, with a learning filter, only those
+ *  posted before it handled the first one (a queue full, the handled one
+ *  and a blocked post at most), and that nothing is filtered without
+ *  filters.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include "bench_clock.h"
+
+#define FILTER_SIGNAL_NOISE (DISPATCHER_SIGNAL_USER)
+#define FILTER_SIGNAL_TOGGLE (DISPATCHER_SIGNAL_USER + 1)
+#define FILTER_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + 2)
+
+typedef enum
+{
+    FILTER_MODE_NONE = 0,
+    FILTER_MODE_DECLARED,
+    FILTER_MODE_LEARNED,
+    FILTER_MODE_MAX,
+} filterMode_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t workNs;
+    uint32_t handled;  /* noise handled by the busy state. */
+    uint32_t ignored;  /* noise which reached the idle state. */
+    uint32_t toggles;
+    bool stop;
+} filterDispatcher_t;
+
+static char const *const gModeNames[FILTER_MODE_MAX] = {
+    [FILTER_MODE_NONE] = "none",
+    [FILTER_MODE_DECLARED] = "declared",
+    [FILTER_MODE_LEARNED] = "learned",
+};
+
+static uint8_t FilterBusy(filterDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+static uint8_t FilterIdle(filterDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case FILTER_SIGNAL_NOISE:
+        pDispatcher->ignored++;
+        return DISPATCHER_SM_STATUS_IGNORED;
+    case FILTER_SIGNAL_TOGGLE:
+        __atomic_store_n(&pDispatcher->toggles, pDispatcher->toggles + 1u, __ATOMIC_RELEASE);
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)FilterBusy);
+    case FILTER_SIGNAL_DONE:
+        pDispatcher->stop = true;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static uint8_t FilterBusy(filterDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case FILTER_SIGNAL_NOISE:
+    {
+        uint64_t until = BenchNow() + pDispatcher->workNs;
+
+        pDispatcher->handled++;
+        while (BenchNow() < until)
+        {
+        }
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    case FILTER_SIGNAL_TOGGLE:
+        __atomic_store_n(&pDispatcher->toggles, pDispatcher->toggles + 1u, __ATOMIC_RELEASE);
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)FilterIdle);
+    case FILTER_SIGNAL_DONE:
+        pDispatcher->stop = true;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static void *FilterLoop(void *pArg)
+{
+    filterDispatcher_t *pDispatcher = pArg;
+
+    while (!pDispatcher->stop)
+    {
+        (void)DISPATCHER_EVENT_LOOP(pDispatcher);
+    }
+    return NULL;
+}
+
+static int FilterRun(filterMode_t mode, uint32_t depth, uint32_t events, uint32_t period, uint32_t workNs)
+{
+    static filterDispatcher_t gDispatcher;
+    static dispatcher_filter_t gFilter;
+    dispatcher_eventBase_t eventStorage;
+    uint8_t *pQueueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                           DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_DEFAULT,
+                                                                                                   sizeof(dispatcher_eventBase_t),
+                                                                                                   depth)));
+    uint32_t failed = 0, busy = 0, idle = 0, toggles = 0;
+
+    (void)memset(&gDispatcher, 0, sizeof(gDispatcher));
+    gDispatcher.workNs = workNs;
+    (void)DISPATCHER_FILTER_INIT(&gFilter, FilterIdle, mode == FILTER_MODE_LEARNED);
+    (void)dispatcher_FilterAccept(&gFilter, FILTER_SIGNAL_TOGGLE);
+    (void)dispatcher_FilterAccept(&gFilter, FILTER_SIGNAL_DONE);
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(dispatcher_eventBase_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = pQueueStorage,
+        .eventStorage = (uint8_t *)&eventStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)FilterIdle,
+        .filters = (mode == FILTER_MODE_NONE) ? NULL : &gFilter,
+        .filterCount = (mode == FILTER_MODE_NONE) ? 0u : 1u,
+    };
+
+    if (pQueueStorage == NULL || dispatcher_InitWithConfig(&gDispatcher.base, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        free(pQueueStorage);
+        return -1;
+    }
+
+    pthread_t thread;
+    uint64_t start = BenchNow();
+
+    (void)pthread_create(&thread, NULL, FilterLoop, &gDispatcher);
+
+    for (uint32_t i = 1; i <= events; i++)
+    {
+        dispatcher_eventBase_t event;
+
+        DISPATCHER_SET_EVENT(&event, (i % period == 0) ? FILTER_SIGNAL_TOGGLE : FILTER_SIGNAL_NOISE);
+        uint8_t ret = DISPATCHER_POST_EVENT(&gDispatcher, &event);
+
+        if (ret != DISPATCHER_ERR_CLEAR && ret != DISPATCHER_ERR_FILTERED)
+        {
+            failed++;
+        }
+        if (event.sig == FILTER_SIGNAL_NOISE)
+        {
+            busy += (toggles % 2u) ? 1u : 0u;
+            idle += (toggles % 2u) ? 0u : 1u;
+            continue;
+        }
+
+        // the state after the transition is the one the next posts are filtered against
+        toggles++;
+        while (__atomic_load_n(&gDispatcher.toggles, __ATOMIC_ACQUIRE) != toggles)
+        {
+            (void)sched_yield();
+        }
+    }
+    uint64_t posted = BenchNow() - start;
+
+    dispatcher_eventBase_t done;
+
+    DISPATCHER_SET_EVENT(&done, FILTER_SIGNAL_DONE);
+    (void)DISPATCHER_POST_EVENT(&gDispatcher, &done);
+    (void)pthread_join(thread, NULL);
+    uint64_t elapsed = BenchNow() - start;
+
+    uint32_t filtered = dispatcher_FilteredCount(&gDispatcher.base);
+    bool learned = (mode != FILTER_MODE_LEARNED) || (idle == 0) ||
+                   (gDispatcher.ignored != 0 && gDispatcher.ignored <= depth + 2u);
+    bool accounted = gDispatcher.handled == busy && gDispatcher.handled + gDispatcher.ignored + filtered == busy + idle &&
+                     (mode != FILTER_MODE_NONE || gDispatcher.ignored == idle) &&
+                     (mode != FILTER_MODE_DECLARED || gDispatcher.ignored == 0);
+    bool errors = failed != 0 || !accounted || !learned;
+
+    printf("{\"bench\":\"filter\",\"mode\":\"%s\",\"depth\":%u,\"events\":%u,\"period\":%u,\"work_ns\":%u,"
+           "\"post_mean_ns\":%.1f,\"run_ms\":%.2f,\"queued\":%u,\"handled\":%u,\"ignored\":%u,\"filtered\":%u,"
+           "\"failed\":%u,\"accounted\":%s}\n",
+           gModeNames[mode], depth, events, period, workNs, (double)posted / events, (double)elapsed / 1e6,
+           gDispatcher.handled + gDispatcher.ignored + gDispatcher.toggles, gDispatcher.handled, gDispatcher.ignored,
+           filtered, failed, accounted ? "true" : "false");
+    fflush(stdout);
+    fprintf(stderr, "%-8s post %7.1f ns run %8.2f ms handled=%-7u ignored=%-7u filtered=%-7u%s\n", gModeNames[mode],
+            (double)posted / events, (double)elapsed / 1e6, gDispatcher.handled, gDispatcher.ignored, filtered,
+            errors ? " ERRORS" : "");
+
+    free(pQueueStorage);
+    return errors ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t depth = 64, events = 200000, period = 1000, workNs = 200;
+    int option;
+
+    while ((option = getopt(argc, argv, "d:n:p:u:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            period = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            workNs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -d count   queue depth (default 64)\n"
+                    "  -n count   events per run (default 200000)\n"
+                    "  -p count   events between two toggles (default 1000)\n"
+                    "  -u ns      busy state handler cost (default 200)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (depth == 0 || depth > UINT16_MAX || events == 0 || period < 2)
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    int ret = 0;
+
+    for (filterMode_t mode = FILTER_MODE_NONE; mode < FILTER_MODE_MAX; mode++)
+    {
+        ret |= FilterRun(mode, depth, events, period, workNs);
+    }
+    return (ret != 0) ? 1 : 0;
+}
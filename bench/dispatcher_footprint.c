@@ -0,0 +1,205 @@
+/*
+ *  Host footprint report : how many events fit in the same queue storage
+ *  buffer with every queue backend.
+ *
+ *  Events follow the shape of appEvent_t in main/advance_demo.c, a
+ *  dispatcher_eventBase_t followed by a union of parameters (the default
+ *  sweep also uses larger unions). A given percentage of the posted events
+ *  is a bare signal, the rest carries the full union. Fixed size backends
+ *  spend a whole slot on every event, the variable size ring only the
+ *  event's own size plus a length word.
+ *
+ *  Every backend gets the largest storage its layout allows inside the
+ *  buffer, events are posted without a consumer until the queue is full.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    union
+    {
+        struct
+        {
+            int param1;
+            float param2;
+        } eventOne;
+        struct
+        {
+            int param1;
+            float param2;
+        } eventTwo;
+    } params;
+} footprintEvent_t;
+
+static char const *const gQueueNames[DISPATCHER_QUEUE_TYPE_MAX] = {
+    [DISPATCHER_QUEUE_TYPE_DEFAULT] = "default",
+    [DISPATCHER_QUEUE_TYPE_SPSC] = "spsc",
+    [DISPATCHER_QUEUE_TYPE_MPSC] = "mpsc",
+    [DISPATCHER_QUEUE_TYPE_VARIABLE] = "var",
+};
+
+static uint8_t FootprintHandler(dispatcher_base_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    (void)pDispatcher;
+    (void)pEvent;
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+/*
+ *  Largest item count whose storage fits in bufferSize bytes.
+ */
+static uint32_t FootprintItemCount(dispatcher_queueType_t type, uint32_t itemSize, uint32_t bufferSize)
+{
+    uint32_t count = bufferSize / DISPATCHER_QUEUE_STORAGE_SIZE(type, itemSize, 1u);
+
+    if (type == DISPATCHER_QUEUE_TYPE_SPSC || type == DISPATCHER_QUEUE_TYPE_MPSC)
+    {
+        while ((count & (count - 1u)) != 0)
+        {
+            count &= count - 1u;
+        }
+    }
+    return (count > UINT16_MAX) ? UINT16_MAX : count;
+}
+
+static int FootprintRun(dispatcher_queueType_t type, uint32_t itemSize, uint32_t bufferSize, uint32_t barePercent)
+{
+    uint32_t itemCount = FootprintItemCount(type, itemSize, bufferSize);
+    uint32_t storageSize = DISPATCHER_QUEUE_STORAGE_SIZE(type, itemSize, itemCount);
+    uint8_t *queueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN, DISPATCHER_QUEUE_ALIGN_UP(bufferSize));
+    uint8_t *eventStorage = calloc(1, itemSize);
+    uint8_t *pEvent = calloc(1, itemSize);
+    dispatcher_base_t dispatcher;
+    uint32_t events = 0;
+    int ret = -1;
+
+    if (itemCount == 0 || queueStorage == NULL || eventStorage == NULL || pEvent == NULL)
+    {
+        goto cleanup;
+    }
+
+    dispatcher_config_t config = {
+        .itemSize = (uint16_t)itemSize,
+        .itemCount = (uint16_t)itemCount,
+        .queueStorage = queueStorage,
+        .eventStorage = eventStorage,
+        .defaultHandler = FootprintHandler,
+        .queueType = type,
+    };
+
+    if (dispatcher_InitWithConfig(&dispatcher, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        goto cleanup;
+    }
+
+    for (;;)
+    {
+        /* spreads bare events evenly, barePercent of every 100 events. */
+        bool bare = ((events + 1u) * barePercent / 100u) != (events * barePercent / 100u);
+        uint16_t size = (bare && type == DISPATCHER_QUEUE_TYPE_VARIABLE) ? sizeof(dispatcher_eventBase_t)
+                                                                        : (uint16_t)itemSize;
+
+        DISPATCHER_SET_EVENT(pEvent, bare ? DISPATCHER_SIGNAL_USER : DISPATCHER_SIGNAL_USER + 1);
+        if (DISPATCHER_POST_EVENT_SIZED_FROM_ISR(&dispatcher, pEvent, size, false) != DISPATCHER_ERR_CLEAR)
+        {
+            break;
+        }
+        events++;
+    }
+
+    printf("{\"bench\":\"footprint\",\"queue\":\"%s\",\"buffer_bytes\":%u,\"storage_bytes\":%u,"
+           "\"item_size\":%u,\"bare_size\":%u,\"bare_percent\":%u,\"events\":%u}\n",
+           gQueueNames[type], bufferSize, storageSize, itemSize,
+           (unsigned)sizeof(dispatcher_eventBase_t), barePercent, events);
+    fflush(stdout);
+    ret = (int)events;
+
+cleanup:
+    free(pEvent);
+    free(eventStorage);
+    free(queueStorage);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultSizes[] = {sizeof(footprintEvent_t), 64, 256};
+    static uint32_t const defaultBare[] = {0, 50, 90, 100};
+    uint32_t const *sizes = defaultSizes, *bare = defaultBare;
+    uint32_t sizeCount = 3, bareCount = 4, size = 0, barePercent = 0;
+    uint32_t bufferSize = 1024;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:b:m:h")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            size = (uint32_t)strtoul(optarg, NULL, 0);
+            sizes = &size;
+            sizeCount = 1;
+            break;
+        case 'b':
+            bufferSize = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'm':
+            barePercent = (uint32_t)strtoul(optarg, NULL, 0);
+            bare = &barePercent;
+            bareCount = 1;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -s bytes   largest event size (default sweep 12,64,256)\n"
+                    "  -b bytes   queue storage buffer size (default 1024)\n"
+                    "  -m percent share of bare signal events (default sweep 0,50,90,100)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (barePercent > 100u || bufferSize == 0 ||
+        (sizes == &size && (size < sizeof(dispatcher_eventBase_t) || size > UINT16_MAX)))
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < sizeCount * bareCount; i++)
+    {
+        uint32_t itemSize = sizes[i / bareCount];
+        uint32_t const *pBare = &bare[i % bareCount];
+        int baseline = 0;
+
+        fprintf(stderr, "buffer=%u size=%-4u bare=%3u%% :", bufferSize, itemSize, *pBare);
+        for (uint32_t q = 0; q < DISPATCHER_QUEUE_TYPE_MAX; q++)
+        {
+            int events = FootprintRun((dispatcher_queueType_t)q, itemSize, bufferSize, *pBare);
+
+            if (events < 0)
+            {
+                fprintf(stderr, "\n%s initialization failed\n", gQueueNames[q]);
+                return 1;
+            }
+            if (q == DISPATCHER_QUEUE_TYPE_DEFAULT)
+            {
+                baseline = events;
+            }
+            fprintf(stderr, "  %s=%d", gQueueNames[q], events);
+            if (q == DISPATCHER_QUEUE_TYPE_VARIABLE && baseline != 0)
+            {
+                fprintf(stderr, " (%.2fx)", (double)events / (double)baseline);
+            }
+        }
+        fprintf(stderr, "\n");
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ *  Host hierarchical state machine benchmark : a toggle event handled by
+ *  the top state, posted while one of two leaf states is active. The
+ *  leaves sit the given number of levels below the top state on two
+ *  separate branches, so every toggle bubbles up from the leaf and exits
+ *  and enters one whole branch.
+ *
+ *  The cached mode gives the dispatcher a path cache holding both
+ *  transitions, the uncached mode a single entry the two transitions keep
+ *  replacing, so every transition asks the handlers for their superstates
+ *  again. Level 0 runs two flat states toggling each other without a
+ *  cache (the flat transition).
+ *
+ *  Every transition checks the new active state and the number and order
+ *  of EXIT / ENTRY calls, a run fails on any mismatch.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench_clock.h"
+
+#define HSM_SIGNAL_TOGGLE (DISPATCHER_SIGNAL_USER)
+#define HSM_MAX_LEVELS (DISPATCHER_HSM_MAX_DEPTH - 1)
+#define HSM_TOP (0)
+#define HSM_STATE_A(level) (level)
+#define HSM_STATE_B(level) (HSM_MAX_LEVELS + (level))
+#define HSM_STATE_COUNT (2 * HSM_MAX_LEVELS + 1)
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t levels;   /* levels of the leaves below the top state, 0 for flat. */
+    bool inA;          /* leaf of branch A active. */
+    uint32_t expected; /* next state to enter. */
+    uint32_t errors;
+    uint64_t exits;
+    uint64_t entries;
+    uint64_t queries;  /* superstate queries. */
+    uint64_t calls;    /* all handler calls. */
+} hsmDispatcher_t;
+
+static uint8_t HsmHandle(hsmDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent, uint32_t state);
+
+#define HSM_STATE(index)                                                                           \
+    static uint8_t HsmState##index(hsmDispatcher_t *const pDispatcher,                             \
+                                   dispatcher_eventBase_t const *const pEvent)                     \
+    {                                                                                              \
+        return HsmHandle(pDispatcher, pEvent, index);                                              \
+    }
+
+HSM_STATE(0)
+HSM_STATE(1)
+HSM_STATE(2)
+HSM_STATE(3)
+HSM_STATE(4)
+HSM_STATE(5)
+HSM_STATE(6)
+HSM_STATE(7)
+HSM_STATE(8)
+HSM_STATE(9)
+HSM_STATE(10)
+
+static dispatcher_stateHandler_t const gStates[HSM_STATE_COUNT] = {
+    (dispatcher_stateHandler_t)HsmState0, (dispatcher_stateHandler_t)HsmState1,
+    (dispatcher_stateHandler_t)HsmState2, (dispatcher_stateHandler_t)HsmState3,
+    (dispatcher_stateHandler_t)HsmState4, (dispatcher_stateHandler_t)HsmState5,
+    (dispatcher_stateHandler_t)HsmState6, (dispatcher_stateHandler_t)HsmState7,
+    (dispatcher_stateHandler_t)HsmState8, (dispatcher_stateHandler_t)HsmState9,
+    (dispatcher_stateHandler_t)HsmState10,
+};
+
+static uint32_t HsmLeaf(hsmDispatcher_t const *const pDispatcher, bool inA)
+{
+    uint32_t level = (pDispatcher->levels == 0) ? 1u : pDispatcher->levels;
+
+    return inA ? HSM_STATE_A(level) : HSM_STATE_B(level);
+}
+
+static uint8_t HsmHandle(hsmDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent, uint32_t state)
+{
+    uint32_t level = (state > HSM_MAX_LEVELS) ? state - HSM_MAX_LEVELS : state;
+    uint32_t parent = (level <= 1u) ? HSM_TOP : state - 1u;
+    bool flat = pDispatcher->levels == 0;
+
+    pDispatcher->calls++;
+    switch (pEvent->sig)
+    {
+    case DISPATCHER_SIGNAL_NONE:
+        pDispatcher->queries++;
+        break;
+    case DISPATCHER_SIGNAL_ENTRY:
+        pDispatcher->entries++;
+        if (state != pDispatcher->expected)
+        {
+            pDispatcher->errors++;
+        }
+        pDispatcher->expected = state + 1u;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case DISPATCHER_SIGNAL_EXIT:
+        pDispatcher->exits++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case HSM_SIGNAL_TOGGLE:
+        if (state == HSM_TOP || flat)
+        {
+            uint32_t target = HsmLeaf(pDispatcher, !pDispatcher->inA);
+
+            // the branch is entered from its first level down
+            pDispatcher->expected = flat ? target : target - pDispatcher->levels + 1u;
+            pDispatcher->inA = !pDispatcher->inA;
+            return DISPATCHER_TRANSITION(pDispatcher, gStates[target]);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (state == HSM_TOP || flat)
+    {
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+    return DISPATCHER_SUPER(pDispatcher, gStates[parent]);
+}
+
+static int HsmRun(uint32_t levels, uint8_t pathCount, uint32_t transitions)
+{
+    static uint8_t queueStorage[DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_SPSC, sizeof(dispatcher_eventBase_t), 4)]
+        __attribute__((aligned(DISPATCHER_QUEUE_ALIGN)));
+    dispatcher_path_t paths[2];
+    hsmDispatcher_t dispatcher;
+    dispatcher_eventBase_t toggle = {.sig = HSM_SIGNAL_TOGGLE};
+
+    (void)memset(&dispatcher, 0, sizeof(dispatcher));
+    dispatcher.levels = levels;
+    dispatcher.inA = true;
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(dispatcher_eventBase_t),
+        .itemCount = 4,
+        .queueStorage = queueStorage,
+        .defaultHandler = gStates[HsmLeaf(&dispatcher, true)],
+        .queueType = DISPATCHER_QUEUE_TYPE_SPSC,
+        .paths = paths,
+        .pathCount = pathCount,
+    };
+
+    dispatcher.expected = (levels == 0) ? HsmLeaf(&dispatcher, true) : HSM_TOP;
+    if (dispatcher_InitWithConfig(&dispatcher.base, &config) != DISPATCHER_ERR_CLEAR ||
+        DISPATCHER_START(&dispatcher, false) != DISPATCHER_ERR_CLEAR ||
+        dispatcher.entries != ((levels == 0) ? 1u : levels + 1u))
+    {
+        fprintf(stderr, "initialization failed\n");
+        return -1;
+    }
+    dispatcher.calls = dispatcher.queries = dispatcher.entries = 0;
+
+    uint64_t start = BenchNow();
+
+    for (uint32_t i = 0; i < transitions; i++)
+    {
+        if (DISPATCHER_POST_EVENT_FROM_ISR(&dispatcher, &toggle, false) != DISPATCHER_ERR_CLEAR ||
+            DISPATCHER_EVENT_LOOP(&dispatcher) != DISPATCHER_ERR_CLEAR)
+        {
+            fprintf(stderr, "transition %u failed\n", i);
+            return -1;
+        }
+        if (dispatcher.base.active != gStates[HsmLeaf(&dispatcher, dispatcher.inA)])
+        {
+            dispatcher.errors++;
+        }
+    }
+
+    uint64_t elapsed = BenchNow() - start;
+    uint32_t chain = (levels == 0) ? 1u : levels;
+    char const *mode = (levels == 0) ? "flat" : (pathCount > 1) ? "cached" : "uncached";
+
+    if (dispatcher.exits != (uint64_t)chain * transitions || dispatcher.entries != (uint64_t)chain * transitions)
+    {
+        dispatcher.errors++;
+    }
+
+    printf("{\"bench\":\"hsm\",\"mode\":\"%s\",\"levels\":%u,\"transitions\":%u,\"ns_per_transition\":%.1f,"
+           "\"calls_per_transition\":%.2f,\"queries_per_transition\":%.2f,\"errors\":%u}\n",
+           mode, levels, transitions, (double)elapsed / transitions, (double)dispatcher.calls / transitions,
+           (double)dispatcher.queries / transitions, dispatcher.errors);
+    fflush(stdout);
+    fprintf(stderr, "%-8s levels=%u %8.1f ns/transition calls=%6.2f queries=%6.2f%s\n",
+            mode, levels, (double)elapsed / transitions, (double)dispatcher.calls / transitions,
+            (double)dispatcher.queries / transitions, dispatcher.errors ? " ERRORS" : "");
+    return (dispatcher.errors == 0) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultLevels[] = {1, 2, 3, HSM_MAX_LEVELS};
+    uint32_t const *levels = defaultLevels;
+    uint32_t levelCount = 4, level = 0, transitions = 1000000;
+    int option;
+
+    while ((option = getopt(argc, argv, "l:n:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'l':
+            level = (uint32_t)strtoul(optarg, NULL, 0);
+            levels = &level;
+            levelCount = 1;
+            break;
+        case 'n':
+            transitions = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -l levels  leaf levels below the top state, 1 - %u (default sweep 1,2,3,%u)\n"
+                    "  -n count   transitions per run (default 1000000)\n",
+                    argv[0], HSM_MAX_LEVELS, HSM_MAX_LEVELS);
+            return 1;
+        }
+    }
+
+    if (transitions == 0 || level > HSM_MAX_LEVELS || (levels == &level && level == 0))
+    {
+        return 1;
+    }
+
+    if (HsmRun(0, 0, transitions) != 0)
+    {
+        return 1;
+    }
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        if (HsmRun(levels[i], 1, transitions) != 0 || HsmRun(levels[i], 2, transitions) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
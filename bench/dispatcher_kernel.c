@@ -0,0 +1,345 @@
+/*
+ *  Host cooperative kernel benchmark : a pipeline of state machines, every
+ *  stage forwards the event to the next one and the last stage counts it.
+ *  The producer (main thread) keeps the given number of events in flight.
+ *
+ *  The task mode runs every stage dispatcher on a thread of its own (the
+ *  task per dispatcher model), the kernel mode attaches all of them to one
+ *  dispatcher_kernel_t running on a single thread, later stages have the
+ *  higher priority.
+ *
+ *  Every run reports the time per event, the context switches of the whole
+ *  process per event (getrusage) and the stack the model reserves for its
+ *  tasks. The last stage checks every event arrived once and in order, a
+ *  run fails otherwise.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include "bench_clock.h"
+
+#define KERNEL_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define KERNEL_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + 1)
+#define KERNEL_DEPTH (64)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+} kernelEvent_t;
+
+typedef struct kernelStage
+{
+    dispatcher_base_t base;
+
+    struct kernelStage *pNext; /* next stage, NULL for the last one. */
+    uint8_t *queueStorage;
+    uint8_t *eventStorage;
+    uint32_t expected;         /* next sequence number (last stage). */
+    uint32_t reordered;
+    uint32_t lost;             /* forwards which found the next queue full. */
+    uint32_t *pCompleted;      /* events through the whole pipeline. */
+    uint32_t *pDone;           /* stages which got the done event. */
+    bool done;
+    pthread_t thread;
+} kernelStage_t;
+
+static char const *const gQueueNames[DISPATCHER_QUEUE_TYPE_MAX] = {
+    [DISPATCHER_QUEUE_TYPE_DEFAULT] = "default",
+    [DISPATCHER_QUEUE_TYPE_SPSC] = "spsc",
+    [DISPATCHER_QUEUE_TYPE_MPSC] = "mpsc",
+    [DISPATCHER_QUEUE_TYPE_VARIABLE] = "var",
+};
+
+static uint64_t KernelSwitches(void)
+{
+    struct rusage usage;
+
+    (void)getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_nvcsw + (uint64_t)usage.ru_nivcsw;
+}
+
+static uint8_t KernelStage(kernelStage_t *const pStage, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case KERNEL_SIGNAL_DATA:
+    {
+        kernelEvent_t const *pData = (kernelEvent_t const *)pEvent;
+
+        if (pStage->pNext != NULL)
+        {
+            // never blocks, the producer window is below the queue depth
+            if (DISPATCHER_POST_EVENT_FROM_ISR(pStage->pNext, pEvent, false) != DISPATCHER_ERR_CLEAR)
+            {
+                pStage->lost++;
+            }
+            return DISPATCHER_SM_STATUS_HANDLED;
+        }
+        if (pData->seq != pStage->expected)
+        {
+            pStage->reordered++;
+        }
+        pStage->expected = pData->seq + 1u;
+        (void)__atomic_fetch_add(pStage->pCompleted, 1u, __ATOMIC_RELEASE);
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    case KERNEL_SIGNAL_DONE:
+        pStage->done = true;
+        (void)__atomic_fetch_add(pStage->pDone, 1u, __ATOMIC_RELAXED);
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static void *KernelTaskLoop(void *pArg)
+{
+    kernelStage_t *pStage = pArg;
+
+    while (!pStage->done)
+    {
+        (void)DISPATCHER_EVENT_LOOP_BATCH(pStage, 32, 0, NULL);
+    }
+    return NULL;
+}
+
+typedef struct
+{
+    dispatcher_kernel_t *pKernel;
+    uint32_t *pDone;
+    uint32_t stages;
+} kernelTask_t;
+
+static void *KernelKernelLoop(void *pArg)
+{
+    kernelTask_t *pTask = pArg;
+
+    while (__atomic_load_n(pTask->pDone, __ATOMIC_RELAXED) < pTask->stages)
+    {
+        (void)DISPATCHER_KERNEL_LOOP(pTask->pKernel, 32, NULL);
+    }
+    return NULL;
+}
+
+static int KernelRun(dispatcher_queueType_t type, uint32_t stages, uint32_t events, uint32_t window,
+                     uint32_t stackSize, bool kernel)
+{
+    kernelStage_t *pStages = calloc(stages, sizeof(kernelStage_t));
+    static dispatcher_kernel_t gKernel;
+    uint32_t completed = 0, done = 0;
+    kernelTask_t task = {.pKernel = &gKernel, .pDone = &done, .stages = stages};
+    pthread_t thread;
+    pthread_attr_t attr;
+    int ret = -1;
+
+    (void)pthread_attr_init(&attr);
+    (void)pthread_attr_setstacksize(&attr, (stackSize < PTHREAD_STACK_MIN) ? PTHREAD_STACK_MIN : stackSize);
+
+    if (pStages == NULL || (kernel && dispatcher_KernelInit(&gKernel) != DISPATCHER_ERR_CLEAR))
+    {
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < stages; i++)
+    {
+        kernelStage_t *pStage = &pStages[i];
+
+        pStage->pNext = (i + 1u < stages) ? &pStages[i + 1u] : NULL;
+        pStage->pCompleted = &completed;
+        pStage->pDone = &done;
+        pStage->queueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                             DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(type, sizeof(kernelEvent_t), KERNEL_DEPTH)));
+        pStage->eventStorage = calloc(1, sizeof(kernelEvent_t));
+
+        dispatcher_config_t config = {
+            .itemSize = sizeof(kernelEvent_t),
+            .itemCount = KERNEL_DEPTH,
+            .queueStorage = pStage->queueStorage,
+            .eventStorage = pStage->eventStorage,
+            .defaultHandler = (dispatcher_stateHandler_t)KernelStage,
+            .queueType = type,
+        };
+
+        if (pStage->queueStorage == NULL || pStage->eventStorage == NULL ||
+            dispatcher_InitWithConfig(&pStage->base, &config) != DISPATCHER_ERR_CLEAR ||
+            (kernel && dispatcher_KernelAttach(&gKernel, &pStage->base, (uint8_t)i) != DISPATCHER_ERR_CLEAR))
+        {
+            fprintf(stderr, "initialization failed\n");
+            goto cleanup;
+        }
+    }
+
+    uint64_t switches = KernelSwitches();
+    uint64_t start = BenchNow();
+
+    if (kernel)
+    {
+        (void)pthread_create(&thread, &attr, KernelKernelLoop, &task);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < stages; i++)
+        {
+            (void)pthread_create(&pStages[i].thread, &attr, KernelTaskLoop, &pStages[i]);
+        }
+    }
+
+    for (uint32_t seq = 0; seq < events; seq++)
+    {
+        kernelEvent_t event = {.seq = seq};
+
+        while (seq - __atomic_load_n(&completed, __ATOMIC_ACQUIRE) >= window)
+        {
+            (void)sched_yield();
+        }
+        DISPATCHER_SET_EVENT(&event, KERNEL_SIGNAL_DATA);
+        while (DISPATCHER_POST_EVENT_FROM_ISR(&pStages[0], &event, false) != DISPATCHER_ERR_CLEAR)
+        {
+            (void)sched_yield();
+        }
+    }
+    while (__atomic_load_n(&completed, __ATOMIC_ACQUIRE) < events)
+    {
+        (void)sched_yield();
+    }
+
+    uint64_t elapsed = BenchNow() - start;
+
+    switches = KernelSwitches() - switches;
+    for (uint32_t i = 0; i < stages; i++)
+    {
+        kernelEvent_t event = {0};
+
+        DISPATCHER_SET_EVENT(&event, KERNEL_SIGNAL_DONE);
+        while (DISPATCHER_POST_EVENT_FROM_ISR(&pStages[i], &event, false) != DISPATCHER_ERR_CLEAR)
+        {
+            (void)sched_yield();
+        }
+    }
+    if (kernel)
+    {
+        (void)pthread_join(thread, NULL);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < stages; i++)
+        {
+            (void)pthread_join(pStages[i].thread, NULL);
+        }
+    }
+
+    uint32_t lost = 0;
+    uint32_t tasks = kernel ? 1u : stages;
+    kernelStage_t const *pLast = &pStages[stages - 1u];
+
+    for (uint32_t i = 0; i < stages; i++)
+    {
+        lost += pStages[i].lost;
+    }
+
+    printf("{\"bench\":\"kernel\",\"mode\":\"%s\",\"queue\":\"%s\",\"stages\":%u,\"events\":%u,\"window\":%u,"
+           "\"ns_per_event\":%.1f,\"switches_per_event\":%.2f,\"tasks\":%u,\"stack_bytes\":%u,"
+           "\"kernel_bytes\":%u,\"reordered\":%u,\"lost\":%u}\n",
+           kernel ? "kernel" : "task", gQueueNames[type], stages, events, window, (double)elapsed / events,
+           (double)switches / events, tasks, tasks * stackSize,
+           kernel ? (uint32_t)sizeof(dispatcher_kernel_t) : 0u, pLast->reordered, lost);
+    fflush(stdout);
+    fprintf(stderr, "%-6s %-7s stages=%-2u window=%-3u %9.1f ns/event switches=%6.2f/event tasks=%-2u stack=%6u B%s\n",
+            kernel ? "kernel" : "task", gQueueNames[type], stages, window, (double)elapsed / events,
+            (double)switches / events, tasks, tasks * stackSize,
+            (pLast->reordered != 0 || lost != 0 || pLast->expected != events) ? " ERRORS" : "");
+    ret = (pLast->reordered == 0 && lost == 0 && pLast->expected == events) ? 0 : -1;
+
+cleanup:
+    for (uint32_t i = 0; pStages != NULL && i < stages; i++)
+    {
+        free(pStages[i].queueStorage);
+        free(pStages[i].eventStorage);
+    }
+    free(pStages);
+    (void)pthread_attr_destroy(&attr);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultStages[] = {1, 4, 16, 32};
+    uint32_t const *stages = defaultStages;
+    uint32_t stageCount = 4, stage = 0, events = 100000, window = 1, stackSize = 4096;
+    dispatcher_queueType_t type = DISPATCHER_QUEUE_TYPE_MPSC;
+    int option;
+
+    while ((option = getopt(argc, argv, "d:n:w:s:q:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'd':
+            stage = (uint32_t)strtoul(optarg, NULL, 0);
+            stages = &stage;
+            stageCount = 1;
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            window = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            stackSize = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            type = DISPATCHER_QUEUE_TYPE_MAX;
+            for (uint32_t q = 0; q < DISPATCHER_QUEUE_TYPE_MAX; q++)
+            {
+                if (strcmp(optarg, gQueueNames[q]) == 0)
+                {
+                    type = (dispatcher_queueType_t)q;
+                }
+            }
+            // spsc has one producer, the done events come from the main thread
+            if (type == DISPATCHER_QUEUE_TYPE_MAX || type == DISPATCHER_QUEUE_TYPE_SPSC)
+            {
+                fprintf(stderr, "unsupported queue %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -d stages  pipeline stages, 1 - %u (default sweep 1,4,16,32)\n"
+                    "  -n count   events per run (default 100000)\n"
+                    "  -w events  events in flight, 1 - %u (default 1)\n"
+                    "  -s bytes   stack reserved per task (default 4096)\n"
+                    "  -q queue   default|mpsc|var (default mpsc)\n",
+                    argv[0], DISPATCHER_KERNEL_MAX_DISPATCHERS, KERNEL_DEPTH);
+            return 1;
+        }
+    }
+
+    if (events == 0 || window == 0 || window > KERNEL_DEPTH ||
+        (stages == &stage && (stage == 0 || stage > DISPATCHER_KERNEL_MAX_DISPATCHERS)))
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < stageCount; i++)
+    {
+        if (KernelRun(type, stages[i], events, window, stackSize, false) != 0 ||
+            KernelRun(type, stages[i], events, window, stackSize, true) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,391 @@
+/*
+ *  Host priority lane benchmark : latency of an urgent event posted behind
+ *  a backlog of telemetry events, on a dispatcher with one extra priority
+ *  lane (dispatcher_PostPriority) and on the same dispatcher posting the
+ *  urgent event to its own queue (FIFO baseline).
+ *
+ *  Inline runs (default) queue the backlog, post the urgent event and then
+ *  drain on the same thread, the latency is the time from the urgent post
+ *  to its handler. Every telemetry handler spins for the given work time.
+ *  With -T a producer thread streams telemetry and urgent events while the
+ *  event loop runs on its own thread, every lane is checked for loss and
+ *  reordering.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include "bench_clock.h"
+
+#define LANES_SIGNAL_TELEMETRY (DISPATCHER_SIGNAL_USER)
+#define LANES_SIGNAL_URGENT (DISPATCHER_SIGNAL_USER + 1)
+#define LANES_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + 2)
+#define LANES_URGENT_DEPTH (8)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+    uint32_t posted; /* post time in ns, wraps (ring slots are only 4 byte aligned). */
+} lanesEvent_t;
+
+typedef struct
+{
+    uint32_t backlog;  /* telemetry events queued before the urgent one. */
+    uint32_t workNs;   /* telemetry handler cost. */
+    uint32_t runs;     /* urgent events measured per config. */
+    dispatcher_queueType_t queueType;
+    bool lanes;        /* urgent event through the priority lane. */
+} lanesConfig_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t workNs;
+    uint32_t expected[2]; /* next sequence number, telemetry and urgent. */
+    uint32_t reordered;
+    uint32_t handled;     /* telemetry events handled before the urgent one. */
+    uint64_t latency;     /* ns from urgent post to urgent handler. */
+    bool urgent;
+    bool done;
+} lanesDispatcher_t;
+
+static char const *const gQueueNames[DISPATCHER_QUEUE_TYPE_MAX] = {
+    [DISPATCHER_QUEUE_TYPE_DEFAULT] = "default",
+    [DISPATCHER_QUEUE_TYPE_SPSC] = "spsc",
+    [DISPATCHER_QUEUE_TYPE_MPSC] = "mpsc",
+    [DISPATCHER_QUEUE_TYPE_VARIABLE] = "var",
+};
+
+static uint8_t LanesHandler(lanesDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    lanesEvent_t const *pData = (lanesEvent_t const *)pEvent;
+
+    switch (pEvent->sig)
+    {
+    case LANES_SIGNAL_TELEMETRY:
+    case LANES_SIGNAL_URGENT:
+    {
+        uint32_t lane = pEvent->sig - LANES_SIGNAL_TELEMETRY;
+
+        if (pData->seq != pDispatcher->expected[lane])
+        {
+            pDispatcher->reordered++;
+        }
+        pDispatcher->expected[lane] = pData->seq + 1u;
+
+        if (lane == 0)
+        {
+            uint64_t until = BenchNow() + pDispatcher->workNs;
+
+            while (BenchNow() < until)
+            {
+            }
+            if (!pDispatcher->urgent)
+            {
+                pDispatcher->handled++;
+            }
+        }
+        else
+        {
+            pDispatcher->latency = (uint32_t)BenchNow() - pData->posted;
+            pDispatcher->urgent = true;
+        }
+        break;
+    }
+    case LANES_SIGNAL_DONE:
+        pDispatcher->done = true;
+        break;
+    default:
+        break;
+    }
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+static void *LanesLoop(void *pArg)
+{
+    lanesDispatcher_t *pDispatcher = pArg;
+
+    while (!pDispatcher->done)
+    {
+        (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, 32, 0, NULL);
+    }
+    return NULL;
+}
+
+static int LanesCompare(void const *pA, void const *pB)
+{
+    uint64_t a = *(uint64_t const *)pA, b = *(uint64_t const *)pB;
+
+    return (a > b) - (a < b);
+}
+
+static int LanesInit(lanesDispatcher_t *pDispatcher,
+                     lanesConfig_t const *pConfig,
+                     uint32_t depth,
+                     dispatcher_lane_t *pLane,
+                     uint8_t **ppStorage)
+{
+    uint32_t storageSize = DISPATCHER_QUEUE_STORAGE_SIZE(pConfig->queueType, sizeof(lanesEvent_t), depth);
+    uint32_t laneSize = DISPATCHER_QUEUE_STORAGE_SIZE(pConfig->queueType, sizeof(lanesEvent_t), LANES_URGENT_DEPTH);
+
+    ppStorage[0] = aligned_alloc(DISPATCHER_QUEUE_ALIGN, DISPATCHER_QUEUE_ALIGN_UP(storageSize));
+    ppStorage[1] = aligned_alloc(DISPATCHER_QUEUE_ALIGN, DISPATCHER_QUEUE_ALIGN_UP(laneSize));
+    ppStorage[2] = calloc(1, sizeof(lanesEvent_t));
+    if (ppStorage[0] == NULL || ppStorage[1] == NULL || ppStorage[2] == NULL)
+    {
+        return -1;
+    }
+
+    pLane->itemCount = LANES_URGENT_DEPTH;
+    pLane->queueStorage = ppStorage[1];
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(lanesEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = ppStorage[0],
+        .eventStorage = ppStorage[2],
+        .defaultHandler = (dispatcher_stateHandler_t)LanesHandler,
+        .queueType = pConfig->queueType,
+        .lanes = pConfig->lanes ? pLane : NULL,
+        .laneCount = pConfig->lanes ? 1 : 0,
+    };
+
+    (void)memset(pDispatcher, 0, sizeof(*pDispatcher));
+    pDispatcher->workNs = pConfig->workNs;
+    return (dispatcher_InitWithConfig(&pDispatcher->base, &config) == DISPATCHER_ERR_CLEAR) ? 0 : -1;
+}
+
+static uint8_t LanesPost(lanesDispatcher_t *pDispatcher, lanesConfig_t const *pConfig, uint32_t sig, uint32_t seq)
+{
+    lanesEvent_t event = {.seq = seq};
+
+    DISPATCHER_SET_EVENT(&event, sig);
+    event.posted = (uint32_t)BenchNow();
+    if (sig == LANES_SIGNAL_URGENT && pConfig->lanes)
+    {
+        return DISPATCHER_POST_EVENT_PRIORITY_FROM_ISR(pDispatcher, &event, 1, false);
+    }
+    return DISPATCHER_POST_EVENT_FROM_ISR(pDispatcher, &event, false);
+}
+
+static int LanesRunInline(lanesConfig_t const *pConfig)
+{
+    lanesDispatcher_t dispatcher;
+    dispatcher_lane_t lane;
+    uint8_t *storage[3] = {NULL, NULL, NULL};
+    uint64_t *latencies = calloc(pConfig->runs, sizeof(uint64_t));
+    uint32_t depth = 1, telemetry = 0;
+    uint64_t handledSum = 0;
+    int ret = -1;
+
+    while (depth < pConfig->backlog + 1u)
+    {
+        depth <<= 1;
+    }
+
+    if (latencies == NULL || LanesInit(&dispatcher, pConfig, depth, &lane, storage) != 0)
+    {
+        fprintf(stderr, "initialization failed\n");
+        goto cleanup;
+    }
+
+    for (uint32_t run = 0; run < pConfig->runs; run++)
+    {
+        for (uint32_t i = 0; i < pConfig->backlog; i++)
+        {
+            if (LanesPost(&dispatcher, pConfig, LANES_SIGNAL_TELEMETRY, telemetry) != DISPATCHER_ERR_CLEAR)
+            {
+                fprintf(stderr, "backlog post failed\n");
+                goto cleanup;
+            }
+            telemetry++;
+        }
+
+        dispatcher.urgent = false;
+        dispatcher.handled = 0;
+        if (LanesPost(&dispatcher, pConfig, LANES_SIGNAL_URGENT, run) != DISPATCHER_ERR_CLEAR)
+        {
+            fprintf(stderr, "urgent post failed\n");
+            goto cleanup;
+        }
+
+        while (!dispatcher.urgent)
+        {
+            (void)DISPATCHER_EVENT_LOOP(&dispatcher);
+        }
+        latencies[run] = dispatcher.latency;
+        handledSum += dispatcher.handled;
+
+        while (dispatcher.expected[0] != telemetry)
+        {
+            (void)DISPATCHER_EVENT_LOOP_BATCH(&dispatcher, 64, 0, NULL);
+        }
+    }
+
+    qsort(latencies, pConfig->runs, sizeof(uint64_t), LanesCompare);
+
+    uint64_t p50 = latencies[pConfig->runs / 2];
+    uint64_t p99 = latencies[(pConfig->runs * 99u) / 100u];
+
+    printf("{\"bench\":\"lanes\",\"queue\":\"%s\",\"mode\":\"%s\",\"backlog\":%u,\"work_ns\":%u,"
+           "\"runs\":%u,\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,\"ahead\":%.1f,\"reordered\":%u}\n",
+           gQueueNames[pConfig->queueType], pConfig->lanes ? "lane" : "fifo", pConfig->backlog,
+           pConfig->workNs, pConfig->runs, (unsigned long long)p50, (unsigned long long)p99,
+           (unsigned long long)latencies[pConfig->runs - 1u], (double)handledSum / (double)pConfig->runs,
+           dispatcher.reordered);
+    fflush(stdout);
+
+    fprintf(stderr, "%-7s %-4s backlog=%-4u p50=%9.2f us p99=%9.2f us ahead=%6.1f%s\n",
+            gQueueNames[pConfig->queueType], pConfig->lanes ? "lane" : "fifo", pConfig->backlog,
+            (double)p50 / 1000.0, (double)p99 / 1000.0, (double)handledSum / (double)pConfig->runs,
+            dispatcher.reordered ? " REORDERED" : "");
+    ret = (dispatcher.reordered == 0) ? 0 : -1;
+
+cleanup:
+    free(latencies);
+    free(storage[0]);
+    free(storage[1]);
+    free(storage[2]);
+    return ret;
+}
+
+static int LanesRunThreaded(lanesConfig_t const *pConfig)
+{
+    lanesDispatcher_t dispatcher;
+    dispatcher_lane_t lane;
+    uint8_t *storage[3] = {NULL, NULL, NULL};
+    uint32_t telemetry = 0, urgent = 0;
+    pthread_t thread;
+    int ret = -1;
+
+    if (LanesInit(&dispatcher, pConfig, 64, &lane, storage) != 0 ||
+        pthread_create(&thread, NULL, LanesLoop, &dispatcher) != 0)
+    {
+        fprintf(stderr, "initialization failed\n");
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < pConfig->runs * (pConfig->backlog + 1u); i++)
+    {
+        bool isUrgent = (i % (pConfig->backlog + 1u)) == pConfig->backlog;
+        uint32_t *pSeq = isUrgent ? &urgent : &telemetry;
+
+        while (LanesPost(&dispatcher, pConfig, isUrgent ? LANES_SIGNAL_URGENT : LANES_SIGNAL_TELEMETRY, *pSeq) !=
+               DISPATCHER_ERR_CLEAR)
+        {
+            (void)sched_yield();
+        }
+        (*pSeq)++;
+    }
+
+    lanesEvent_t done = {0};
+    DISPATCHER_SET_EVENT(&done, LANES_SIGNAL_DONE);
+    while (DISPATCHER_POST_EVENT_FROM_ISR(&dispatcher, &done, false) != DISPATCHER_ERR_CLEAR)
+    {
+        (void)sched_yield();
+    }
+    (void)pthread_join(thread, NULL);
+
+    bool lost = dispatcher.expected[0] != telemetry || dispatcher.expected[1] != urgent;
+
+    printf("{\"bench\":\"lanes_threaded\",\"queue\":\"%s\",\"mode\":\"%s\",\"telemetry\":%u,\"urgent\":%u,"
+           "\"lost\":%s,\"reordered\":%u}\n",
+           gQueueNames[pConfig->queueType], pConfig->lanes ? "lane" : "fifo", telemetry, urgent,
+           lost ? "true" : "false", dispatcher.reordered);
+    fflush(stdout);
+    fprintf(stderr, "%-7s %-4s threaded telemetry=%u urgent=%u%s%s\n",
+            gQueueNames[pConfig->queueType], pConfig->lanes ? "lane" : "fifo", telemetry, urgent,
+            lost ? " LOST" : "", dispatcher.reordered ? " REORDERED" : "");
+    ret = (!lost && dispatcher.reordered == 0) ? 0 : -1;
+
+cleanup:
+    free(storage[0]);
+    free(storage[1]);
+    free(storage[2]);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultBacklogs[] = {0, 16, 64, 256};
+    uint32_t const *backlogs = defaultBacklogs;
+    uint32_t backlogCount = 4, backlog = 0;
+    lanesConfig_t config = {
+        .workNs = 1000,
+        .runs = 200,
+        .queueType = DISPATCHER_QUEUE_TYPE_MPSC,
+    };
+    bool threaded = false;
+    int option;
+
+    while ((option = getopt(argc, argv, "b:w:n:q:Th")) != -1)
+    {
+        switch (option)
+        {
+        case 'b':
+            backlog = (uint32_t)strtoul(optarg, NULL, 0);
+            backlogs = &backlog;
+            backlogCount = 1;
+            break;
+        case 'w':
+            config.workNs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            config.runs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            config.queueType = DISPATCHER_QUEUE_TYPE_MAX;
+            for (uint32_t q = 0; q < DISPATCHER_QUEUE_TYPE_MAX; q++)
+            {
+                if (strcmp(optarg, gQueueNames[q]) == 0)
+                {
+                    config.queueType = (dispatcher_queueType_t)q;
+                }
+            }
+            if (config.queueType == DISPATCHER_QUEUE_TYPE_MAX)
+            {
+                fprintf(stderr, "unknown queue %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'T':
+            threaded = true;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -b events  telemetry backlog ahead of the urgent event (default sweep 0,16,64,256)\n"
+                    "  -w ns      telemetry handler work (default 1000)\n"
+                    "  -n runs    urgent events per config (default 200)\n"
+                    "  -q queue   default|spsc|mpsc|var (default mpsc)\n"
+                    "  -T         producer and event loop on separate threads\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.runs == 0 || backlog >= UINT16_MAX)
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < backlogCount * 2u; i++)
+    {
+        config.backlog = backlogs[i / 2u];
+        config.lanes = (i % 2u) != 0;
+        if ((threaded ? LanesRunThreaded(&config) : LanesRunInline(&config)) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+/*
+ *  Host logging benchmark : producer threads log an error line per call
+ *  with DISPATCHER_LOG_ERROR, as dispatcher_Post does for every rejected
+ *  post under overload, and report how long the calls took in the
+ *  producer context.
+ *
+ *  Built with DISPATCHER_LOG_DEFERRED the calls only store a record, a
+ *  drain thread formats them through a sink and checks every line (per
+ *  producer order, arguments) and that drained plus lost records add up to
+ *  the calls made. Without it every call formats and writes to stderr at
+ *  once (sent to /dev/null during the run, -o picks another file), running
+ *  both builds compares the two. Both builds check dispatcher_LogFormat
+ *  against snprintf first.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench_clock.h"
+
+#define LOG_MAX_PRODUCERS (16)
+
+static char const *TAG = "bench";
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t calls;
+    uint32_t *pLatency;
+} logProducer_t;
+
+typedef struct
+{
+    uint32_t lines;
+    uint32_t lostLines;
+    uint32_t bad;
+    uint32_t last[LOG_MAX_PRODUCERS];
+} logSink_t;
+
+static volatile bool gDone = false;
+
+static int LogCompare(void const *pA, void const *pB)
+{
+    uint32_t a = *(uint32_t const *)pA, b = *(uint32_t const *)pB;
+
+    return (a > b) - (a < b);
+}
+
+/* every conversion the formatter supports against the C library. */
+static uint32_t LogFormatCheck(void)
+{
+    static char const *const formats[] = {"%d,%u", "%5d|%-5u|%05x", "%X %o %c", "%s and %%", "%ld %lu",
+                                          "%lld %llx", "no args", "%d %d %d %d", "%+d % d %#x"};
+    uintptr_t args[DISPATCHER_LOG_MAX_ARGS] = {(uintptr_t)-42, 17, 0x2af, 'z'};
+    uint32_t failed = 0;
+
+    for (uint32_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        dispatcher_logRecord_t record = {
+            .tick = 1234, .level = DISPATCHER_LOG_LEVEL_ERROR, .argCount = DISPATCHER_LOG_MAX_ARGS, .tag = TAG,
+            .format = formats[i]};
+        char line[DISPATCHER_LOG_LINE_SIZE], expected[DISPATCHER_LOG_LINE_SIZE];
+        int prefix = snprintf(expected, sizeof(expected), "E (1234) %s: ", TAG);
+
+        (void)memcpy(record.args, args, sizeof(args));
+        if (i == 3)
+        {
+            record.args[0] = (uintptr_t) "text";
+        }
+
+        char *pOut = expected + prefix;
+        size_t room = sizeof(expected) - (size_t)prefix;
+
+        switch (i)
+        {
+        case 0:
+            (void)snprintf(pOut, room, formats[i], -42, 17u);
+            break;
+        case 1:
+            (void)snprintf(pOut, room, formats[i], -42, 17u, 0x2afu);
+            break;
+        case 2:
+            (void)snprintf(pOut, room, formats[i], (unsigned)-42, 17u, 0x2af);
+            break;
+        case 3:
+            (void)snprintf(pOut, room, formats[i], "text");
+            break;
+        case 4:
+            (void)snprintf(pOut, room, formats[i], -42L, 17UL);
+            break;
+        case 5:
+            (void)snprintf(pOut, room, formats[i], -42LL, 17ULL);
+            break;
+        case 6:
+            (void)snprintf(pOut, room, "%s", formats[i]);
+            break;
+        case 7:
+            (void)snprintf(pOut, room, formats[i], -42, 17, 0x2af, 'z');
+            break;
+        default:
+            (void)snprintf(pOut, room, formats[i], -42, 17, 0x2af);
+            break;
+        }
+
+        uint32_t length = dispatcher_LogFormat(&record, line, sizeof(line));
+
+        if (strcmp(line, expected) != 0 || length != strlen(expected))
+        {
+            fprintf(stderr, "  format \"%s\": got \"%s\" expected \"%s\"\n", formats[i], line, expected);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+static void *LogProduce(void *pArg)
+{
+    logProducer_t *pProducer = pArg;
+
+    for (uint32_t seq = 1; seq <= pProducer->calls; seq++)
+    {
+        uint64_t start = BenchNow();
+
+        DISPATCHER_LOG_ERROR(TAG, "%u,%u,post failed,error %d", pProducer->producer, seq, DISPATCHER_ERR_QUEUE_FULL);
+        pProducer->pLatency[seq - 1u] = (uint32_t)(BenchNow() - start);
+    }
+    return NULL;
+}
+
+static void LogSinkLine(uint8_t level, char const *pLine, void *pArg)
+{
+    logSink_t *pSink = pArg;
+    char const *pMessage = strstr(pLine, ": ");
+    unsigned producer, seq;
+    int error;
+
+    if (level == DISPATCHER_LOG_LEVEL_ERROR && pMessage != NULL && strstr(pMessage, "log records lost") != NULL)
+    {
+        pSink->lostLines++;
+        return;
+    }
+    if (level != DISPATCHER_LOG_LEVEL_ERROR || pMessage == NULL || strncmp(pLine, "E (", 3) != 0 ||
+        sscanf(pMessage + 2, "%u,%u,post failed,error %d", &producer, &seq, &error) != 3 ||
+        producer >= LOG_MAX_PRODUCERS || error != DISPATCHER_ERR_QUEUE_FULL || seq <= pSink->last[producer])
+    {
+        pSink->bad++;
+        return;
+    }
+    pSink->last[producer] = seq;
+    pSink->lines++;
+}
+
+static void *LogDrainTask(void *pArg)
+{
+    logSink_t *pSink = pArg;
+    uint16_t count = 1;
+
+    // the last pass runs after the producers are done and takes what is left
+    while (!gDone || count != 0)
+    {
+        (void)dispatcher_LogDrain(LogSinkLine, pSink, 10, &count);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t producers = 1, calls = 100000, ring = 1024;
+    char const *pOutPath = "/dev/null";
+    int option;
+
+    while ((option = getopt(argc, argv, "p:n:r:o:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'p':
+            producers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            calls = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            ring = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            pOutPath = optarg;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -p count   producer threads (default 1)\n"
+                    "  -n count   log calls per producer (default 100000)\n"
+                    "  -r count   deferred log records, power of two (default 1024)\n"
+                    "  -o file    where direct log lines go during the run (default /dev/null)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (producers == 0 || producers > LOG_MAX_PRODUCERS || calls == 0 || ring == 0 ||
+        (ring & (ring - 1u)) != 0 || ring > UINT16_MAX)
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    uint32_t formatFailed = LogFormatCheck();
+    uint8_t *pStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN, DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_LOG_STORAGE_SIZE(ring)));
+    uint32_t *pLatency = malloc((size_t)producers * calls * sizeof(uint32_t));
+    uint8_t init = (pStorage != NULL) ? dispatcher_LogInit(pStorage, (uint16_t)ring) : DISPATCHER_ERR_NULL_PTR;
+    bool deferred = init == DISPATCHER_ERR_CLEAR;
+
+    if (pLatency == NULL || (!deferred && init != DISPATCHER_ERR_NOT_SUPPORTED))
+    {
+        fprintf(stderr, "initialization failed\n");
+        free(pStorage);
+        free(pLatency);
+        return 1;
+    }
+
+    // direct lines must not reach the terminal, stderr is restored for the summary
+    int savedErr = dup(STDERR_FILENO);
+    int out = open(pOutPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (savedErr < 0 || out < 0)
+    {
+        perror(pOutPath);
+        free(pStorage);
+        free(pLatency);
+        return 1;
+    }
+
+    static logSink_t gSink;
+    pthread_t drain;
+    pthread_t threads[LOG_MAX_PRODUCERS];
+    logProducer_t producer[LOG_MAX_PRODUCERS];
+    uint64_t start = BenchNow();
+
+    (void)dup2(out, STDERR_FILENO);
+    if (deferred)
+    {
+        (void)pthread_create(&drain, NULL, LogDrainTask, &gSink);
+    }
+    for (uint32_t i = 0; i < producers; i++)
+    {
+        producer[i] = (logProducer_t){.producer = i, .calls = calls, .pLatency = &pLatency[(size_t)i * calls]};
+        (void)pthread_create(&threads[i], NULL, LogProduce, &producer[i]);
+    }
+    for (uint32_t i = 0; i < producers; i++)
+    {
+        (void)pthread_join(threads[i], NULL);
+    }
+    uint64_t produced = BenchNow() - start;
+
+    gDone = true;
+    if (deferred)
+    {
+        (void)pthread_join(drain, NULL);
+    }
+    uint64_t drained = BenchNow() - start;
+
+    (void)fflush(stderr);
+    (void)dup2(savedErr, STDERR_FILENO);
+    (void)close(savedErr);
+    (void)close(out);
+
+    uint32_t total = producers * calls;
+    uint32_t dropped = dispatcher_LogDropped();
+
+    qsort(pLatency, total, sizeof(uint32_t), LogCompare);
+
+    bool errors = formatFailed != 0 ||
+                  (deferred && (gSink.bad != 0 || gSink.lines + dropped != total || (dropped != 0) != (gSink.lostLines != 0)));
+
+    printf("{\"bench\":\"log\",\"mode\":\"%s\",\"producers\":%u,\"calls\":%u,\"ring\":%u,\"call_mean_ns\":%.1f,"
+           "\"call_p50_ns\":%u,\"call_p99_ns\":%u,\"call_max_ns\":%u,\"drain_ms\":%.2f,\"drained\":%u,\"dropped\":%u,"
+           "\"bad_lines\":%u,\"format_failed\":%u}\n",
+           deferred ? "deferred" : "direct", producers, calls, ring, (double)produced * producers / total,
+           pLatency[total / 2u], pLatency[(uint64_t)total * 99u / 100u], pLatency[total - 1u],
+           (double)drained / 1e6, gSink.lines, dropped, gSink.bad, formatFailed);
+    fprintf(stderr, "%-8s producers=%u call p50 %6u ns p99 %7u ns max %8u ns drained=%u dropped=%u%s\n",
+            deferred ? "deferred" : "direct", producers, pLatency[total / 2u], pLatency[(uint64_t)total * 99u / 100u],
+            pLatency[total - 1u], gSink.lines, dropped, errors ? " ERRORS" : "");
+
+    free(pStorage);
+    free(pLatency);
+    return errors ? 1 : 0;
+}
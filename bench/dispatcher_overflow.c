@@ -0,0 +1,266 @@
+/*
+ *  Host overflow benchmark : a producer posts bursts of events faster than
+ *  the event loop handles them, once for every full queue policy (block,
+ *  fail, drop newest, drop oldest, overwrite) set in the dispatcher
+ *  configuration, on the port queue and on the mpsc ring.
+ *
+ *  The producer reports how long its posts took (a blocking post stalls it
+ *  until the event loop makes room), the event loop runs with a 1 ms
+ *  timeout and counts the idle polls it got between bursts. A run checks
+ *  that events arrive in order, that every posted event is either handled
+ *  or counted by the drop counter of the policy and that the policies
+ *  dropping queued events deliver the newest event.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include "bench_clock.h"
+
+#define OVERFLOW_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define OVERFLOW_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + 1)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+} overflowEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t workNs;
+    uint32_t last;     /* newest handled sequence number. */
+    uint32_t handled;
+    uint32_t reordered;
+    uint32_t idle;     /* event loop calls which timed out. */
+    bool stop;
+} overflowDispatcher_t;
+
+static char const *const gPolicyNames[DISPATCHER_OVERFLOW_MAX] = {
+    [DISPATCHER_OVERFLOW_BLOCK] = "block",
+    [DISPATCHER_OVERFLOW_FAIL] = "fail",
+    [DISPATCHER_OVERFLOW_DROP_NEWEST] = "drop_newest",
+    [DISPATCHER_OVERFLOW_DROP_OLDEST] = "drop_oldest",
+    [DISPATCHER_OVERFLOW_OVERWRITE] = "overwrite",
+};
+
+static uint8_t OverflowHandler(overflowDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case OVERFLOW_SIGNAL_DATA:
+    {
+        overflowEvent_t const *pData = (overflowEvent_t const *)pEvent;
+
+        if (pData->seq <= pDispatcher->last)
+        {
+            pDispatcher->reordered++;
+        }
+        pDispatcher->last = pData->seq;
+        pDispatcher->handled++;
+
+        uint64_t until = BenchNow() + pDispatcher->workNs;
+
+        while (BenchNow() < until)
+        {
+        }
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    case OVERFLOW_SIGNAL_DONE:
+        pDispatcher->stop = true;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+/* the loop never sleeps longer than 1 ms, a timeout is where idle work would go. */
+static void *OverflowLoop(void *pArg)
+{
+    overflowDispatcher_t *pDispatcher = pArg;
+
+    while (!pDispatcher->stop)
+    {
+        if (DISPATCHER_EVENT_LOOP_TIMEOUT(pDispatcher, 1) == DISPATCHER_ERR_QUEUE_EMPTY)
+        {
+            pDispatcher->idle++;
+        }
+    }
+    return NULL;
+}
+
+static int OverflowCompare(void const *pA, void const *pB)
+{
+    uint32_t a = *(uint32_t const *)pA, b = *(uint32_t const *)pB;
+
+    return (a > b) - (a < b);
+}
+
+static int OverflowRun(dispatcher_queueType_t type,
+                       dispatcher_overflow_t policy,
+                       uint32_t depth,
+                       uint32_t events,
+                       uint32_t burst,
+                       uint32_t gapUs,
+                       uint32_t workNs,
+                       uint32_t timeoutMs)
+{
+    static overflowDispatcher_t gDispatcher;
+    uint32_t *pLatency = malloc(events * sizeof(uint32_t));
+    uint8_t *pQueueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                           DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(type,
+                                                                                                   sizeof(overflowEvent_t),
+                                                                                                   depth)));
+    overflowEvent_t eventStorage;
+    uint32_t failed = 0;
+    int ret = -1;
+
+    (void)memset(&gDispatcher, 0, sizeof(gDispatcher));
+    gDispatcher.workNs = workNs;
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(overflowEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = pQueueStorage,
+        .eventStorage = (uint8_t *)&eventStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)OverflowHandler,
+        .queueType = type,
+        .overflow = policy,
+        .postTimeoutMs = timeoutMs,
+    };
+
+    if (pLatency == NULL || pQueueStorage == NULL ||
+        dispatcher_InitWithConfig(&gDispatcher.base, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        goto cleanup;
+    }
+
+    pthread_t thread;
+
+    (void)pthread_create(&thread, NULL, OverflowLoop, &gDispatcher);
+
+    for (uint32_t seq = 1; seq <= events; seq++)
+    {
+        overflowEvent_t event = {.seq = seq};
+        uint64_t start = BenchNow();
+
+        DISPATCHER_SET_EVENT(&event, OVERFLOW_SIGNAL_DATA);
+        if (DISPATCHER_POST_EVENT(&gDispatcher, &event) != DISPATCHER_ERR_CLEAR)
+        {
+            failed++;
+        }
+        pLatency[seq - 1u] = (uint32_t)(BenchNow() - start);
+
+        if (seq % burst == 0)
+        {
+            struct timespec gap = {.tv_sec = 0, .tv_nsec = (long)gapUs * 1000};
+
+            (void)nanosleep(&gap, NULL);
+        }
+    }
+
+    // the stop event must never be dropped whatever the dispatcher policy is
+    overflowEvent_t done = {0};
+
+    DISPATCHER_SET_EVENT(&done, OVERFLOW_SIGNAL_DONE);
+    (void)DISPATCHER_POST_EVENT_OVERFLOW(&gDispatcher, &done, DISPATCHER_OVERFLOW_BLOCK, DISPATCHER_WAIT_FOREVER);
+    (void)pthread_join(thread, NULL);
+
+    qsort(pLatency, events, sizeof(uint32_t), OverflowCompare);
+
+    uint32_t drops = dispatcher_DropCount(&gDispatcher.base, policy);
+    bool newest = (policy != DISPATCHER_OVERFLOW_DROP_OLDEST && policy != DISPATCHER_OVERFLOW_OVERWRITE) ||
+                  gDispatcher.last == events;
+    bool accounted = gDispatcher.handled + drops == events;
+    bool errors = gDispatcher.reordered != 0 || !accounted || !newest;
+    char const *pQueueName = (type == DISPATCHER_QUEUE_TYPE_MPSC) ? "mpsc" : "port";
+
+    printf("{\"bench\":\"overflow\",\"queue\":\"%s\",\"policy\":\"%s\",\"depth\":%u,\"events\":%u,\"burst\":%u,"
+           "\"work_ns\":%u,\"post_p50_ns\":%u,\"post_p99_ns\":%u,\"post_max_ns\":%u,\"failed\":%u,\"drops\":%u,"
+           "\"handled\":%u,\"idle_polls\":%u,\"reordered\":%u,\"accounted\":%s,\"newest\":%s}\n",
+           pQueueName, gPolicyNames[policy], depth, events, burst, workNs, pLatency[events / 2u],
+           pLatency[(uint64_t)events * 99u / 100u], pLatency[events - 1u], failed, drops, gDispatcher.handled,
+           gDispatcher.idle, gDispatcher.reordered, accounted ? "true" : "false", newest ? "true" : "false");
+    fflush(stdout);
+    fprintf(stderr, "%-4s %-11s post p99 %9u ns max %9u ns drops=%-7u handled=%-7u idle=%-5u%s\n",
+            pQueueName, gPolicyNames[policy], pLatency[(uint64_t)events * 99u / 100u], pLatency[events - 1u],
+            drops, gDispatcher.handled, gDispatcher.idle, errors ? " ERRORS" : "");
+    ret = errors ? -1 : 0;
+
+cleanup:
+    free(pLatency);
+    free(pQueueStorage);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t depth = 16, events = 20000, burst = 64, gapUs = 500, workNs = 5000, timeoutMs = 0;
+    int option;
+
+    while ((option = getopt(argc, argv, "d:n:b:g:u:t:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            burst = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            gapUs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            workNs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            timeoutMs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -d count   queue depth, power of two (default 16)\n"
+                    "  -n count   events per run (default 20000)\n"
+                    "  -b count   events per burst (default 64)\n"
+                    "  -g us      pause between bursts (default 500)\n"
+                    "  -u ns      handler cost (default 5000)\n"
+                    "  -t ms      blocking post timeout, 0 for DISPATCHER_POST_TIMEOUT_MS (default 0)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (depth == 0 || (depth & (depth - 1u)) != 0 || depth > UINT16_MAX || events == 0 || burst == 0)
+    {
+        return 1;
+    }
+
+    dispatcher_queueType_t types[] = {DISPATCHER_QUEUE_TYPE_DEFAULT, DISPATCHER_QUEUE_TYPE_MPSC};
+
+    for (uint32_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        for (uint32_t policy = 0; policy < DISPATCHER_OVERFLOW_MAX; policy++)
+        {
+            if (OverflowRun(types[i], (dispatcher_overflow_t)policy, depth, events, burst, gapUs, workNs,
+                            timeoutMs) != 0)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
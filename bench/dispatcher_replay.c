@@ -0,0 +1,510 @@
+/*
+ *  Host record / replay benchmark : a producer thread posts data events of
+ *  random size (variable size queue) in bursts to a two state machine, a
+ *  toggle signal switches the state, data events reaching the busy state
+ *  are deferred and recalled on the way back, and a 1 ms periodic time
+ *  event runs meanwhile. The handlers fold state, signal and event bytes
+ *  into a hash.
+ *
+ *  Built with DISPATCHER_RECORD_ENABLE the live run is recorded into
+ *  memory, then replayed into a second dispatcher with the same handlers,
+ *  once as fast as possible and once with the recorded timing. Every replay
+ *  must reproduce the hash and the event counts of the live run, the timed
+ *  one must take about as long as the recording. -o writes the recording,
+ *  -i replays a recording from a file instead (also without the recorder),
+ *  the regression test use.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include "bench_clock.h"
+
+#define REPLAY_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define REPLAY_SIGNAL_TOGGLE (DISPATCHER_SIGNAL_USER + 1)
+#define REPLAY_SIGNAL_TICK (DISPATCHER_SIGNAL_USER + 2)
+#define REPLAY_DATA_MAX (48)
+#define REPLAY_DEFER_COUNT (64)
+#define REPLAY_BURST (64)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+    uint8_t data[REPLAY_DATA_MAX];
+} replayEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    dispatcher_timeEvent_t tick;
+    bool live;         /* arms the tick, a replay gets the ticks from the recording. */
+    uint64_t hash;
+    uint32_t data;     /* data events handled. */
+    uint32_t ticks;    /* time events handled. */
+    uint32_t deferred; /* data events deferred. */
+} replayDispatcher_t;
+
+typedef struct
+{
+    uint8_t *pData;
+    size_t size;
+    size_t capacity;
+    size_t offset;
+} replayBuffer_t;
+
+typedef struct
+{
+    replayDispatcher_t *pDispatcher;
+    uint32_t events;
+    uint32_t failed;
+} replayProducer_t;
+
+static volatile bool gDone = false;
+
+static void ReplayHash(replayDispatcher_t *const pDispatcher, void const *pData, size_t size)
+{
+    uint8_t const *pByte = pData;
+
+    // FNV-1a
+    for (size_t i = 0; i < size; i++)
+    {
+        pDispatcher->hash = (pDispatcher->hash ^ pByte[i]) * 0x100000001b3ull;
+    }
+}
+
+static uint8_t ReplayIdle(replayDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+static uint8_t ReplayBusy(replayDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+/* common reactions, the state id goes into the hash first. */
+static uint8_t ReplayReact(replayDispatcher_t *const pDispatcher,
+                           dispatcher_eventBase_t const *const pEvent,
+                           uint8_t state)
+{
+    ReplayHash(pDispatcher, &state, sizeof(state));
+    ReplayHash(pDispatcher, &pEvent->sig, sizeof(pEvent->sig));
+
+    if (pEvent->sig == REPLAY_SIGNAL_TICK)
+    {
+        pDispatcher->ticks++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+
+    replayEvent_t const *pData = (replayEvent_t const *)pEvent;
+    uint8_t length = (uint8_t)(pData->seq % (REPLAY_DATA_MAX + 1u));
+
+    ReplayHash(pDispatcher, &pData->seq, sizeof(pData->seq));
+    ReplayHash(pDispatcher, pData->data, length);
+    pDispatcher->data++;
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+static uint8_t ReplayIdle(replayDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case DISPATCHER_SIGNAL_ENTRY:
+        (void)DISPATCHER_RECALL(pDispatcher);
+        if (pDispatcher->live && !dispatcher_TimeEventIsArmed(&pDispatcher->tick))
+        {
+            (void)DISPATCHER_TIME_EVENT_ARM(&pDispatcher->tick, 1, 1);
+        }
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case DISPATCHER_SIGNAL_EXIT:
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case REPLAY_SIGNAL_TOGGLE:
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)ReplayBusy);
+    default:
+        return ReplayReact(pDispatcher, pEvent, 0);
+    }
+}
+
+static uint8_t ReplayBusy(replayDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case DISPATCHER_SIGNAL_ENTRY:
+    case DISPATCHER_SIGNAL_EXIT:
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case REPLAY_SIGNAL_TOGGLE:
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)ReplayIdle);
+    case REPLAY_SIGNAL_DATA:
+        if (((replayEvent_t const *)pEvent)->seq % 3u == 0)
+        {
+            pDispatcher->deferred++;
+            return DISPATCHER_DEFER(pDispatcher);
+        }
+        return ReplayReact(pDispatcher, pEvent, 1);
+    default:
+        return ReplayReact(pDispatcher, pEvent, 1);
+    }
+}
+
+/* bursts of data events with a toggle now and then, a short pause after every burst. */
+static void *ReplayProduce(void *pArg)
+{
+    replayProducer_t *pProducer = pArg;
+    uint32_t seed = 1;
+
+    for (uint32_t seq = 1; seq <= pProducer->events; seq++)
+    {
+        replayEvent_t event = {.seq = seq};
+        uint16_t length = (uint16_t)(offsetof(replayEvent_t, data) + seq % (REPLAY_DATA_MAX + 1u));
+
+        for (uint32_t i = 0; i < REPLAY_DATA_MAX; i++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            event.data[i] = (uint8_t)seed;
+        }
+        DISPATCHER_SET_EVENT(&event, (seed % 16u == 0) ? REPLAY_SIGNAL_TOGGLE : REPLAY_SIGNAL_DATA);
+        pProducer->failed += (DISPATCHER_POST_EVENT_SIZED(pProducer->pDispatcher, &event, length) != DISPATCHER_ERR_CLEAR)
+                                 ? 1u
+                                 : 0u;
+        if (seq % REPLAY_BURST == 0)
+        {
+            struct timespec pause = {.tv_nsec = 100000};
+
+            (void)nanosleep(&pause, NULL);
+        }
+    }
+    __atomic_store_n(&gDone, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void ReplayWrite(void const *pData, uint32_t size, void *pArg)
+{
+    replayBuffer_t *pBuffer = pArg;
+
+    if (pBuffer->size + size > pBuffer->capacity)
+    {
+        size_t capacity = (pBuffer->size + size) * 2u;
+        uint8_t *pGrown = realloc(pBuffer->pData, capacity);
+
+        if (pGrown == NULL)
+        {
+            return;
+        }
+        pBuffer->pData = pGrown;
+        pBuffer->capacity = capacity;
+    }
+    (void)memcpy(pBuffer->pData + pBuffer->size, pData, size);
+    pBuffer->size += size;
+}
+
+static uint32_t ReplayRead(void *pData, uint32_t size, void *pArg)
+{
+    replayBuffer_t *pBuffer = pArg;
+    size_t left = pBuffer->size - pBuffer->offset;
+    uint32_t copy = (size < left) ? size : (uint32_t)left;
+
+    (void)memcpy(pData, pBuffer->pData + pBuffer->offset, copy);
+    pBuffer->offset += copy;
+    return copy;
+}
+
+/* sum of the recorded gaps, the length of the recording in microseconds. */
+static uint64_t ReplaySpan(replayBuffer_t const *pBuffer)
+{
+    uint64_t span = 0;
+
+    for (size_t offset = sizeof(dispatcher_recordHeader_t); offset + sizeof(dispatcher_recordEntry_t) <= pBuffer->size;)
+    {
+        dispatcher_recordEntry_t entry;
+
+        (void)memcpy(&entry, pBuffer->pData + offset, sizeof(entry));
+        span += entry.delta;
+        offset += sizeof(entry) + entry.length;
+    }
+    return span;
+}
+
+static int ReplayInit(replayDispatcher_t *const pDispatcher,
+                      uint8_t *pQueueStorage,
+                      uint8_t *pDeferStorage,
+                      dispatcher_wheel_t *pWheel,
+                      uint32_t depth,
+                      bool live)
+{
+    dispatcher_config_t config = {
+        .itemSize = sizeof(replayEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = pQueueStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)ReplayIdle,
+        .queueType = DISPATCHER_QUEUE_TYPE_VARIABLE,
+        .postTimeoutMs = DISPATCHER_WAIT_FOREVER,
+        .deferStorage = pDeferStorage,
+        .deferCount = REPLAY_DEFER_COUNT,
+        .wheel = pWheel,
+    };
+
+    (void)memset(pDispatcher, 0, sizeof(*pDispatcher));
+    pDispatcher->hash = 0xcbf29ce484222325ull;
+    pDispatcher->live = live;
+    if (dispatcher_InitWithConfig(&pDispatcher->base, &config) != DISPATCHER_ERR_CLEAR ||
+        dispatcher_TimeEventInit(&pDispatcher->tick, &pDispatcher->base, REPLAY_SIGNAL_TICK) != DISPATCHER_ERR_CLEAR)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* one replay into a fresh dispatcher, returns the elapsed time in ns or 0 on failure. */
+static uint64_t ReplayRun(replayDispatcher_t *const pDispatcher,
+                          replayBuffer_t *const pRecording,
+                          uint8_t *pQueueStorage,
+                          uint8_t *pDeferStorage,
+                          dispatcher_wheel_t *pWheel,
+                          uint32_t depth,
+                          dispatcher_replay_t pace,
+                          uint32_t *pCount)
+{
+    replayEvent_t buffer;
+    uint64_t start;
+
+    pRecording->offset = 0;
+    if (ReplayInit(pDispatcher, pQueueStorage, pDeferStorage, pWheel, depth, false) != 0 ||
+        DISPATCHER_START(pDispatcher, false) != DISPATCHER_ERR_CLEAR)
+    {
+        return 0;
+    }
+    start = BenchNow();
+    if (dispatcher_Replay(&pDispatcher->base, ReplayRead, pRecording, (uint8_t *)&buffer, sizeof(buffer), pace,
+                          pCount) != DISPATCHER_ERR_CLEAR)
+    {
+        return 0;
+    }
+    return BenchNow() - start;
+}
+
+static int ReplayLoad(char const *pPath, replayBuffer_t *pBuffer)
+{
+    FILE *pFile = fopen(pPath, "rb");
+    uint8_t chunk[4096];
+    size_t got;
+
+    if (pFile == NULL)
+    {
+        perror(pPath);
+        return -1;
+    }
+    while ((got = fread(chunk, 1, sizeof(chunk), pFile)) != 0)
+    {
+        ReplayWrite(chunk, (uint32_t)got, pBuffer);
+    }
+    fclose(pFile);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static replayDispatcher_t gLive, gReplay;
+    static dispatcher_wheel_t gLiveWheel, gReplayWheel;
+    uint32_t events = 100000, depth = 256;
+    bool timed = true;
+    char const *pOutPath = NULL, *pInPath = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:d:o:i:Fh")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            pOutPath = optarg;
+            break;
+        case 'i':
+            pInPath = optarg;
+            break;
+        case 'F':
+            timed = false;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -n count   data and toggle events of the live run (default 100000)\n"
+                    "  -d count   queue depth in events (default 256)\n"
+                    "  -o file    write the recording of the live run\n"
+                    "  -i file    replay a recording from a file instead of a live run\n"
+                    "  -F         skip the replay with the recorded timing\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (events == 0 || depth == 0 || depth > UINT16_MAX)
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    uint32_t queueSize = DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_VARIABLE,
+                                                                                sizeof(replayEvent_t), depth));
+    uint32_t deferSize = DISPATCHER_DEFER_STORAGE_SIZE(sizeof(replayEvent_t), REPLAY_DEFER_COUNT);
+    uint8_t *pLiveQueue = aligned_alloc(DISPATCHER_QUEUE_ALIGN, queueSize);
+    uint8_t *pReplayQueue = aligned_alloc(DISPATCHER_QUEUE_ALIGN, queueSize);
+    uint8_t *pLiveDefer = aligned_alloc(DISPATCHER_QUEUE_ALIGN, deferSize);
+    uint8_t *pReplayDefer = aligned_alloc(DISPATCHER_QUEUE_ALIGN, deferSize);
+    replayBuffer_t recording = {0};
+    uint32_t problems = 0, failed = 0;
+    uint64_t liveNs = 0, fastNs = 0, timedNs = 0, spanUs = 0;
+    uint32_t fastCount = 0, timedCount = 0;
+    uint64_t expected = 0;
+    bool recorded = false;
+
+    if (pLiveQueue == NULL || pReplayQueue == NULL || pLiveDefer == NULL || pReplayDefer == NULL)
+    {
+        fprintf(stderr, "initialization failed\n");
+        problems++;
+        goto cleanup;
+    }
+
+    if (pInPath != NULL)
+    {
+        if (ReplayLoad(pInPath, &recording) != 0)
+        {
+            problems++;
+            goto cleanup;
+        }
+    }
+    else
+    {
+        if (ReplayInit(&gLive, pLiveQueue, pLiveDefer, &gLiveWheel, depth, true) != 0)
+        {
+            fprintf(stderr, "initialization failed\n");
+            problems++;
+            goto cleanup;
+        }
+
+        uint8_t record = DISPATCHER_RECORD_START(&gLive, ReplayWrite, &recording);
+
+        recorded = record == DISPATCHER_ERR_CLEAR;
+        if (!recorded && record != DISPATCHER_ERR_NOT_SUPPORTED)
+        {
+            fprintf(stderr, "record start failed\n");
+            problems++;
+            goto cleanup;
+        }
+
+        // the live state machine must be started before the producer posts
+        replayProducer_t producer = {.pDispatcher = &gLive, .events = events};
+        pthread_t thread;
+        uint64_t start = BenchNow();
+
+        (void)DISPATCHER_START(&gLive, false);
+        (void)pthread_create(&thread, NULL, ReplayProduce, &producer);
+
+        // done is read before the queue is found empty, so no post is left behind
+        for (;;)
+        {
+            bool done = __atomic_load_n(&gDone, __ATOMIC_ACQUIRE);
+            uint8_t ret = DISPATCHER_EVENT_LOOP_TIMEOUT(&gLive, 10);
+
+            if (done && ret == DISPATCHER_ERR_QUEUE_EMPTY)
+            {
+                break;
+            }
+            if (done && dispatcher_TimeEventIsArmed(&gLive.tick))
+            {
+                (void)DISPATCHER_TIME_EVENT_DISARM(&gLive.tick);
+            }
+        }
+        (void)pthread_join(thread, NULL);
+        liveNs = BenchNow() - start;
+        (void)dispatcher_RecordStop(&gLive.base);
+        failed = producer.failed;
+        if (!recorded)
+        {
+            fprintf(stderr, "recorder compiled out (DISPATCHER_RECORD_ENABLE), live run only\n");
+        }
+    }
+
+    if (recorded || pInPath != NULL)
+    {
+        spanUs = ReplaySpan(&recording);
+        fastNs = ReplayRun(&gReplay, &recording, pReplayQueue, pReplayDefer, &gReplayWheel, depth,
+                           DISPATCHER_REPLAY_FAST, &fastCount);
+        problems += (fastNs == 0) ? 1u : 0u;
+        if (recorded &&
+            (gReplay.hash != gLive.hash || gReplay.data != gLive.data || gReplay.ticks != gLive.ticks ||
+             gReplay.deferred != gLive.deferred))
+        {
+            fprintf(stderr, "  fast replay differs: data %u/%u ticks %u/%u deferred %u/%u\n", gReplay.data,
+                    gLive.data, gReplay.ticks, gLive.ticks, gReplay.deferred, gLive.deferred);
+            problems++;
+        }
+        // a file replay is the reference of the timed one
+        expected = recorded ? gLive.hash : gReplay.hash;
+    }
+
+    if ((recorded || pInPath != NULL) && timed)
+    {
+        timedNs = ReplayRun(&gReplay, &recording, pReplayQueue, pReplayDefer, &gReplayWheel, depth,
+                            DISPATCHER_REPLAY_TIMED, &timedCount);
+        problems += (timedNs == 0 || timedCount != fastCount) ? 1u : 0u;
+        if (gReplay.hash != expected)
+        {
+            fprintf(stderr, "  timed replay differs\n");
+            problems++;
+        }
+        // never early, late by at most a tenth of the span plus scheduling noise
+        if (timedNs / 1000u + 1000u < spanUs || timedNs / 1000u > spanUs + spanUs / 10u + 20000u)
+        {
+            fprintf(stderr, "  timed replay took %llu us for a %llu us recording\n",
+                    (unsigned long long)(timedNs / 1000u), (unsigned long long)spanUs);
+            problems++;
+        }
+    }
+
+    if (recorded && pOutPath != NULL)
+    {
+        FILE *pFile = fopen(pOutPath, "wb");
+
+        if (pFile == NULL || fwrite(recording.pData, 1, recording.size, pFile) != recording.size)
+        {
+            perror(pOutPath);
+            problems++;
+        }
+        if (pFile != NULL)
+        {
+            fclose(pFile);
+        }
+    }
+
+    bool errors = problems != 0 || failed != 0;
+    double fastRate = (fastNs != 0) ? (double)fastCount * 1e9 / (double)fastNs : 0.0;
+
+    printf("{\"bench\":\"replay\",\"source\":\"%s\",\"record\":%s,\"events\":%u,\"recording_bytes\":%zu,"
+           "\"span_ms\":%.2f,\"live_ms\":%.2f,\"replayed\":%u,\"fast_ms\":%.2f,\"fast_events_per_s\":%.0f,"
+           "\"timed_ms\":%.2f,\"hash\":\"%016llx\",\"problems\":%u,\"failed\":%u}\n",
+           (pInPath != NULL) ? "file" : "live", recorded ? "true" : "false", events, recording.size,
+           (double)spanUs / 1e3, (double)liveNs / 1e6, fastCount, (double)fastNs / 1e6, fastRate,
+           (double)timedNs / 1e6, (unsigned long long)gReplay.hash, problems, failed);
+    fprintf(stderr, "replay %-4s %u events, %zu bytes: live %.1f ms, fast %.1f ms (%.0f events/s), timed %.1f ms "
+            "for a %.1f ms recording%s\n",
+            (pInPath != NULL) ? "file" : "live", fastCount, recording.size, (double)liveNs / 1e6, (double)fastNs / 1e6,
+            fastRate, (double)timedNs / 1e6, (double)spanUs / 1e3, errors ? " ERRORS" : "");
+
+cleanup:
+    free(recording.pData);
+    free(pLiveQueue);
+    free(pReplayQueue);
+    free(pLiveDefer);
+    free(pReplayDefer);
+    return (problems != 0 || failed != 0) ? 1 : 0;
+}
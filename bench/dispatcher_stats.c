@@ -0,0 +1,363 @@
+/*
+ *  Host statistics benchmark : events on a set of signals are posted to a
+ *  two state machine, the last signal toggles the state. Handler cost
+ *  grows with the signal (signal i spins i * -u ns). By default one thread
+ *  fills the queue and drains it with the event loop in turns, so the run
+ *  measures the cpu time per event, -p runs producer threads against an
+ *  event loop thread instead.
+ *
+ *  Built with DISPATCHER_STATS_ENABLE the run prints the statistics
+ *  snapshot and checks it against what the producers and handlers counted
+ *  themselves : posted, dispatched and per signal counts, transitions and
+ *  a queue high water mark within the queue depth. Without it only the
+ *  throughput is reported, running the same options on both builds gives
+ *  the cost of the statistics.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "bench_clock.h"
+
+#define STATS_MAX_SIGNALS (16)
+#define STATS_MAX_PRODUCERS (16)
+#define STATS_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define STATS_SIGNAL_DONE (STATS_SIGNAL_DATA + STATS_MAX_SIGNALS)
+#define STATS_SIGNAL_COUNT (STATS_SIGNAL_DONE + 1)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t producer;
+    uint32_t seq;
+} statsEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t workNs;
+    uint32_t signals;
+    uint32_t count[STATS_MAX_SIGNALS];  /* events handled per signal. */
+    uint32_t last[STATS_MAX_PRODUCERS]; /* newest sequence number per producer. */
+    uint32_t handled;
+    uint32_t toggles;
+    uint32_t reordered;
+    bool stop;
+} statsDispatcher_t;
+
+typedef struct
+{
+    statsDispatcher_t *pDispatcher;
+    uint32_t producer;
+    uint32_t events;
+    uint32_t failed;
+} statsProducer_t;
+
+static uint8_t StatsStateA(statsDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+static uint8_t StatsStateB(statsDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+/* both states count the same way, the last data signal switches to the other one. */
+static uint8_t StatsReact(statsDispatcher_t *const pDispatcher,
+                          dispatcher_eventBase_t const *const pEvent,
+                          dispatcher_stateHandler_t other)
+{
+    if (pEvent->sig == STATS_SIGNAL_DONE)
+    {
+        pDispatcher->stop = true;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+
+    if (pEvent->sig < STATS_SIGNAL_DATA || pEvent->sig >= STATS_SIGNAL_DATA + pDispatcher->signals)
+    {
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+
+    statsEvent_t const *pData = (statsEvent_t const *)pEvent;
+    uint32_t signal = pEvent->sig - STATS_SIGNAL_DATA;
+
+    if (pData->seq <= pDispatcher->last[pData->producer])
+    {
+        pDispatcher->reordered++;
+    }
+    pDispatcher->last[pData->producer] = pData->seq;
+    pDispatcher->count[signal]++;
+    pDispatcher->handled++;
+
+    if (pDispatcher->workNs != 0)
+    {
+        uint64_t until = BenchNow() + (uint64_t)signal * pDispatcher->workNs;
+
+        while (BenchNow() < until)
+        {
+        }
+    }
+
+    if (signal + 1u == pDispatcher->signals)
+    {
+        pDispatcher->toggles++;
+        pDispatcher->base.next = other;
+        return DISPATCHER_SM_STATUS_TRANSITION;
+    }
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+static uint8_t StatsStateA(statsDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    if (pEvent->sig == DISPATCHER_SIGNAL_ENTRY || pEvent->sig == DISPATCHER_SIGNAL_EXIT)
+    {
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    return StatsReact(pDispatcher, pEvent, (dispatcher_stateHandler_t)StatsStateB);
+}
+
+static uint8_t StatsStateB(statsDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    if (pEvent->sig == DISPATCHER_SIGNAL_ENTRY || pEvent->sig == DISPATCHER_SIGNAL_EXIT)
+    {
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    return StatsReact(pDispatcher, pEvent, (dispatcher_stateHandler_t)StatsStateA);
+}
+
+static void *StatsLoop(void *pArg)
+{
+    statsDispatcher_t *pDispatcher = pArg;
+
+    while (!pDispatcher->stop)
+    {
+        (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, 32, 0, NULL);
+    }
+    return NULL;
+}
+
+static void StatsPost(statsProducer_t *const pProducer, uint32_t seq)
+{
+    statsEvent_t event = {.producer = pProducer->producer, .seq = seq};
+
+    DISPATCHER_SET_EVENT(&event, STATS_SIGNAL_DATA + (seq + pProducer->producer) % pProducer->pDispatcher->signals);
+    if (DISPATCHER_POST_EVENT(pProducer->pDispatcher, &event) != DISPATCHER_ERR_CLEAR)
+    {
+        pProducer->failed++;
+    }
+}
+
+static void *StatsProduce(void *pArg)
+{
+    statsProducer_t *pProducer = pArg;
+
+    for (uint32_t seq = 1; seq <= pProducer->events; seq++)
+    {
+        StatsPost(pProducer, seq);
+    }
+    return NULL;
+}
+
+/* posting and handling in turns of a full queue, no thread switches. */
+static void StatsInline(statsProducer_t *const pProducer, uint32_t depth)
+{
+    for (uint32_t seq = 1; seq <= pProducer->events;)
+    {
+        uint32_t round = 0;
+
+        for (; round < depth && seq <= pProducer->events; round++, seq++)
+        {
+            StatsPost(pProducer, seq);
+        }
+        while (round != 0)
+        {
+            uint16_t processed = 0;
+
+            (void)DISPATCHER_EVENT_LOOP_BATCH(pProducer->pDispatcher, round, 0, &processed);
+            round -= processed;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static statsDispatcher_t gDispatcher;
+    static dispatcher_signalStats_t gSignalStats[STATS_SIGNAL_COUNT];
+    dispatcher_queueType_t type = DISPATCHER_QUEUE_TYPE_MPSC;
+    uint32_t producers = 0, events = 200000, depth = 256, signals = 4, workNs = 0;
+    bool timing = true;
+    int option;
+
+    while ((option = getopt(argc, argv, "q:p:n:d:s:u:Th")) != -1)
+    {
+        switch (option)
+        {
+        case 'q':
+            type = (strcmp(optarg, "port") == 0)   ? DISPATCHER_QUEUE_TYPE_DEFAULT
+                   : (strcmp(optarg, "spsc") == 0) ? DISPATCHER_QUEUE_TYPE_SPSC
+                                                   : DISPATCHER_QUEUE_TYPE_MPSC;
+            break;
+        case 'p':
+            producers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            signals = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            workNs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'T':
+            timing = false;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -q type    port, spsc or mpsc queue (default mpsc)\n"
+                    "  -p count   producer threads, 1 with spsc, 0 posts and handles on one thread (default 0)\n"
+                    "  -n count   events per producer (default 200000)\n"
+                    "  -d count   queue depth, power of two (default 256)\n"
+                    "  -s count   data signals, the last one toggles the state (default 4)\n"
+                    "  -u ns      handler cost step, signal i spins i * ns (default 0)\n"
+                    "  -T         counters only, no signal statistics table (handlers not timed)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (type == DISPATCHER_QUEUE_TYPE_SPSC && producers > 1u)
+    {
+        producers = 1;
+    }
+    if (producers > STATS_MAX_PRODUCERS || events == 0 || signals == 0 ||
+        signals > STATS_MAX_SIGNALS || depth == 0 || (depth & (depth - 1u)) != 0 || depth > UINT16_MAX)
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    uint8_t *pQueueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                           DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(type,
+                                                                                                   sizeof(statsEvent_t),
+                                                                                                   depth)));
+    statsEvent_t eventStorage;
+
+    gDispatcher.workNs = workNs;
+    gDispatcher.signals = signals;
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(statsEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = pQueueStorage,
+        .eventStorage = (uint8_t *)&eventStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)StatsStateA,
+        .queueType = type,
+        .postTimeoutMs = DISPATCHER_WAIT_FOREVER,
+        .signalStats = timing ? gSignalStats : NULL,
+        .signalStatsCount = timing ? STATS_SIGNAL_COUNT : 0,
+    };
+
+    if (pQueueStorage == NULL ||
+        dispatcher_InitWithConfig(&gDispatcher.base, &config) != DISPATCHER_ERR_CLEAR ||
+        DISPATCHER_START(&gDispatcher, false) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        free(pQueueStorage);
+        return 1;
+    }
+
+    pthread_t loop;
+    pthread_t threads[STATS_MAX_PRODUCERS];
+    statsProducer_t producer[STATS_MAX_PRODUCERS];
+    uint32_t failed = 0;
+    statsEvent_t done = {0};
+    uint64_t start = BenchNow();
+
+    DISPATCHER_SET_EVENT(&done, STATS_SIGNAL_DONE);
+    if (producers == 0)
+    {
+        producer[0] = (statsProducer_t){.pDispatcher = &gDispatcher, .producer = 0, .events = events};
+        StatsInline(&producer[0], depth);
+        failed = producer[0].failed;
+        (void)DISPATCHER_POST_EVENT(&gDispatcher, &done);
+        (void)DISPATCHER_EVENT_LOOP(&gDispatcher);
+    }
+    else
+    {
+        (void)pthread_create(&loop, NULL, StatsLoop, &gDispatcher);
+        for (uint32_t i = 0; i < producers; i++)
+        {
+            producer[i] = (statsProducer_t){.pDispatcher = &gDispatcher, .producer = i, .events = events};
+            (void)pthread_create(&threads[i], NULL, StatsProduce, &producer[i]);
+        }
+
+        for (uint32_t i = 0; i < producers; i++)
+        {
+            (void)pthread_join(threads[i], NULL);
+            failed += producer[i].failed;
+        }
+
+        // with spsc only the producer thread may post, it is gone by now
+        (void)DISPATCHER_POST_EVENT(&gDispatcher, &done);
+        (void)pthread_join(loop, NULL);
+    }
+
+    double seconds = (double)(BenchNow() - start) / 1e9;
+    uint32_t total = ((producers == 0) ? 1u : producers) * events;
+    double rate = (double)gDispatcher.handled / seconds;
+    char const *pQueueName = (type == DISPATCHER_QUEUE_TYPE_DEFAULT) ? "port"
+                             : (type == DISPATCHER_QUEUE_TYPE_SPSC)  ? "spsc"
+                                                                     : "mpsc";
+    bool errors = gDispatcher.reordered != 0 || failed != 0 || gDispatcher.handled != total;
+    dispatcher_stats_t stats = {0};
+    bool enabled = DISPATCHER_STATS_GET(&gDispatcher, &stats) == DISPATCHER_ERR_CLEAR;
+
+    printf("{\"bench\":\"stats\",\"queue\":\"%s\",\"producers\":%u,\"events\":%u,\"depth\":%u,\"signals\":%u,"
+           "\"work_ns\":%u,\"stats\":%s,\"timing\":%s,\"events_per_sec\":%.0f",
+           pQueueName, producers, events, depth, signals, workNs, enabled ? "true" : "false",
+           timing ? "true" : "false", rate);
+    fprintf(stderr, "%s producers=%u stats=%s timing=%s %12.0f ev/s\n", pQueueName, producers, enabled ? "on" : "off",
+            timing ? "on" : "off", rate);
+
+    if (enabled)
+    {
+        // the stop event is posted and dispatched too
+        errors |= stats.posted != total + 1u || stats.dispatched != total + 1u || stats.dropped != 0 ||
+                  stats.transitions != gDispatcher.toggles || stats.highWater == 0 || stats.highWater > depth + 1u;
+
+        printf(",\"posted\":%u,\"dispatched\":%u,\"dropped\":%u,\"high_water\":%u,\"transitions\":%u,\"signal_cycles\":[",
+               stats.posted, stats.dispatched, stats.dropped, stats.highWater, stats.transitions);
+        fprintf(stderr, "  posted=%u dispatched=%u dropped=%u high_water=%u transitions=%u\n",
+                stats.posted, stats.dispatched, stats.dropped, stats.highWater, stats.transitions);
+
+        for (uint32_t i = 0; timing && i < signals; i++)
+        {
+            dispatcher_signalStats_t signal = {0};
+
+            (void)DISPATCHER_STATS_SIGNAL(&gDispatcher, STATS_SIGNAL_DATA + i, &signal);
+            errors |= signal.count != gDispatcher.count[i];
+
+            uint64_t mean = (signal.count != 0) ? signal.sum / signal.count : 0;
+
+            printf("%s{\"signal\":%u,\"count\":%u,\"min\":%u,\"mean\":%llu,\"max\":%u}", (i != 0) ? "," : "", i,
+                   signal.count, (signal.count != 0) ? signal.min : 0, (unsigned long long)mean, signal.max);
+            fprintf(stderr, "  signal %-2u count=%-8u cycles min=%-8u mean=%-8llu max=%u\n", i, signal.count,
+                    (signal.count != 0) ? signal.min : 0, (unsigned long long)mean, signal.max);
+        }
+        printf("]");
+    }
+    printf(",\"reordered\":%u,\"failed\":%u}\n", gDispatcher.reordered, failed);
+
+    if (errors)
+    {
+        fprintf(stderr, "ERRORS\n");
+    }
+    free(pQueueStorage);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+/*
+ *  Host table driven dispatch benchmark : the same two state machine
+ *  written as switch handlers and as DISPATCHER_STATE_TABLE states, fed
+ *  with the same pseudo random signal stream.
+ *
+ *  Every signal has its own action, state A handles the even signals,
+ *  state B the odd ones and both ignore the rest. A toggle signal (one in
+ *  every 16 events on average) switches state. Events are posted in
+ *  bursts of the queue depth and drained with the batched event loop.
+ *
+ *  Both machines must run the same actions the same number of times, a
+ *  run fails otherwise.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench_clock.h"
+
+#define TABLE_DEPTH (256)
+#define TABLE_ACTIONS (32)
+#define TABLE_SIGNAL_ACTION(n) (DISPATCHER_SIGNAL_USER + (n))
+#define TABLE_SIGNAL_TOGGLE (DISPATCHER_SIGNAL_USER + TABLE_ACTIONS)
+#define TABLE_SIGNAL_MAX (TABLE_SIGNAL_TOGGLE + 1)
+
+#define TABLE_EVEN(X) X(0) X(2) X(4) X(6) X(8) X(10) X(12) X(14) \
+    X(16) X(18) X(20) X(22) X(24) X(26) X(28) X(30)
+#define TABLE_ODD(X) X(1) X(3) X(5) X(7) X(9) X(11) X(13) X(15) \
+    X(17) X(19) X(21) X(23) X(25) X(27) X(29) X(31)
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint64_t counts[TABLE_ACTIONS];
+    uint64_t toggles;
+} tableDispatcher_t;
+
+#define TABLE_ACTION(n)                                                                           \
+    __attribute__((noinline)) static uint8_t TableAction##n(tableDispatcher_t *const pDispatcher, \
+                                                            dispatcher_eventBase_t const *const pEvent) \
+    {                                                                                             \
+        (void)pEvent;                                                                             \
+        pDispatcher->counts[n]++;                                                                 \
+        return DISPATCHER_SM_STATUS_HANDLED;                                                      \
+    }
+TABLE_EVEN(TABLE_ACTION)
+TABLE_ODD(TABLE_ACTION)
+
+__attribute__((noinline)) static uint8_t TableToggle(tableDispatcher_t *const pDispatcher,
+                                                     dispatcher_eventBase_t const *const pEvent)
+{
+    (void)pEvent;
+    pDispatcher->toggles++;
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+/* switch handlers */
+
+static uint8_t SwitchB(tableDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+#define SWITCH_CASE(n)             \
+    case TABLE_SIGNAL_ACTION(n):   \
+        return TableAction##n(pDispatcher, pEvent);
+
+static uint8_t SwitchA(tableDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (DISPATCHER_GET_SIGNAL(pEvent))
+    {
+        TABLE_EVEN(SWITCH_CASE)
+    case TABLE_SIGNAL_TOGGLE:
+        (void)TableToggle(pDispatcher, pEvent);
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)SwitchB);
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static uint8_t SwitchB(tableDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (DISPATCHER_GET_SIGNAL(pEvent))
+    {
+        TABLE_ODD(SWITCH_CASE)
+    case TABLE_SIGNAL_TOGGLE:
+        (void)TableToggle(pDispatcher, pEvent);
+        return DISPATCHER_TRANSITION(pDispatcher, (dispatcher_stateHandler_t)SwitchA);
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+/* table driven states */
+
+#define TABLE_ROW(n) DISPATCHER_ON(TABLE_SIGNAL_ACTION(n), TableAction##n, NULL),
+
+DISPATCHER_STATE_DECLARE(TableB);
+DISPATCHER_STATE_TABLE(TableA, NULL, TABLE_SIGNAL_MAX,
+                       TABLE_EVEN(TABLE_ROW)
+                       DISPATCHER_ON(TABLE_SIGNAL_TOGGLE, TableToggle, TableB));
+DISPATCHER_STATE_TABLE(TableB, NULL, TABLE_SIGNAL_MAX,
+                       TABLE_ODD(TABLE_ROW)
+                       DISPATCHER_ON(TABLE_SIGNAL_TOGGLE, TableToggle, TableA));
+
+static int TableRun(bool table, dispatcher_eventBase_t const *pEvents, uint32_t events, tableDispatcher_t *pDispatcher)
+{
+    static uint8_t queueStorage[DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_SPSC, sizeof(dispatcher_eventBase_t), TABLE_DEPTH)]
+        __attribute__((aligned(DISPATCHER_QUEUE_ALIGN)));
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(dispatcher_eventBase_t),
+        .itemCount = TABLE_DEPTH,
+        .queueStorage = queueStorage,
+        .defaultHandler = table ? (dispatcher_stateHandler_t)TableA : (dispatcher_stateHandler_t)SwitchA,
+        .queueType = DISPATCHER_QUEUE_TYPE_SPSC,
+    };
+
+    (void)memset(pDispatcher, 0, sizeof(*pDispatcher));
+    if (dispatcher_InitWithConfig(&pDispatcher->base, &config) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        return -1;
+    }
+
+    uint64_t start = BenchNow();
+
+    for (uint32_t i = 0; i < events; i += TABLE_DEPTH)
+    {
+        uint16_t burst = (uint16_t)((events - i < TABLE_DEPTH) ? events - i : TABLE_DEPTH);
+        uint16_t accepted = 0, processed = 0;
+
+        (void)DISPATCHER_POST_BATCH_FROM_ISR(pDispatcher, &pEvents[i], burst, &accepted, false);
+        while (processed < accepted)
+        {
+            uint16_t batch = 0;
+
+            (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, (uint16_t)(accepted - processed), 0, &batch);
+            processed += batch;
+        }
+    }
+
+    uint64_t elapsed = BenchNow() - start;
+
+    printf("{\"bench\":\"table\",\"mode\":\"%s\",\"events\":%u,\"ns_per_event\":%.2f,\"toggles\":%llu}\n",
+           table ? "table" : "switch", events, (double)elapsed / events, (unsigned long long)pDispatcher->toggles);
+    fflush(stdout);
+    fprintf(stderr, "%-6s %6.2f ns/event toggles=%llu\n", table ? "table" : "switch", (double)elapsed / events,
+            (unsigned long long)pDispatcher->toggles);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t events = 4000000, seed = 1;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:r:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -n count   events per run (default 4000000)\n"
+                    "  -r seed    signal stream seed (default 1)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    dispatcher_eventBase_t *pEvents = malloc((size_t)events * sizeof(dispatcher_eventBase_t));
+    static tableDispatcher_t switchDispatcher, tableDispatcher;
+
+    if (events == 0 || seed == 0 || pEvents == NULL)
+    {
+        free(pEvents);
+        return 1;
+    }
+
+    // xorshift32, one toggle in 16 events on average
+    for (uint32_t i = 0; i < events; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pEvents[i].sig = ((seed >> 8) % 16u == 0) ? TABLE_SIGNAL_TOGGLE : TABLE_SIGNAL_ACTION(seed % TABLE_ACTIONS);
+    }
+
+    int ret = (TableRun(false, pEvents, events, &switchDispatcher) == 0 &&
+               TableRun(true, pEvents, events, &tableDispatcher) == 0)
+                  ? 0
+                  : 1;
+
+    if (ret == 0 && (switchDispatcher.toggles != tableDispatcher.toggles ||
+                     memcmp(switchDispatcher.counts, tableDispatcher.counts, sizeof(switchDispatcher.counts)) != 0))
+    {
+        fprintf(stderr, "table and switch machines diverged\n");
+        ret = 1;
+    }
+    free(pEvents);
+    return ret;
+}
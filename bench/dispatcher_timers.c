@@ -0,0 +1,453 @@
+/*
+ *  Host time event benchmark : arm / rearm / cancel throughput with
+ *  thousands of armed timers, the hierarchical timing wheel against a
+ *  sorted list (the naive timer list, O(n) arm).
+ *
+ *  Every run fills the structure with the given number of timers at random
+ *  delays (1 tick - the range), then times random rearms of armed timers,
+ *  cancels of every timer and fresh arms into the full structure. The
+ *  expiry pass then advances one tick at a time over the range, every timer
+ *  must fire exactly once and exactly on its expiry tick, a run fails
+ *  otherwise.
+ *
+ *  The dispatcher run arms one-shot time events on a real dispatcher, one
+ *  periodic time event and one disarmed again, and runs its event loop on
+ *  the host 1 kHz tick. Every one-shot must arrive once, not before its
+ *  expiry, and the disarmed one never.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench_clock.h"
+
+#define TIMERS_SIGNAL_ONESHOT (DISPATCHER_SIGNAL_USER)
+#define TIMERS_SIGNAL_PERIODIC (DISPATCHER_SIGNAL_USER + 1)
+#define TIMERS_SIGNAL_DISARMED (DISPATCHER_SIGNAL_USER + 2)
+#define TIMERS_DEPTH (8)
+#define TIMERS_PERIOD_MS (5)
+
+typedef struct timersListNode
+{
+    struct timersListNode *pPrev;
+    struct timersListNode *pNext;
+    dispatcher_portTick_t expiry;
+    bool armed;
+} timersListNode_t;
+
+typedef struct
+{
+    timersListNode_t *pHead;
+    dispatcher_portTick_t now;
+} timersList_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    dispatcher_timeEvent_t *timeEvents;
+    uint32_t *fired;
+    uint32_t oneShots;   /* one-shot time events handled. */
+    uint32_t periodic;   /* periodic time events handled. */
+    uint32_t disarmed;   /* disarmed time events handled, must stay 0. */
+    uint32_t early;      /* time events handled before their expiry. */
+    uint32_t maxLate;    /* largest delay after the expiry tick. */
+} timersDispatcher_t;
+
+static uint32_t gSeed = 1;
+
+static uint32_t TimersRandom(void)
+{
+    gSeed ^= gSeed << 13;
+    gSeed ^= gSeed >> 17;
+    gSeed ^= gSeed << 5;
+    return gSeed;
+}
+
+/* sorted list baseline */
+
+static void ListDisarm(timersList_t *const pList, timersListNode_t *const pNode)
+{
+    if (!pNode->armed)
+    {
+        return;
+    }
+    if (pNode->pPrev != NULL)
+    {
+        pNode->pPrev->pNext = pNode->pNext;
+    }
+    else
+    {
+        pList->pHead = pNode->pNext;
+    }
+    if (pNode->pNext != NULL)
+    {
+        pNode->pNext->pPrev = pNode->pPrev;
+    }
+    pNode->armed = false;
+}
+
+static void ListArm(timersList_t *const pList, timersListNode_t *const pNode, dispatcher_portTick_t ticks)
+{
+    timersListNode_t *pPrev = NULL;
+    timersListNode_t *pNext;
+
+    ListDisarm(pList, pNode);
+    pNext = pList->pHead;
+    pNode->expiry = pList->now + ticks;
+    while (pNext != NULL && (pNext->expiry - pList->now) <= ticks)
+    {
+        pPrev = pNext;
+        pNext = pNext->pNext;
+    }
+    pNode->pPrev = pPrev;
+    pNode->pNext = pNext;
+    if (pPrev != NULL)
+    {
+        pPrev->pNext = pNode;
+    }
+    else
+    {
+        pList->pHead = pNode;
+    }
+    if (pNext != NULL)
+    {
+        pNext->pPrev = pNode;
+    }
+    pNode->armed = true;
+}
+
+/* both structures behind one interface, index based */
+
+typedef struct
+{
+    bool wheel;
+    dispatcher_wheel_t *pWheel;
+    dispatcher_wheelNode_t *wheelNodes;
+    timersList_t list;
+    timersListNode_t *listNodes;
+} timersImpl_t;
+
+static void ImplArm(timersImpl_t *const pImpl, uint32_t index, dispatcher_portTick_t ticks)
+{
+    if (pImpl->wheel)
+    {
+        dispatcher_WheelArm(pImpl->pWheel, &pImpl->wheelNodes[index], ticks);
+    }
+    else
+    {
+        ListArm(&pImpl->list, &pImpl->listNodes[index], ticks);
+    }
+}
+
+static void ImplDisarm(timersImpl_t *const pImpl, uint32_t index)
+{
+    if (pImpl->wheel)
+    {
+        (void)dispatcher_WheelDisarm(pImpl->pWheel, &pImpl->wheelNodes[index]);
+    }
+    else
+    {
+        ListDisarm(&pImpl->list, &pImpl->listNodes[index]);
+    }
+}
+
+/*
+ *  Advance one tick and count the expired timers, a timer expiring on any
+ *  other tick than its own counts as an error.
+ */
+static uint32_t ImplTick(timersImpl_t *const pImpl, uint32_t *pErrors)
+{
+    uint32_t fired = 0;
+
+    if (pImpl->wheel)
+    {
+        dispatcher_wheelNode_t *pNode;
+
+        dispatcher_WheelAdvance(pImpl->pWheel, pImpl->pWheel->now + 1u);
+        while ((pNode = dispatcher_WheelTakeExpired(pImpl->pWheel)) != NULL)
+        {
+            *pErrors += (pNode->expiry != pImpl->pWheel->now) ? 1u : 0u;
+            fired++;
+        }
+        return fired;
+    }
+
+    timersList_t *pList = &pImpl->list;
+
+    pList->now++;
+    while (pList->pHead != NULL && pList->pHead->expiry == pList->now)
+    {
+        ListDisarm(pList, pList->pHead);
+        fired++;
+    }
+    return fired;
+}
+
+static int TimersRun(bool wheel, uint32_t timers, uint32_t range, uint32_t ops)
+{
+    static dispatcher_wheel_t gWheel;
+    timersImpl_t impl = {
+        .wheel = wheel,
+        .pWheel = &gWheel,
+        .wheelNodes = calloc(timers, sizeof(dispatcher_wheelNode_t)),
+        .listNodes = calloc(timers, sizeof(timersListNode_t)),
+    };
+    uint32_t *order = malloc((size_t)timers * sizeof(uint32_t));
+    uint32_t *rearms = malloc((size_t)ops * 2u * sizeof(uint32_t));
+    uint32_t errors = 0, fired = 0;
+    int ret = -1;
+
+    if (impl.wheelNodes == NULL || impl.listNodes == NULL || order == NULL || rearms == NULL)
+    {
+        goto cleanup;
+    }
+
+    dispatcher_WheelInit(&gWheel, 0);
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        dispatcher_WheelNodeInit(&impl.wheelNodes[i]);
+        order[i] = i;
+    }
+    for (uint32_t i = timers; i > 1; i--)
+    {
+        uint32_t j = TimersRandom() % i, swap = order[i - 1u];
+
+        order[i - 1u] = order[j];
+        order[j] = swap;
+    }
+    for (uint32_t i = 0; i < ops; i++)
+    {
+        rearms[2u * i] = TimersRandom() % timers;
+        rearms[2u * i + 1u] = 1u + TimersRandom() % range;
+    }
+
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        ImplArm(&impl, i, 1u + TimersRandom() % range);
+    }
+
+    uint64_t start = BenchNow();
+
+    for (uint32_t i = 0; i < ops; i++)
+    {
+        ImplArm(&impl, rearms[2u * i], rearms[2u * i + 1u]);
+    }
+
+    uint64_t rearmNs = BenchNow() - start;
+
+    start = BenchNow();
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        ImplDisarm(&impl, order[i]);
+    }
+
+    uint64_t cancelNs = BenchNow() - start;
+
+    start = BenchNow();
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        ImplArm(&impl, order[i], rearms[2u * (i % ops) + 1u]);
+    }
+
+    uint64_t armNs = BenchNow() - start;
+
+    start = BenchNow();
+    for (uint32_t tick = 0; tick < range; tick++)
+    {
+        fired += ImplTick(&impl, &errors);
+    }
+
+    uint64_t expireNs = BenchNow() - start;
+
+    errors += (fired != timers) ? 1u : 0u;
+
+    char const *mode = wheel ? "wheel" : "list";
+
+    printf("{\"bench\":\"timers\",\"mode\":\"%s\",\"timers\":%u,\"range\":%u,\"ops\":%u,\"rearm_ns\":%.1f,"
+           "\"cancel_ns\":%.1f,\"arm_ns\":%.1f,\"expire_ns_per_tick\":%.1f,\"fired\":%u,\"errors\":%u}\n",
+           mode, timers, range, ops, (double)rearmNs / ops, (double)cancelNs / timers, (double)armNs / timers,
+           (double)expireNs / range, fired, errors);
+    fflush(stdout);
+    fprintf(stderr, "%-5s timers=%-6u rearm %8.1f ns cancel %6.1f ns arm %8.1f ns expire %6.1f ns/tick%s\n",
+            mode, timers, (double)rearmNs / ops, (double)cancelNs / timers, (double)armNs / timers,
+            (double)expireNs / range, errors ? " ERRORS" : "");
+    ret = (errors == 0) ? 0 : -1;
+
+cleanup:
+    free(impl.wheelNodes);
+    free(impl.listNodes);
+    free(order);
+    free(rearms);
+    return ret;
+}
+
+/* time events on a dispatcher */
+
+static uint8_t TimersHandler(timersDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    dispatcher_timeEvent_t const *pTimeEvent = (dispatcher_timeEvent_t const *)pEvent;
+    dispatcher_portTick_t late = dispatcher_PortGetTick() - pTimeEvent->node.expiry;
+
+    switch (pEvent->sig)
+    {
+    case TIMERS_SIGNAL_ONESHOT:
+        if ((int32_t)late < 0)
+        {
+            pDispatcher->early++;
+        }
+        else if (late > pDispatcher->maxLate)
+        {
+            pDispatcher->maxLate = late;
+        }
+        pDispatcher->fired[pTimeEvent - pDispatcher->timeEvents]++;
+        pDispatcher->oneShots++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case TIMERS_SIGNAL_PERIODIC:
+        pDispatcher->periodic++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    case TIMERS_SIGNAL_DISARMED:
+        pDispatcher->disarmed++;
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static int TimersDispatcherRun(uint32_t timers, uint32_t rangeMs)
+{
+    static uint8_t queueStorage[DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_SPSC, sizeof(dispatcher_eventBase_t), TIMERS_DEPTH)]
+        __attribute__((aligned(DISPATCHER_QUEUE_ALIGN)));
+    static dispatcher_wheel_t gWheel;
+    static timersDispatcher_t gDispatcher;
+    dispatcher_timeEvent_t periodic, disarmed;
+    int ret = -1;
+
+    (void)memset(&gDispatcher, 0, sizeof(gDispatcher));
+    gDispatcher.timeEvents = calloc(timers, sizeof(dispatcher_timeEvent_t));
+    gDispatcher.fired = calloc(timers, sizeof(uint32_t));
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(dispatcher_eventBase_t),
+        .itemCount = TIMERS_DEPTH,
+        .queueStorage = queueStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)TimersHandler,
+        .queueType = DISPATCHER_QUEUE_TYPE_SPSC,
+        .wheel = &gWheel,
+    };
+
+    if (gDispatcher.timeEvents == NULL || gDispatcher.fired == NULL ||
+        dispatcher_InitWithConfig(&gDispatcher.base, &config) != DISPATCHER_ERR_CLEAR ||
+        dispatcher_TimeEventInit(&periodic, &gDispatcher.base, TIMERS_SIGNAL_PERIODIC) != DISPATCHER_ERR_CLEAR ||
+        dispatcher_TimeEventInit(&disarmed, &gDispatcher.base, TIMERS_SIGNAL_DISARMED) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        (void)dispatcher_TimeEventInit(&gDispatcher.timeEvents[i], &gDispatcher.base, TIMERS_SIGNAL_ONESHOT);
+        (void)DISPATCHER_TIME_EVENT_ARM(&gDispatcher.timeEvents[i], 1u + TimersRandom() % rangeMs, 0);
+    }
+    (void)DISPATCHER_TIME_EVENT_ARM(&periodic, TIMERS_PERIOD_MS, TIMERS_PERIOD_MS);
+    (void)DISPATCHER_TIME_EVENT_ARM(&disarmed, rangeMs / 2u, 0);
+    (void)DISPATCHER_TIME_EVENT_DISARM(&disarmed);
+
+    uint64_t start = BenchNow();
+
+    while (gDispatcher.oneShots < timers)
+    {
+        if (DISPATCHER_EVENT_LOOP(&gDispatcher) != DISPATCHER_ERR_CLEAR)
+        {
+            fprintf(stderr, "event loop failed\n");
+            goto cleanup;
+        }
+    }
+
+    uint64_t elapsed = BenchNow() - start;
+    uint32_t twice = 0;
+    // the periodic time event may be one off the elapsed periods (tick phase), a
+    // loop held up for more than a period drops the missed ones
+    uint32_t periods = (uint32_t)(elapsed / 1000000u / TIMERS_PERIOD_MS);
+    uint32_t errors = gDispatcher.early + gDispatcher.disarmed +
+                      ((gDispatcher.periodic == 0 || gDispatcher.periodic > periods + 1u) ? 1u : 0u);
+
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        twice += (gDispatcher.fired[i] != 1u) ? 1u : 0u;
+    }
+    errors += twice;
+
+    printf("{\"bench\":\"timers\",\"mode\":\"dispatcher\",\"timers\":%u,\"range_ms\":%u,\"elapsed_ms\":%.1f,"
+           "\"periodic\":%u,\"max_late_ticks\":%u,\"early\":%u,\"disarmed\":%u,\"errors\":%u}\n",
+           timers, rangeMs, (double)elapsed / 1e6, gDispatcher.periodic, gDispatcher.maxLate, gDispatcher.early,
+           gDispatcher.disarmed, errors);
+    fflush(stdout);
+    fprintf(stderr, "dispatcher timers=%-6u %6.1f ms periodic=%u (%u periods) max late %u ticks%s\n",
+            timers, (double)elapsed / 1e6, gDispatcher.periodic, periods, gDispatcher.maxLate,
+            errors ? " ERRORS" : "");
+    ret = (errors == 0) ? 0 : -1;
+
+cleanup:
+    free(gDispatcher.timeEvents);
+    free(gDispatcher.fired);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t const defaultTimers[] = {1000, 10000};
+    uint32_t const *timers = defaultTimers;
+    uint32_t timerCount = 2, single = 0, range = 60000, ops = 20000;
+    int option;
+
+    while ((option = getopt(argc, argv, "t:r:n:s:h")) != -1)
+    {
+        switch (option)
+        {
+        case 't':
+            single = (uint32_t)strtoul(optarg, NULL, 0);
+            timers = &single;
+            timerCount = 1;
+            break;
+        case 'r':
+            range = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            ops = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            gSeed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -t count   armed timers (default sweep 1000,10000)\n"
+                    "  -r ticks   largest timer delay (default 60000)\n"
+                    "  -n count   rearms per run (default 20000)\n"
+                    "  -s seed    random seed (default 1)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (range == 0 || ops == 0 || gSeed == 0 || (timers == &single && single == 0))
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < timerCount; i++)
+    {
+        if (TimersRun(true, timers[i], range, ops) != 0 || TimersRun(false, timers[i], range, ops) != 0)
+        {
+            return 1;
+        }
+    }
+    return (TimersDispatcherRun(timers[timerCount - 1u], 100) == 0) ? 0 : 1;
+}
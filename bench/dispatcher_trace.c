@@ -0,0 +1,383 @@
+/*
+ *  Host trace benchmark : events on a set of signals are posted to a two
+ *  state machine (the last signal toggles the state) and handled in turns
+ *  of a full queue on one thread, every fourth event is posted with
+ *  dispatcher_PostFromIsr. The same rounds run with tracing stopped and
+ *  started, the difference is the cost of the trace records (4 per event,
+ *  7 with a transition).
+ *
+ *  Built with DISPATCHER_TRACE_ENABLE the traced run is dumped and checked :
+ *  records kept plus records overwritten match the records the run must
+ *  have written, timestamps never go back, every record names the
+ *  dispatcher, handler start / end alternate and, when nothing was
+ *  overwritten, every ISR post is flagged. -o writes the dump, -y a
+ *  symbol file with the state handlers, for tools/dispatcher_trace_decode.
+ *  Without it only the throughput is reported.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench_clock.h"
+
+#define TRACE_MAX_SIGNALS (16)
+#define TRACE_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+} traceEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint32_t signals;
+    uint32_t last;
+    uint32_t handled;
+    uint32_t toggles;
+    uint32_t reordered;
+} traceDispatcher_t;
+
+typedef struct
+{
+    uint8_t *pData;
+    size_t size;
+    size_t capacity;
+} traceBuffer_t;
+
+static uint8_t TraceStateA(traceDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+static uint8_t TraceStateB(traceDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent);
+
+static uint8_t TraceReact(traceDispatcher_t *const pDispatcher,
+                          dispatcher_eventBase_t const *const pEvent,
+                          dispatcher_stateHandler_t other)
+{
+    if (pEvent->sig == DISPATCHER_SIGNAL_ENTRY || pEvent->sig == DISPATCHER_SIGNAL_EXIT)
+    {
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+
+    traceEvent_t const *pData = (traceEvent_t const *)pEvent;
+
+    if (pData->seq <= pDispatcher->last)
+    {
+        pDispatcher->reordered++;
+    }
+    pDispatcher->last = pData->seq;
+    pDispatcher->handled++;
+
+    if (pEvent->sig + 1u == TRACE_SIGNAL_DATA + pDispatcher->signals)
+    {
+        pDispatcher->toggles++;
+        pDispatcher->base.next = other;
+        return DISPATCHER_SM_STATUS_TRANSITION;
+    }
+    return DISPATCHER_SM_STATUS_HANDLED;
+}
+
+static uint8_t TraceStateA(traceDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    return TraceReact(pDispatcher, pEvent, (dispatcher_stateHandler_t)TraceStateB);
+}
+
+static uint8_t TraceStateB(traceDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    return TraceReact(pDispatcher, pEvent, (dispatcher_stateHandler_t)TraceStateA);
+}
+
+/* posting and handling in turns of a full queue, sequence numbers go on across runs. */
+static uint32_t TraceRounds(traceDispatcher_t *const pDispatcher, uint32_t *pSeq, uint32_t events, uint32_t depth)
+{
+    uint32_t failed = 0;
+
+    for (uint32_t sent = 0; sent < events;)
+    {
+        uint32_t round = 0;
+
+        for (; round < depth && sent < events; round++, sent++)
+        {
+            traceEvent_t event = {.seq = ++(*pSeq)};
+            uint8_t ret;
+
+            DISPATCHER_SET_EVENT(&event, TRACE_SIGNAL_DATA + event.seq % pDispatcher->signals);
+            ret = (event.seq % 4u == 0) ? DISPATCHER_POST_EVENT_FROM_ISR(pDispatcher, &event, 0)
+                                        : DISPATCHER_POST_EVENT(pDispatcher, &event);
+            failed += (ret != DISPATCHER_ERR_CLEAR) ? 1u : 0u;
+        }
+        while (round != 0)
+        {
+            uint16_t processed = 0;
+
+            (void)DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, round, 0, &processed);
+            round -= processed;
+        }
+    }
+    return failed;
+}
+
+static void TraceWrite(void const *pData, uint32_t size, void *pArg)
+{
+    traceBuffer_t *pBuffer = pArg;
+
+    if (pBuffer->size + size > pBuffer->capacity)
+    {
+        size_t capacity = (pBuffer->size + size) * 2u;
+        uint8_t *pGrown = realloc(pBuffer->pData, capacity);
+
+        if (pGrown == NULL)
+        {
+            return;
+        }
+        pBuffer->pData = pGrown;
+        pBuffer->capacity = capacity;
+    }
+    (void)memcpy(pBuffer->pData + pBuffer->size, pData, size);
+    pBuffer->size += size;
+}
+
+/*
+ *  Checks a dump of one traced run, returns the number of problems found.
+ */
+static uint32_t TraceCheck(traceBuffer_t const *pBuffer,
+                           traceDispatcher_t const *pDispatcher,
+                           uint64_t expected,
+                           uint32_t expectedIsr)
+{
+    dispatcher_traceHeader_t header;
+    uint32_t problems = 0;
+
+    if (pBuffer->size < sizeof(header))
+    {
+        return 1;
+    }
+    (void)memcpy(&header, pBuffer->pData, sizeof(header));
+    if (header.magic != DISPATCHER_TRACE_MAGIC || header.version != DISPATCHER_TRACE_VERSION ||
+        header.recordSize != sizeof(dispatcher_traceRecord_t) ||
+        pBuffer->size != sizeof(header) + (size_t)header.count * sizeof(dispatcher_traceRecord_t) ||
+        (uint64_t)header.count + header.lost != expected)
+    {
+        fprintf(stderr, "  bad header: count=%u lost=%u expected=%llu\n", header.count, header.lost,
+                (unsigned long long)expected);
+        return 1;
+    }
+
+    dispatcher_traceRecord_t const *pRecords = (dispatcher_traceRecord_t const *)(pBuffer->pData + sizeof(header));
+    bool open = false, started = false;
+    uint32_t isr = 0;
+
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        dispatcher_traceRecord_t const *pRecord = &pRecords[i];
+
+        problems += (pRecord->dispatcher != (uint32_t)(uintptr_t)pDispatcher) ? 1u : 0u;
+        problems += (i != 0 && (int32_t)(pRecord->timestamp - pRecords[i - 1u].timestamp) < 0) ? 1u : 0u;
+        isr += (pRecord->flags & DISPATCHER_TRACE_FLAG_ISR) ? 1u : 0u;
+        if (pRecord->type == DISPATCHER_TRACE_HANDLER_START)
+        {
+            problems += open ? 1u : 0u;
+            open = true;
+            started = true;
+        }
+        else if (pRecord->type == DISPATCHER_TRACE_HANDLER_END)
+        {
+            // the oldest record may be the end of a handler started before it
+            problems += (!open && started) ? 1u : 0u;
+            open = false;
+        }
+        else if (pRecord->type == 0 || pRecord->type >= DISPATCHER_TRACE_MAX)
+        {
+            problems++;
+        }
+    }
+
+    // ISR posts are only all there when nothing was overwritten
+    problems += (header.lost == 0 && isr != expectedIsr) ? 1u : 0u;
+    return problems;
+}
+
+int main(int argc, char **argv)
+{
+    static traceDispatcher_t gDispatcher;
+    uint32_t events = 200000, depth = 256, signals = 4, records = 65536, reps = 3;
+    char const *pDumpPath = NULL, *pSymbolPath = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:d:s:r:R:o:y:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            depth = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            signals = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            records = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'R':
+            reps = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            pDumpPath = optarg;
+            break;
+        case 'y':
+            pSymbolPath = optarg;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -n count   events per run (default 200000)\n"
+                    "  -d count   queue depth, power of two (default 256)\n"
+                    "  -s count   data signals, the last one toggles the state (default 4)\n"
+                    "  -r count   trace records, power of two (default 65536)\n"
+                    "  -R count   runs with tracing stopped and started, best is kept (default 3)\n"
+                    "  -o file    write the dump of the last traced run\n"
+                    "  -y file    write the state handler symbols\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (events == 0 || signals == 0 || signals > TRACE_MAX_SIGNALS || depth == 0 ||
+        (depth & (depth - 1u)) != 0 || depth > UINT16_MAX || records == 0 || reps == 0)
+    {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    uint8_t *pQueueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                           DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_MPSC,
+                                                                                                   sizeof(traceEvent_t),
+                                                                                                   depth)));
+    dispatcher_traceRecord_t *pRecords = malloc((size_t)records * sizeof(dispatcher_traceRecord_t));
+    traceEvent_t eventStorage;
+
+    gDispatcher.signals = signals;
+
+    dispatcher_config_t config = {
+        .itemSize = sizeof(traceEvent_t),
+        .itemCount = (uint16_t)depth,
+        .queueStorage = pQueueStorage,
+        .eventStorage = (uint8_t *)&eventStorage,
+        .defaultHandler = (dispatcher_stateHandler_t)TraceStateA,
+        .queueType = DISPATCHER_QUEUE_TYPE_MPSC,
+        .postTimeoutMs = DISPATCHER_WAIT_FOREVER,
+    };
+
+    if (pQueueStorage == NULL || pRecords == NULL ||
+        dispatcher_InitWithConfig(&gDispatcher.base, &config) != DISPATCHER_ERR_CLEAR ||
+        DISPATCHER_START(&gDispatcher, false) != DISPATCHER_ERR_CLEAR)
+    {
+        fprintf(stderr, "initialization failed\n");
+        free(pQueueStorage);
+        free(pRecords);
+        return 1;
+    }
+
+    uint8_t traceInit = dispatcher_TraceInit(pRecords, records);
+    bool enabled = traceInit == DISPATCHER_ERR_CLEAR;
+
+    if (!enabled && traceInit != DISPATCHER_ERR_NOT_SUPPORTED)
+    {
+        fprintf(stderr, "trace initialization failed\n");
+        free(pQueueStorage);
+        free(pRecords);
+        return 1;
+    }
+
+    traceBuffer_t dump = {0};
+    uint64_t best[2] = {UINT64_MAX, UINT64_MAX};
+    uint32_t seq = 0, failed = 0, problems = 0;
+
+    for (uint32_t rep = 0; rep < reps; rep++)
+    {
+        for (uint32_t traced = 0; traced < 2u; traced++)
+        {
+            uint32_t toggles = gDispatcher.toggles;
+            uint32_t first = seq;
+            uint64_t start;
+
+            if (enabled && traced)
+            {
+                (void)dispatcher_TraceInit(pRecords, records);
+                (void)dispatcher_TraceStart();
+            }
+            start = BenchNow();
+            failed += TraceRounds(&gDispatcher, &seq, events, depth);
+            start = BenchNow() - start;
+            best[traced] = (start < best[traced]) ? start : best[traced];
+
+            if (enabled && traced)
+            {
+                (void)dispatcher_TraceStop();
+                dump.size = 0;
+                (void)dispatcher_TraceDump(TraceWrite, &dump);
+                problems += TraceCheck(&dump, &gDispatcher,
+                                       (uint64_t)events * 4u + (uint64_t)(gDispatcher.toggles - toggles) * 3u,
+                                       seq / 4u - first / 4u);
+            }
+        }
+    }
+
+    if (enabled && pDumpPath != NULL)
+    {
+        FILE *pFile = fopen(pDumpPath, "wb");
+
+        if (pFile == NULL || fwrite(dump.pData, 1, dump.size, pFile) != dump.size)
+        {
+            perror(pDumpPath);
+            problems++;
+        }
+        if (pFile != NULL)
+        {
+            fclose(pFile);
+        }
+    }
+    if (pSymbolPath != NULL)
+    {
+        FILE *pFile = fopen(pSymbolPath, "w");
+
+        if (pFile == NULL)
+        {
+            perror(pSymbolPath);
+            problems++;
+        }
+        else
+        {
+            fprintf(pFile, "%08x T TraceStateA\n%08x T TraceStateB\n",
+                    (uint32_t)(uintptr_t)TraceStateA, (uint32_t)(uintptr_t)TraceStateB);
+            fclose(pFile);
+        }
+    }
+
+    double plainNs = (double)best[0] / events;
+    double tracedNs = (double)best[1] / events;
+    double perEvent = 4.0 + 3.0 / signals;
+    double recordNs = (tracedNs - plainNs) / perEvent;
+    bool errors = problems != 0 || failed != 0 || gDispatcher.reordered != 0 ||
+                  gDispatcher.handled != seq;
+
+    printf("{\"bench\":\"trace\",\"events\":%u,\"depth\":%u,\"signals\":%u,\"records\":%u,\"trace\":%s,"
+           "\"plain_ns_per_event\":%.1f,\"traced_ns_per_event\":%.1f,\"records_per_event\":%.2f,"
+           "\"ns_per_record\":%.1f,\"problems\":%u,\"reordered\":%u,\"failed\":%u}\n",
+           events, depth, signals, records, enabled ? "true" : "false", plainNs, tracedNs, perEvent,
+           enabled ? recordNs : 0.0, problems, gDispatcher.reordered, failed);
+    fprintf(stderr, "trace=%s %7.1f ns/event stopped %7.1f ns/event traced, %5.1f ns per record%s\n",
+            enabled ? "on" : "off", plainNs, tracedNs, enabled ? recordNs : 0.0, errors ? " ERRORS" : "");
+
+    free(dump.pData);
+    free(pQueueStorage);
+    free(pRecords);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+/*
+ *  Host worker pool benchmark : events with a fixed handler cost posted
+ *  round robin to a set of dispatchers run by 1 - N workers (one thread
+ *  each), the throughput shows how the pool scales with the workers.
+ *
+ *  The spread mode lets the pool home the dispatchers on all workers. The
+ *  steal and pinned modes home every dispatcher on worker 0, steal leaves
+ *  them stealable so idle workers take over, pinned keeps them on worker 0
+ *  (a single busy core, the task bound dispatcher case). The burst mode is
+ *  steal with the events posted in short bursts, workers go to sleep
+ *  between two bursts while thieves may still hold a dispatcher, a home
+ *  worker missing the wake up of a post stalls the run.
+ *
+ *  Every handler checks it is never entered by two workers at once and
+ *  that its events arrive in order, and a run must not stop making progress
+ *  for a second, it fails otherwise.
+ *
+ *  Output is one JSON object per run on stdout (JSON lines), a human readable
+ *  summary goes to stderr.
+ */
+
+#include <dispatcher.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "bench_clock.h"
+
+#define WORKERS_SIGNAL_DATA (DISPATCHER_SIGNAL_USER)
+#define WORKERS_SIGNAL_DONE (DISPATCHER_SIGNAL_USER + 1)
+#define WORKERS_DEPTH (64)
+#define WORKERS_MAX_DISPATCHERS (16)
+#define WORKERS_MAX_WORKERS (DISPATCHER_WORKER_POOL_MAX_DISPATCHERS - WORKERS_MAX_DISPATCHERS)
+#define WORKERS_BURST_GAP_US (50)
+#define WORKERS_STALL_NS (1000000000ull)
+
+typedef enum
+{
+    WORKERS_MODE_SPREAD = 0,
+    WORKERS_MODE_STEAL = 1,
+    WORKERS_MODE_PINNED = 2,
+    WORKERS_MODE_BURST = 3,
+    WORKERS_MODE_MAX = 4,
+} workersMode_t;
+
+typedef struct
+{
+    dispatcher_eventBase_t base;
+    uint32_t seq;
+} workersEvent_t;
+
+typedef struct
+{
+    dispatcher_base_t base;
+
+    uint8_t *queueStorage;
+    uint32_t workNs;   /* handler cost. */
+    uint32_t inside;   /* non zero while a worker runs the handler. */
+    uint32_t overlaps; /* handler entered by two workers at once. */
+    uint32_t expected; /* next sequence number. */
+    uint32_t reordered;
+    uint32_t handled;
+    bool *pStop;       /* worker stop flag (control dispatchers). */
+} workersDispatcher_t;
+
+typedef struct
+{
+    dispatcher_workerPool_t *pPool;
+    uint8_t worker;
+    bool stop;
+    uint32_t events;
+    pthread_t thread;
+} workersThread_t;
+
+static char const *const gModeNames[WORKERS_MODE_MAX] = {
+    [WORKERS_MODE_SPREAD] = "spread",
+    [WORKERS_MODE_STEAL] = "steal",
+    [WORKERS_MODE_PINNED] = "pinned",
+    [WORKERS_MODE_BURST] = "burst",
+};
+
+static uint8_t WorkersHandler(workersDispatcher_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+{
+    switch (pEvent->sig)
+    {
+    case WORKERS_SIGNAL_DATA:
+    {
+        workersEvent_t const *pData = (workersEvent_t const *)pEvent;
+
+        if (__atomic_exchange_n(&pDispatcher->inside, 1u, __ATOMIC_ACQUIRE) != 0u)
+        {
+            __atomic_fetch_add(&pDispatcher->overlaps, 1u, __ATOMIC_RELAXED);
+        }
+        if (pData->seq != pDispatcher->expected)
+        {
+            pDispatcher->reordered++;
+        }
+        pDispatcher->expected = pData->seq + 1u;
+        (void)__atomic_fetch_add(&pDispatcher->handled, 1u, __ATOMIC_RELAXED);
+
+        uint64_t until = BenchNow() + pDispatcher->workNs;
+
+        while (BenchNow() < until)
+        {
+        }
+        __atomic_store_n(&pDispatcher->inside, 0u, __ATOMIC_RELEASE);
+        return DISPATCHER_SM_STATUS_HANDLED;
+    }
+    case WORKERS_SIGNAL_DONE:
+        __atomic_store_n(pDispatcher->pStop, true, __ATOMIC_RELAXED);
+        return DISPATCHER_SM_STATUS_HANDLED;
+    default:
+        return DISPATCHER_SM_STATUS_IGNORED;
+    }
+}
+
+static void *WorkersLoop(void *pArg)
+{
+    workersThread_t *pThread = pArg;
+
+    while (!__atomic_load_n(&pThread->stop, __ATOMIC_RELAXED))
+    {
+        uint16_t processed = 0;
+
+        (void)DISPATCHER_WORKER_LOOP(pThread->pPool, pThread->worker, 32, &processed);
+        pThread->events += processed;
+    }
+    return NULL;
+}
+
+static int WorkersRun(workersMode_t mode, uint32_t workers, uint32_t dispatchers, uint32_t events, uint32_t workNs)
+{
+    static dispatcher_worker_t gWorkers[WORKERS_MAX_WORKERS];
+    static dispatcher_workerPool_t gPool;
+    static workersThread_t gThreads[WORKERS_MAX_WORKERS];
+    static workersDispatcher_t gDispatchers[WORKERS_MAX_DISPATCHERS + WORKERS_MAX_WORKERS];
+    uint32_t total = dispatchers + workers;
+    int ret = -1;
+
+    (void)memset(gThreads, 0, sizeof(gThreads));
+    (void)memset(gDispatchers, 0, sizeof(gDispatchers));
+    if (dispatcher_WorkerPoolInit(&gPool, gWorkers, (uint8_t)workers) != DISPATCHER_ERR_CLEAR)
+    {
+        return -1;
+    }
+
+    // work dispatchers first, then one control dispatcher pinned to every worker to stop it
+    for (uint32_t i = 0; i < total; i++)
+    {
+        workersDispatcher_t *pDispatcher = &gDispatchers[i];
+        bool control = i >= dispatchers;
+        uint8_t home = control ? (uint8_t)(i - dispatchers) : (mode == WORKERS_MODE_SPREAD) ? DISPATCHER_WORKER_ANY : 0;
+
+        pDispatcher->workNs = workNs;
+        pDispatcher->pStop = control ? &gThreads[i - dispatchers].stop : NULL;
+        pDispatcher->queueStorage = aligned_alloc(DISPATCHER_QUEUE_ALIGN,
+                                                  DISPATCHER_QUEUE_ALIGN_UP(DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_MPSC,
+                                                                                                          sizeof(workersEvent_t),
+                                                                                                          WORKERS_DEPTH)));
+
+        dispatcher_config_t config = {
+            .itemSize = sizeof(workersEvent_t),
+            .itemCount = WORKERS_DEPTH,
+            .queueStorage = pDispatcher->queueStorage,
+            .defaultHandler = (dispatcher_stateHandler_t)WorkersHandler,
+            .queueType = DISPATCHER_QUEUE_TYPE_MPSC,
+        };
+
+        if (pDispatcher->queueStorage == NULL ||
+            dispatcher_InitWithConfig(&pDispatcher->base, &config) != DISPATCHER_ERR_CLEAR ||
+            dispatcher_WorkerPoolAttach(&gPool, &pDispatcher->base, (uint8_t)i, home,
+                                        control || mode == WORKERS_MODE_PINNED) != DISPATCHER_ERR_CLEAR)
+        {
+            fprintf(stderr, "initialization failed\n");
+            goto cleanup;
+        }
+    }
+
+    uint64_t start = BenchNow();
+
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        gThreads[i].pPool = &gPool;
+        gThreads[i].worker = (uint8_t)i;
+        (void)pthread_create(&gThreads[i].thread, NULL, WorkersLoop, &gThreads[i]);
+    }
+
+    for (uint32_t seq = 0; seq < events; seq++)
+    {
+        workersEvent_t event = {.seq = seq / dispatchers};
+
+        DISPATCHER_SET_EVENT(&event, WORKERS_SIGNAL_DATA);
+        while (DISPATCHER_POST_EVENT_FROM_ISR(&gDispatchers[seq % dispatchers], &event, false) != DISPATCHER_ERR_CLEAR)
+        {
+            (void)sched_yield();
+        }
+        if (mode == WORKERS_MODE_BURST && (seq + 1u) % dispatchers == 0)
+        {
+            struct timespec gap = {.tv_sec = 0, .tv_nsec = WORKERS_BURST_GAP_US * 1000};
+
+            (void)nanosleep(&gap, NULL);
+        }
+    }
+
+    uint32_t handled = 0, last = 0;
+    uint64_t progress = BenchNow();
+    bool stalled = false;
+
+    // a lost wake up leaves events queued with every worker asleep, the stop events below wake them again
+    while (handled < events && !stalled)
+    {
+        (void)sched_yield();
+        handled = 0;
+        for (uint32_t i = 0; i < dispatchers; i++)
+        {
+            handled += __atomic_load_n(&gDispatchers[i].handled, __ATOMIC_RELAXED);
+        }
+        if (handled != last)
+        {
+            last = handled;
+            progress = BenchNow();
+        }
+        stalled = BenchNow() - progress > WORKERS_STALL_NS;
+    }
+
+    uint64_t elapsed = BenchNow() - start;
+
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        workersEvent_t event = {0};
+
+        DISPATCHER_SET_EVENT(&event, WORKERS_SIGNAL_DONE);
+        while (DISPATCHER_POST_EVENT_FROM_ISR(&gDispatchers[dispatchers + i], &event, false) != DISPATCHER_ERR_CLEAR)
+        {
+            (void)sched_yield();
+        }
+        (void)pthread_join(gThreads[i].thread, NULL);
+    }
+
+    uint32_t overlaps = 0, reordered = 0, steals = 0, busiest = 0;
+
+    for (uint32_t i = 0; i < dispatchers; i++)
+    {
+        overlaps += gDispatchers[i].overlaps;
+        reordered += gDispatchers[i].reordered;
+    }
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        steals += gWorkers[i].steals;
+        busiest = (gThreads[i].events > busiest) ? gThreads[i].events : busiest;
+    }
+
+    double rate = (double)events * 1e9 / (double)elapsed;
+
+    printf("{\"bench\":\"workers\",\"mode\":\"%s\",\"workers\":%u,\"dispatchers\":%u,\"events\":%u,\"work_ns\":%u,"
+           "\"events_per_s\":%.0f,\"steals\":%u,\"busiest_share\":%.3f,\"overlaps\":%u,\"reordered\":%u,"
+           "\"stalled\":%s}\n",
+           gModeNames[mode], workers, dispatchers, events, workNs, rate, steals, (double)busiest / (events + 1u),
+           overlaps, reordered, stalled ? "true" : "false");
+    fflush(stdout);
+    fprintf(stderr, "%-6s workers=%-2u dispatchers=%-2u %10.0f events/s steals=%-7u busiest=%5.1f%%%s\n",
+            gModeNames[mode], workers, dispatchers, rate, steals, 100.0 * busiest / (events + 1u),
+            (overlaps != 0 || reordered != 0 || stalled) ? " ERRORS" : "");
+    ret = (overlaps == 0 && reordered == 0 && !stalled) ? 0 : -1;
+
+cleanup:
+    for (uint32_t i = 0; i < total; i++)
+    {
+        free(gDispatchers[i].queueStorage);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t maxWorkers = 4, dispatchers = 8, events = 20000, workNs = 5000;
+    int option;
+
+    while ((option = getopt(argc, argv, "w:d:n:u:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'w':
+            maxWorkers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            dispatchers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            events = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            workNs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options]\n"
+                    "  -w count   largest worker count, sweeps 1 - count (default 4, max %u)\n"
+                    "  -d count   dispatchers (default 8, max %u)\n"
+                    "  -n count   events per run (default 20000)\n"
+                    "  -u ns      handler cost (default 5000)\n",
+                    argv[0], WORKERS_MAX_WORKERS, WORKERS_MAX_DISPATCHERS);
+            return 1;
+        }
+    }
+
+    if (maxWorkers == 0 || maxWorkers > WORKERS_MAX_WORKERS || dispatchers == 0 ||
+        dispatchers > WORKERS_MAX_DISPATCHERS || events == 0)
+    {
+        return 1;
+    }
+
+    for (uint32_t mode = 0; mode < WORKERS_MODE_MAX; mode++)
+    {
+        for (uint32_t workers = 1; workers <= maxWorkers; workers++)
+        {
+            if (WorkersRun((workersMode_t)mode, workers, dispatchers, events, workNs) != 0)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
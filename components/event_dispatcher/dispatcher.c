@@ -1,7 +1,344 @@
 #include <dispatcher.h>
 #include <string.h>
+#include <stddef.h>
 
-static const char *TAG = __FILE__;
+// unused when DISPATCHER_LOG_STATE compiles every level out
+static const char *TAG __attribute__((unused)) = __FILE__;
+
+/* deferred event slots keep the event length in front of the event. */
+#define DEFER_HEADER_SIZE DISPATCHER_QUEUE_ALIGN_UP(sizeof(uint32_t))
+
+/* state of the queue item of a coalesced signal. */
+#define COALESCE_IDLE (0u)
+#define COALESCE_QUEUED_VALUE (1u) /* queued item holds the oldest value. */
+#define COALESCE_QUEUED_BARE (2u)  /* queued item only stands for the pending event. */
+
+/* event pool size classes, increasing block size. */
+static dispatcher_pool_t *gPools[DISPATCHER_POOL_MAX];
+static uint8_t gPoolCount = 0;
+
+#if (DISPATCHER_STATS_ENABLE)
+
+/*
+ *  Statistics are lock free : posted and dropped are added by producers,
+ *  the rest is only written by the context running the event loop, with
+ *  relaxed stores so any task can take a snapshot.
+ */
+static inline void StatsPosted(dispatcher_base_t *const pDispatcher, uint32_t count)
+{
+    (void)__atomic_fetch_add(&pDispatcher->stats.posted, count, __ATOMIC_RELAXED);
+}
+
+static inline void StatsBump(uint32_t *const pCounter)
+{
+    __atomic_store_n(pCounter, *pCounter + 1u, __ATOMIC_RELAXED);
+}
+
+/*
+ *  The queue only grows between two takes of the event loop, its size at
+ *  a take is the peak since the previous one.
+ */
+static inline void StatsTaken(dispatcher_base_t *const pDispatcher, dispatcher_queue_t *const pQueue)
+{
+    if (pQueue == &pDispatcher->queue)
+    {
+        uint32_t used = dispatcher_QueueUsed(pQueue);
+
+        if (used > pDispatcher->stats.highWater)
+        {
+            __atomic_store_n(&pDispatcher->stats.highWater, used, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*
+ *  Handlers are only timed with a signal statistics table, the cycle
+ *  counter is read twice per event.
+ */
+static inline uint32_t StatsStart(dispatcher_base_t const *const pDispatcher)
+{
+    return (pDispatcher->signalStats != NULL) ? dispatcher_PortCycles() : 0u;
+}
+
+static inline void StatsHandled(dispatcher_base_t *const pDispatcher,
+                                dispatcher_eventSignal_t signal,
+                                uint32_t start,
+                                bool transition)
+{
+    StatsBump(&pDispatcher->stats.dispatched);
+    if (transition)
+    {
+        StatsBump(&pDispatcher->stats.transitions);
+    }
+    if (signal < pDispatcher->signalStatsCount)
+    {
+        dispatcher_signalStats_t *pSignal = &pDispatcher->signalStats[signal];
+        uint32_t cycles = dispatcher_PortCycles() - start;
+
+        StatsBump(&pSignal->count);
+        __atomic_store_n(&pSignal->sum, pSignal->sum + cycles, __ATOMIC_RELAXED);
+        if (cycles < pSignal->min)
+        {
+            __atomic_store_n(&pSignal->min, cycles, __ATOMIC_RELAXED);
+        }
+        if (cycles > pSignal->max)
+        {
+            __atomic_store_n(&pSignal->max, cycles, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+#else
+
+static inline void StatsPosted(dispatcher_base_t *const pDispatcher, uint32_t count)
+{
+    (void)pDispatcher;
+    (void)count;
+}
+
+static inline void StatsTaken(dispatcher_base_t *const pDispatcher, dispatcher_queue_t *const pQueue)
+{
+    (void)pDispatcher;
+    (void)pQueue;
+}
+
+static inline uint32_t StatsStart(dispatcher_base_t const *const pDispatcher)
+{
+    (void)pDispatcher;
+    return 0;
+}
+
+static inline void StatsHandled(dispatcher_base_t *const pDispatcher,
+                                dispatcher_eventSignal_t signal,
+                                uint32_t start,
+                                bool transition)
+{
+    (void)pDispatcher;
+    (void)signal;
+    (void)start;
+    (void)transition;
+}
+
+#endif
+
+#if (DISPATCHER_TRACE_ENABLE)
+
+/* one ring for every dispatcher, records name the dispatcher. */
+static dispatcher_trace_t gTrace;
+
+static inline void TraceRecord(dispatcher_base_t const *const pDispatcher,
+                               dispatcher_traceType_t type,
+                               uint8_t flags,
+                               dispatcher_eventSignal_t signal,
+                               uint32_t arg)
+{
+    // a stopped trace costs a load, not a call
+    if (__atomic_load_n(&gTrace.enabled, __ATOMIC_RELAXED))
+    {
+        dispatcher_TraceRingWrite(&gTrace, (uint8_t)type, flags, signal, pDispatcher, arg);
+    }
+}
+
+#else
+
+static inline void TraceRecord(dispatcher_base_t const *const pDispatcher,
+                               dispatcher_traceType_t type,
+                               uint8_t flags,
+                               dispatcher_eventSignal_t signal,
+                               uint32_t arg)
+{
+    (void)pDispatcher;
+    (void)type;
+    (void)flags;
+    (void)signal;
+    (void)arg;
+}
+
+#endif
+
+#if (DISPATCHER_RECORD_ENABLE)
+
+/*
+ *  Write one entry and its event bytes, an event posted by reference is
+ *  written by value with the block size of its pool.
+ */
+static void RecordWrite(dispatcher_base_t *const pDispatcher,
+                        void const *pItem,
+                        uint16_t length,
+                        uint8_t flags)
+{
+    uint64_t now = dispatcher_PortTimeUs();
+    uint64_t delta = now - pDispatcher->recordTime;
+    dispatcher_recordEntry_t entry = {.flags = flags};
+
+    if (((dispatcher_eventBase_t const *)pItem)->sig == DISPATCHER_SIGNAL_REF)
+    {
+        void *pShared = NULL;
+
+        (void)memcpy(&pShared, (uint8_t const *)pItem + offsetof(dispatcher_eventRef_t, pEvent), sizeof(pShared));
+        pItem = pShared;
+        length = ((dispatcher_poolBlock_t const *)((uint8_t const *)pShared - DISPATCHER_POOL_HEADER_SIZE))
+                     ->pPool->blockSize;
+    }
+
+    entry.delta = (delta < UINT32_MAX) ? (uint32_t)delta : UINT32_MAX;
+    entry.length = length;
+    pDispatcher->recordTime = now;
+    pDispatcher->record(&entry, sizeof(entry), pDispatcher->recordArg);
+    pDispatcher->record(pItem, length, pDispatcher->recordArg);
+}
+
+static inline void RecordEvent(dispatcher_base_t *const pDispatcher,
+                               void const *const pItem,
+                               uint16_t length,
+                               uint8_t flags)
+{
+    if (pDispatcher->record != NULL)
+    {
+        RecordWrite(pDispatcher, pItem, length, flags);
+    }
+}
+
+#else
+
+static inline void RecordEvent(dispatcher_base_t *const pDispatcher,
+                               void const *const pItem,
+                               uint16_t length,
+                               uint8_t flags)
+{
+    (void)pDispatcher;
+    (void)pItem;
+    (void)length;
+    (void)flags;
+}
+
+#endif
+
+#if (DISPATCHER_LOG_DEFERRED)
+
+/* deferred log records, any task writes, the drain task reads. */
+static dispatcher_queue_t gLogQueue;
+static dispatcher_waiter_t gLogWaiter;
+static uint32_t gLogDropped = 0;
+static uint32_t gLogReported = 0; /* drops already reported by the drain. */
+
+#endif
+
+/* trace argument of a state handler, its address. */
+#define TRACE_STATE(handler) ((uint32_t)(uintptr_t)(handler))
+
+/* trace argument of a DROP by the signal filter, one past the overflow policies. */
+#define TRACE_FILTERED ((uint32_t)DISPATCHER_OVERFLOW_MAX)
+
+/*
+ *  Point the posting contexts at the filter of the active state, called
+ *  whenever the active state changes.
+ */
+static void DispatcherFilterSelect(dispatcher_base_t *const pDispatcher)
+{
+    dispatcher_filter_t *pFilter = NULL;
+
+    for (uint8_t i = 0; i < pDispatcher->filterCount; i++)
+    {
+        if (pDispatcher->filters[i].state == pDispatcher->active)
+        {
+            pFilter = &pDispatcher->filters[i];
+            break;
+        }
+    }
+    __atomic_store_n(&pDispatcher->filter, pFilter, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Signals kept by the dispatcher for its own queue items (pool references,
+ *  released slots), events posted by value must not carry them.
+ */
+static inline bool DispatcherSignalReserved(dispatcher_eventSignal_t signal)
+{
+    return signal >= DISPATCHER_SIGNAL_VOID;
+}
+
+/*
+ *  Posting side check, a load of the filter and of one of its words. A
+ *  filtered post is counted and traced as a drop.
+ */
+static inline bool DispatcherFiltered(dispatcher_base_t *const pDispatcher,
+                                      dispatcher_eventSignal_t signal,
+                                      uint8_t flags)
+{
+    dispatcher_filter_t const *pFilter = __atomic_load_n(&pDispatcher->filter, __ATOMIC_ACQUIRE);
+
+    if (pFilter == NULL || signal < DISPATCHER_SIGNAL_USER || signal >= DISPATCHER_FILTER_WORDS * 32u ||
+        (__atomic_load_n(&pFilter->accept[signal / 32u], __ATOMIC_RELAXED) & (1u << (signal % 32u))) != 0)
+    {
+        return false;
+    }
+    (void)__atomic_fetch_add(&pDispatcher->filtered, 1u, __ATOMIC_RELAXED);
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_DROP, flags, signal, TRACE_FILTERED);
+    return true;
+}
+
+/*
+ *  A learning filter stops accepting a signal the active state ignored.
+ */
+static void DispatcherFilterLearn(dispatcher_base_t *const pDispatcher, dispatcher_eventSignal_t signal)
+{
+    dispatcher_filter_t *pFilter = __atomic_load_n(&pDispatcher->filter, __ATOMIC_RELAXED);
+
+    if (pFilter != NULL && pFilter->learn && signal >= DISPATCHER_SIGNAL_USER &&
+        signal < DISPATCHER_FILTER_WORDS * 32u)
+    {
+        (void)__atomic_fetch_and(&pFilter->accept[signal / 32u], ~(1u << (signal % 32u)), __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ *  Superstate of a state, asked with an empty event, NULL for a top level
+ *  state.
+ */
+static dispatcher_stateHandler_t DispatcherParent(dispatcher_base_t *const pDispatcher,
+                                                  dispatcher_stateHandler_t state)
+{
+    dispatcher_eventBase_t event = {.sig = DISPATCHER_SIGNAL_NONE};
+
+    pDispatcher->next = NULL;
+    return (state(pDispatcher, &event) == DISPATCHER_SM_STATUS_SUPER) ? pDispatcher->next : NULL;
+}
+
+static dispatcher_portTick_t DispatcherTicks(uint32_t timeoutMs)
+{
+    return (timeoutMs == DISPATCHER_WAIT_FOREVER) ? DISPATCHER_PORT_MAX_DELAY : DISPATCHER_PORT_MS_TO_TICKS(timeoutMs);
+}
+
+/*
+ *  Dropping queued events takes them from the producer side, which only
+ *  the port queue and the mpsc ring allow.
+ */
+static uint8_t DispatcherOverflowCheck(dispatcher_queueType_t type, uint16_t itemSize, dispatcher_overflow_t overflow)
+{
+    if (overflow >= DISPATCHER_OVERFLOW_MAX)
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    if (overflow != DISPATCHER_OVERFLOW_DROP_OLDEST && overflow != DISPATCHER_OVERFLOW_OVERWRITE)
+    {
+        return DISPATCHER_ERR_CLEAR;
+    }
+    if (type != DISPATCHER_QUEUE_TYPE_DEFAULT && type != DISPATCHER_QUEUE_TYPE_MPSC)
+    {
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+#if DISPATCHER_PORT_EVICT_ITEM_MAX < UINT16_MAX
+    // the port queue evicts through a bounded buffer
+    if (type == DISPATCHER_QUEUE_TYPE_DEFAULT && itemSize > DISPATCHER_PORT_EVICT_ITEM_MAX)
+    {
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+#else
+    (void)itemSize;
+#endif
+    return DISPATCHER_ERR_CLEAR;
+}
 
 uint8_t dispatcher_Init(dispatcher_base_t *const pDispatcher,
                         uint16_t itemSize,
@@ -10,168 +347,3288 @@ uint8_t dispatcher_Init(dispatcher_base_t *const pDispatcher,
                         uint8_t *eventStorage,
                         dispatcher_stateHandler_t defaultHandler)
 {
-    if (pDispatcher == NULL || queueStorage == NULL || eventStorage == NULL || defaultHandler == NULL)
+    dispatcher_config_t config = {
+        .itemSize = itemSize,
+        .itemCount = itemCount,
+        .queueStorage = queueStorage,
+        .eventStorage = eventStorage,
+        .defaultHandler = defaultHandler,
+        .queueType = DISPATCHER_QUEUE_TYPE_DEFAULT,
+    };
+
+    return dispatcher_InitWithConfig(pDispatcher, &config);
+}
+
+uint8_t dispatcher_InitWithConfig(dispatcher_base_t *const pDispatcher,
+                                  dispatcher_config_t const *const pConfig)
+{
+    if (pDispatcher == NULL || pConfig == NULL || pConfig->queueStorage == NULL ||
+        pConfig->defaultHandler == NULL ||
+        (pConfig->eventStorage == NULL && pConfig->queueType == DISPATCHER_QUEUE_TYPE_DEFAULT))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (pConfig->itemSize == 0 || pConfig->itemCount == 0)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,requied non zero arguments", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->queueType >= DISPATCHER_QUEUE_TYPE_MAX ||
+        ((pConfig->queueType == DISPATCHER_QUEUE_TYPE_SPSC || pConfig->queueType == DISPATCHER_QUEUE_TYPE_MPSC) &&
+         (pConfig->itemCount & (pConfig->itemCount - 1u)) != 0))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,ring queue requires power of two item count", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if ((pConfig->queueType == DISPATCHER_QUEUE_TYPE_MPSC || pConfig->queueType == DISPATCHER_QUEUE_TYPE_VARIABLE) &&
+        ((uintptr_t)pConfig->queueStorage & (DISPATCHER_QUEUE_ALIGN - 1u)) != 0)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,queue storage not aligned", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->laneCount >= DISPATCHER_LANE_MAX || (pConfig->laneCount != 0 && pConfig->lanes == NULL))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid priority lanes", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->deferCount != 0 &&
+        (pConfig->deferStorage == NULL || ((uintptr_t)pConfig->deferStorage & (DISPATCHER_QUEUE_ALIGN - 1u)) != 0))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid deferred event storage", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->pathCount != 0 && pConfig->paths == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid transition path cache", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->coalesceCount != 0 && pConfig->coalesce == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid coalescing table", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->signalStatsCount != 0 && pConfig->signalStats == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid signal statistics table", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pConfig->filterCount != 0 && pConfig->filters == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid signal filters", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    uint8_t ret = DispatcherOverflowCheck(pConfig->queueType, pConfig->itemSize, pConfig->overflow);
+
+    if (ret != DISPATCHER_ERR_CLEAR)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid overflow policy for queue backend", __LINE__);
+        return ret;
+    }
+
+    (void)memset(pDispatcher, 0, sizeof(dispatcher_base_t));
+    if (dispatcher_WaiterInit(&pDispatcher->waiter) != DISPATCHER_PORT_OK ||
+        dispatcher_QueueInit(&pDispatcher->queue,
+                             pConfig->queueType,
+                             pConfig->itemSize,
+                             pConfig->itemCount,
+                             pConfig->queueStorage,
+                             &pDispatcher->waiter) != DISPATCHER_PORT_OK)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,queue initialization failed", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    // lanes share the event loop waiter, a post marks its lane ready and wakes the loop
+    for (uint8_t i = 0; i < pConfig->laneCount; i++)
+    {
+        dispatcher_lane_t *pLane = &pConfig->lanes[i];
+
+        if (pLane->queueStorage == NULL || pLane->itemCount == 0 ||
+            dispatcher_QueueInit(&pLane->queue,
+                                 pConfig->queueType,
+                                 pConfig->itemSize,
+                                 pLane->itemCount,
+                                 pLane->queueStorage,
+                                 &pDispatcher->waiter) != DISPATCHER_PORT_OK ||
+            dispatcher_QueueSetLane(&pLane->queue, (uint8_t)(i + 1u), &pDispatcher->waiter) != DISPATCHER_PORT_OK)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,lane initialization failed", __LINE__);
+            return DISPATCHER_ERR_NOT_INITIALIZED;
+        }
+    }
+    if (pConfig->laneCount != 0)
+    {
+        (void)dispatcher_QueueSetLane(&pDispatcher->queue, 0, &pDispatcher->waiter);
+        pDispatcher->lanes = pConfig->lanes;
+        pDispatcher->laneCount = pConfig->laneCount;
+    }
+    pDispatcher->defer.storage = pConfig->deferStorage;
+    pDispatcher->defer.stride = (uint16_t)DISPATCHER_QUEUE_SLOT_SIZE(pConfig->itemSize);
+    pDispatcher->defer.count = pConfig->deferCount;
+    if (pConfig->pathCount != 0)
+    {
+        (void)memset(pConfig->paths, 0, pConfig->pathCount * sizeof(dispatcher_path_t));
+        pDispatcher->paths = pConfig->paths;
+        pDispatcher->pathCount = pConfig->pathCount;
+    }
+    if (pConfig->wheel != NULL)
+    {
+        dispatcher_WheelInit(pConfig->wheel, dispatcher_PortGetTick());
+        pDispatcher->wheel = pConfig->wheel;
+    }
+    if (pConfig->coalesceCount != 0)
+    {
+        (void)memset(pConfig->coalesce, 0, pConfig->coalesceCount * sizeof(dispatcher_coalesce_t));
+        pDispatcher->coalesce = pConfig->coalesce;
+        pDispatcher->coalesceCount = pConfig->coalesceCount;
+    }
+#if (DISPATCHER_STATS_ENABLE)
+    for (uint16_t i = 0; i < pConfig->signalStatsCount; i++)
+    {
+        pConfig->signalStats[i] = (dispatcher_signalStats_t){.min = UINT32_MAX};
+    }
+    pDispatcher->signalStats = pConfig->signalStats;
+    pDispatcher->signalStatsCount = pConfig->signalStatsCount;
+#endif
+    pDispatcher->overflow = (uint8_t)pConfig->overflow;
+    pDispatcher->postTimeout = DispatcherTicks((pConfig->postTimeoutMs == 0) ? DISPATCHER_POST_TIMEOUT_MS
+                                                                             : pConfig->postTimeoutMs);
+    pDispatcher->eventStorage = pConfig->eventStorage;
+    pDispatcher->active = pConfig->defaultHandler;
+    pDispatcher->filters = pConfig->filters;
+    pDispatcher->filterCount = pConfig->filterCount;
+    DispatcherFilterSelect(pDispatcher);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_Start(dispatcher_base_t *const pDispatcher,
+                         bool userSignal)
+{
+
+    if (pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (pDispatcher->active == NULL || !dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    dispatcher_eventBase_t event = {.sig = DISPATCHER_SIGNAL_ENTRY};
+
+    if (pDispatcher->paths != NULL)
+    {
+        // superstates of the initial state are entered first, outermost first
+        dispatcher_stateHandler_t states[DISPATCHER_HSM_MAX_DEPTH];
+        dispatcher_stateHandler_t state = pDispatcher->active;
+        uint8_t depth = 0;
+
+        for (; state != NULL && depth < DISPATCHER_HSM_MAX_DEPTH; depth++)
+        {
+            states[depth] = state;
+            state = DispatcherParent(pDispatcher, state);
+        }
+        if (state != NULL)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,states nested deeper than DISPATCHER_HSM_MAX_DEPTH", __LINE__);
+            return DISPATCHER_ERR_PROCESS_FAIL;
+        }
+        while (depth > 1u)
+        {
+            TraceRecord(pDispatcher, DISPATCHER_TRACE_ENTRY, 0, event.sig, TRACE_STATE(states[depth - 1u]));
+            states[--depth](pDispatcher, &event);
+        }
+    }
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_ENTRY, 0, event.sig, TRACE_STATE(pDispatcher->active));
+    pDispatcher->active(pDispatcher, &event);
+
+    if (userSignal)
+    {
+        event.sig = DISPATCHER_SIGNAL_USER;
+        ret = dispatcher_Post(pDispatcher, &event);
+    }
+
+    return ret;
+}
+
+/*
+ *  Copy a deferred event (or the reference of a pool event) to the back of
+ *  the store. pItem may be the slot just taken from the front when the
+ *  store was full, the event then already is in place.
+ */
+static uint8_t DispatcherDefer(dispatcher_base_t *const pDispatcher,
+                               void const *const pItem,
+                               uint16_t length)
+{
+    dispatcher_defer_t *pDefer = &pDispatcher->defer;
+
+    if (pDefer->used == pDefer->count)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,deferred event store full,event dropped", __LINE__);
+        return DISPATCHER_ERR_DEFER_FULL;
+    }
+
+    uint8_t *pSlot = &pDefer->storage[((pDefer->head + pDefer->used) % pDefer->count) * pDefer->stride];
+
+    *(uint32_t *)(void *)pSlot = length;
+    if (pSlot + DEFER_HEADER_SIZE != (uint8_t const *)pItem)
+    {
+        (void)memcpy(pSlot + DEFER_HEADER_SIZE, pItem, length);
+    }
+    pDefer->used++;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Take the oldest deferred event off the store, its slot stays untouched
+ *  until the next defer so it can be dispatched in place.
+ */
+static void *DispatcherRecallNext(dispatcher_base_t *const pDispatcher, uint16_t *pLength)
+{
+    dispatcher_defer_t *pDefer = &pDispatcher->defer;
+    uint8_t *pSlot = &pDefer->storage[pDefer->head * pDefer->stride];
+
+    pDefer->head = (uint16_t)((pDefer->head + 1u) % pDefer->count);
+    pDefer->used--;
+    pDefer->recall--;
+    *pLength = (uint16_t)*(uint32_t *)(void *)pSlot;
+    return pSlot + DEFER_HEADER_SIZE;
+}
+
+/*
+ *  Fill the exit and entry chains of a path. States are left up to the
+ *  innermost state containing both source and target, a transition to the
+ *  source itself or one of its superstates also leaves and enters the
+ *  target again.
+ */
+static uint8_t DispatcherPath(dispatcher_base_t *const pDispatcher,
+                              dispatcher_path_t *const pPath,
+                              dispatcher_stateHandler_t target)
+{
+    dispatcher_stateHandler_t sources[DISPATCHER_HSM_MAX_DEPTH];
+    dispatcher_stateHandler_t targets[DISPATCHER_HSM_MAX_DEPTH];
+    dispatcher_stateHandler_t state = NULL;
+    uint8_t sourceDepth = 0, targetDepth = 0;
+
+    for (state = pPath->source; state != NULL && sourceDepth < DISPATCHER_HSM_MAX_DEPTH; sourceDepth++)
+    {
+        sources[sourceDepth] = state;
+        state = DispatcherParent(pDispatcher, state);
+    }
+    for (state = (state == NULL) ? target : NULL; state != NULL && targetDepth < DISPATCHER_HSM_MAX_DEPTH; targetDepth++)
+    {
+        targets[targetDepth] = state;
+        state = DispatcherParent(pDispatcher, state);
+    }
+    if (state != NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,states nested deeper than DISPATCHER_HSM_MAX_DEPTH", __LINE__);
+        return DISPATCHER_ERR_PROCESS_FAIL;
+    }
+
+    // innermost common superstate, target chain up to it is entered
+    dispatcher_stateHandler_t common = NULL;
+    uint8_t entryCount = targetDepth;
+
+    for (uint8_t i = 0; i < targetDepth && common == NULL; i++)
+    {
+        for (uint8_t j = 0; j < sourceDepth; j++)
+        {
+            if (targets[i] == sources[j])
+            {
+                common = targets[i];
+                entryCount = i;
+                break;
+            }
+        }
+    }
+    if (common == target)
+    {
+        common = (targetDepth > 1) ? targets[1] : NULL;
+        entryCount = 1;
+    }
+
+    // the active state may be a substate of source, its chain is walked up to common
+    pPath->exitCount = 0;
+    for (state = pPath->active; state != common; state = DispatcherParent(pDispatcher, state))
+    {
+        if (state == NULL || pPath->exitCount == DISPATCHER_HSM_MAX_DEPTH)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,states nested deeper than DISPATCHER_HSM_MAX_DEPTH", __LINE__);
+            return DISPATCHER_ERR_PROCESS_FAIL;
+        }
+        pPath->exits[pPath->exitCount++] = state;
+    }
+
+    pPath->entryCount = entryCount;
+    for (uint8_t i = 0; i < entryCount; i++)
+    {
+        pPath->entries[i] = targets[entryCount - 1u - i];
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Hierarchical transition, the path of every active / source / target
+ *  triple is computed once and then replayed from the cache.
+ */
+static uint8_t DispatcherTransition(dispatcher_base_t *const pDispatcher,
+                                    dispatcher_stateHandler_t source,
+                                    dispatcher_stateHandler_t target)
+{
+    dispatcher_path_t *pPath = NULL;
+    dispatcher_eventBase_t event = {.sig = DISPATCHER_SIGNAL_EXIT};
+
+    for (uint8_t i = 0; i < pDispatcher->pathCount; i++)
+    {
+        dispatcher_path_t *pEntry = &pDispatcher->paths[i];
+
+        if (pEntry->target == target && pEntry->source == source && pEntry->active == pDispatcher->active)
+        {
+            pPath = pEntry;
+            break;
+        }
+    }
+
+    if (pPath == NULL)
+    {
+        // replaced round robin, a failed lookup leaves the entry unusable
+        pPath = &pDispatcher->paths[pDispatcher->pathNext];
+        pDispatcher->pathNext = (uint8_t)((pDispatcher->pathNext + 1u) % pDispatcher->pathCount);
+        pPath->active = pDispatcher->active;
+        pPath->source = source;
+        pPath->target = NULL;
+        if (DispatcherPath(pDispatcher, pPath, target) != DISPATCHER_ERR_CLEAR)
+        {
+            return DISPATCHER_ERR_PROCESS_FAIL;
+        }
+        pPath->target = target;
+    }
+
+    for (uint8_t i = 0; i < pPath->exitCount; i++)
+    {
+        TraceRecord(pDispatcher, DISPATCHER_TRACE_EXIT, 0, event.sig, TRACE_STATE(pPath->exits[i]));
+        pPath->exits[i](pDispatcher, &event);
+    }
+    event.sig = DISPATCHER_SIGNAL_ENTRY;
+    pDispatcher->active = target;
+    DispatcherFilterSelect(pDispatcher);
+    for (uint8_t i = 0; i < pPath->entryCount; i++)
+    {
+        TraceRecord(pDispatcher, DISPATCHER_TRACE_ENTRY, 0, event.sig, TRACE_STATE(pPath->entries[i]));
+        pPath->entries[i](pDispatcher, &event);
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Reaction of a table driven state, signals past the table go to the
+ *  superstate.
+ */
+static uint8_t DispatcherTableRun(dispatcher_base_t *const pDispatcher,
+                                  dispatcher_eventBase_t const *const pEvent,
+                                  dispatcher_table_t const *const pTable)
+{
+    if (pEvent->sig >= pTable->signalCount)
+    {
+        if (pTable->parent == NULL)
+        {
+            return DISPATCHER_SM_STATUS_IGNORED;
+        }
+        pDispatcher->next = pTable->parent;
+        return DISPATCHER_SM_STATUS_SUPER;
+    }
+
+    // rows without a row of their own hold the unhandled action of the state
+    dispatcher_tableRow_t const *pRow = &pTable->rows[pEvent->sig];
+    uint8_t status = (pRow->action != NULL) ? pRow->action(pDispatcher, pEvent) : DISPATCHER_SM_STATUS_HANDLED;
+
+    if (pRow->target != NULL && status == DISPATCHER_SM_STATUS_HANDLED)
+    {
+        pDispatcher->next = pRow->target;
+        status = DISPATCHER_SM_STATUS_TRANSITION;
+    }
+    return status;
+}
+
+/*
+ *  Call a state handler, the table of the active state is run directly.
+ */
+static inline uint8_t DispatcherCall(dispatcher_base_t *const pDispatcher,
+                                     dispatcher_stateHandler_t handler,
+                                     dispatcher_eventBase_t const *const pEvent)
+{
+    dispatcher_table_t const *pTable = pDispatcher->table;
+
+    if (pTable != NULL && pTable->state == handler)
+    {
+        return DispatcherTableRun(pDispatcher, pEvent, pTable);
+    }
+    return handler(pDispatcher, pEvent);
+}
+
+/*
+ *  Run one queue item through the active handler, EXIT and ENTRY of a
+ *  transition use a local event so pItem may point into the queue.
+ */
+static uint8_t DispatcherDispatch(dispatcher_base_t *const pDispatcher,
+                                  void const *const pItem,
+                                  uint16_t length)
+{
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    dispatcher_smStatus_t status = 0;
+    dispatcher_eventBase_t event = {.sig = DISPATCHER_SIGNAL_EXIT};
+    dispatcher_eventBase_t const *pEvent = (dispatcher_eventBase_t const *)pItem;
+    void *pShared = NULL;
+    uint32_t start = StatsStart(pDispatcher);
+
+    // events posted by reference live in a pool, the slot only holds the pointer
+    if (pEvent->sig == DISPATCHER_SIGNAL_REF)
+    {
+        (void)memcpy(&pShared, (uint8_t const *)pItem + offsetof(dispatcher_eventRef_t, pEvent), sizeof(pShared));
+        pEvent = (dispatcher_eventBase_t const *)pShared;
+    }
+
+    dispatcher_stateHandler_t handler = pDispatcher->active;
+
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_HANDLER_START, 0, pEvent->sig, TRACE_STATE(handler));
+
+    // unhandled events bubble up to the superstates
+    status = DispatcherCall(pDispatcher, handler, pEvent);
+    while (status == DISPATCHER_SM_STATUS_SUPER && pDispatcher->next != NULL)
+    {
+        handler = pDispatcher->next;
+        status = DispatcherCall(pDispatcher, handler, pEvent);
+    }
+
+    if (status == DISPATCHER_SM_STATUS_DEFERRED)
+    {
+        // the store keeps the reference of a pool event until it is recalled
+        ret = DispatcherDefer(pDispatcher, pItem, length);
+        if (ret == DISPATCHER_ERR_CLEAR)
+        {
+            pShared = NULL;
+        }
+    }
+    else if (status == DISPATCHER_SM_STATUS_TRANSITION && pDispatcher->paths != NULL && pDispatcher->next != NULL)
+    {
+        TraceRecord(pDispatcher, DISPATCHER_TRACE_TRANSITION, 0, pEvent->sig, TRACE_STATE(pDispatcher->next));
+        ret = DispatcherTransition(pDispatcher, handler, pDispatcher->next);
+    }
+    else if (status == DISPATCHER_SM_STATUS_TRANSITION)
+    {
+        TraceRecord(pDispatcher, DISPATCHER_TRACE_TRANSITION, 0, pEvent->sig, TRACE_STATE(pDispatcher->next));
+        TraceRecord(pDispatcher, DISPATCHER_TRACE_EXIT, 0, event.sig, TRACE_STATE(pDispatcher->active));
+        pDispatcher->active(pDispatcher, &event);
+
+        if (pDispatcher->next != NULL)
+        {
+            pDispatcher->active = pDispatcher->next;
+            DispatcherFilterSelect(pDispatcher);
+            event.sig = DISPATCHER_SIGNAL_ENTRY;
+            TraceRecord(pDispatcher, DISPATCHER_TRACE_ENTRY, 0, event.sig, TRACE_STATE(pDispatcher->active));
+            pDispatcher->active(pDispatcher, &event);
+        }
+        else
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,invalid transition request,handler is NULL", __LINE__);
+            ret = DISPATCHER_ERR_PROCESS_FAIL;
+        }
+    }
+    else if (status == DISPATCHER_SM_STATUS_IGNORED)
+    {
+        DispatcherFilterLearn(pDispatcher, pEvent->sig);
+    }
+
+    StatsHandled(pDispatcher, pEvent->sig, start,
+                 status == DISPATCHER_SM_STATUS_TRANSITION && ret == DISPATCHER_ERR_CLEAR);
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_HANDLER_END, 0, pEvent->sig, status);
+    if (pShared != NULL)
+    {
+        (void)dispatcher_PoolRelease(pShared);
+    }
+    return ret;
+}
+
+static dispatcher_queue_t *DispatcherLane(dispatcher_base_t *const pDispatcher, uint8_t priority)
+{
+    return (priority == 0) ? &pDispatcher->queue : &pDispatcher->lanes[priority - 1u].queue;
+}
+
+/*
+ *  Take the next event from the highest priority lane holding one. A lane
+ *  bit is only cleared after the lane was found empty and stays clear only
+ *  if a second look finds it empty too, so a post racing the clear is never
+ *  lost. Without lanes this is the plain queue acquire.
+ */
+static dispatcher_portStatus_t DispatcherAcquire(dispatcher_base_t *const pDispatcher,
+                                                 void **ppItem,
+                                                 dispatcher_queue_t **ppQueue,
+                                                 dispatcher_portTick_t timeout)
+{
+    if (pDispatcher->laneCount == 0)
+    {
+        *ppQueue = &pDispatcher->queue;
+        return dispatcher_QueueAcquire(&pDispatcher->queue, pDispatcher->eventStorage, ppItem, timeout);
+    }
+
+    dispatcher_waiter_t *pWaiter = &pDispatcher->waiter;
+    bool timed = (timeout != 0 && timeout != DISPATCHER_PORT_MAX_DELAY);
+    dispatcher_portTick_t start = timed ? dispatcher_PortGetTick() : 0;
+
+    for (;;)
+    {
+        uint32_t ready = dispatcher_WaiterReady(pWaiter);
+
+        while (ready != 0u)
+        {
+            uint8_t priority = (uint8_t)(31 - __builtin_clz(ready));
+            uint32_t bit = 1u << priority;
+            dispatcher_queue_t *pQueue = DispatcherLane(pDispatcher, priority);
+
+            if (dispatcher_QueueAcquire(pQueue, pDispatcher->eventStorage, ppItem, 0) == DISPATCHER_PORT_OK)
+            {
+                *ppQueue = pQueue;
+                return DISPATCHER_PORT_OK;
+            }
+
+            dispatcher_WaiterClear(pWaiter, bit);
+            if (dispatcher_QueueAcquire(pQueue, pDispatcher->eventStorage, ppItem, 0) == DISPATCHER_PORT_OK)
+            {
+                dispatcher_WaiterMark(pWaiter, bit);
+                *ppQueue = pQueue;
+                return DISPATCHER_PORT_OK;
+            }
+            ready &= ~bit;
+        }
+
+        if (timeout == 0)
+        {
+            return DISPATCHER_PORT_EMPTY;
+        }
+
+        dispatcher_portTick_t elapsed = dispatcher_PortGetTick() - start;
+        if (timeout != DISPATCHER_PORT_MAX_DELAY && elapsed >= timeout)
+        {
+            return DISPATCHER_PORT_EMPTY;
+        }
+        (void)dispatcher_WaiterWait(pWaiter, (timeout == DISPATCHER_PORT_MAX_DELAY) ? timeout : (timeout - elapsed));
+    }
+}
+
+/*
+ *  Bring the timing wheel up to the current tick and take the oldest
+ *  expired time event. A periodic one is rearmed from its expiry, a late
+ *  one by more than a period expires on the next tick.
+ */
+static dispatcher_timeEvent_t *DispatcherExpired(dispatcher_base_t *const pDispatcher)
+{
+    dispatcher_wheel_t *pWheel = pDispatcher->wheel;
+    dispatcher_wheelNode_t *pNode;
+
+    dispatcher_WheelAdvance(pWheel, dispatcher_PortGetTick());
+    pNode = dispatcher_WheelTakeExpired(pWheel);
+    if (pNode == NULL)
+    {
+        return NULL;
+    }
+
+    dispatcher_timeEvent_t *pTimeEvent = (dispatcher_timeEvent_t *)((uint8_t *)pNode -
+                                                                    offsetof(dispatcher_timeEvent_t, node));
+
+    if (pTimeEvent->period != 0)
+    {
+        dispatcher_portTick_t ticks = pNode->expiry + pTimeEvent->period - pWheel->now;
+
+        dispatcher_WheelArm(pWheel, pNode, (ticks > pTimeEvent->period) ? 1u : ticks);
+    }
+    return pTimeEvent;
+}
+
+/*
+ *  Take the next event of a dispatcher, recalled events go first, straight
+ *  from the deferred event store, then expired time events. Ring queues
+ *  hand out the slot itself, the port queue copies into eventStorage.
+ *  pQueue stays NULL for a recalled event or a time event.
+ *  With time events armed the wait is cut at the next wheel deadline and
+ *  resumed with what is left of the timeout.
+ */
+static dispatcher_portStatus_t DispatcherTake(dispatcher_base_t *const pDispatcher,
+                                              void **ppItem,
+                                              dispatcher_queue_t **ppQueue,
+                                              uint16_t *pLength,
+                                              dispatcher_portTick_t timeout)
+{
+    *ppQueue = NULL;
+    if (pDispatcher->defer.recall != 0)
+    {
+        *ppItem = DispatcherRecallNext(pDispatcher, pLength);
+        return DISPATCHER_PORT_OK;
+    }
+
+    bool timed = (timeout != 0 && timeout != DISPATCHER_PORT_MAX_DELAY);
+    dispatcher_portTick_t start = timed ? dispatcher_PortGetTick() : 0;
+
+    for (;;)
+    {
+        dispatcher_portTick_t wait = timeout;
+        bool wheelWait = false;
+
+        if (timed)
+        {
+            dispatcher_portTick_t elapsed = dispatcher_PortGetTick() - start;
+
+            wait = (elapsed < timeout) ? (timeout - elapsed) : 0;
+        }
+
+        if (pDispatcher->wheel != NULL)
+        {
+            dispatcher_timeEvent_t *pTimeEvent = DispatcherExpired(pDispatcher);
+
+            if (pTimeEvent != NULL)
+            {
+                *ppItem = &pTimeEvent->base;
+                *ppQueue = NULL;
+                *pLength = sizeof(dispatcher_eventBase_t);
+                RecordEvent(pDispatcher, *ppItem, *pLength, DISPATCHER_RECORD_FLAG_TIME);
+                return DISPATCHER_PORT_OK;
+            }
+            dispatcher_portTick_t deadline = dispatcher_WheelTimeout(pDispatcher->wheel);
+
+            if (deadline < wait)
+            {
+                wheelWait = true;
+                wait = deadline;
+            }
+        }
+
+        dispatcher_portStatus_t state = DispatcherAcquire(pDispatcher, ppItem, ppQueue, wait);
+
+        if (state == DISPATCHER_PORT_OK)
+        {
+            *pLength = dispatcher_QueueItemLength(*ppQueue);
+            return state;
+        }
+        if (!wheelWait)
+        {
+            return state;
+        }
+    }
+}
+
+/*
+ *  Coalescing state of a signal, NULL if its posts are queued as usual.
+ */
+static dispatcher_coalesce_t *DispatcherCoalesceCell(dispatcher_base_t *const pDispatcher,
+                                                     dispatcher_eventSignal_t signal)
+{
+    if (signal >= pDispatcher->coalesceCount ||
+        pDispatcher->coalesce[signal].policy == DISPATCHER_COALESCE_NONE)
+    {
+        return NULL;
+    }
+    return &pDispatcher->coalesce[signal];
+}
+
+/*
+ *  A queued event of a coalesced signal stands for its pending event too,
+ *  the newest pending event replaces it or is merged into it (the slot is
+ *  owned by the event loop until released). A bare item queued for a
+ *  pending event already taken by an earlier item is dropped (NULL).
+ */
+static void *DispatcherCoalesced(dispatcher_base_t *const pDispatcher,
+                                 void *const pItem,
+                                 uint16_t *pLength,
+                                 void **ppShared)
+{
+    dispatcher_coalesce_t *pCell = DispatcherCoalesceCell(pDispatcher, ((dispatcher_eventBase_t *)pItem)->sig);
+
+    *ppShared = NULL;
+    if (pCell == NULL)
+    {
+        return pItem;
+    }
+
+    uint8_t queued = __atomic_exchange_n(&pCell->queued, COALESCE_IDLE, __ATOMIC_ACQ_REL);
+    void *pPending = __atomic_exchange_n(&pCell->pending, NULL, __ATOMIC_ACQ_REL);
+
+    if (pPending == NULL)
+    {
+        return (queued == COALESCE_QUEUED_BARE) ? NULL : pItem;
+    }
+
+    if (pCell->policy == DISPATCHER_COALESCE_MERGE && queued != COALESCE_QUEUED_BARE)
+    {
+        pCell->merge((dispatcher_eventBase_t *)pItem, (dispatcher_eventBase_t const *)pPending);
+        (void)dispatcher_PoolRelease(pPending);
+        return pItem;
+    }
+    *ppShared = pPending;
+    *pLength = pDispatcher->queue.itemSize;
+    return pPending;
+}
+
+/*
+ *  Run an event taken by DispatcherTake to completion and give its slot
+ *  back.
+ */
+static uint8_t DispatcherHandle(dispatcher_base_t *const pDispatcher,
+                                void *pItem,
+                                dispatcher_queue_t *const pQueue,
+                                uint16_t length)
+{
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    void *pShared = NULL;
+
+    StatsTaken(pDispatcher, pQueue);
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_DEQUEUE, 0, ((dispatcher_eventBase_t const *)pItem)->sig, length);
+
+    // slots committed with a reserved signal only give their slot back
+    if (((dispatcher_eventBase_t const *)pItem)->sig == DISPATCHER_SIGNAL_VOID)
+    {
+        pItem = NULL;
+    }
+    // recalled events and time events are never coalesced
+    else if (pQueue != NULL && pDispatcher->coalesce != NULL)
+    {
+        pItem = DispatcherCoalesced(pDispatcher, pItem, &length, &pShared);
+    }
+
+    if (pItem != NULL)
+    {
+        // recalled events are left out, the replayed handlers recall them again
+        if (pQueue != NULL)
+        {
+            RecordEvent(pDispatcher, pItem, length, 0);
+        }
+        ret = DispatcherDispatch(pDispatcher, pItem, length);
+    }
+
+    if (pShared != NULL)
+    {
+        (void)dispatcher_PoolRelease(pShared);
+    }
+    if (pQueue != NULL)
+    {
+        dispatcher_QueueRelease(pQueue);
+    }
+    return ret;
+}
+
+/*
+ *  Event loop of every variant, only the first event waits (up to
+ *  timeout), the rest of the batch is what is already queued.
+ */
+static uint8_t DispatcherLoop(dispatcher_base_t *const pDispatcher,
+                              uint16_t maxEvents,
+                              uint32_t budgetMs,
+                              dispatcher_portTick_t timeout,
+                              uint16_t *pProcessed)
+{
+    if (pProcessed != NULL)
+    {
+        *pProcessed = 0;
+    }
+
+    if (pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (maxEvents == 0)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,requied non zero arguments", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pDispatcher->active == NULL || !dispatcher_QueueIsValid(&pDispatcher->queue) ||
+        (pDispatcher->eventStorage == NULL && pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    uint16_t processed = 0;
+    dispatcher_portTick_t start = 0;
+    dispatcher_portTick_t budget = DISPATCHER_PORT_MS_TO_TICKS(budgetMs);
+
+    if (budgetMs != 0 && budget == 0)
+    {
+        budget = 1; // budget shorter than a tick
+    }
+
+    while (processed < maxEvents)
+    {
+        void *pItem = NULL;
+        dispatcher_queue_t *pQueue = NULL;
+        uint16_t length = 0;
+
+        if (DispatcherTake(pDispatcher,
+                           &pItem,
+                           &pQueue,
+                           &length,
+                           (processed == 0) ? timeout : 0) != DISPATCHER_PORT_OK)
+        {
+            if (processed == 0 && timeout == DISPATCHER_PORT_MAX_DELAY)
+            {
+                DISPATCHER_LOG_ERROR(TAG, "%d,dequeue operation failed", __LINE__);
+                ret = DISPATCHER_ERR_PROCESS_FAIL;
+            }
+            else if (processed == 0)
+            {
+                ret = DISPATCHER_ERR_QUEUE_EMPTY;
+            }
+            break;
+        }
+
+        if (processed == 0 && budgetMs != 0)
+        {
+            start = dispatcher_PortGetTick();
+        }
+
+        ret = DispatcherHandle(pDispatcher, pItem, pQueue, length);
+        processed++;
+
+        if (ret != DISPATCHER_ERR_CLEAR ||
+            (budgetMs != 0 && (dispatcher_PortGetTick() - start) >= budget))
+        {
+            break;
+        }
+    }
+
+    if (pProcessed != NULL)
+    {
+        *pProcessed = processed;
+    }
+    return ret;
+}
+
+uint8_t dispatcher_EventLoop(dispatcher_base_t *const pDispatcher)
+{
+    return DispatcherLoop(pDispatcher, 1, 0, DISPATCHER_PORT_MAX_DELAY, NULL);
+}
+
+uint8_t dispatcher_EventLoopBatch(dispatcher_base_t *const pDispatcher,
+                                  uint16_t maxEvents,
+                                  uint32_t budgetMs,
+                                  uint16_t *pProcessed)
+{
+    return DispatcherLoop(pDispatcher, maxEvents, budgetMs, DISPATCHER_PORT_MAX_DELAY, pProcessed);
+}
+
+uint8_t dispatcher_EventLoopTimeout(dispatcher_base_t *const pDispatcher, uint32_t timeoutMs)
+{
+    return DispatcherLoop(pDispatcher, 1, 0, DispatcherTicks(timeoutMs), NULL);
+}
+
+/*
+ *  Claim the single queue item of a coalesced signal, fails while one is
+ *  queued.
+ */
+static bool DispatcherCoalesceClaim(dispatcher_coalesce_t *const pCell, uint8_t queued)
+{
+    uint8_t idle = COALESCE_IDLE;
+
+    return __atomic_compare_exchange_n(&pCell->queued, &idle, queued, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/*
+ *  Posts of a coalesced signal claim its queue item, the first one is
+ *  queued as usual. While it is queued the event is copied to a pool
+ *  block and replaces or is merged into the pending one. If the queued
+ *  item was taken meanwhile a bare item is queued for the pending event.
+ *  Returns true when nothing is left to queue, pRet then holds the result.
+ *  Lock free, safe from ISR.
+ */
+static bool DispatcherCoalesce(dispatcher_base_t *const pDispatcher,
+                               dispatcher_eventBase_t const *const pEvent,
+                               uint16_t size,
+                               uint8_t *pRet)
+{
+    dispatcher_coalesce_t *pCell = (pDispatcher->coalesce != NULL)
+                                       ? DispatcherCoalesceCell(pDispatcher, pEvent->sig)
+                                       : NULL;
+    void *pMine = NULL;
+
+    *pRet = DISPATCHER_ERR_CLEAR;
+    if (pCell == NULL || DispatcherCoalesceClaim(pCell, COALESCE_QUEUED_VALUE))
+    {
+        return false;
+    }
+
+    *pRet = dispatcher_EventNew(pDispatcher->queue.itemSize, &pMine);
+    if (*pRet != DISPATCHER_ERR_CLEAR)
+    {
+        return true;
+    }
+    (void)memcpy(pMine, pEvent, size);
+
+    if (pCell->policy == DISPATCHER_COALESCE_LATEST)
+    {
+        void *pOld = __atomic_exchange_n(&pCell->pending, pMine, __ATOMIC_ACQ_REL);
+
+        if (pOld != NULL)
+        {
+            (void)dispatcher_PoolRelease(pOld);
+        }
+    }
+    else
+    {
+        // take the pending event out, merge and put it back, a post storing
+        // its own in between is merged on the next round
+        for (;;)
+        {
+            void *pOld = __atomic_exchange_n(&pCell->pending, NULL, __ATOMIC_ACQ_REL);
+            void *pEmpty = NULL;
+
+            if (pOld != NULL)
+            {
+                pCell->merge((dispatcher_eventBase_t *)pOld, (dispatcher_eventBase_t const *)pMine);
+                (void)dispatcher_PoolRelease(pMine);
+                pMine = pOld;
+            }
+            if (__atomic_compare_exchange_n(&pCell->pending, &pEmpty, pMine, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+    }
+    return !DispatcherCoalesceClaim(pCell, COALESCE_QUEUED_BARE);
+}
+
+/*
+ *  A coalesced signal whose item could not be queued gives its claim back.
+ *  A latest value left pending would be taken for newer than the next
+ *  queued one, it is dropped with the failed post.
+ */
+static void DispatcherCoalesceAbort(dispatcher_base_t *const pDispatcher, dispatcher_eventSignal_t signal)
+{
+    dispatcher_coalesce_t *pCell = (pDispatcher->coalesce != NULL)
+                                       ? DispatcherCoalesceCell(pDispatcher, signal)
+                                       : NULL;
+
+    if (pCell == NULL)
+    {
+        return;
+    }
+
+    if (pCell->policy == DISPATCHER_COALESCE_LATEST)
+    {
+        void *pPending = __atomic_exchange_n(&pCell->pending, NULL, __ATOMIC_ACQ_REL);
+
+        if (pPending != NULL)
+        {
+            (void)dispatcher_PoolRelease(pPending);
+        }
+    }
+    __atomic_store_n(&pCell->queued, COALESCE_IDLE, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Drop an event evicted from the queue, only its head was copied out :
+ *  the reference of a pool event is given back, a coalesced signal drops
+ *  its pending event with it.
+ */
+static void DispatcherDiscard(dispatcher_base_t *const pDispatcher, dispatcher_eventRef_t const *const pHead)
+{
+    if (pHead->base.sig == DISPATCHER_SIGNAL_REF)
+    {
+        (void)dispatcher_PoolRelease(pHead->pEvent);
+        return;
+    }
+
+    dispatcher_coalesce_t *pCell = (pDispatcher->coalesce != NULL)
+                                       ? DispatcherCoalesceCell(pDispatcher, pHead->base.sig)
+                                       : NULL;
+
+    if (pCell != NULL)
+    {
+        void *pPending = __atomic_exchange_n(&pCell->pending, NULL, __ATOMIC_ACQ_REL);
+
+        __atomic_store_n(&pCell->queued, COALESCE_IDLE, __ATOMIC_RELEASE);
+        if (pPending != NULL)
+        {
+            (void)dispatcher_PoolRelease(pPending);
+        }
+    }
+}
+
+/*
+ *  Queue an event, a full queue is handled by the overflow policy. Drop
+ *  oldest evicts one queued event per attempt, overwrite all of them, the
+ *  attempts are bounded as producers racing for the freed slots may win.
+ *  ISR posts (pWoken not NULL) never wait. Every event lost counts once.
+ */
+/*
+ *  Posts outside DispatcherSend follow the dispatcher policy as far as
+ *  waiting goes, only a blocking one waits for the post timeout. They do
+ *  not evict, drop oldest / overwrite fail at once like drop newest.
+ */
+static inline dispatcher_portTick_t DispatcherPostTimeout(dispatcher_base_t const *const pDispatcher)
+{
+    return (pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK) ? pDispatcher->postTimeout : 0;
+}
+
+static inline void DispatcherDropped(dispatcher_base_t *const pDispatcher, uint32_t count)
+{
+    (void)__atomic_fetch_add(&pDispatcher->drops[pDispatcher->overflow], count, __ATOMIC_RELAXED);
+}
+
+static uint8_t DispatcherSend(dispatcher_base_t *const pDispatcher,
+                              dispatcher_eventBase_t const *const pEvent,
+                              uint16_t size,
+                              dispatcher_overflow_t overflow,
+                              dispatcher_portTick_t timeout,
+                              int *pWoken)
+{
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    uint8_t flags = (pWoken != NULL) ? DISPATCHER_TRACE_FLAG_ISR : 0u;
+
+    // the event loop would take the event for a pool reference
+    if (DispatcherSignalReserved(pEvent->sig))
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    if (DispatcherFiltered(pDispatcher, pEvent->sig, flags))
+    {
+        return DISPATCHER_ERR_FILTERED;
+    }
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_POST, flags, pEvent->sig, size);
+    if (DispatcherCoalesce(pDispatcher, pEvent, size, &ret))
+    {
+        StatsPosted(pDispatcher, (ret == DISPATCHER_ERR_CLEAR) ? 1u : 0u);
+        return ret;
+    }
+
+    dispatcher_queue_t *pQueue = &pDispatcher->queue;
+    uint16_t headSize = (pQueue->itemSize < sizeof(dispatcher_eventRef_t)) ? pQueue->itemSize
+                                                                            : (uint16_t)sizeof(dispatcher_eventRef_t);
+    dispatcher_portStatus_t state = DISPATCHER_PORT_FULL;
+    int woken = 0;
+
+    for (uint32_t attempt = 0; attempt <= pQueue->itemCount; attempt++)
+    {
+        int sendWoken = 0;
+
+        state = (pWoken != NULL)
+                    ? dispatcher_QueueSendSizedFromIsr(pQueue, pEvent, size, &sendWoken)
+                    : dispatcher_QueueSendSized(pQueue, pEvent, size,
+                                                (overflow == DISPATCHER_OVERFLOW_BLOCK) ? timeout : 0);
+        woken |= sendWoken;
+        if (state != DISPATCHER_PORT_FULL ||
+            (overflow != DISPATCHER_OVERFLOW_DROP_OLDEST && overflow != DISPATCHER_OVERFLOW_OVERWRITE))
+        {
+            break;
+        }
+
+        do
+        {
+            dispatcher_eventRef_t head = {0};
+            int evictWoken = 0;
+
+            if (dispatcher_QueueEvict(pQueue, &head, headSize, &evictWoken) != DISPATCHER_PORT_OK)
+            {
+                break;
+            }
+            woken |= evictWoken;
+            TraceRecord(pDispatcher, DISPATCHER_TRACE_DROP, flags, head.base.sig, overflow);
+            DispatcherDiscard(pDispatcher, &head);
+            (void)__atomic_fetch_add(&pDispatcher->drops[overflow], 1u, __ATOMIC_RELAXED);
+        } while (overflow == DISPATCHER_OVERFLOW_OVERWRITE);
+    }
+
+    if (pWoken != NULL)
+    {
+        *pWoken = woken;
+    }
+
+    if (state == DISPATCHER_PORT_OK)
+    {
+        StatsPosted(pDispatcher, 1u);
+        return DISPATCHER_ERR_CLEAR;
+    }
+
+    DispatcherCoalesceAbort(pDispatcher, pEvent->sig);
+    if (state != DISPATCHER_PORT_FULL)
+    {
+        return DISPATCHER_ERR_PROCESS_FAIL;
+    }
+    (void)__atomic_fetch_add(&pDispatcher->drops[overflow], 1u, __ATOMIC_RELAXED);
+    TraceRecord(pDispatcher, DISPATCHER_TRACE_DROP, flags, pEvent->sig, overflow);
+    return DISPATCHER_ERR_QUEUE_FULL;
+}
+
+uint8_t dispatcher_Post(dispatcher_base_t *const pDispatcher,
+                        dispatcher_eventBase_t const *const pEvent)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    uint8_t ret = DispatcherSend(pDispatcher,
+                                 pEvent,
+                                 pDispatcher->queue.itemSize,
+                                 (dispatcher_overflow_t)pDispatcher->overflow,
+                                 pDispatcher->postTimeout,
+                                 NULL);
+
+    // filtered posts and a full queue of a fail fast or dropping policy are only counted
+    if (ret != DISPATCHER_ERR_CLEAR && ret != DISPATCHER_ERR_FILTERED &&
+        (ret != DISPATCHER_ERR_QUEUE_FULL || pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,post failed,error %d", __LINE__, ret);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostFromIsr(dispatcher_base_t *const pDispatcher,
+                               dispatcher_eventBase_t const *const pEvent,
+                               int flags)
+{
+
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+    int woken = 0;
+    uint8_t ret = DispatcherSend(pDispatcher,
+                                 pEvent,
+                                 pDispatcher->queue.itemSize,
+                                 (dispatcher_overflow_t)pDispatcher->overflow,
+                                 0,
+                                 &woken);
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostOverflow(dispatcher_base_t *const pDispatcher,
+                                dispatcher_eventBase_t const *const pEvent,
+                                dispatcher_overflow_t overflow,
+                                uint32_t timeoutMs)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    uint8_t ret = DispatcherOverflowCheck(pDispatcher->queue.type, pDispatcher->queue.itemSize, overflow);
+
+    if (ret != DISPATCHER_ERR_CLEAR)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid overflow policy for queue backend", __LINE__);
+        return ret;
+    }
+
+    ret = DispatcherSend(pDispatcher, pEvent, pDispatcher->queue.itemSize, overflow, DispatcherTicks(timeoutMs), NULL);
+    if (ret != DISPATCHER_ERR_CLEAR && ret != DISPATCHER_ERR_FILTERED &&
+        (ret != DISPATCHER_ERR_QUEUE_FULL || overflow == DISPATCHER_OVERFLOW_BLOCK))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,post failed,error %d", __LINE__, ret);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostOverflowFromIsr(dispatcher_base_t *const pDispatcher,
+                                       dispatcher_eventBase_t const *const pEvent,
+                                       dispatcher_overflow_t overflow,
+                                       int flags)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    uint8_t ret = DispatcherOverflowCheck(pDispatcher->queue.type, pDispatcher->queue.itemSize, overflow);
+
+    if (ret != DISPATCHER_ERR_CLEAR)
+    {
+        return ret;
+    }
+
+    int woken = 0;
+
+    ret = DispatcherSend(pDispatcher, pEvent, pDispatcher->queue.itemSize, overflow, 0, &woken);
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+uint32_t dispatcher_DropCount(dispatcher_base_t const *const pDispatcher,
+                              dispatcher_overflow_t overflow)
+{
+    if (pDispatcher == NULL || overflow >= DISPATCHER_OVERFLOW_MAX)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&pDispatcher->drops[overflow], __ATOMIC_RELAXED);
+}
+
+uint8_t dispatcher_FilterInit(dispatcher_filter_t *const pFilter,
+                              dispatcher_stateHandler_t state,
+                              bool learn)
+{
+    if (pFilter == NULL || state == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    pFilter->state = state;
+    pFilter->learn = learn;
+    for (uint8_t i = 0; i < DISPATCHER_FILTER_WORDS; i++)
+    {
+        pFilter->accept[i] = learn ? UINT32_MAX : 0u;
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_FilterAccept(dispatcher_filter_t *const pFilter,
+                                dispatcher_eventSignal_t signal)
+{
+    if (pFilter == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    // signals past the filter words are never filtered
+    if (signal < DISPATCHER_FILTER_WORDS * 32u)
+    {
+        (void)__atomic_fetch_or(&pFilter->accept[signal / 32u], 1u << (signal % 32u), __ATOMIC_RELAXED);
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint32_t dispatcher_FilteredCount(dispatcher_base_t const *const pDispatcher)
+{
+    if (pDispatcher == NULL)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&pDispatcher->filtered, __ATOMIC_RELAXED);
+}
+
+uint8_t dispatcher_StatsGet(dispatcher_base_t const *const pDispatcher,
+                            dispatcher_stats_t *const pStats)
+{
+    if (pDispatcher == NULL || pStats == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_STATS_ENABLE)
+    pStats->posted = __atomic_load_n(&pDispatcher->stats.posted, __ATOMIC_RELAXED);
+    pStats->dispatched = __atomic_load_n(&pDispatcher->stats.dispatched, __ATOMIC_RELAXED);
+    pStats->dropped = 0;
+    pStats->highWater = __atomic_load_n(&pDispatcher->stats.highWater, __ATOMIC_RELAXED);
+    pStats->transitions = __atomic_load_n(&pDispatcher->stats.transitions, __ATOMIC_RELAXED);
+    for (uint8_t i = 0; i < DISPATCHER_OVERFLOW_MAX; i++)
+    {
+        pStats->dropped += __atomic_load_n(&pDispatcher->drops[i], __ATOMIC_RELAXED);
+    }
+    return DISPATCHER_ERR_CLEAR;
+#else
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_StatsSignal(dispatcher_base_t const *const pDispatcher,
+                               dispatcher_eventSignal_t signal,
+                               dispatcher_signalStats_t *const pStats)
+{
+    if (pDispatcher == NULL || pStats == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_STATS_ENABLE)
+    if (signal >= pDispatcher->signalStatsCount)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,no statistics for signal %u", __LINE__, signal);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    dispatcher_signalStats_t const *pSignal = &pDispatcher->signalStats[signal];
+
+    pStats->count = __atomic_load_n(&pSignal->count, __ATOMIC_RELAXED);
+    pStats->min = __atomic_load_n(&pSignal->min, __ATOMIC_RELAXED);
+    pStats->max = __atomic_load_n(&pSignal->max, __ATOMIC_RELAXED);
+    pStats->sum = __atomic_load_n(&pSignal->sum, __ATOMIC_RELAXED);
+    return DISPATCHER_ERR_CLEAR;
+#else
+    (void)signal;
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_StatsReset(dispatcher_base_t *const pDispatcher)
+{
+    if (pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_STATS_ENABLE)
+    __atomic_store_n(&pDispatcher->stats.posted, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&pDispatcher->stats.dispatched, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&pDispatcher->stats.highWater, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&pDispatcher->stats.transitions, 0u, __ATOMIC_RELAXED);
+    for (uint8_t i = 0; i < DISPATCHER_OVERFLOW_MAX; i++)
+    {
+        __atomic_store_n(&pDispatcher->drops[i], 0u, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&pDispatcher->filtered, 0u, __ATOMIC_RELAXED);
+    for (uint16_t i = 0; i < pDispatcher->signalStatsCount; i++)
+    {
+        dispatcher_signalStats_t *pSignal = &pDispatcher->signalStats[i];
+
+        __atomic_store_n(&pSignal->count, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&pSignal->min, UINT32_MAX, __ATOMIC_RELAXED);
+        __atomic_store_n(&pSignal->max, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&pSignal->sum, 0u, __ATOMIC_RELAXED);
+    }
+    return DISPATCHER_ERR_CLEAR;
+#else
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_TraceInit(dispatcher_traceRecord_t *const records, uint32_t count)
+{
+    if (records == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_TRACE_ENABLE)
+    if (dispatcher_TraceRingInit(&gTrace, records, count) != DISPATCHER_PORT_OK)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,trace record count not a power of two", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    return DISPATCHER_ERR_CLEAR;
+#else
+    (void)count;
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_TraceStart(void)
+{
+#if (DISPATCHER_TRACE_ENABLE)
+    if (gTrace.records == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,trace not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+    dispatcher_TraceRingEnable(&gTrace, true);
+    return DISPATCHER_ERR_CLEAR;
+#else
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_TraceStop(void)
+{
+#if (DISPATCHER_TRACE_ENABLE)
+    dispatcher_TraceRingEnable(&gTrace, false);
+    return DISPATCHER_ERR_CLEAR;
+#else
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_TraceDump(dispatcher_traceWrite_t write, void *pArg)
+{
+    if (write == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_TRACE_ENABLE)
+    if (gTrace.records == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,trace not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+    (void)dispatcher_TraceRingDump(&gTrace, write, pArg);
+    return DISPATCHER_ERR_CLEAR;
+#else
+    (void)pArg;
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/*
+ *  Lines are written by the port when no sink is given.
+ */
+static void LogOutput(dispatcher_logSink_t sink, void *pArg, uint8_t level, char const *pLine)
+{
+    if (sink != NULL)
+    {
+        sink(level, pLine, pArg);
+        return;
+    }
+    DISPATCHER_PORT_LOG_LINE(pLine);
+}
+
+void dispatcher_LogDefer(uint8_t level,
+                         char const *tag,
+                         char const *format,
+                         uintptr_t const *args,
+                         uint8_t argCount)
+{
+    dispatcher_logRecord_t record = {
+        .tick = dispatcher_PortGetTick(),
+        .level = level,
+        .argCount = (argCount < DISPATCHER_LOG_MAX_ARGS) ? argCount : DISPATCHER_LOG_MAX_ARGS,
+        .tag = tag,
+        .format = format,
+    };
+
+    (void)memcpy(record.args, args, record.argCount * sizeof(uintptr_t));
+
+#if (DISPATCHER_LOG_DEFERRED)
+    if (dispatcher_QueueIsValid(&gLogQueue))
+    {
+        // never waits, a full ring loses the record and counts it
+        if (dispatcher_QueueSend(&gLogQueue, &record, 0) != DISPATCHER_PORT_OK)
+        {
+            (void)__atomic_fetch_add(&gLogDropped, 1u, __ATOMIC_RELAXED);
+        }
+        return;
+    }
+#endif
+
+    // before dispatcher_LogInit records are written at once
+    char line[DISPATCHER_LOG_LINE_SIZE];
+
+    (void)dispatcher_LogFormat(&record, line, sizeof(line));
+    LogOutput(NULL, NULL, level, line);
+}
+
+uint8_t dispatcher_LogInit(uint8_t *const storage, uint16_t count)
+{
+    if (storage == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_LOG_DEFERRED)
+    if (dispatcher_QueueIsValid(&gLogQueue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,log already initialized", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (dispatcher_WaiterInit(&gLogWaiter) != DISPATCHER_PORT_OK ||
+        dispatcher_QueueInit(&gLogQueue,
+                             DISPATCHER_QUEUE_TYPE_MPSC,
+                             (uint16_t)sizeof(dispatcher_logRecord_t),
+                             count,
+                             storage,
+                             &gLogWaiter) != DISPATCHER_PORT_OK)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,log ring initialization failed", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    return DISPATCHER_ERR_CLEAR;
+#else
+    (void)count;
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_LogDrain(dispatcher_logSink_t sink,
+                            void *pArg,
+                            uint32_t timeoutMs,
+                            uint16_t *pCount)
+{
+#if (DISPATCHER_LOG_DEFERRED)
+    if (!dispatcher_QueueIsValid(&gLogQueue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,log not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    dispatcher_logRecord_t record;
+    dispatcher_portTick_t timeout = DispatcherTicks(timeoutMs);
+    char line[DISPATCHER_LOG_LINE_SIZE];
+    uint16_t count = 0;
+
+    // only the first record is waited for, the rest is what is already there
+    while (count < UINT16_MAX && dispatcher_QueueReceive(&gLogQueue, &record, timeout) == DISPATCHER_PORT_OK)
+    {
+        (void)dispatcher_LogFormat(&record, line, sizeof(line));
+        LogOutput(sink, pArg, record.level, line);
+        timeout = 0;
+        count++;
+    }
+
+    uint32_t dropped = __atomic_load_n(&gLogDropped, __ATOMIC_RELAXED);
+
+    if (dropped != gLogReported)
+    {
+        dispatcher_logRecord_t lost = {
+            .tick = dispatcher_PortGetTick(),
+            .level = DISPATCHER_LOG_LEVEL_ERROR,
+            .argCount = 1,
+            .tag = TAG,
+            .format = "%u log records lost",
+            .args = {dropped - gLogReported},
+        };
+
+        (void)dispatcher_LogFormat(&lost, line, sizeof(line));
+        LogOutput(sink, pArg, lost.level, line);
+        gLogReported = dropped;
+    }
+
+    if (pCount != NULL)
+    {
+        *pCount = count;
+    }
+    return (count != 0) ? DISPATCHER_ERR_CLEAR : DISPATCHER_ERR_QUEUE_EMPTY;
+#else
+    (void)sink;
+    (void)pArg;
+    (void)timeoutMs;
+    if (pCount != NULL)
+    {
+        *pCount = 0;
+    }
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint32_t dispatcher_LogDropped(void)
+{
+#if (DISPATCHER_LOG_DEFERRED)
+    return __atomic_load_n(&gLogDropped, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+uint8_t dispatcher_RecordStart(dispatcher_base_t *const pDispatcher,
+                               dispatcher_recordWrite_t write,
+                               void *pArg)
+{
+    if (pDispatcher == NULL || write == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_RECORD_ENABLE)
+    dispatcher_recordHeader_t header = {
+        .magic = DISPATCHER_RECORD_MAGIC,
+        .version = DISPATCHER_RECORD_VERSION,
+        .entrySize = sizeof(dispatcher_recordEntry_t),
+    };
+
+    write(&header, sizeof(header), pArg);
+    pDispatcher->recordArg = pArg;
+    pDispatcher->recordTime = dispatcher_PortTimeUs();
+    pDispatcher->record = write;
+    return DISPATCHER_ERR_CLEAR;
+#else
+    (void)pArg;
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_RecordStop(dispatcher_base_t *const pDispatcher)
+{
+    if (pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+#if (DISPATCHER_RECORD_ENABLE)
+    pDispatcher->record = NULL;
+    return DISPATCHER_ERR_CLEAR;
+#else
+    return DISPATCHER_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t dispatcher_ReplayEvent(dispatcher_base_t *const pDispatcher,
+                               void const *const pEvent,
+                               uint16_t length)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (length < sizeof(dispatcher_eventBase_t) || DispatcherSignalReserved(((dispatcher_eventBase_t const *)pEvent)->sig))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid event", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pDispatcher->active == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    uint8_t ret = DispatcherDispatch(pDispatcher, pEvent, length);
+
+    // the event loop would take the recalled events next
+    while (ret == DISPATCHER_ERR_CLEAR && pDispatcher->defer.recall != 0)
+    {
+        void *pItem = DispatcherRecallNext(pDispatcher, &length);
+
+        ret = DispatcherDispatch(pDispatcher, pItem, length);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_Replay(dispatcher_base_t *const pDispatcher,
+                          dispatcher_recordRead_t read,
+                          void *pArg,
+                          uint8_t *const pBuffer,
+                          uint16_t size,
+                          dispatcher_replay_t pace,
+                          uint32_t *pCount)
+{
+    if (pCount != NULL)
+    {
+        *pCount = 0;
+    }
+
+    if (pDispatcher == NULL || read == NULL || pBuffer == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    dispatcher_recordHeader_t header;
+
+    if (pace >= DISPATCHER_REPLAY_MAX || read(&header, sizeof(header), pArg) != sizeof(header) ||
+        header.magic != DISPATCHER_RECORD_MAGIC || header.version != DISPATCHER_RECORD_VERSION ||
+        header.entrySize != sizeof(dispatcher_recordEntry_t))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid recording", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    uint32_t count = 0;
+    uint64_t due = dispatcher_PortTimeUs();
+    dispatcher_recordEntry_t entry;
+    uint32_t got;
+
+    while ((got = read(&entry, sizeof(entry), pArg)) != 0)
+    {
+        if (got != sizeof(entry) || entry.length > size)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,invalid recording entry", __LINE__);
+            ret = (got != sizeof(entry)) ? DISPATCHER_ERR_PROCESS_FAIL : DISPATCHER_ERR_INVALID_ARGS;
+            break;
+        }
+        if (read(pBuffer, entry.length, pArg) != entry.length)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,recording truncated", __LINE__);
+            ret = DISPATCHER_ERR_PROCESS_FAIL;
+            break;
+        }
+
+        // gaps are kept against the start, a late event does not delay the rest
+        if (pace == DISPATCHER_REPLAY_TIMED)
+        {
+            uint64_t now = dispatcher_PortTimeUs();
+
+            due += entry.delta;
+            if (due > now)
+            {
+                dispatcher_PortSleepUs((uint32_t)(((due - now) < UINT32_MAX) ? (due - now) : UINT32_MAX));
+            }
+        }
+
+        ret = dispatcher_ReplayEvent(pDispatcher, pBuffer, entry.length);
+        if (ret != DISPATCHER_ERR_CLEAR)
+        {
+            break;
+        }
+        count++;
+    }
+
+    if (pCount != NULL)
+    {
+        *pCount = count;
+    }
+    return ret;
+}
+
+uint8_t dispatcher_Recall(dispatcher_base_t *const pDispatcher)
+{
+    if (pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    pDispatcher->defer.recall = pDispatcher->defer.used;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_Coalesce(dispatcher_base_t *const pDispatcher,
+                            dispatcher_eventSignal_t signal,
+                            dispatcher_coalescePolicy_t policy,
+                            dispatcher_mergeHandler_t merge)
+{
+    if (pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (pDispatcher->coalesce == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher has no coalescing table", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (signal < DISPATCHER_SIGNAL_USER || signal >= pDispatcher->coalesceCount ||
+        policy >= DISPATCHER_COALESCE_MAX || (policy == DISPATCHER_COALESCE_MERGE && merge == NULL))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid signal or policy", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    // pending events are copies of whole events
+    if (policy != DISPATCHER_COALESCE_NONE &&
+        (gPoolCount == 0 || gPools[gPoolCount - 1u]->blockSize < pDispatcher->queue.itemSize))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,no event pool for coalesced events", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    pDispatcher->coalesce[signal].merge = merge;
+    pDispatcher->coalesce[signal].policy = (uint8_t)policy;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_TimeEventInit(dispatcher_timeEvent_t *const pTimeEvent,
+                                 dispatcher_base_t *const pDispatcher,
+                                 dispatcher_eventSignal_t signal)
+{
+    if (pTimeEvent == NULL || pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (pDispatcher->wheel == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher has no timing wheel", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (signal < DISPATCHER_SIGNAL_USER)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,time event requires user signal", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    pTimeEvent->base.sig = signal;
+    dispatcher_WheelNodeInit(&pTimeEvent->node);
+    pTimeEvent->pDispatcher = pDispatcher;
+    pTimeEvent->period = 0;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_TimeEventArm(dispatcher_timeEvent_t *const pTimeEvent,
+                                uint32_t timeoutMs,
+                                uint32_t periodMs)
+{
+    if (pTimeEvent == NULL || pTimeEvent->pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    dispatcher_wheel_t *pWheel = pTimeEvent->pDispatcher->wheel;
+
+    pTimeEvent->period = DISPATCHER_PORT_MS_TO_TICKS(periodMs);
+    if (periodMs != 0 && pTimeEvent->period == 0)
+    {
+        pTimeEvent->period = 1; // period shorter than a tick
+    }
+
+    // the wheel may lag behind the tick when the loop slept or was not run yet
+    dispatcher_WheelAdvance(pWheel, dispatcher_PortGetTick());
+    dispatcher_WheelArm(pWheel, &pTimeEvent->node, DISPATCHER_PORT_MS_TO_TICKS(timeoutMs));
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_TimeEventDisarm(dispatcher_timeEvent_t *const pTimeEvent)
+{
+    if (pTimeEvent == NULL || pTimeEvent->pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    (void)dispatcher_WheelDisarm(pTimeEvent->pDispatcher->wheel, &pTimeEvent->node);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+bool dispatcher_TimeEventIsArmed(dispatcher_timeEvent_t const *const pTimeEvent)
+{
+    return (pTimeEvent != NULL) && dispatcher_WheelIsArmed(&pTimeEvent->node);
+}
+
+uint8_t dispatcher_TableDispatch(dispatcher_base_t *const pDispatcher,
+                                 dispatcher_eventBase_t const *const pEvent,
+                                 dispatcher_table_t const *const pTable)
+{
+    // remembered for the event loop, which then skips the handler call
+    if (pDispatcher->active == pTable->state)
+    {
+        pDispatcher->table = pTable;
+    }
+    return DispatcherTableRun(pDispatcher, pEvent, pTable);
+}
+
+uint8_t dispatcher_PostPriority(dispatcher_base_t *const pDispatcher,
+                                dispatcher_eventBase_t const *const pEvent,
+                                uint8_t priority)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (priority > pDispatcher->laneCount || DispatcherSignalReserved(pEvent->sig))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid priority %u or signal", __LINE__, priority);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (DispatcherFiltered(pDispatcher, pEvent->sig, 0))
+    {
+        return DISPATCHER_ERR_FILTERED;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+
+    dispatcher_portStatus_t state = dispatcher_QueueSend(DispatcherLane(pDispatcher, priority),
+                                                         pEvent,
+                                                         DispatcherPostTimeout(pDispatcher));
+
+    if (state == DISPATCHER_PORT_OK)
+    {
+        StatsPosted(pDispatcher, 1u);
+    }
+    else
+    {
+        if (state == DISPATCHER_PORT_FULL)
+        {
+            if (pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK)
+            {
+                DISPATCHER_LOG_ERROR(TAG, "%d,queue overflow", __LINE__);
+            }
+            DispatcherDropped(pDispatcher, 1u);
+            ret = DISPATCHER_ERR_QUEUE_FULL;
+        }
+        else
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,process failed", __LINE__);
+            ret = DISPATCHER_ERR_PROCESS_FAIL;
+        }
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostPriorityFromIsr(dispatcher_base_t *const pDispatcher,
+                                       dispatcher_eventBase_t const *const pEvent,
+                                       uint8_t priority,
+                                       int flags)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (priority > pDispatcher->laneCount || DispatcherSignalReserved(pEvent->sig))
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (DispatcherFiltered(pDispatcher, pEvent->sig, DISPATCHER_TRACE_FLAG_ISR))
+    {
+        return DISPATCHER_ERR_FILTERED;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    int woken = 0;
+    dispatcher_portStatus_t state = dispatcher_QueueSendFromIsr(DispatcherLane(pDispatcher, priority), pEvent, &woken);
+
+    if (state == DISPATCHER_PORT_OK)
+    {
+        StatsPosted(pDispatcher, 1u);
+    }
+    else if (state == DISPATCHER_PORT_FULL)
+    {
+        DispatcherDropped(pDispatcher, 1u);
+        ret = DISPATCHER_ERR_QUEUE_FULL;
+    }
+    else
+    {
+        ret = DISPATCHER_ERR_PROCESS_FAIL;
+    }
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostSized(dispatcher_base_t *const pDispatcher,
+                             dispatcher_eventBase_t const *const pEvent,
+                             uint16_t size)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (size < sizeof(dispatcher_eventBase_t) || size > pDispatcher->queue.itemSize)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid event size", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT && size != pDispatcher->queue.itemSize)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,queue backend requires full size events", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    uint8_t ret = DispatcherSend(pDispatcher,
+                                 pEvent,
+                                 size,
+                                 (dispatcher_overflow_t)pDispatcher->overflow,
+                                 pDispatcher->postTimeout,
+                                 NULL);
+
+    // filtered posts and a full queue of a fail fast or dropping policy are only counted
+    if (ret != DISPATCHER_ERR_CLEAR && ret != DISPATCHER_ERR_FILTERED &&
+        (ret != DISPATCHER_ERR_QUEUE_FULL || pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,post failed,error %d", __LINE__, ret);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostSizedFromIsr(dispatcher_base_t *const pDispatcher,
+                                    dispatcher_eventBase_t const *const pEvent,
+                                    uint16_t size,
+                                    int flags)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (size < sizeof(dispatcher_eventBase_t) || size > pDispatcher->queue.itemSize)
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT && size != pDispatcher->queue.itemSize)
+    {
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    int woken = 0;
+    uint8_t ret = DispatcherSend(pDispatcher,
+                                 pEvent,
+                                 size,
+                                 (dispatcher_overflow_t)pDispatcher->overflow,
+                                 0,
+                                 &woken);
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+/*
+ *  Batches are copied as they are, none of the events may carry a reserved
+ *  signal.
+ */
+static bool DispatcherBatchReserved(dispatcher_base_t const *const pDispatcher,
+                                    void const *const pEvents,
+                                    uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        dispatcher_eventBase_t const *pEvent =
+            (dispatcher_eventBase_t const *)((uint8_t const *)pEvents + (size_t)i * pDispatcher->queue.itemSize);
+
+        if (DispatcherSignalReserved(pEvent->sig))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t dispatcher_PostBatch(dispatcher_base_t *const pDispatcher,
+                             void const *const pEvents,
+                             uint16_t count,
+                             uint16_t *pAccepted)
+{
+    if (pAccepted != NULL)
+    {
+        *pAccepted = 0;
+    }
+
+    if (pDispatcher == NULL || pEvents == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (DispatcherBatchReserved(pDispatcher, pEvents, count))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid event signal", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    uint16_t sent = 0;
+    dispatcher_portStatus_t state = dispatcher_QueueSendBatch(&pDispatcher->queue,
+                                                              pEvents,
+                                                              count,
+                                                              DispatcherPostTimeout(pDispatcher),
+                                                              &sent);
+
+    if (pAccepted != NULL)
+    {
+        *pAccepted = sent;
+    }
+    StatsPosted(pDispatcher, sent);
+
+    if (state != DISPATCHER_PORT_OK && state != DISPATCHER_PORT_FULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,process failed", __LINE__);
+        return DISPATCHER_ERR_PROCESS_FAIL;
+    }
+
+    if (sent != count)
+    {
+        DispatcherDropped(pDispatcher, (uint32_t)(count - sent));
+        if (sent == 0 && pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,queue overflow", __LINE__);
+        }
+        return DISPATCHER_ERR_QUEUE_FULL;
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_PostBatchFromIsr(dispatcher_base_t *const pDispatcher,
+                                    void const *const pEvents,
+                                    uint16_t count,
+                                    uint16_t *pAccepted,
+                                    int flags)
+{
+    if (pAccepted != NULL)
+    {
+        *pAccepted = 0;
+    }
+
+    if (pDispatcher == NULL || pEvents == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (DispatcherBatchReserved(pDispatcher, pEvents, count))
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    uint16_t sent = 0;
+    int woken = 0;
+    dispatcher_portStatus_t state = dispatcher_QueueSendBatchFromIsr(&pDispatcher->queue,
+                                                                     pEvents,
+                                                                     count,
+                                                                     &sent,
+                                                                     &woken);
+
+    if (state != DISPATCHER_PORT_OK && state != DISPATCHER_PORT_FULL)
+        ret = DISPATCHER_ERR_PROCESS_FAIL;
+    else if (sent != count)
+        ret = DISPATCHER_ERR_QUEUE_FULL;
+
+    StatsPosted(pDispatcher, sent);
+    if (ret == DISPATCHER_ERR_QUEUE_FULL)
+    {
+        DispatcherDropped(pDispatcher, (uint32_t)(count - sent));
+    }
+
+    if (pAccepted != NULL)
+    {
+        *pAccepted = sent;
+    }
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostReserve(dispatcher_base_t *const pDispatcher,
+                               void **ppEvent)
+{
+    if (pDispatcher == NULL || ppEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,queue backend can not reserve", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    if (dispatcher_QueueReserve(&pDispatcher->queue,
+                                ppEvent,
+                                DispatcherPostTimeout(pDispatcher)) != DISPATCHER_PORT_OK)
+    {
+        if (pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,queue overflow", __LINE__);
+        }
+        DispatcherDropped(pDispatcher, 1u);
+        return DISPATCHER_ERR_QUEUE_FULL;
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_PostCommit(dispatcher_base_t *const pDispatcher,
+                              void *const pEvent)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,queue backend can not reserve", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    // a reserved slot must be published, one with a reserved signal is only released by the event loop
+    if (DispatcherSignalReserved(((dispatcher_eventBase_t *)pEvent)->sig))
+    {
+        ((dispatcher_eventBase_t *)pEvent)->sig = DISPATCHER_SIGNAL_VOID;
+        dispatcher_QueueCommit(&pDispatcher->queue, pEvent);
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid event signal", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    dispatcher_QueueCommit(&pDispatcher->queue, pEvent);
+    StatsPosted(pDispatcher, 1u);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_EventPoolInit(dispatcher_pool_t *const pPool,
+                                 uint16_t blockSize,
+                                 uint16_t blockCount,
+                                 uint8_t *storage)
+{
+    if (pPool == NULL || storage == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (blockSize < sizeof(dispatcher_eventBase_t) || blockCount == 0 || gPoolCount >= DISPATCHER_POOL_MAX ||
+        (gPoolCount != 0 && blockSize <= gPools[gPoolCount - 1u]->blockSize))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid pool size class", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    if (dispatcher_PoolInit(pPool, blockSize, blockCount, storage) != DISPATCHER_PORT_OK)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,pool initialization failed", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    gPools[gPoolCount++] = pPool;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_EventNew(uint16_t size, void **ppEvent)
+{
+    if (ppEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+    *ppEvent = NULL;
+
+    if (size < sizeof(dispatcher_eventBase_t) || gPoolCount == 0 ||
+        size > gPools[gPoolCount - 1u]->blockSize)
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    for (uint8_t i = 0; i < gPoolCount; i++)
+    {
+        if (gPools[i]->blockSize >= size)
+        {
+            *ppEvent = dispatcher_PoolAlloc(gPools[i]);
+            if (*ppEvent != NULL)
+            {
+                return DISPATCHER_ERR_CLEAR;
+            }
+        }
+    }
+    return DISPATCHER_ERR_POOL_EMPTY;
+}
+
+uint8_t dispatcher_EventRelease(void *const pEvent)
+{
+    if (pEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+    (void)dispatcher_PoolRelease(pEvent);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  A reference takes a whole port queue item, ring backends store it
+ *  sized so the variable size ring only spends a pointer on it.
+ */
+static bool DispatcherCanPostRef(dispatcher_base_t const *const pDispatcher)
+{
+    return (pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+               ? pDispatcher->queue.itemSize == sizeof(dispatcher_eventRef_t)
+               : pDispatcher->queue.itemSize >= sizeof(dispatcher_eventRef_t);
+}
+
+uint8_t dispatcher_PostRef(dispatcher_base_t *const pDispatcher,
+                           void *const pEvent)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (!DispatcherCanPostRef(pDispatcher))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,event size can not hold a reference", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    if (DispatcherFiltered(pDispatcher, ((dispatcher_eventBase_t const *)pEvent)->sig, 0))
+    {
+        return DISPATCHER_ERR_FILTERED;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    dispatcher_eventRef_t ref = {.base = {.sig = DISPATCHER_SIGNAL_REF}, .pEvent = pEvent};
+
+    // the queued reference is dropped by the consuming event loop
+    dispatcher_PoolRetain(pEvent);
+    dispatcher_portStatus_t state = dispatcher_QueueSendSized(&pDispatcher->queue,
+                                                              &ref,
+                                                              sizeof(ref),
+                                                              DispatcherPostTimeout(pDispatcher));
+
+    if (state == DISPATCHER_PORT_OK)
+    {
+        StatsPosted(pDispatcher, 1u);
+    }
+    else
+    {
+        (void)dispatcher_PoolRelease(pEvent);
+        if (state == DISPATCHER_PORT_FULL)
+        {
+            if (pDispatcher->overflow == DISPATCHER_OVERFLOW_BLOCK)
+            {
+                DISPATCHER_LOG_ERROR(TAG, "%d,queue overflow", __LINE__);
+            }
+            DispatcherDropped(pDispatcher, 1u);
+            ret = DISPATCHER_ERR_QUEUE_FULL;
+        }
+        else
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,process failed", __LINE__);
+            ret = DISPATCHER_ERR_PROCESS_FAIL;
+        }
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PostRefFromIsr(dispatcher_base_t *const pDispatcher,
+                                  void *const pEvent,
+                                  int flags)
+{
+    if (pDispatcher == NULL || pEvent == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (!DispatcherCanPostRef(pDispatcher))
+    {
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    if (DispatcherFiltered(pDispatcher, ((dispatcher_eventBase_t const *)pEvent)->sig, DISPATCHER_TRACE_FLAG_ISR))
+    {
+        return DISPATCHER_ERR_FILTERED;
+    }
+
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    int woken = 0;
+    dispatcher_eventRef_t ref = {.base = {.sig = DISPATCHER_SIGNAL_REF}, .pEvent = pEvent};
+
+    dispatcher_PoolRetain(pEvent);
+    dispatcher_portStatus_t state = dispatcher_QueueSendSizedFromIsr(&pDispatcher->queue, &ref, sizeof(ref), &woken);
+
+    if (state == DISPATCHER_PORT_OK)
+    {
+        StatsPosted(pDispatcher, 1u);
+    }
+    else
+    {
+        (void)dispatcher_PoolRelease(pEvent);
+        if (state == DISPATCHER_PORT_FULL)
+        {
+            DispatcherDropped(pDispatcher, 1u);
+            ret = DISPATCHER_ERR_QUEUE_FULL;
+        }
+        else
+        {
+            ret = DISPATCHER_ERR_PROCESS_FAIL;
+        }
+    }
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_BusInit(dispatcher_bus_t *const pBus,
+                           uint32_t *subscriptions,
+                           uint16_t signalCount)
+{
+    if (pBus == NULL || subscriptions == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (signalCount == 0)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,requied non zero arguments", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    (void)memset(pBus, 0, sizeof(dispatcher_bus_t));
+    (void)memset(subscriptions, 0, (size_t)signalCount * sizeof(uint32_t));
+    pBus->subscriptions = subscriptions;
+    pBus->signalCount = signalCount;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_BusAttach(dispatcher_bus_t *const pBus,
+                             dispatcher_base_t *const pDispatcher,
+                             uint8_t priority)
+{
+    if (pBus == NULL || pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (priority >= DISPATCHER_BUS_MAX_SUBSCRIBERS || pBus->subscribers[priority] != NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,priority invalid or in use", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    for (uint8_t i = 0; i < DISPATCHER_BUS_MAX_SUBSCRIBERS; i++)
+    {
+        if (pBus->subscribers[i] == pDispatcher)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher already attached", __LINE__);
+            return DISPATCHER_ERR_INVALID_ARGS;
+        }
+    }
+    pBus->subscribers[priority] = pDispatcher;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Subscriber bit of an attached dispatcher, 0 if it is not attached.
+ */
+static uint32_t BusSubscriberBit(dispatcher_bus_t const *const pBus,
+                                 dispatcher_base_t const *const pDispatcher)
+{
+    for (uint8_t i = 0; i < DISPATCHER_BUS_MAX_SUBSCRIBERS; i++)
+    {
+        if (pBus->subscribers[i] == pDispatcher)
+        {
+            return 1u << i;
+        }
+    }
+    return 0;
+}
+
+uint8_t dispatcher_Subscribe(dispatcher_bus_t *const pBus,
+                             dispatcher_base_t *const pDispatcher,
+                             dispatcher_eventSignal_t signal)
+{
+    if (pBus == NULL || pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    uint32_t bit = BusSubscriberBit(pBus, pDispatcher);
+
+    if (bit == 0 || signal >= pBus->signalCount)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not attached or invalid signal", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    (void)__atomic_fetch_or(&pBus->subscriptions[signal], bit, __ATOMIC_RELAXED);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_Unsubscribe(dispatcher_bus_t *const pBus,
+                               dispatcher_base_t *const pDispatcher,
+                               dispatcher_eventSignal_t signal)
+{
+    if (pBus == NULL || pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    uint32_t bit = BusSubscriberBit(pBus, pDispatcher);
+
+    if (bit == 0 || signal >= pBus->signalCount)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not attached or invalid signal", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    (void)__atomic_fetch_and(&pBus->subscriptions[signal], ~bit, __ATOMIC_RELAXED);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Queue one published event to a subscriber, pWoken is NULL in task
+ *  context. Events by reference take a reference of their own.
+ */
+static uint8_t BusDeliver(dispatcher_base_t *const pDispatcher,
+                          void const *pEvent,
+                          uint16_t size,
+                          bool byRef,
+                          int *pWoken)
+{
+    dispatcher_eventRef_t ref = {.base = {.sig = DISPATCHER_SIGNAL_REF}, .pEvent = (void *)pEvent};
+    dispatcher_portStatus_t state;
+
+    if (!dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+
+    if (DispatcherFiltered(pDispatcher,
+                           ((dispatcher_eventBase_t const *)pEvent)->sig,
+                           (pWoken != NULL) ? DISPATCHER_TRACE_FLAG_ISR : 0u))
+    {
+        return DISPATCHER_ERR_FILTERED;
+    }
+
+    if (byRef)
+    {
+        if (!DispatcherCanPostRef(pDispatcher))
+        {
+            return DISPATCHER_ERR_NOT_SUPPORTED;
+        }
+        dispatcher_PoolRetain(ref.pEvent);
+        pEvent = &ref;
+        size = sizeof(ref);
+    }
+    else if (size > pDispatcher->queue.itemSize || DispatcherSignalReserved(((dispatcher_eventBase_t const *)pEvent)->sig))
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+    else if (pDispatcher->queue.type == DISPATCHER_QUEUE_TYPE_DEFAULT && size != pDispatcher->queue.itemSize)
+    {
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    if (pWoken != NULL)
+    {
+        int woken = 0;
+
+        state = dispatcher_QueueSendSizedFromIsr(&pDispatcher->queue, pEvent, size, &woken);
+        *pWoken |= woken;
+    }
+    else
+    {
+        state = dispatcher_QueueSendSized(&pDispatcher->queue,
+                                          pEvent,
+                                          size,
+                                          DispatcherPostTimeout(pDispatcher));
+    }
+
+    if (state == DISPATCHER_PORT_OK)
+    {
+        StatsPosted(pDispatcher, 1u);
+        return DISPATCHER_ERR_CLEAR;
+    }
+
+    if (byRef)
+    {
+        (void)dispatcher_PoolRelease(ref.pEvent);
+    }
+    if (state != DISPATCHER_PORT_FULL)
+    {
+        return DISPATCHER_ERR_PROCESS_FAIL;
+    }
+    DispatcherDropped(pDispatcher, 1u);
+    return DISPATCHER_ERR_QUEUE_FULL;
+}
+
+/*
+ *  Walks the subscriber bitmap of the event signal from the highest
+ *  priority down.
+ */
+static uint8_t BusPublish(dispatcher_bus_t *const pBus,
+                          void const *const pEvent,
+                          uint16_t size,
+                          bool byRef,
+                          uint8_t *pDelivered,
+                          int *pWoken)
+{
+    dispatcher_eventSignal_t signal = ((dispatcher_eventBase_t const *)pEvent)->sig;
+    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    uint8_t delivered = 0;
+
+    if (signal >= pBus->signalCount)
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    uint32_t bits = __atomic_load_n(&pBus->subscriptions[signal], __ATOMIC_RELAXED);
+
+    while (bits != 0)
+    {
+        uint8_t priority = (uint8_t)(31 - __builtin_clz(bits));
+        uint8_t err = BusDeliver(pBus->subscribers[priority], pEvent, size, byRef, pWoken);
+
+        bits &= ~(1u << priority);
+        if (err == DISPATCHER_ERR_CLEAR)
+        {
+            delivered++;
+        }
+        else if (ret == DISPATCHER_ERR_CLEAR && err != DISPATCHER_ERR_FILTERED)
+        {
+            ret = err;
+        }
+    }
+
+    if (pDelivered != NULL)
+    {
+        *pDelivered = delivered;
+    }
+    return ret;
+}
+
+uint8_t dispatcher_Publish(dispatcher_bus_t *const pBus,
+                           dispatcher_eventBase_t const *const pEvent,
+                           uint16_t size,
+                           uint8_t *pDelivered)
+{
+    if (pDelivered != NULL)
+    {
+        *pDelivered = 0;
+    }
+
+    if (pBus == NULL || pEvent == NULL || pBus->subscriptions == NULL)
     {
         DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
         return DISPATCHER_ERR_NULL_PTR;
     }
 
-    if (itemSize == 0 || itemCount == 0)
+    if (size < sizeof(dispatcher_eventBase_t))
     {
-        DISPATCHER_LOG_ERROR(TAG, "%d,requied non zero arguments", __LINE__);
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid event size", __LINE__);
         return DISPATCHER_ERR_INVALID_ARGS;
     }
 
-    (void)memset(pDispatcher, 0, sizeof(dispatcher_base_t));
-    pDispatcher->queue = xQueueCreateStatic(itemCount,
-                                            itemSize,
-                                            queueStorage,
-                                            &pDispatcher->queueStorage);
-    if (pDispatcher->queue == NULL)
+    uint8_t ret = BusPublish(pBus, pEvent, size, false, pDelivered, NULL);
+
+    if (ret != DISPATCHER_ERR_CLEAR)
     {
-        DISPATCHER_LOG_ERROR(TAG, "%d,queue initialization failed", __LINE__);
-        return DISPATCHER_ERR_NOT_INITIALIZED;
+        DISPATCHER_LOG_ERROR(TAG, "%d,publish incomplete,err %u", __LINE__, ret);
     }
-    pDispatcher->eventStorage = eventStorage;
-    pDispatcher->active = defaultHandler;
-    return DISPATCHER_ERR_CLEAR;
+    return ret;
 }
 
-uint8_t dispatcher_Start(dispatcher_base_t *const pDispatcher,
-                         bool userSignal)
+uint8_t dispatcher_PublishFromIsr(dispatcher_bus_t *const pBus,
+                                  dispatcher_eventBase_t const *const pEvent,
+                                  uint16_t size,
+                                  uint8_t *pDelivered,
+                                  int flags)
 {
+    if (pDelivered != NULL)
+    {
+        *pDelivered = 0;
+    }
 
-    if (pDispatcher == NULL)
+    if (pBus == NULL || pEvent == NULL || pBus->subscriptions == NULL)
+    {
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (size < sizeof(dispatcher_eventBase_t))
+    {
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    int woken = 0;
+    uint8_t ret = BusPublish(pBus, pEvent, size, false, pDelivered, &woken);
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
+    return ret;
+}
+
+uint8_t dispatcher_PublishRef(dispatcher_bus_t *const pBus,
+                              void *const pEvent,
+                              uint8_t *pDelivered)
+{
+    if (pDelivered != NULL)
+    {
+        *pDelivered = 0;
+    }
+
+    if (pBus == NULL || pEvent == NULL || pBus->subscriptions == NULL)
     {
         DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
         return DISPATCHER_ERR_NULL_PTR;
     }
 
-    if (pDispatcher->active == NULL || pDispatcher->queue == NULL)
+    uint8_t ret = BusPublish(pBus, pEvent, 0, true, pDelivered, NULL);
+
+    if (ret != DISPATCHER_ERR_CLEAR)
     {
-        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
-        return DISPATCHER_ERR_NOT_INITIALIZED;
+        DISPATCHER_LOG_ERROR(TAG, "%d,publish incomplete,err %u", __LINE__, ret);
     }
+    return ret;
+}
 
-    uint8_t ret = DISPATCHER_ERR_CLEAR;
-    dispatcher_eventBase_t event = {.sig = DISPATCHER_SIGNAL_ENTRY};
-    pDispatcher->active(pDispatcher, &event);
+uint8_t dispatcher_PublishRefFromIsr(dispatcher_bus_t *const pBus,
+                                     void *const pEvent,
+                                     uint8_t *pDelivered,
+                                     int flags)
+{
+    if (pDelivered != NULL)
+    {
+        *pDelivered = 0;
+    }
 
-    if (userSignal)
+    if (pBus == NULL || pEvent == NULL || pBus->subscriptions == NULL)
     {
-        event.sig = DISPATCHER_SIGNAL_USER;
-        ret = dispatcher_Post(pDispatcher, &event);
+        return DISPATCHER_ERR_NULL_PTR;
     }
 
+    int woken = 0;
+    uint8_t ret = BusPublish(pBus, pEvent, 0, true, pDelivered, &woken);
+
+    if (flags)
+    {
+        dispatcher_PortYieldFromIsr(woken);
+    }
     return ret;
 }
 
-uint8_t dispatcher_EventLoop(dispatcher_base_t *const pDispatcher)
+uint8_t dispatcher_KernelInit(dispatcher_kernel_t *const pKernel)
 {
-    if (pDispatcher == NULL)
+    if (pKernel == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    (void)memset(pKernel, 0, sizeof(dispatcher_kernel_t));
+    if (dispatcher_WaiterInit(&pKernel->waiter) != DISPATCHER_PORT_OK)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,waiter initialization failed", __LINE__);
+        return DISPATCHER_ERR_NOT_INITIALIZED;
+    }
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_KernelAttach(dispatcher_kernel_t *const pKernel,
+                                dispatcher_base_t *const pDispatcher,
+                                uint8_t priority)
+{
+    if (pKernel == NULL || pDispatcher == NULL)
     {
         DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
         return DISPATCHER_ERR_NULL_PTR;
     }
 
-    if (pDispatcher->active == NULL || pDispatcher->queue == NULL || pDispatcher->eventStorage == NULL)
+    if (pDispatcher->active == NULL || !dispatcher_QueueIsValid(&pDispatcher->queue))
     {
         DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
         return DISPATCHER_ERR_NOT_INITIALIZED;
     }
 
-    if (xQueueReceive(pDispatcher->queue, pDispatcher->eventStorage, portMAX_DELAY) != pdTRUE)
+    if (pDispatcher->laneCount != 0)
     {
-        DISPATCHER_LOG_ERROR(TAG, "%d,dequeue operation failed", __LINE__);
-        return DISPATCHER_ERR_PROCESS_FAIL;
+        DISPATCHER_LOG_ERROR(TAG, "%d,priority lanes not supported by kernel", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    if (priority >= DISPATCHER_KERNEL_MAX_DISPATCHERS || pKernel->dispatchers[priority] != NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,priority invalid or in use", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    for (uint8_t i = 0; i < DISPATCHER_KERNEL_MAX_DISPATCHERS; i++)
+    {
+        if (pKernel->dispatchers[i] == pDispatcher)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher already attached", __LINE__);
+            return DISPATCHER_ERR_INVALID_ARGS;
+        }
+    }
+
+    // the dispatcher queue becomes a lane of the kernel, events posted
+    // before (the start signal) are found through the initial ready bit
+    (void)dispatcher_QueueSetLane(&pDispatcher->queue, priority, &pKernel->waiter);
+    pKernel->dispatchers[priority] = pDispatcher;
+    if (pDispatcher->wheel != NULL)
+    {
+        pKernel->timed |= 1u << priority;
+    }
+    dispatcher_WaiterMark(&pKernel->waiter, 1u << priority);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Take the next event of the highest priority ready dispatcher, the ready
+ *  bits are handled like the lanes of a dispatcher (see DispatcherAcquire).
+ *  A dispatcher with recalled events stays ready until they are replayed.
+ */
+static dispatcher_base_t *KernelTake(dispatcher_kernel_t *const pKernel,
+                                     void **ppItem,
+                                     dispatcher_queue_t **ppQueue,
+                                     uint16_t *pLength)
+{
+    dispatcher_waiter_t *pWaiter = &pKernel->waiter;
+    uint32_t ready = dispatcher_WaiterReady(pWaiter);
+
+    while (ready != 0u)
+    {
+        uint8_t priority = (uint8_t)(31 - __builtin_clz(ready));
+        uint32_t bit = 1u << priority;
+        dispatcher_base_t *pDispatcher = pKernel->dispatchers[priority];
+
+        if (DispatcherTake(pDispatcher, ppItem, ppQueue, pLength, 0) == DISPATCHER_PORT_OK)
+        {
+            return pDispatcher;
+        }
+
+        dispatcher_WaiterClear(pWaiter, bit);
+        if (DispatcherTake(pDispatcher, ppItem, ppQueue, pLength, 0) == DISPATCHER_PORT_OK)
+        {
+            dispatcher_WaiterMark(pWaiter, bit);
+            return pDispatcher;
+        }
+        ready &= ~bit;
+    }
+    return NULL;
+}
+
+/*
+ *  Bring the wheels of the attached dispatchers up to the current tick, a
+ *  dispatcher with expired time events becomes ready. Returns the ticks
+ *  until the next wheel deadline.
+ */
+static dispatcher_portTick_t KernelTimers(dispatcher_kernel_t *const pKernel)
+{
+    dispatcher_portTick_t timeout = DISPATCHER_PORT_MAX_DELAY;
+    uint32_t timed = pKernel->timed;
+
+    if (timed == 0u)
+    {
+        return timeout;
+    }
+
+    dispatcher_portTick_t now = dispatcher_PortGetTick();
+
+    while (timed != 0u)
+    {
+        uint8_t priority = (uint8_t)__builtin_ctz(timed);
+        dispatcher_wheel_t *pWheel = pKernel->dispatchers[priority]->wheel;
+        dispatcher_portTick_t ticks;
+
+        timed &= timed - 1u;
+        dispatcher_WheelAdvance(pWheel, now);
+        ticks = dispatcher_WheelTimeout(pWheel);
+        if (ticks == 0)
+        {
+            dispatcher_WaiterMark(&pKernel->waiter, 1u << priority);
+        }
+        timeout = (ticks < timeout) ? ticks : timeout;
+    }
+    return timeout;
+}
+
+uint8_t dispatcher_KernelLoop(dispatcher_kernel_t *const pKernel,
+                              uint16_t maxEvents,
+                              uint16_t *pProcessed)
+{
+    if (pProcessed != NULL)
+    {
+        *pProcessed = 0;
+    }
+
+    if (pKernel == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (maxEvents == 0)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,requied non zero arguments", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
     }
 
     uint8_t ret = DISPATCHER_ERR_CLEAR;
-    dispatcher_smStatus_t status = 0;
-    dispatcher_eventBase_t *pEvent = (dispatcher_eventBase_t *)pDispatcher->eventStorage;
+    uint16_t processed = 0;
 
-    status = pDispatcher->active(pDispatcher, pEvent);
-    if (status == DISPATCHER_SM_STATUS_TRANSITION)
+    while (processed < maxEvents)
     {
-        pEvent->sig = DISPATCHER_SIGNAL_EXIT;
-        pDispatcher->active(pDispatcher, pEvent);
+        void *pItem = NULL;
+        dispatcher_queue_t *pQueue = NULL;
+        uint16_t length = 0;
+        dispatcher_portTick_t timeout = KernelTimers(pKernel);
+        dispatcher_base_t *pDispatcher = KernelTake(pKernel, &pItem, &pQueue, &length);
 
-        if (pDispatcher->next != NULL)
+        if (pDispatcher == NULL)
         {
-            pDispatcher->active = pDispatcher->next;
-            pEvent->sig = DISPATCHER_SIGNAL_ENTRY;
-            pDispatcher->active(pDispatcher, pEvent);
+            if (processed != 0)
+            {
+                break;
+            }
+            // every dispatcher is idle, the kernel task sleeps on its own waiter
+            // until a post or the next time event deadline
+            (void)dispatcher_WaiterWait(&pKernel->waiter, timeout);
+            continue;
         }
-        else
+
+        ret = DispatcherHandle(pDispatcher, pItem, pQueue, length);
+        processed++;
+        if (ret != DISPATCHER_ERR_CLEAR)
         {
-            DISPATCHER_LOG_ERROR(TAG, "%d,invalid transition request,handler is NULL", __LINE__);
-            ret = DISPATCHER_ERR_PROCESS_FAIL;
+            break;
         }
     }
 
+    if (pProcessed != NULL)
+    {
+        *pProcessed = processed;
+    }
     return ret;
 }
 
-uint8_t dispatcher_Post(dispatcher_base_t *const pDispatcher,
-                        dispatcher_eventBase_t const *const pEvent)
+uint8_t dispatcher_WorkerPoolInit(dispatcher_workerPool_t *const pPool,
+                                  dispatcher_worker_t *workers,
+                                  uint8_t workerCount)
 {
-    if (pDispatcher == NULL || pEvent == NULL)
+    if (pPool == NULL || workers == NULL)
     {
         DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
         return DISPATCHER_ERR_NULL_PTR;
     }
 
-    if (pDispatcher->queue == NULL)
+    if (workerCount == 0 || workerCount > DISPATCHER_WORKER_MAX)
     {
-        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher not initialized", __LINE__);
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid worker count", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
+
+    (void)memset(pPool, 0, sizeof(dispatcher_workerPool_t));
+    (void)memset(workers, 0, (size_t)workerCount * sizeof(dispatcher_worker_t));
+    for (uint8_t i = 0; i < workerCount; i++)
+    {
+        if (dispatcher_WaiterInit(&workers[i].waiter) != DISPATCHER_PORT_OK)
+        {
+            DISPATCHER_LOG_ERROR(TAG, "%d,waiter initialization failed", __LINE__);
+            return DISPATCHER_ERR_NOT_INITIALIZED;
+        }
+    }
+    pPool->workers = workers;
+    pPool->workerCount = workerCount;
+    return DISPATCHER_ERR_CLEAR;
+}
+
+uint8_t dispatcher_WorkerPoolAttach(dispatcher_workerPool_t *const pPool,
+                                    dispatcher_base_t *const pDispatcher,
+                                    uint8_t priority,
+                                    uint8_t home,
+                                    bool pinned)
+{
+    if (pPool == NULL || pDispatcher == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
+        return DISPATCHER_ERR_NULL_PTR;
+    }
+
+    if (pPool->workers == NULL || pDispatcher->active == NULL || !dispatcher_QueueIsValid(&pDispatcher->queue))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher or pool not initialized", __LINE__);
         return DISPATCHER_ERR_NOT_INITIALIZED;
     }
 
-    uint8_t ret = DISPATCHER_ERR_CLEAR;
+    if (pDispatcher->laneCount != 0)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,priority lanes not supported by worker pool", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
 
-    // TODO event posting timeout is 100 ms should be changed or
-    // defined as a macro to make it user friendly
-    BaseType_t state = xQueueSend(pDispatcher->queue, (void *)pEvent, pdMS_TO_TICKS(100));
+    if (pDispatcher->wheel != NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,time events not supported by worker pool", __LINE__);
+        return DISPATCHER_ERR_NOT_SUPPORTED;
+    }
+
+    if (priority >= DISPATCHER_WORKER_POOL_MAX_DISPATCHERS || pPool->dispatchers[priority] != NULL ||
+        (home != DISPATCHER_WORKER_ANY && home >= pPool->workerCount))
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,priority invalid or in use", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
+    }
 
-    if (state != pdTRUE)
+    for (uint8_t i = 0; i < DISPATCHER_WORKER_POOL_MAX_DISPATCHERS; i++)
     {
-        if (state == errQUEUE_FULL)
+        if (pPool->dispatchers[i] == pDispatcher)
         {
-            DISPATCHER_LOG_ERROR(TAG, "%d,queue overflow", __LINE__);
-            ret = DISPATCHER_ERR_QUEUE_FULL;
+            DISPATCHER_LOG_ERROR(TAG, "%d,dispatcher already attached", __LINE__);
+            return DISPATCHER_ERR_INVALID_ARGS;
         }
-        else
+    }
+
+    if (home == DISPATCHER_WORKER_ANY)
+    {
+        home = (uint8_t)(priority % pPool->workerCount);
+    }
+
+    dispatcher_worker_t *pHome = &pPool->workers[home];
+
+    // like a kernel, the dispatcher queue becomes a lane of its home worker
+    (void)dispatcher_QueueSetLane(&pDispatcher->queue, priority, &pHome->waiter);
+    if (pinned)
+    {
+        pHome->pinned |= 1u << priority;
+    }
+    pPool->home[priority] = home;
+    pPool->dispatchers[priority] = pDispatcher;
+    dispatcher_WaiterMark(&pHome->waiter, 1u << priority);
+    return DISPATCHER_ERR_CLEAR;
+}
+
+/*
+ *  Claim and take the next event of the highest priority ready dispatcher
+ *  homed on worker owner, out of mask. The busy bit is claimed before the
+ *  queue is looked at and kept while the event runs, ready bits follow the
+ *  kernel protocol.
+ */
+static dispatcher_base_t *WorkerTake(dispatcher_workerPool_t *const pPool,
+                                     uint8_t owner,
+                                     uint32_t mask,
+                                     void **ppItem,
+                                     dispatcher_queue_t **ppQueue,
+                                     uint16_t *pLength,
+                                     uint8_t *pPriority)
+{
+    dispatcher_waiter_t *pWaiter = &pPool->workers[owner].waiter;
+    uint32_t ready = dispatcher_WaiterReady(pWaiter) & mask & ~__atomic_load_n(&pPool->busy, __ATOMIC_RELAXED);
+
+    while (ready != 0u)
+    {
+        uint8_t priority = (uint8_t)(31 - __builtin_clz(ready));
+        uint32_t bit = 1u << priority;
+        dispatcher_base_t *pDispatcher = pPool->dispatchers[priority];
+
+        ready &= ~bit;
+        if ((__atomic_fetch_or(&pPool->busy, bit, __ATOMIC_ACQUIRE) & bit) != 0u)
         {
-            DISPATCHER_LOG_ERROR(TAG, "%d,process failed", __LINE__);
-            ret = DISPATCHER_ERR_PROCESS_FAIL;
+            continue; // another worker runs it
+        }
+
+        *pPriority = priority;
+        if (DispatcherTake(pDispatcher, ppItem, ppQueue, pLength, 0) == DISPATCHER_PORT_OK)
+        {
+            return pDispatcher;
+        }
+        dispatcher_WaiterClear(pWaiter, bit);
+        if (DispatcherTake(pDispatcher, ppItem, ppQueue, pLength, 0) == DISPATCHER_PORT_OK)
+        {
+            dispatcher_WaiterMark(pWaiter, bit);
+            return pDispatcher;
+        }
+        // a post between the take and the clear may have been skipped by a sleeping home worker
+        (void)__atomic_fetch_and(&pPool->busy, ~bit, __ATOMIC_RELEASE);
+        if ((dispatcher_WaiterReady(pWaiter) & bit) != 0u)
+        {
+            dispatcher_WaiterNotify(pWaiter);
         }
     }
-    return ret;
+    return NULL;
 }
 
-uint8_t dispatcher_PostFromIsr(dispatcher_base_t *const pDispatcher,
-                               dispatcher_eventBase_t const *const pEvent,
-                               int flags)
+/*
+ *  Wake a sleeping worker when the worker about to run an event leaves
+ *  other stealable dispatchers ready behind it.
+ */
+static void WorkerWakeThief(dispatcher_workerPool_t *const pPool, uint8_t worker)
 {
+    dispatcher_worker_t *pWorker = &pPool->workers[worker];
+    uint32_t left = dispatcher_WaiterReady(&pWorker->waiter) & ~pWorker->pinned &
+                    ~__atomic_load_n(&pPool->busy, __ATOMIC_RELAXED);
 
-    if (pDispatcher == NULL || pEvent == NULL)
+    if (left == 0u)
+    {
+        return;
+    }
+    for (uint8_t i = 1; i < pPool->workerCount; i++)
+    {
+        dispatcher_worker_t *pThief = &pPool->workers[(worker + i) % pPool->workerCount];
+
+        if (__atomic_load_n(&pThief->waiter.sleeping, __ATOMIC_RELAXED) != 0u)
+        {
+            dispatcher_WaiterNotify(&pThief->waiter);
+            return;
+        }
+    }
+}
+
+uint8_t dispatcher_WorkerLoop(dispatcher_workerPool_t *const pPool,
+                              uint8_t worker,
+                              uint16_t maxEvents,
+                              uint16_t *pProcessed)
+{
+    if (pProcessed != NULL)
     {
+        *pProcessed = 0;
+    }
+
+    if (pPool == NULL)
+    {
+        DISPATCHER_LOG_ERROR(TAG, "%d,null pointer argument", __LINE__);
         return DISPATCHER_ERR_NULL_PTR;
     }
 
-    if (pDispatcher->queue == NULL)
+    if (maxEvents == 0 || worker >= pPool->workerCount)
     {
-        return DISPATCHER_ERR_NOT_INITIALIZED;
+        DISPATCHER_LOG_ERROR(TAG, "%d,invalid arguments", __LINE__);
+        return DISPATCHER_ERR_INVALID_ARGS;
     }
+
+    dispatcher_worker_t *pWorker = &pPool->workers[worker];
     uint8_t ret = DISPATCHER_ERR_CLEAR;
-    BaseType_t state = xQueueSendFromISR(pDispatcher->queue, (void *)pEvent, flags);
+    uint16_t processed = 0;
 
-    if (state != pdTRUE)
+    while (processed < maxEvents)
     {
-        if (state == errQUEUE_FULL)
-            ret = DISPATCHER_ERR_QUEUE_FULL;
+        void *pItem = NULL;
+        dispatcher_queue_t *pQueue = NULL;
+        uint16_t length = 0;
+        uint8_t priority = 0;
+        uint8_t owner = worker;
+        dispatcher_base_t *pDispatcher = WorkerTake(pPool, worker, UINT32_MAX, &pItem, &pQueue, &length, &priority);
+
+        // nothing at home, steal from the other workers
+        for (uint8_t i = 1; pDispatcher == NULL && i < pPool->workerCount; i++)
+        {
+            owner = (uint8_t)((worker + i) % pPool->workerCount);
+            pDispatcher = WorkerTake(pPool, owner, ~pPool->workers[owner].pinned, &pItem, &pQueue, &length, &priority);
+        }
+
+        if (pDispatcher == NULL)
+        {
+            if (processed != 0)
+            {
+                break;
+            }
+            // dispatchers held by other workers do not keep this one awake
+            (void)dispatcher_WaiterWaitExcept(&pWorker->waiter, &pPool->busy, DISPATCHER_PORT_MAX_DELAY);
+            continue;
+        }
+
+        if (owner != worker)
+        {
+            pWorker->steals++;
+        }
         else
-            ret = DISPATCHER_ERR_PROCESS_FAIL;
+        {
+            WorkerWakeThief(pPool, worker);
+        }
+
+        uint32_t bit = 1u << priority;
+        dispatcher_waiter_t *pHome = &pPool->workers[owner].waiter;
+
+        ret = DispatcherHandle(pDispatcher, pItem, pQueue, length);
+        processed++;
+
+        // a home worker which skipped the dispatcher while it was busy may sleep on it
+        (void)__atomic_fetch_and(&pPool->busy, ~bit, __ATOMIC_RELEASE);
+        if ((dispatcher_WaiterReady(pHome) & bit) != 0u)
+        {
+            dispatcher_WaiterNotify(pHome);
+        }
+
+        if (ret != DISPATCHER_ERR_CLEAR)
+        {
+            break;
+        }
+    }
+
+    if (pProcessed != NULL)
+    {
+        *pProcessed = processed;
     }
     return ret;
-}
\ No newline at end of file
+}
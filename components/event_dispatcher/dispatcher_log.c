@@ -0,0 +1,128 @@
+#include <dispatcher_log.h>
+#include <stdio.h>
+#include <string.h>
+
+/* longest conversion kept, e.g. "%-08.3lx". */
+#define LOG_SPEC_SIZE (16u)
+
+/*
+ *  Appends at most what still fits, *pLength counts the full length so a
+ *  truncated line still reports where it stopped.
+ */
+static void LogAppend(char *const pBuffer, uint32_t size, uint32_t *pLength, char const *pText, uint32_t count)
+{
+    if (*pLength + 1u < size)
+    {
+        uint32_t room = size - 1u - *pLength;
+        uint32_t copy = (count < room) ? count : room;
+
+        (void)memcpy(&pBuffer[*pLength], pText, copy);
+        pBuffer[*pLength + copy] = '\0';
+    }
+    *pLength += count;
+}
+
+/*
+ *  One conversion with its argument, the stored uintptr_t is cast back to
+ *  the type the length modifier and conversion ask for.
+ */
+static int LogConvert(char *const pOut, size_t size, char const *pSpec, uint32_t longs, char conversion, uintptr_t arg)
+{
+    switch (conversion)
+    {
+    case 'd':
+    case 'i':
+        if (longs == 0)
+        {
+            return snprintf(pOut, size, pSpec, (int)arg);
+        }
+        return (longs == 1) ? snprintf(pOut, size, pSpec, (long)(intptr_t)arg)
+                            : snprintf(pOut, size, pSpec, (long long)(intptr_t)arg);
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        if (longs == 0)
+        {
+            return snprintf(pOut, size, pSpec, (unsigned)arg);
+        }
+        return (longs == 1) ? snprintf(pOut, size, pSpec, (unsigned long)arg)
+                            : snprintf(pOut, size, pSpec, (unsigned long long)arg);
+    case 'c':
+        return snprintf(pOut, size, pSpec, (int)arg);
+    case 's':
+        return snprintf(pOut, size, pSpec, (arg != 0) ? (char const *)arg : "(null)");
+    case 'p':
+        return snprintf(pOut, size, pSpec, (void *)arg);
+    default:
+        return snprintf(pOut, size, "%s", pSpec);
+    }
+}
+
+uint32_t dispatcher_LogFormat(dispatcher_logRecord_t const *const pRecord,
+                              char *const pBuffer,
+                              uint32_t size)
+{
+    static char const levels[] = {'?', 'E', 'I', 'D'};
+    char const *pFormat = pRecord->format;
+    uint32_t length = 0;
+    uint8_t arg = 0;
+    char text[DISPATCHER_LOG_LINE_SIZE];
+    int count;
+
+    if (size != 0)
+    {
+        pBuffer[0] = '\0';
+    }
+
+    count = snprintf(text, sizeof(text), "%c (%u) %s: ", (pRecord->level < sizeof(levels)) ? levels[pRecord->level] : '?',
+                     (unsigned)pRecord->tick, pRecord->tag);
+    LogAppend(pBuffer, size, &length, text, (count > 0) ? (uint32_t)count : 0u);
+
+    while (*pFormat != '\0')
+    {
+        char const *pPercent = strchr(pFormat, '%');
+
+        if (pPercent == NULL)
+        {
+            LogAppend(pBuffer, size, &length, pFormat, (uint32_t)strlen(pFormat));
+            break;
+        }
+        LogAppend(pBuffer, size, &length, pFormat, (uint32_t)(pPercent - pFormat));
+
+        if (pPercent[1] == '%')
+        {
+            LogAppend(pBuffer, size, &length, "%", 1u);
+            pFormat = pPercent + 2;
+            continue;
+        }
+
+        // flags, width and precision are copied as they are, h and l are counted
+        char spec[LOG_SPEC_SIZE];
+        uint32_t specLength = 0, longs = 0;
+        char const *pEnd = pPercent + 1;
+
+        while (*pEnd != '\0' && strchr("-+ #0123456789.hl", *pEnd) != NULL && specLength < LOG_SPEC_SIZE - 3u)
+        {
+            longs += (*pEnd == 'l') ? 1u : 0u;
+            pEnd++;
+            specLength++;
+        }
+        if (*pEnd == '\0')
+        {
+            LogAppend(pBuffer, size, &length, pPercent, (uint32_t)strlen(pPercent));
+            break;
+        }
+        (void)memcpy(spec, pPercent, specLength + 2u);
+        spec[specLength + 2u] = '\0';
+
+        uintptr_t value = (arg < pRecord->argCount) ? pRecord->args[arg] : 0u;
+
+        arg++;
+        count = LogConvert(text, sizeof(text), spec, longs, *pEnd, value);
+        LogAppend(pBuffer, size, &length, text,
+                  (count <= 0) ? 0u : ((uint32_t)count < sizeof(text)) ? (uint32_t)count : sizeof(text) - 1u);
+        pFormat = pEnd + 1;
+    }
+    return length;
+}
@@ -0,0 +1,127 @@
+#include <dispatcher_pool.h>
+#include <string.h>
+
+#define POOL_TAG_ONE (0x10000u)
+#define POOL_INDEX_MASK (0xFFFFu)
+
+static dispatcher_poolBlock_t *PoolBlock(dispatcher_pool_t const *const pPool, uint32_t index)
+{
+    return (dispatcher_poolBlock_t *)&pPool->storage[index * pPool->stride];
+}
+
+static dispatcher_poolBlock_t *PoolHeader(void *const pEvent)
+{
+    return (dispatcher_poolBlock_t *)((uint8_t *)pEvent - DISPATCHER_POOL_HEADER_SIZE);
+}
+
+/*
+ *  Every successful swap bumps the tag, a stale head read by a preempted
+ *  context never matches again even if the same block is back on top.
+ */
+static void PoolPush(dispatcher_pool_t *const pPool, dispatcher_poolBlock_t *const pBlock)
+{
+    uint32_t head = __atomic_load_n(&pPool->freeHead, __ATOMIC_RELAXED);
+    uint32_t next;
+
+    do
+    {
+        __atomic_store_n(&pBlock->next, (uint16_t)(head & POOL_INDEX_MASK), __ATOMIC_RELAXED);
+        next = ((head + POOL_TAG_ONE) & ~POOL_INDEX_MASK) | pBlock->index;
+    } while (!__atomic_compare_exchange_n(&pPool->freeHead, &head, next, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static dispatcher_poolBlock_t *PoolPop(dispatcher_pool_t *const pPool)
+{
+    uint32_t head = __atomic_load_n(&pPool->freeHead, __ATOMIC_ACQUIRE);
+    dispatcher_poolBlock_t *pBlock;
+    uint32_t next;
+
+    do
+    {
+        if ((head & POOL_INDEX_MASK) == DISPATCHER_POOL_NIL)
+        {
+            return NULL;
+        }
+        /* may read a block some other context just took, the tag then
+           makes the swap fail. */
+        pBlock = PoolBlock(pPool, head & POOL_INDEX_MASK);
+        next = ((head + POOL_TAG_ONE) & ~POOL_INDEX_MASK) |
+               __atomic_load_n(&pBlock->next, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&pPool->freeHead, &head, next, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return pBlock;
+}
+
+dispatcher_portStatus_t dispatcher_PoolInit(dispatcher_pool_t *const pPool,
+                                            uint16_t blockSize,
+                                            uint16_t blockCount,
+                                            uint8_t *storage)
+{
+    if (blockSize == 0 || blockCount == 0 || blockCount >= DISPATCHER_POOL_NIL ||
+        ((uintptr_t)storage & (DISPATCHER_POOL_ALIGN - 1u)) != 0)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    pPool->blockSize = blockSize;
+    pPool->blockCount = blockCount;
+    pPool->stride = DISPATCHER_POOL_HEADER_SIZE + DISPATCHER_POOL_ALIGN_UP(blockSize);
+    pPool->storage = storage;
+
+    for (uint32_t i = 0; i < blockCount; i++)
+    {
+        dispatcher_poolBlock_t *pBlock = PoolBlock(pPool, i);
+
+        pBlock->pPool = pPool;
+        pBlock->refCount = 0;
+        pBlock->index = (uint16_t)i;
+        pBlock->next = (i + 1u < blockCount) ? (uint16_t)(i + 1u) : DISPATCHER_POOL_NIL;
+    }
+    __atomic_store_n(&pPool->freeHead, 0u, __ATOMIC_RELEASE);
+    return DISPATCHER_PORT_OK;
+}
+
+void *dispatcher_PoolAlloc(dispatcher_pool_t *const pPool)
+{
+    dispatcher_poolBlock_t *pBlock = PoolPop(pPool);
+
+    if (pBlock == NULL)
+    {
+        return NULL;
+    }
+    __atomic_store_n(&pBlock->refCount, 1u, __ATOMIC_RELAXED);
+    return (uint8_t *)pBlock + DISPATCHER_POOL_HEADER_SIZE;
+}
+
+void dispatcher_PoolRetain(void *const pEvent)
+{
+    (void)__atomic_add_fetch(&PoolHeader(pEvent)->refCount, 1u, __ATOMIC_RELAXED);
+}
+
+bool dispatcher_PoolRelease(void *const pEvent)
+{
+    dispatcher_poolBlock_t *pBlock = PoolHeader(pEvent);
+
+    /* acq_rel, writes of every holder happen before the block is reused. */
+    if (__atomic_sub_fetch(&pBlock->refCount, 1u, __ATOMIC_ACQ_REL) != 0u)
+    {
+        return false;
+    }
+    PoolPush(pBlock->pPool, pBlock);
+    return true;
+}
+
+uint16_t dispatcher_PoolFreeCount(dispatcher_pool_t const *const pPool)
+{
+    uint16_t count = 0;
+
+    for (uint32_t i = 0; i < pPool->blockCount; i++)
+    {
+        if (__atomic_load_n(&PoolBlock(pPool, i)->refCount, __ATOMIC_RELAXED) == 0u)
+        {
+            count++;
+        }
+    }
+    return count;
+}
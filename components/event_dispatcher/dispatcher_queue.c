@@ -0,0 +1,997 @@
+#include <dispatcher_queue.h>
+#include <string.h>
+
+/*-------------------------WAITER-------------------------*/
+
+dispatcher_portStatus_t dispatcher_WaiterInit(dispatcher_waiter_t *const pWaiter)
+{
+    pWaiter->sleeping = 0;
+    pWaiter->ready = 0;
+    return dispatcher_PortSignalCreate(&pWaiter->signal);
+}
+
+void dispatcher_WaiterNotify(dispatcher_waiter_t *const pWaiter)
+{
+    /* pairs with the fence in QueueSleep, either the consumer sees the
+       published item or we see it sleeping. */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pWaiter->sleeping, __ATOMIC_RELAXED) != 0u)
+    {
+        __atomic_store_n(&pWaiter->sleeping, 0u, __ATOMIC_RELAXED);
+        dispatcher_PortSignalNotify(&pWaiter->signal);
+    }
+}
+
+void dispatcher_WaiterNotifyFromIsr(dispatcher_waiter_t *const pWaiter, int *pWoken)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pWaiter->sleeping, __ATOMIC_RELAXED) != 0u)
+    {
+        __atomic_store_n(&pWaiter->sleeping, 0u, __ATOMIC_RELAXED);
+        dispatcher_PortSignalNotifyFromIsr(&pWaiter->signal, pWoken);
+    }
+}
+
+uint32_t dispatcher_WaiterReady(dispatcher_waiter_t *const pWaiter)
+{
+    return __atomic_load_n(&pWaiter->ready, __ATOMIC_ACQUIRE);
+}
+
+void dispatcher_WaiterClear(dispatcher_waiter_t *const pWaiter, uint32_t bits)
+{
+    (void)__atomic_fetch_and(&pWaiter->ready, ~bits, __ATOMIC_SEQ_CST);
+}
+
+void dispatcher_WaiterMark(dispatcher_waiter_t *const pWaiter, uint32_t bits)
+{
+    (void)__atomic_fetch_or(&pWaiter->ready, bits, __ATOMIC_RELEASE);
+}
+
+dispatcher_portStatus_t dispatcher_WaiterWait(dispatcher_waiter_t *const pWaiter, dispatcher_portTick_t timeout)
+{
+    return dispatcher_WaiterWaitExcept(pWaiter, NULL, timeout);
+}
+
+dispatcher_portStatus_t dispatcher_WaiterWaitExcept(dispatcher_waiter_t *const pWaiter,
+                                                    uint32_t const *pBusy,
+                                                    dispatcher_portTick_t timeout)
+{
+    dispatcher_portStatus_t state = DISPATCHER_PORT_OK;
+    uint32_t busy = 0;
+
+    /* same handshake as QueueSleep, with the ready bitmap as the condition. */
+    __atomic_store_n(&pWaiter->sleeping, 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (pBusy != NULL)
+    {
+        busy = __atomic_load_n(pBusy, __ATOMIC_RELAXED);
+    }
+    if ((__atomic_load_n(&pWaiter->ready, __ATOMIC_RELAXED) & ~busy) == 0u)
+    {
+        state = dispatcher_PortSignalWait(&pWaiter->signal, timeout);
+    }
+    __atomic_store_n(&pWaiter->sleeping, 0u, __ATOMIC_RELAXED);
+    return state;
+}
+
+/*-------------------------SPSC---------------------------*/
+
+static void *SpscReserve(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_spsc_t *pRing = &pQueue->backend.spsc;
+    uint32_t head = __atomic_load_n(&pRing->head, __ATOMIC_RELAXED);
+
+    if (head - pRing->tailCache >= pQueue->itemCount)
+    {
+        pRing->tailCache = __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE);
+        if (head - pRing->tailCache >= pQueue->itemCount)
+        {
+            return NULL;
+        }
+    }
+    return &pQueue->storage[(head & pQueue->mask) * pQueue->slotSize];
+}
+
+static void SpscCommit(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_spsc_t *pRing = &pQueue->backend.spsc;
+
+    __atomic_store_n(&pRing->head, __atomic_load_n(&pRing->head, __ATOMIC_RELAXED) + 1u, __ATOMIC_RELEASE);
+}
+
+static void *SpscPeek(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_spsc_t *pRing = &pQueue->backend.spsc;
+    uint32_t tail = __atomic_load_n(&pRing->tail, __ATOMIC_RELAXED);
+
+    if (tail == pRing->headCache)
+    {
+        pRing->headCache = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE);
+        if (tail == pRing->headCache)
+        {
+            return NULL;
+        }
+    }
+    return &pQueue->storage[(tail & pQueue->mask) * pQueue->slotSize];
+}
+
+static void SpscRelease(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_spsc_t *pRing = &pQueue->backend.spsc;
+
+    __atomic_store_n(&pRing->tail, __atomic_load_n(&pRing->tail, __ATOMIC_RELAXED) + 1u, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Copy as many of count items as fit and publish them with one store.
+ */
+static uint16_t SpscPushBatch(dispatcher_queue_t *const pQueue, uint8_t const *pItems, uint16_t count)
+{
+    dispatcher_spsc_t *pRing = &pQueue->backend.spsc;
+    uint32_t head = __atomic_load_n(&pRing->head, __ATOMIC_RELAXED);
+    uint32_t space = pQueue->itemCount - (head - pRing->tailCache);
+
+    if (space < count)
+    {
+        pRing->tailCache = __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE);
+        space = pQueue->itemCount - (head - pRing->tailCache);
+    }
+    if (space > count)
+    {
+        space = count;
+    }
+
+    for (uint32_t i = 0; i < space; i++)
+    {
+        (void)memcpy(&pQueue->storage[((head + i) & pQueue->mask) * pQueue->slotSize],
+                     &pItems[i * pQueue->itemSize],
+                     pQueue->itemSize);
+    }
+    __atomic_store_n(&pRing->head, head + space, __ATOMIC_RELEASE);
+    return (uint16_t)space;
+}
+
+/*-------------------------MPSC---------------------------*/
+
+/*
+ *  Slot layout : sequence word, item at DISPATCHER_QUEUE_ALIGN_UP(4).
+ *  A slot is free for position pos when sequence == pos and holds the
+ *  item of position pos when sequence == pos + 1. A reserved slot keeps
+ *  sequence == pos until it is committed, so commit finds everything it
+ *  needs from the item pointer.
+ */
+#define MPSC_HEADER_SIZE DISPATCHER_QUEUE_ALIGN_UP(sizeof(uint32_t))
+
+static inline uint32_t *MpscSequence(dispatcher_queue_t *const pQueue, uint32_t pos)
+{
+    return (uint32_t *)(void *)&pQueue->storage[(pos & pQueue->mask) * pQueue->slotSize];
+}
+
+static inline uint8_t *MpscItem(dispatcher_queue_t *const pQueue, uint32_t pos)
+{
+    return &pQueue->storage[(pos & pQueue->mask) * pQueue->slotSize + MPSC_HEADER_SIZE];
+}
+
+static void *MpscReserve(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_mpsc_t *pRing = &pQueue->backend.mpsc;
+    uint32_t pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        uint32_t sequence = __atomic_load_n(MpscSequence(pQueue, pos), __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(sequence - pos);
+
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&pRing->enqueue, &pos, pos + 1u, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                return MpscItem(pQueue, pos);
+            }
+        }
+        else if (diff < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void MpscCommit(void *const pItem)
+{
+    uint32_t *pSequence = (uint32_t *)(void *)((uint8_t *)pItem - MPSC_HEADER_SIZE);
+
+    __atomic_store_n(pSequence, __atomic_load_n(pSequence, __ATOMIC_RELAXED) + 1u, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Claim a run of consecutive free slots with one compare and swap.
+ *  The consumer frees slots in order, so the run ends at the first slot
+ *  still in use.
+ */
+static uint16_t MpscPushBatch(dispatcher_queue_t *const pQueue, uint8_t const *pItems, uint16_t count)
+{
+    dispatcher_mpsc_t *pRing = &pQueue->backend.mpsc;
+    uint32_t pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+    uint32_t claimed;
+
+    for (;;)
+    {
+        int32_t diff = (int32_t)(__atomic_load_n(MpscSequence(pQueue, pos), __ATOMIC_ACQUIRE) - pos);
+
+        if (diff < 0)
+        {
+            return 0;
+        }
+        if (diff > 0)
+        {
+            pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        claimed = 1;
+        while (claimed < count &&
+               __atomic_load_n(MpscSequence(pQueue, pos + claimed), __ATOMIC_ACQUIRE) == pos + claimed)
+        {
+            claimed++;
+        }
+
+        if (__atomic_compare_exchange_n(&pRing->enqueue, &pos, pos + claimed, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < claimed; i++)
+    {
+        (void)memcpy(MpscItem(pQueue, pos + i), &pItems[i * pQueue->itemSize], pQueue->itemSize);
+        __atomic_store_n(MpscSequence(pQueue, pos + i), pos + i + 1u, __ATOMIC_RELEASE);
+    }
+    return (uint16_t)claimed;
+}
+
+/*
+ *  The consumer claims the oldest published item by moving dequeue on,
+ *  producers evicting race for the same item (MpscEvict). The claimed
+ *  item is returned again until it is released.
+ */
+static void *MpscPeek(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_mpsc_t *pRing = &pQueue->backend.mpsc;
+
+    if (pRing->held != 0u)
+    {
+        return MpscItem(pQueue, pRing->taken);
+    }
+
+    uint32_t pos = __atomic_load_n(&pRing->dequeue, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        if (__atomic_load_n(MpscSequence(pQueue, pos), __ATOMIC_ACQUIRE) != pos + 1u)
+        {
+            return NULL;
+        }
+        if (__atomic_compare_exchange_n(&pRing->dequeue, &pos, pos + 1u, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            pRing->taken = pos;
+            pRing->held = 1u;
+            return MpscItem(pQueue, pos);
+        }
+    }
+}
+
+static void MpscRelease(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_mpsc_t *pRing = &pQueue->backend.mpsc;
+    uint32_t pos = pRing->taken;
+
+    __atomic_store_n(MpscSequence(pQueue, pos), pos + pQueue->mask + 1u, __ATOMIC_RELEASE);
+    pRing->held = 0u;
+}
+
+/*
+ *  Claim the oldest published item like the consumer does, copy it out
+ *  and free its slot. An item still being written stops the eviction.
+ */
+static bool MpscEvict(dispatcher_queue_t *const pQueue, void *const pItem, uint16_t size)
+{
+    dispatcher_mpsc_t *pRing = &pQueue->backend.mpsc;
+    uint32_t pos = __atomic_load_n(&pRing->dequeue, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        if (__atomic_load_n(MpscSequence(pQueue, pos), __ATOMIC_ACQUIRE) != pos + 1u)
+        {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&pRing->dequeue, &pos, pos + 1u, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            (void)memcpy(pItem, MpscItem(pQueue, pos), size);
+            __atomic_store_n(MpscSequence(pQueue, pos), pos + pQueue->mask + 1u, __ATOMIC_RELEASE);
+            return true;
+        }
+    }
+}
+
+/*-------------------------VARIABLE-----------------------*/
+
+/*
+ *  Record layout : length word, item at DISPATCHER_QUEUE_ALIGN_UP(4), the
+ *  record takes DISPATCHER_QUEUE_SLOT_SIZE(length) bytes. A record never
+ *  wraps, a producer which would cross the end of storage claims the tail
+ *  end as a padding record and starts again at offset 0.
+ *  The consumer zeroes every record it frees, so any word at a record
+ *  boundary still being written reads as not ready.
+ */
+#define VAR_READY (0x80000000u)
+#define VAR_PAD (0x40000000u)
+#define VAR_LENGTH_MASK (0x3FFFFFFFu)
+
+static inline uint32_t *VarHeader(dispatcher_queue_t *const pQueue, uint32_t pos)
+{
+    return (uint32_t *)(void *)&pQueue->storage[pos & pQueue->mask];
+}
+
+static void *VarReserve(dispatcher_queue_t *const pQueue, uint16_t size)
+{
+    dispatcher_var_t *pRing = &pQueue->backend.var;
+    uint32_t stride = DISPATCHER_QUEUE_SLOT_SIZE(size);
+    uint32_t pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        uint32_t contiguous = pRing->capacity - (pos & pQueue->mask);
+        uint32_t claim = (contiguous < stride) ? contiguous : stride;
+        uint32_t tail = __atomic_load_n(&pRing->dequeue, __ATOMIC_ACQUIRE);
+
+        if ((int32_t)(pos - tail) < 0)
+        {
+            // pos is stale, the consumer already moved past it
+            pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (pos + claim - tail > pRing->capacity)
+        {
+            return NULL;
+        }
+        if (!__atomic_compare_exchange_n(&pRing->enqueue, &pos, pos + claim, true,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            continue;
+        }
+
+        if (claim == stride)
+        {
+            // length without the ready bit, published by commit
+            __atomic_store_n(VarHeader(pQueue, pos), (uint32_t)size, __ATOMIC_RELAXED);
+            return (uint8_t *)VarHeader(pQueue, pos) + MPSC_HEADER_SIZE;
+        }
+
+        __atomic_store_n(VarHeader(pQueue, pos), VAR_READY | VAR_PAD | claim, __ATOMIC_RELEASE);
+        pos = __atomic_load_n(&pRing->enqueue, __ATOMIC_RELAXED);
+    }
+}
+
+static void VarCommit(void *const pItem)
+{
+    uint32_t *pHeader = (uint32_t *)(void *)((uint8_t *)pItem - MPSC_HEADER_SIZE);
+
+    __atomic_store_n(pHeader, __atomic_load_n(pHeader, __ATOMIC_RELAXED) | VAR_READY, __ATOMIC_RELEASE);
+}
+
+static void *VarPeek(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_var_t *pRing = &pQueue->backend.var;
+
+    for (;;)
+    {
+        uint32_t pos = __atomic_load_n(&pRing->dequeue, __ATOMIC_RELAXED);
+        uint32_t *pHeader = VarHeader(pQueue, pos);
+        uint32_t header = __atomic_load_n(pHeader, __ATOMIC_ACQUIRE);
+
+        if ((header & VAR_READY) == 0)
+        {
+            return NULL;
+        }
+
+        if ((header & VAR_PAD) != 0)
+        {
+            __atomic_store_n(pHeader, 0u, __ATOMIC_RELAXED);
+            __atomic_store_n(&pRing->dequeue, pos + (header & VAR_LENGTH_MASK), __ATOMIC_RELEASE);
+            continue;
+        }
+
+        pRing->length = header & VAR_LENGTH_MASK;
+        return (uint8_t *)pHeader + MPSC_HEADER_SIZE;
+    }
+}
+
+static void VarRelease(dispatcher_queue_t *const pQueue)
+{
+    dispatcher_var_t *pRing = &pQueue->backend.var;
+    uint32_t pos = __atomic_load_n(&pRing->dequeue, __ATOMIC_RELAXED);
+    uint32_t stride = DISPATCHER_QUEUE_SLOT_SIZE(pRing->length);
+
+    (void)memset(VarHeader(pQueue, pos), 0, stride);
+    __atomic_store_n(&pRing->dequeue, pos + stride, __ATOMIC_RELEASE);
+}
+
+static uint16_t VarPushBatch(dispatcher_queue_t *const pQueue, uint8_t const *pItems, uint16_t count)
+{
+    uint16_t sent = 0;
+    void *pSlot;
+
+    while (sent < count && (pSlot = VarReserve(pQueue, pQueue->itemSize)) != NULL)
+    {
+        (void)memcpy(pSlot, &pItems[sent * pQueue->itemSize], pQueue->itemSize);
+        VarCommit(pSlot);
+        sent++;
+    }
+    return sent;
+}
+
+/*-------------------------QUEUE--------------------------*/
+
+static void *QueueTryReserve(dispatcher_queue_t *const pQueue, uint16_t size)
+{
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+        return SpscReserve(pQueue);
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        return MpscReserve(pQueue);
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        return VarReserve(pQueue, size);
+    default:
+        return NULL;
+    }
+}
+
+static uint16_t QueueTryPushBatch(dispatcher_queue_t *const pQueue, uint8_t const *pItems, uint16_t count)
+{
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+        return SpscPushBatch(pQueue, pItems, count);
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        return MpscPushBatch(pQueue, pItems, count);
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        return VarPushBatch(pQueue, pItems, count);
+    default:
+        return 0;
+    }
+}
+
+static void QueuePublish(dispatcher_queue_t *const pQueue, void *const pItem)
+{
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+        SpscCommit(pQueue);
+        break;
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        MpscCommit(pItem);
+        break;
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        VarCommit(pItem);
+        break;
+    default:
+        break;
+    }
+}
+
+static void *QueueTryPeek(dispatcher_queue_t *const pQueue)
+{
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+        return SpscPeek(pQueue);
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        return MpscPeek(pQueue);
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        return VarPeek(pQueue);
+    default:
+        return NULL;
+    }
+}
+
+/*
+ *  Wakes the consumer after publishing, a lane also sets its ready bit
+ *  first. Port queues only have a waiter when they are a lane.
+ */
+static void QueueNotify(dispatcher_queue_t *const pQueue)
+{
+    if (pQueue->laneBit != 0u)
+    {
+        dispatcher_WaiterMark(pQueue->pWaiter, pQueue->laneBit);
+    }
+    if (pQueue->pWaiter != NULL)
+    {
+        dispatcher_WaiterNotify(pQueue->pWaiter);
+    }
+}
+
+static void QueueNotifyFromIsr(dispatcher_queue_t *const pQueue, int *pWoken)
+{
+    if (pQueue->laneBit != 0u)
+    {
+        dispatcher_WaiterMark(pQueue->pWaiter, pQueue->laneBit);
+    }
+    if (pQueue->pWaiter != NULL)
+    {
+        dispatcher_WaiterNotifyFromIsr(pQueue->pWaiter, pWoken);
+    }
+}
+
+/*
+ *  Number of valid bytes of the item returned by QueueTryPeek.
+ */
+static inline uint16_t QueueItemLength(dispatcher_queue_t const *const pQueue)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_VARIABLE)
+    {
+        return (uint16_t)pQueue->backend.var.length;
+    }
+    return pQueue->itemSize;
+}
+
+/*
+ *  Remaining part of a timeout started at tick start, 0 once expired.
+ */
+static dispatcher_portTick_t QueueRemaining(dispatcher_portTick_t start, dispatcher_portTick_t timeout)
+{
+    dispatcher_portTick_t elapsed = dispatcher_PortGetTick() - start;
+
+    if (timeout == DISPATCHER_PORT_MAX_DELAY)
+    {
+        return DISPATCHER_PORT_MAX_DELAY;
+    }
+    return (elapsed >= timeout) ? 0 : (timeout - elapsed);
+}
+
+/*
+ *  Producer side of a ring backend, polls with backoff while full. The
+ *  tick is only read once the first attempt failed.
+ */
+static void *QueueReserveWait(dispatcher_queue_t *const pQueue, uint16_t size, dispatcher_portTick_t timeout)
+{
+    dispatcher_portTick_t start = 0;
+    uint32_t attempt = 0;
+    void *pItem;
+
+    while ((pItem = QueueTryReserve(pQueue, size)) == NULL)
+    {
+        if (attempt == 0)
+        {
+            start = dispatcher_PortGetTick();
+        }
+        if (QueueRemaining(start, timeout) == 0)
+        {
+            return NULL;
+        }
+        dispatcher_PortBackoff(attempt++);
+    }
+    return pItem;
+}
+
+/*
+ *  Consumer side of a ring backend, polls once more after announcing
+ *  sleep so a producer publishing concurrently is never missed.
+ */
+static void *QueueSleep(dispatcher_queue_t *const pQueue, dispatcher_portTick_t timeout)
+{
+    dispatcher_waiter_t *pWaiter = pQueue->pWaiter;
+    void *pItem = QueueTryPeek(pQueue);
+
+    if (pItem != NULL)
+    {
+        return pItem;
+    }
+
+    dispatcher_portTick_t start = dispatcher_PortGetTick();
+
+    for (;;)
+    {
+        dispatcher_portTick_t remaining = QueueRemaining(start, timeout);
+        if (remaining == 0)
+        {
+            return NULL;
+        }
+
+        __atomic_store_n(&pWaiter->sleeping, 1u, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((pItem = QueueTryPeek(pQueue)) != NULL)
+        {
+            __atomic_store_n(&pWaiter->sleeping, 0u, __ATOMIC_RELAXED);
+            return pItem;
+        }
+
+        (void)dispatcher_PortSignalWait(&pWaiter->signal, remaining);
+        __atomic_store_n(&pWaiter->sleeping, 0u, __ATOMIC_RELAXED);
+
+        if ((pItem = QueueTryPeek(pQueue)) != NULL)
+        {
+            return pItem;
+        }
+    }
+}
+
+dispatcher_portStatus_t dispatcher_QueueInit(dispatcher_queue_t *const pQueue,
+                                             dispatcher_queueType_t type,
+                                             uint16_t itemSize,
+                                             uint16_t itemCount,
+                                             uint8_t *storage,
+                                             dispatcher_waiter_t *pWaiter)
+{
+    (void)memset(pQueue, 0, sizeof(dispatcher_queue_t));
+    pQueue->slotSize = itemSize;
+
+    switch (type)
+    {
+    case DISPATCHER_QUEUE_TYPE_DEFAULT:
+        if (dispatcher_PortQueueCreate(&pQueue->backend.port, itemSize, itemCount, storage) != DISPATCHER_PORT_OK)
+        {
+            return DISPATCHER_PORT_FAIL;
+        }
+        break;
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        if (pWaiter == NULL || (itemCount & (itemCount - 1u)) != 0)
+        {
+            return DISPATCHER_PORT_FAIL;
+        }
+        pQueue->mask = (uint32_t)itemCount - 1u;
+        pQueue->pWaiter = pWaiter;
+
+        if (type == DISPATCHER_QUEUE_TYPE_MPSC)
+        {
+            if (((uintptr_t)storage & (DISPATCHER_QUEUE_ALIGN - 1u)) != 0)
+            {
+                return DISPATCHER_PORT_FAIL;
+            }
+            pQueue->slotSize = (uint16_t)DISPATCHER_QUEUE_SLOT_SIZE(itemSize);
+            pQueue->storage = storage;
+            for (uint32_t pos = 0; pos < itemCount; pos++)
+            {
+                *MpscSequence(pQueue, pos) = pos;
+            }
+        }
+        break;
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        if (pWaiter == NULL || ((uintptr_t)storage & (DISPATCHER_QUEUE_ALIGN - 1u)) != 0)
+        {
+            return DISPATCHER_PORT_FAIL;
+        }
+        // positions wrap at 2^32, a power of two capacity keeps them on the same bytes
+        if ((uint32_t)itemCount * DISPATCHER_QUEUE_SLOT_SIZE(itemSize) > 0x80000000u)
+        {
+            return DISPATCHER_PORT_FAIL;
+        }
+        pQueue->pWaiter = pWaiter;
+        pQueue->backend.var.capacity = DISPATCHER_QUEUE_VAR_CAPACITY(itemSize, itemCount);
+        pQueue->mask = pQueue->backend.var.capacity - 1u;
+        (void)memset(storage, 0, pQueue->backend.var.capacity);
+        break;
+    default:
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    pQueue->itemSize = itemSize;
+    pQueue->itemCount = itemCount;
+    pQueue->type = type;
+    pQueue->storage = storage;
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_QueueSetLane(dispatcher_queue_t *const pQueue,
+                                                uint8_t lane,
+                                                dispatcher_waiter_t *pWaiter)
+{
+    if (lane >= 32u || pWaiter == NULL)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+    pQueue->pWaiter = pWaiter;
+    pQueue->laneBit = 1u << lane;
+    return DISPATCHER_PORT_OK;
+}
+
+bool dispatcher_QueueIsValid(dispatcher_queue_t const *const pQueue)
+{
+    return pQueue->storage != NULL;
+}
+
+dispatcher_portStatus_t dispatcher_QueueSend(dispatcher_queue_t *const pQueue,
+                                             void const *const pItem,
+                                             dispatcher_portTick_t timeout)
+{
+    return dispatcher_QueueSendSized(pQueue, pItem, pQueue->itemSize, timeout);
+}
+
+dispatcher_portStatus_t dispatcher_QueueSendSized(dispatcher_queue_t *const pQueue,
+                                                  void const *const pItem,
+                                                  uint16_t size,
+                                                  dispatcher_portTick_t timeout)
+{
+    if (size == 0 || size > pQueue->itemSize)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        if (size != pQueue->itemSize)
+        {
+            return DISPATCHER_PORT_FAIL;
+        }
+
+        dispatcher_portStatus_t state = dispatcher_PortQueueSend(&pQueue->backend.port, pItem, timeout);
+
+        if (state == DISPATCHER_PORT_OK)
+        {
+            QueueNotify(pQueue);
+        }
+        return state;
+    }
+
+    void *pSlot = QueueReserveWait(pQueue, size, timeout);
+
+    if (pSlot == NULL)
+    {
+        return DISPATCHER_PORT_FULL;
+    }
+    (void)memcpy(pSlot, pItem, size);
+    dispatcher_QueueCommit(pQueue, pSlot);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_QueueSendFromIsr(dispatcher_queue_t *const pQueue,
+                                                    void const *const pItem,
+                                                    int *pWoken)
+{
+    return dispatcher_QueueSendSizedFromIsr(pQueue, pItem, pQueue->itemSize, pWoken);
+}
+
+dispatcher_portStatus_t dispatcher_QueueSendSizedFromIsr(dispatcher_queue_t *const pQueue,
+                                                         void const *const pItem,
+                                                         uint16_t size,
+                                                         int *pWoken)
+{
+    if (size == 0 || size > pQueue->itemSize)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        if (size != pQueue->itemSize)
+        {
+            return DISPATCHER_PORT_FAIL;
+        }
+
+        dispatcher_portStatus_t state = dispatcher_PortQueueSendFromIsr(&pQueue->backend.port, pItem, pWoken);
+
+        if (state == DISPATCHER_PORT_OK)
+        {
+            QueueNotifyFromIsr(pQueue, pWoken);
+        }
+        return state;
+    }
+
+    void *pSlot = QueueTryReserve(pQueue, size);
+
+    if (pSlot == NULL)
+    {
+        return DISPATCHER_PORT_FULL;
+    }
+    (void)memcpy(pSlot, pItem, size);
+    QueuePublish(pQueue, pSlot);
+    QueueNotifyFromIsr(pQueue, pWoken);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_QueueSendBatch(dispatcher_queue_t *const pQueue,
+                                                  void const *const pItems,
+                                                  uint16_t count,
+                                                  dispatcher_portTick_t timeout,
+                                                  uint16_t *pSent)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        dispatcher_portStatus_t state = dispatcher_PortQueueSendBatch(&pQueue->backend.port, pItems, count, timeout, pSent);
+
+        if (*pSent != 0)
+        {
+            QueueNotify(pQueue);
+        }
+        return state;
+    }
+
+    dispatcher_portTick_t start = 0;
+    uint32_t attempt = 0;
+    uint16_t sent;
+
+    *pSent = 0;
+    if (count == 0)
+    {
+        return DISPATCHER_PORT_OK;
+    }
+
+    while ((sent = QueueTryPushBatch(pQueue, pItems, count)) == 0)
+    {
+        if (attempt == 0)
+        {
+            start = dispatcher_PortGetTick();
+        }
+        if (QueueRemaining(start, timeout) == 0)
+        {
+            return DISPATCHER_PORT_FULL;
+        }
+        dispatcher_PortBackoff(attempt++);
+    }
+
+    QueueNotify(pQueue);
+    *pSent = sent;
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_QueueSendBatchFromIsr(dispatcher_queue_t *const pQueue,
+                                                         void const *const pItems,
+                                                         uint16_t count,
+                                                         uint16_t *pSent,
+                                                         int *pWoken)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        dispatcher_portStatus_t state = dispatcher_PortQueueSendBatchFromIsr(&pQueue->backend.port, pItems, count, pSent, pWoken);
+
+        if (*pSent != 0)
+        {
+            QueueNotifyFromIsr(pQueue, pWoken);
+        }
+        return state;
+    }
+
+    *pSent = QueueTryPushBatch(pQueue, pItems, count);
+    if (*pSent == 0)
+    {
+        return (count == 0) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_FULL;
+    }
+
+    QueueNotifyFromIsr(pQueue, pWoken);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_QueueReceive(dispatcher_queue_t *const pQueue,
+                                                void *const pItem,
+                                                dispatcher_portTick_t timeout)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        return dispatcher_PortQueueReceive(&pQueue->backend.port, pItem, timeout);
+    }
+
+    void *pSlot = QueueSleep(pQueue, timeout);
+
+    if (pSlot == NULL)
+    {
+        return DISPATCHER_PORT_EMPTY;
+    }
+    (void)memcpy(pItem, pSlot, QueueItemLength(pQueue));
+    dispatcher_QueueRelease(pQueue);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_QueueReserve(dispatcher_queue_t *const pQueue,
+                                                void **ppItem,
+                                                dispatcher_portTick_t timeout)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    *ppItem = QueueReserveWait(pQueue, pQueue->itemSize, timeout);
+    return (*ppItem != NULL) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_FULL;
+}
+
+void dispatcher_QueueCommit(dispatcher_queue_t *const pQueue, void *const pItem)
+{
+    QueuePublish(pQueue, pItem);
+    QueueNotify(pQueue);
+}
+
+dispatcher_portStatus_t dispatcher_QueueAcquire(dispatcher_queue_t *const pQueue,
+                                                void *const pStorage,
+                                                void **ppItem,
+                                                dispatcher_portTick_t timeout)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_DEFAULT)
+    {
+        dispatcher_portStatus_t state = dispatcher_PortQueueReceive(&pQueue->backend.port, pStorage, timeout);
+
+        *ppItem = (state == DISPATCHER_PORT_OK) ? pStorage : NULL;
+        return state;
+    }
+
+    *ppItem = QueueSleep(pQueue, timeout);
+    return (*ppItem != NULL) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_EMPTY;
+}
+
+uint16_t dispatcher_QueueItemLength(dispatcher_queue_t const *const pQueue)
+{
+    if (pQueue->type == DISPATCHER_QUEUE_TYPE_VARIABLE)
+    {
+        return (uint16_t)pQueue->backend.var.length;
+    }
+    return pQueue->itemSize;
+}
+
+uint32_t dispatcher_QueueUsed(dispatcher_queue_t *const pQueue)
+{
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+        return __atomic_load_n(&pQueue->backend.spsc.head, __ATOMIC_RELAXED) -
+               __atomic_load_n(&pQueue->backend.spsc.tail, __ATOMIC_RELAXED);
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        return __atomic_load_n(&pQueue->backend.mpsc.enqueue, __ATOMIC_RELAXED) - pQueue->backend.mpsc.taken;
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        return __atomic_load_n(&pQueue->backend.var.enqueue, __ATOMIC_RELAXED) -
+               __atomic_load_n(&pQueue->backend.var.dequeue, __ATOMIC_RELAXED);
+    default:
+        // the port queue already gave the held item out
+        return dispatcher_PortQueueCount(&pQueue->backend.port) + 1u;
+    }
+}
+
+void dispatcher_QueueRelease(dispatcher_queue_t *const pQueue)
+{
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_SPSC:
+        SpscRelease(pQueue);
+        break;
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        MpscRelease(pQueue);
+        break;
+    case DISPATCHER_QUEUE_TYPE_VARIABLE:
+        VarRelease(pQueue);
+        break;
+    default:
+        break;
+    }
+}
+
+dispatcher_portStatus_t dispatcher_QueueEvict(dispatcher_queue_t *const pQueue,
+                                              void *const pItem,
+                                              uint16_t size,
+                                              int *pWoken)
+{
+    if (size > pQueue->itemSize)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    switch (pQueue->type)
+    {
+    case DISPATCHER_QUEUE_TYPE_DEFAULT:
+        return dispatcher_PortQueueEvict(&pQueue->backend.port, pItem, size, pWoken);
+    case DISPATCHER_QUEUE_TYPE_MPSC:
+        if (pWoken != NULL)
+        {
+            *pWoken = 0;
+        }
+        return MpscEvict(pQueue, pItem, size) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_EMPTY;
+    default:
+        return DISPATCHER_PORT_FAIL;
+    }
+}
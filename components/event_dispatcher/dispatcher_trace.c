@@ -0,0 +1,82 @@
+#include <dispatcher_trace.h>
+
+dispatcher_portStatus_t dispatcher_TraceRingInit(dispatcher_trace_t *const pTrace,
+                                                 dispatcher_traceRecord_t *const records,
+                                                 uint32_t count)
+{
+    if (records == NULL || count == 0 || (count & (count - 1u)) != 0)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    __atomic_store_n(&pTrace->enabled, 0u, __ATOMIC_RELAXED);
+    pTrace->records = records;
+    pTrace->mask = count - 1u;
+    __atomic_store_n(&pTrace->head, 0u, __ATOMIC_RELEASE);
+    return DISPATCHER_PORT_OK;
+}
+
+void dispatcher_TraceRingEnable(dispatcher_trace_t *const pTrace, bool enable)
+{
+    __atomic_store_n(&pTrace->enabled, enable ? 1u : 0u, __ATOMIC_RELEASE);
+}
+
+/*
+ *  The slot is claimed before the timestamp is taken, records of racing
+ *  writers may be a few cycles out of order in the ring.
+ */
+void dispatcher_TraceRingWrite(dispatcher_trace_t *const pTrace,
+                               uint8_t type,
+                               uint8_t flags,
+                               uint16_t signal,
+                               void const *const pDispatcher,
+                               uint32_t arg)
+{
+    if (!__atomic_load_n(&pTrace->enabled, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    uint32_t index = __atomic_fetch_add(&pTrace->head, 1u, __ATOMIC_RELAXED);
+    dispatcher_traceRecord_t *pRecord = &pTrace->records[index & pTrace->mask];
+
+    pRecord->timestamp = dispatcher_PortCycles();
+    pRecord->type = type;
+    pRecord->flags = flags;
+    pRecord->signal = signal;
+    pRecord->dispatcher = (uint32_t)(uintptr_t)pDispatcher;
+    pRecord->arg = arg;
+}
+
+uint32_t dispatcher_TraceRingDump(dispatcher_trace_t const *const pTrace,
+                                  dispatcher_traceWrite_t write,
+                                  void *pArg)
+{
+    uint32_t head = __atomic_load_n(&pTrace->head, __ATOMIC_ACQUIRE);
+    uint32_t size = pTrace->mask + 1u;
+    uint32_t count = (head < size) ? head : size;
+    dispatcher_traceHeader_t header = {
+        .magic = DISPATCHER_TRACE_MAGIC,
+        .version = DISPATCHER_TRACE_VERSION,
+        .recordSize = (uint16_t)sizeof(dispatcher_traceRecord_t),
+        .count = count,
+        .lost = head - count,
+        .cyclesPerUs = dispatcher_PortCyclesPerUs(),
+    };
+
+    write(&header, sizeof(header), pArg);
+
+    // oldest record up to the end of the storage, then the wrapped part
+    uint32_t first = (head - count) & pTrace->mask;
+    uint32_t chunk = (count < size - first) ? count : size - first;
+
+    if (chunk != 0)
+    {
+        write(&pTrace->records[first], chunk * (uint32_t)sizeof(dispatcher_traceRecord_t), pArg);
+    }
+    if (count > chunk)
+    {
+        write(&pTrace->records[0], (count - chunk) * (uint32_t)sizeof(dispatcher_traceRecord_t), pArg);
+    }
+    return count;
+}
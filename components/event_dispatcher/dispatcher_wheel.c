@@ -0,0 +1,270 @@
+
+#include <dispatcher_wheel.h>
+#include <string.h>
+
+#define WHEEL_MASK (DISPATCHER_WHEEL_SLOTS - 1u)
+#define WHEEL_RANGE_BITS (DISPATCHER_WHEEL_SLOT_BITS * DISPATCHER_WHEEL_LEVELS)
+#define WHEEL_SHIFT(level) ((level) * DISPATCHER_WHEEL_SLOT_BITS)
+
+#if (DISPATCHER_WHEEL_SLOT_BITS > 5) || (WHEEL_RANGE_BITS > 31)
+#error "DISPATCHER_WHEEL_SLOT_BITS or DISPATCHER_WHEEL_LEVELS too large"
+#endif
+
+/*
+ *  Distance from index to the next occupied slot, wrapping around the
+ *  level. occupied must not be 0.
+ */
+static uint32_t WheelNextSlot(uint32_t occupied, uint32_t index)
+{
+    uint32_t above = occupied & ~((1u << index) - 1u);
+
+    if (above != 0)
+    {
+        return (uint32_t)__builtin_ctz(above) - index;
+    }
+    return DISPATCHER_WHEEL_SLOTS - index + (uint32_t)__builtin_ctz(occupied);
+}
+
+/*
+ *  The level is picked by the remaining time, the slot by the expiry bits
+ *  of that level, so a timer of level n reaches level n - 1 exactly when
+ *  its slot cascades. Timers beyond the wheel take the farthest slot.
+ */
+static void WheelLink(dispatcher_wheel_t *const pWheel, dispatcher_wheelNode_t *const pNode, dispatcher_portTick_t base)
+{
+    dispatcher_portTick_t delta = pNode->expiry - base;
+    uint32_t level = 0;
+
+    if (delta >= (1u << WHEEL_RANGE_BITS))
+    {
+        delta = (1u << WHEEL_RANGE_BITS) - 1u;
+    }
+    if (delta >= DISPATCHER_WHEEL_SLOTS)
+    {
+        level = (31u - (uint32_t)__builtin_clz(delta)) / DISPATCHER_WHEEL_SLOT_BITS;
+    }
+
+    uint32_t slot = ((base + delta) >> WHEEL_SHIFT(level)) & WHEEL_MASK;
+    dispatcher_wheelNode_t **ppHead = &pWheel->slots[level][slot];
+
+    pNode->pNext = *ppHead;
+    pNode->ppPrev = ppHead;
+    if (pNode->pNext != NULL)
+    {
+        pNode->pNext->ppPrev = &pNode->pNext;
+    }
+    *ppHead = pNode;
+    pNode->slot = (uint16_t)(level * DISPATCHER_WHEEL_SLOTS + slot);
+    pWheel->occupied[level] |= (1u << slot);
+}
+
+static void WheelUnlink(dispatcher_wheel_t *const pWheel, dispatcher_wheelNode_t *const pNode)
+{
+    *pNode->ppPrev = pNode->pNext;
+    if (pNode->pNext != NULL)
+    {
+        pNode->pNext->ppPrev = pNode->ppPrev;
+    }
+
+    if (pNode->slot == DISPATCHER_WHEEL_EXPIRED)
+    {
+        if (pWheel->ppExpiredTail == &pNode->pNext)
+        {
+            pWheel->ppExpiredTail = pNode->ppPrev;
+        }
+    }
+    else
+    {
+        uint32_t level = pNode->slot / DISPATCHER_WHEEL_SLOTS;
+        uint32_t slot = pNode->slot & WHEEL_MASK;
+
+        if (pWheel->slots[level][slot] == NULL)
+        {
+            pWheel->occupied[level] &= ~(1u << slot);
+        }
+        pWheel->armed--;
+    }
+    pNode->pNext = NULL;
+    pNode->ppPrev = NULL;
+    pNode->slot = DISPATCHER_WHEEL_NONE;
+}
+
+/*
+ *  Detach a whole slot list, the caller moves every timer on.
+ */
+static dispatcher_wheelNode_t *WheelTakeSlot(dispatcher_wheel_t *const pWheel, uint32_t level, uint32_t slot)
+{
+    dispatcher_wheelNode_t *pList = pWheel->slots[level][slot];
+    dispatcher_wheelNode_t *pNode;
+
+    pWheel->slots[level][slot] = NULL;
+    pWheel->occupied[level] &= ~(1u << slot);
+    for (pNode = pList; pNode != NULL; pNode = pNode->pNext)
+    {
+        pWheel->armed--;
+    }
+    return pList;
+}
+
+static void WheelExpire(dispatcher_wheel_t *const pWheel, uint32_t slot)
+{
+    dispatcher_wheelNode_t *pNode = WheelTakeSlot(pWheel, 0, slot);
+
+    while (pNode != NULL)
+    {
+        dispatcher_wheelNode_t *pNext = pNode->pNext;
+
+        pNode->pNext = NULL;
+        pNode->ppPrev = pWheel->ppExpiredTail;
+        pNode->slot = DISPATCHER_WHEEL_EXPIRED;
+        *pWheel->ppExpiredTail = pNode;
+        pWheel->ppExpiredTail = &pNode->pNext;
+        pNode = pNext;
+    }
+}
+
+/*
+ *  Called when tick has its lower level bits all zero, the slots of the
+ *  wrapped levels move down, the farthest level first.
+ */
+static void WheelCascade(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t tick)
+{
+    uint32_t level = 1;
+
+    while ((level < DISPATCHER_WHEEL_LEVELS - 1u) && ((tick & ((1u << WHEEL_SHIFT(level + 1u)) - 1u)) == 0))
+    {
+        level++;
+    }
+
+    for (; level > 0; level--)
+    {
+        uint32_t slot = (tick >> WHEEL_SHIFT(level)) & WHEEL_MASK;
+
+        if ((pWheel->occupied[level] & (1u << slot)) == 0)
+        {
+            continue;
+        }
+
+        dispatcher_wheelNode_t *pNode = WheelTakeSlot(pWheel, level, slot);
+
+        while (pNode != NULL)
+        {
+            dispatcher_wheelNode_t *pNext = pNode->pNext;
+
+            WheelLink(pWheel, pNode, tick);
+            pWheel->armed++;
+            pNode = pNext;
+        }
+    }
+}
+
+void dispatcher_WheelInit(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t now)
+{
+    (void)memset(pWheel, 0, sizeof(dispatcher_wheel_t));
+    pWheel->now = now;
+    pWheel->ppExpiredTail = &pWheel->expired;
+}
+
+void dispatcher_WheelNodeInit(dispatcher_wheelNode_t *const pNode)
+{
+    pNode->pNext = NULL;
+    pNode->ppPrev = NULL;
+    pNode->expiry = 0;
+    pNode->slot = DISPATCHER_WHEEL_NONE;
+}
+
+void dispatcher_WheelArm(dispatcher_wheel_t *const pWheel,
+                         dispatcher_wheelNode_t *const pNode,
+                         dispatcher_portTick_t ticks)
+{
+    if (pNode->slot != DISPATCHER_WHEEL_NONE)
+    {
+        WheelUnlink(pWheel, pNode);
+    }
+    pNode->expiry = pWheel->now + ((ticks == 0) ? 1u : ticks);
+    WheelLink(pWheel, pNode, pWheel->now);
+    pWheel->armed++;
+}
+
+bool dispatcher_WheelDisarm(dispatcher_wheel_t *const pWheel, dispatcher_wheelNode_t *const pNode)
+{
+    if (pNode->slot == DISPATCHER_WHEEL_NONE)
+    {
+        return false;
+    }
+    WheelUnlink(pWheel, pNode);
+    return true;
+}
+
+bool dispatcher_WheelIsArmed(dispatcher_wheelNode_t const *const pNode)
+{
+    return pNode->slot != DISPATCHER_WHEEL_NONE;
+}
+
+/*
+ *  Steps from one interesting tick to the next, an occupied level 0 slot
+ *  or a level 0 wrap, so long idle gaps cost one step per wrap at most.
+ */
+void dispatcher_WheelAdvance(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t now)
+{
+    while ((pWheel->armed != 0) && (pWheel->now != now))
+    {
+        dispatcher_portTick_t remaining = now - pWheel->now;
+        dispatcher_portTick_t step = DISPATCHER_WHEEL_SLOTS - (pWheel->now & WHEEL_MASK);
+
+        if (pWheel->occupied[0] != 0)
+        {
+            dispatcher_portTick_t fire = WheelNextSlot(pWheel->occupied[0], (pWheel->now + 1u) & WHEEL_MASK) + 1u;
+
+            step = (fire < step) ? fire : step;
+        }
+        step = (remaining < step) ? remaining : step;
+
+        pWheel->now += step;
+        if ((pWheel->now & WHEEL_MASK) == 0)
+        {
+            WheelCascade(pWheel, pWheel->now);
+        }
+        if ((pWheel->occupied[0] & (1u << (pWheel->now & WHEEL_MASK))) != 0)
+        {
+            WheelExpire(pWheel, pWheel->now & WHEEL_MASK);
+        }
+    }
+    pWheel->now = now;
+}
+
+dispatcher_wheelNode_t *dispatcher_WheelTakeExpired(dispatcher_wheel_t *const pWheel)
+{
+    dispatcher_wheelNode_t *pNode = pWheel->expired;
+
+    if (pNode != NULL)
+    {
+        WheelUnlink(pWheel, pNode);
+    }
+    return pNode;
+}
+
+dispatcher_portTick_t dispatcher_WheelTimeout(dispatcher_wheel_t const *const pWheel)
+{
+    dispatcher_portTick_t timeout = DISPATCHER_PORT_MAX_DELAY;
+
+    if (pWheel->expired != NULL)
+    {
+        return 0;
+    }
+
+    for (uint32_t level = 0; (pWheel->armed != 0) && (level < DISPATCHER_WHEEL_LEVELS); level++)
+    {
+        if (pWheel->occupied[level] == 0)
+        {
+            continue;
+        }
+
+        dispatcher_portTick_t current = pWheel->now >> WHEEL_SHIFT(level);
+        dispatcher_portTick_t distance = WheelNextSlot(pWheel->occupied[level], (current + 1u) & WHEEL_MASK) + 1u;
+        dispatcher_portTick_t ticks = ((current + distance) << WHEEL_SHIFT(level)) - pWheel->now;
+
+        timeout = (ticks < timeout) ? ticks : timeout;
+    }
+    return timeout;
+}
@@ -8,16 +8,30 @@
 #define __DISPATCHER_H__
 
 #include <stdint.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
-#include <esp_log.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+#include <dispatcher_queue.h>
+#include <dispatcher_pool.h>
+#include <dispatcher_wheel.h>
+#include <dispatcher_trace.h>
+#include <dispatcher_log.h>
+#include <dispatcher_record.h>
+
+#ifdef __cplusplus
+#include <initializer_list>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 
 /*--------------------------LOGGING----------------------*/
 
-/*! \def    DISPATCHER_LOG_ENABLE (1)
-    \brief  Log enable value.
+/*! \def    DISPATCHER_LOG_ENABLE
+    \brief  Log enable value, every level is logged.
 */
-#define DISPATCHER_LOG_ENABLE (1)
+#define DISPATCHER_LOG_ENABLE DISPATCHER_LOG_LEVEL_DEBUG
 
 /*! \def    DISPATCHER_LOG_DISABLE (0)
     \brief  Log disbale value.
@@ -25,35 +39,221 @@
 #define DISPATCHER_LOG_DISABLE (0)
 
 /*! \def    DISPATCHER_LOG_STATE
-    \brief  Dispatcher logging state,vale DISPATCHER_LOG_ENABLE means enable and
-            DISPATCHER_LOG_DISABLE means disabled .
+    \brief  Dispatcher logging state, the highest level logged :
+            DISPATCHER_LOG_LEVEL_ERROR, DISPATCHER_LOG_LEVEL_INFO,
+            DISPATCHER_LOG_LEVEL_DEBUG (same as DISPATCHER_LOG_ENABLE) or
+            DISPATCHER_LOG_DISABLE. Calls of higher levels compile to
+            nothing.
 */
+#if !defined(DISPATCHER_LOG_STATE)
 #define DISPATCHER_LOG_STATE DISPATCHER_LOG_ENABLE
+#endif
+
+/*! \def    DISPATCHER_LOG_DEFERRED
+    \brief  Deferred logging, 1 makes log calls store the format string
+            pointer and the raw arguments into the ring given to
+            dispatcher_LogInit, formatting and output are done by
+            dispatcher_LogDrain. 0 logs through the port at once.
+*/
+#if !defined(DISPATCHER_LOG_DEFERRED)
+#define DISPATCHER_LOG_DEFERRED (0)
+#endif
+
+/*! \def    DISPATCHER_LOG_STORAGE_SIZE(count)
+    \brief  Bytes of storage for count deferred log records.
+*/
+#define DISPATCHER_LOG_STORAGE_SIZE(count) \
+    DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_MPSC, sizeof(dispatcher_logRecord_t), count)
+
+#if (DISPATCHER_LOG_DEFERRED)
+
+/* format string of a log call, the first of the variable arguments. */
+#define DISPATCHER_LOG_FORMAT(...) DISPATCHER_LOG_FORMAT_(__VA_ARGS__, 0)
+#define DISPATCHER_LOG_FORMAT_(format, ...) format
+
+/* number of arguments after the format string, 0 - 8. */
+#define DISPATCHER_LOG_NARGS(...) DISPATCHER_LOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+#define DISPATCHER_LOG_NARGS_(_f, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+/* every argument after the format string cast to uintptr_t on its own, each one preceded by a comma. */
+#define DISPATCHER_LOG_CAST(...) DISPATCHER_LOG_CAST_N(DISPATCHER_LOG_NARGS(__VA_ARGS__), __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_N(n, ...) DISPATCHER_LOG_CAST_N_(n, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_N_(n, ...) DISPATCHER_LOG_CAST_##n(__VA_ARGS__)
+#define DISPATCHER_LOG_CAST_0(f)
+#define DISPATCHER_LOG_CAST_1(f, a) , (uintptr_t)(a)
+#define DISPATCHER_LOG_CAST_2(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_1(f, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_3(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_2(f, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_4(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_3(f, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_5(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_4(f, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_6(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_5(f, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_7(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_6(f, __VA_ARGS__)
+#define DISPATCHER_LOG_CAST_8(f, a, ...) , (uintptr_t)(a) DISPATCHER_LOG_CAST_7(f, __VA_ARGS__)
+
+/* temporary array of the arguments, alive until the end of the log call. */
+#ifdef __cplusplus
+#define DISPATCHER_LOG_ARGV(...) (std::initializer_list<uintptr_t>{__VA_ARGS__}.begin())
+#else
+#define DISPATCHER_LOG_ARGV(...) ((uintptr_t const[]){__VA_ARGS__})
+#endif
+
+/*! \def    DISPATCHER_LOG_DEFER(level, tag, format, ...)
+    \brief  Store a deferred log record, every argument (at most 8) is
+            cast to uintptr_t, pointers and strings included. The
+            arguments are evaluated once.
+*/
+#define DISPATCHER_LOG_DEFER(level, tag, ...)                                                 \
+    dispatcher_LogDefer((uint8_t)(level), (tag), DISPATCHER_LOG_FORMAT(__VA_ARGS__),          \
+                        DISPATCHER_LOG_ARGV((uintptr_t)0 DISPATCHER_LOG_CAST(__VA_ARGS__)) + 1, \
+                        (uint8_t)DISPATCHER_LOG_NARGS(__VA_ARGS__))
 
-#if (DISPATCHER_LOG_STATE == DISPATCHER_LOG_ENABLE)
+#define DISPATCHER_LOG_WRITE_INFO(tag, format, ...) \
+    DISPATCHER_LOG_DEFER(DISPATCHER_LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_WRITE_ERROR(tag, format, ...) \
+    DISPATCHER_LOG_DEFER(DISPATCHER_LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_WRITE_DEBUG(tag, format, ...) \
+    DISPATCHER_LOG_DEFER(DISPATCHER_LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#else
+#define DISPATCHER_LOG_WRITE_INFO(tag, format, ...) DISPATCHER_PORT_LOG_INFO(tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_WRITE_ERROR(tag, format, ...) DISPATCHER_PORT_LOG_ERROR(tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_WRITE_DEBUG(tag, format, ...) DISPATCHER_PORT_LOG_DEBUG(tag, format, ##__VA_ARGS__)
+#endif
+
+#if (DISPATCHER_LOG_STATE >= DISPATCHER_LOG_LEVEL_INFO)
 
 /*! \def    DISPATCHER_LOG_INFO(tag, format, ...)
     \brief  Logs in info level.
 */
-#define DISPATCHER_LOG_INFO(tag, format, ...) ESP_LOGI(tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_INFO(tag, format, ...) DISPATCHER_LOG_WRITE_INFO(tag, format, ##__VA_ARGS__)
+#else
+#define DISPATCHER_LOG_INFO(tag, format, ...)
+#endif
+
+#if (DISPATCHER_LOG_STATE >= DISPATCHER_LOG_LEVEL_ERROR)
 
 /*! \def    DISPATCHER_LOG_ERROR(tag, format, ...)
     \brief  Logs in error level.
 */
-#define DISPATCHER_LOG_ERROR(tag, format, ...) ESP_LOGE(tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_ERROR(tag, format, ...) DISPATCHER_LOG_WRITE_ERROR(tag, format, ##__VA_ARGS__)
+#else
+#define DISPATCHER_LOG_ERROR(tag, format, ...)
+#endif
+
+#if (DISPATCHER_LOG_STATE >= DISPATCHER_LOG_LEVEL_DEBUG)
 
 /*! \def    DISPATCHER_LOG_DEBUG(tag, format, ...)
     \brief  Logs in debug level.
 */
-#define DISPATCHER_LOG_DEBUG(tag, format, ...) ESP_LOGD(tag, format, ##__VA_ARGS__)
+#define DISPATCHER_LOG_DEBUG(tag, format, ...) DISPATCHER_LOG_WRITE_DEBUG(tag, format, ##__VA_ARGS__)
 #else
-#define DISPATCHER_LOG_INFO(tag, format, ...)
-#define DISPATCHER_LOG_ERROR(tag, format, ...)
 #define DISPATCHER_LOG_DEBUG(tag, format, ...)
 #endif
 
 /*-------------------------------------------------------*/
 
+/*! \def    DISPATCHER_POST_TIMEOUT_MS
+    \brief  Max time in milliseconds a post waits for free queue space.
+*/
+#if !defined(DISPATCHER_POST_TIMEOUT_MS)
+#define DISPATCHER_POST_TIMEOUT_MS (100)
+#endif
+
+/*! \def    DISPATCHER_WAIT_FOREVER
+    \brief  Timeout in milliseconds waiting without limit.
+*/
+#define DISPATCHER_WAIT_FOREVER (UINT32_MAX)
+
+/*! \def    DISPATCHER_POOL_MAX
+    \brief  Max number of event pools (size classes) dispatcher_EventNew
+            allocates from.
+*/
+#if !defined(DISPATCHER_POOL_MAX)
+#define DISPATCHER_POOL_MAX (3)
+#endif
+
+/*! \def    DISPATCHER_LANE_MAX
+    \brief  Max number of priority lanes of a dispatcher including its own
+            queue, one bit of the lane ready bitmap each.
+*/
+#define DISPATCHER_LANE_MAX (32)
+
+/*! \def    DISPATCHER_HSM_MAX_DEPTH
+    \brief  Max nesting depth of hierarchical states (a top level state
+            has depth 1), bounds the chains kept by a transition path.
+*/
+#if !defined(DISPATCHER_HSM_MAX_DEPTH)
+#define DISPATCHER_HSM_MAX_DEPTH (6)
+#endif
+
+/*! \def    DISPATCHER_STATS_ENABLE
+    \brief  Runtime statistics, 1 keeps posted / dispatched / dropped
+            counters, the queue high water mark, transitions and per signal
+            handler time in every dispatcher, 0 compiles them out.
+*/
+#if !defined(DISPATCHER_STATS_ENABLE)
+#define DISPATCHER_STATS_ENABLE (0)
+#endif
+
+/*! \def    DISPATCHER_TRACE_ENABLE
+    \brief  Binary event trace, 1 records posts, dequeues, handler calls,
+            ENTRY / EXIT and transitions into the ring given to
+            dispatcher_TraceInit, 0 compiles the records out.
+*/
+#if !defined(DISPATCHER_TRACE_ENABLE)
+#define DISPATCHER_TRACE_ENABLE (0)
+#endif
+
+/*! \def    DISPATCHER_RECORD_ENABLE
+    \brief  Event recording, 1 lets dispatcher_RecordStart stream every
+            event a dispatcher handles to a sink for a later replay, 0
+            compiles the recorder out. Replay is always available.
+*/
+#if !defined(DISPATCHER_RECORD_ENABLE)
+#define DISPATCHER_RECORD_ENABLE (0)
+#endif
+
+/*! \def    DISPATCHER_DEFER_STORAGE_SIZE(itemSize, count)
+    \brief  Size in bytes of a deferred event store holding count events
+            of itemSize bytes, every slot keeps the event length.
+*/
+#define DISPATCHER_DEFER_STORAGE_SIZE(itemSize, count) \
+    ((uint32_t)(count) * DISPATCHER_QUEUE_SLOT_SIZE(itemSize))
+
+/*! \def    DISPATCHER_FILTER_WORDS
+    \brief  Number of 32 bit words of a state signal filter, signals from
+            32 * DISPATCHER_FILTER_WORDS up are never filtered.
+*/
+#if !defined(DISPATCHER_FILTER_WORDS)
+#define DISPATCHER_FILTER_WORDS (2)
+#endif
+
+/*! \def    DISPATCHER_BUS_MAX_SUBSCRIBERS
+    \brief  Max number of dispatchers attached to a bus, one bit of the
+            per signal subscriber bitmap each.
+*/
+#define DISPATCHER_BUS_MAX_SUBSCRIBERS (32)
+
+/*! \def    DISPATCHER_KERNEL_MAX_DISPATCHERS
+    \brief  Max number of dispatchers hosted by a kernel, one bit of the
+            kernel ready bitmap each.
+*/
+#define DISPATCHER_KERNEL_MAX_DISPATCHERS (32)
+
+/*! \def    DISPATCHER_WORKER_POOL_MAX_DISPATCHERS
+    \brief  Max number of dispatchers scheduled by a worker pool, one bit
+            of the ready and busy bitmaps each.
+*/
+#define DISPATCHER_WORKER_POOL_MAX_DISPATCHERS (32)
+
+/*! \def    DISPATCHER_WORKER_MAX
+    \brief  Max number of workers of a worker pool.
+*/
+#define DISPATCHER_WORKER_MAX (16)
+
+/*! \def    DISPATCHER_WORKER_ANY
+    \brief  Home worker chosen by the worker pool.
+*/
+#define DISPATCHER_WORKER_ANY (0xFFu)
+
 /*-------------------------EVENTS-------------------------*/
 
 /*! \typedef    typedef uint16_t dispatcher_eventSignal_t
@@ -71,6 +271,12 @@ typedef enum
     DISPATCHER_SIGNAL_ENTRY = 1, /*!< Value of 1, representing ENTRY event signal. */
     DISPATCHER_SIGNAL_EXIT = 2,  /*!< Value of 2, representing EXIT event signal. */
     DISPATCHER_SIGNAL_USER = 3,  /*!< Value of 3, representing USER event signal. */
+    DISPATCHER_SIGNAL_VOID = 0xFFFE, /*!< Value of 0xFFFE, reserved for reserved slots committed
+                                          with an invalid signal, the event loop releases them
+                                          without dispatch. Posts of events by value with it
+                                          are rejected. */
+    DISPATCHER_SIGNAL_REF = 0xFFFF, /*!< Value of 0xFFFF, reserved for pool event references,
+                                         posts of events by value with it are rejected. */
 } dispatcher_privateSignals_t;
 
 /*! \struct  dispatcher_eventBase_t
@@ -98,6 +304,17 @@ typedef struct
     /* ... */
 } dispatcher_eventBase_t;
 
+/*! \struct  dispatcher_eventRef_t
+    \brief   Queue item of an event posted by reference with
+             dispatcher_PostRef, the signal is DISPATCHER_SIGNAL_REF and
+             the event loop hands pEvent to the state handler.
+*/
+typedef struct
+{
+    dispatcher_eventBase_t base; /*!< Element contains DISPATCHER_SIGNAL_REF. */
+    void *pEvent;                /*!< Element contains pool event. */
+} dispatcher_eventRef_t;
+
 /*-------------------------------------------------------*/
 
 /*! \enum   dispatcher_err_t
@@ -112,6 +329,10 @@ typedef enum
     DISPATCHER_ERR_QUEUE_FULL,      /*!< Value representing queue full error. */
     DISPATCHER_ERR_QUEUE_EMPTY,     /*!< Value representing queue empty error. */
     DISPATCHER_ERR_PROCESS_FAIL,    /*!< Value representing process fail error. */
+    DISPATCHER_ERR_NOT_SUPPORTED,   /*!< Value representing operation not supported by queue backend. */
+    DISPATCHER_ERR_POOL_EMPTY,      /*!< Value representing no free event pool block error. */
+    DISPATCHER_ERR_DEFER_FULL,      /*!< Value representing deferred event store full error. */
+    DISPATCHER_ERR_FILTERED,        /*!< Value representing event signal not accepted by the active state. */
     DISPATCHER_ERR_MAX,             /*!< Value representing num of errors. */
 } dispatcher_err_t;
 
@@ -124,7 +345,9 @@ typedef enum
     DISPATCHER_SM_STATUS_HANDLED = 1, /*!< Value 1 representing event handled status. */
     DISPATCHER_SM_STATUS_IGNORED = 2, /*!< Value 2 representing event ignored status. */
     DISPATCHER_SM_STATUS_TRANSITION = 3, /*!< Value 3 representing transition status. */
-    DISPATCHER_SM_STATUS_MAX = 4, /*!< Value 4 representing num of status. */
+    DISPATCHER_SM_STATUS_DEFERRED = 4, /*!< Value 4 representing event deferred status. */
+    DISPATCHER_SM_STATUS_SUPER = 5, /*!< Value 5 representing event passed to superstate status. */
+    DISPATCHER_SM_STATUS_MAX = 6, /*!< Value 6 representing num of status. */
 } dispatcher_smStatus_t;
 
 /*! \typedef    typedef dispatcher_tagBase dispatcher_base_t
@@ -153,6 +376,168 @@ typedef struct dispatcher_tagBase dispatcher_base_t;
 typedef uint8_t (*dispatcher_stateHandler_t)(dispatcher_base_t *const pDispatcher,
                                              dispatcher_eventBase_t const *const pEvent);
 
+/*! \enum   dispatcher_overflow_t
+    \brief  Enum represenst what a post does when the queue is full.
+*/
+typedef enum
+{
+    DISPATCHER_OVERFLOW_BLOCK = 0,       /*!< Value 0 representing wait for space up to the post timeout. */
+    DISPATCHER_OVERFLOW_FAIL = 1,        /*!< Value 1 representing fail at once. */
+    DISPATCHER_OVERFLOW_DROP_NEWEST = 2, /*!< Value 2 representing posted event dropped, post returns
+                                              DISPATCHER_ERR_QUEUE_FULL. */
+    DISPATCHER_OVERFLOW_DROP_OLDEST = 3, /*!< Value 3 representing oldest queued event dropped to make room. */
+    DISPATCHER_OVERFLOW_OVERWRITE = 4,   /*!< Value 4 representing every queued event dropped, posted one kept. */
+    DISPATCHER_OVERFLOW_MAX = 5,         /*!< Value representing num of policies. */
+} dispatcher_overflow_t;
+
+/*! \enum   dispatcher_coalescePolicy_t
+    \brief  Enum represenst how posts of one signal are coalesced while an
+            event of the signal is queued.
+*/
+typedef enum
+{
+    DISPATCHER_COALESCE_NONE = 0,   /*!< Value 0 representing every post queued. */
+    DISPATCHER_COALESCE_LATEST = 1, /*!< Value 1 representing only the newest event kept. */
+    DISPATCHER_COALESCE_MERGE = 2,  /*!< Value 2 representing newer events merged into the pending one. */
+    DISPATCHER_COALESCE_MAX = 3,    /*!< Value representing num of policies. */
+} dispatcher_coalescePolicy_t;
+
+/*! \typedef    typedef void (*dispatcher_mergeHandler_t)(dispatcher_eventBase_t *const pPending,
+                                                       dispatcher_eventBase_t const *const pEvent)
+    \brief      Merge handler of a DISPATCHER_COALESCE_MERGE signal, folds
+                pEvent into the older pPending event. Called by the posting
+                context (may be an ISR) and the event loop, must be short.
+*/
+typedef void (*dispatcher_mergeHandler_t)(dispatcher_eventBase_t *const pPending,
+                                          dispatcher_eventBase_t const *const pEvent);
+
+/*! \struct  dispatcher_coalesce_t
+    \brief   Coalescing state of one signal, an array of them indexed by
+             signal is given with the dispatcher configuration.
+*/
+typedef struct
+{
+    void *pending;                   /*!< Element contains newest or merged pool event waiting for the queued one. */
+    dispatcher_mergeHandler_t merge; /*!< Element contains merge handler of DISPATCHER_COALESCE_MERGE. */
+    uint8_t policy;                  /*!< Element contains dispatcher_coalescePolicy_t value. */
+    uint8_t queued;                  /*!< Element contains state of the queued event of the signal. */
+} dispatcher_coalesce_t;
+
+/*! \struct  dispatcher_tableRow_t
+    \brief   Reaction of a table driven state to one signal. action may be
+             NULL, target is NULL for an internal reaction.
+*/
+typedef struct
+{
+    dispatcher_stateHandler_t action; /*!< Element contains action, returns a status like a handler. */
+    dispatcher_stateHandler_t target; /*!< Element contains transition target taken when action
+                                           is NULL or returns DISPATCHER_SM_STATUS_HANDLED. */
+} dispatcher_tableRow_t;
+
+/*! \struct  dispatcher_table_t
+    \brief   Table driven state, a dense row array indexed by signal.
+             Generated by DISPATCHER_STATE_TABLE.
+*/
+typedef struct
+{
+    dispatcher_tableRow_t const *rows; /*!< Element contains one row per signal. */
+    uint16_t signalCount;               /*!< Element contains number of rows. */
+    dispatcher_stateHandler_t parent;   /*!< Element contains superstate, NULL for top level states. */
+    dispatcher_stateHandler_t state;    /*!< Element contains the state handler owning the table. */
+} dispatcher_table_t;
+
+/*! \struct  dispatcher_lane_t
+    \brief   Extra priority lane of a dispatcher, a queue of its own
+             with the backend and event size of the dispatcher queue.
+             itemCount and queueStorage are set by the user, queue by
+             dispatcher_InitWithConfig.
+*/
+typedef struct
+{
+    uint16_t itemCount;       /*!< Element contains max number of events the lane can store. */
+    uint8_t *queueStorage;    /*!< Element contains pointer to lane queue storage buffer. */
+    dispatcher_queue_t queue; /*!< Element contains lane queue. */
+} dispatcher_lane_t;
+
+/*! \struct  dispatcher_path_t
+    \brief   Cached transition of a hierarchical state machine, the states
+             to exit (innermost first) and to enter (outermost first) when
+             source takes a transition to target while active is the
+             current state.
+*/
+typedef struct
+{
+    dispatcher_stateHandler_t active; /*!< Element contains state active when the transition was taken. */
+    dispatcher_stateHandler_t source; /*!< Element contains state which took the transition. */
+    dispatcher_stateHandler_t target; /*!< Element contains transition target. */
+    dispatcher_stateHandler_t exits[DISPATCHER_HSM_MAX_DEPTH];   /*!< Element contains states to exit. */
+    dispatcher_stateHandler_t entries[DISPATCHER_HSM_MAX_DEPTH]; /*!< Element contains states to enter. */
+    uint8_t exitCount;  /*!< Element contains number of states to exit. */
+    uint8_t entryCount; /*!< Element contains number of states to enter. */
+} dispatcher_path_t;
+
+/*! \struct  dispatcher_filter_t
+    \brief   Signal filter of one state, posts of signals the state does
+             not accept are dropped by the posting context while the state
+             is active, before they take a queue slot. System signals are
+             always accepted. A learning filter starts accepting every
+             signal and stops accepting a signal the state returned
+             DISPATCHER_SM_STATUS_IGNORED for.
+    \example
+    \code{c}
+             static dispatcher_filter_t gFilters[2];
+
+             DISPATCHER_FILTER_INIT(&gFilters[0], LedOff, false);
+             dispatcher_FilterAccept(&gFilters[0], EVENT_SIGNAL_ON);
+             DISPATCHER_FILTER_INIT(&gFilters[1], LedOn, true);
+    \endcode
+*/
+typedef struct
+{
+    dispatcher_stateHandler_t state;          /*!< Element contains state, the innermost active one. */
+    uint32_t accept[DISPATCHER_FILTER_WORDS]; /*!< Element contains bit of every accepted signal. */
+    bool learn;                               /*!< Element contains true to drop signals the state ignored. */
+} dispatcher_filter_t;
+
+/*! \struct  dispatcher_defer_t
+    \brief   Deferred event store of a dispatcher, a ring of event slots
+             only used by the event loop context.
+*/
+typedef struct
+{
+    uint8_t *storage; /*!< Element contains slot buffer, DISPATCHER_DEFER_STORAGE_SIZE bytes. */
+    uint16_t stride;  /*!< Element contains distance between two slots. */
+    uint16_t count;   /*!< Element contains number of slots. */
+    uint16_t head;    /*!< Element contains oldest deferred event slot. */
+    uint16_t used;    /*!< Element contains number of deferred events. */
+    uint16_t recall;  /*!< Element contains number of deferred events to replay. */
+} dispatcher_defer_t;
+
+/*! \struct  dispatcher_stats_t
+    \brief   Runtime statistics of a dispatcher, see dispatcher_StatsGet.
+*/
+typedef struct
+{
+    uint32_t posted;      /*!< Element contains events accepted by posts, coalesced ones included. */
+    uint32_t dispatched;  /*!< Element contains events run by the event loop. */
+    uint32_t dropped;     /*!< Element contains events lost on a full queue. */
+    uint32_t highWater;   /*!< Element contains max items seen in the dispatcher queue (bytes with
+                               the variable ring), sampled when the event loop takes one. */
+    uint32_t transitions; /*!< Element contains state transitions. */
+} dispatcher_stats_t;
+
+/*! \struct  dispatcher_signalStats_t
+    \brief   Handler time of one signal in dispatcher_PortCycles units,
+             transitions it caused included.
+*/
+typedef struct
+{
+    uint32_t count; /*!< Element contains handled events. */
+    uint32_t min;   /*!< Element contains shortest handler time, UINT32_MAX before the first event. */
+    uint32_t max;   /*!< Element contains longest handler time. */
+    uint64_t sum;   /*!< Element contains total handler time. */
+} dispatcher_signalStats_t;
+
 /*! \struct  dispatcher_tagBase
     \brief   Dispatcher base structure.
              User defined diaptchers structures are used
@@ -179,10 +564,196 @@ struct dispatcher_tagBase
     dispatcher_stateHandler_t active; /*!< Element contains active state handler. */
     dispatcher_stateHandler_t next; /*!< Element contains next state handler. */
     uint8_t *eventStorage; /*!< Element contains pointer to a event storage buffer. */
-    QueueHandle_t queue; /*!< Element contains event queue handle. */
-    StaticQueue_t queueStorage; /*!< Element contains event queue stack. */
+    dispatcher_queue_t queue; /*!< Element contains event queue. */
+    dispatcher_waiter_t waiter; /*!< Element contains event loop waiter (ring queues and lanes). */
+    dispatcher_lane_t *lanes; /*!< Element contains extra priority lanes, lanes[i] has priority i + 1. */
+    uint8_t laneCount; /*!< Element contains number of extra priority lanes. */
+    dispatcher_defer_t defer; /*!< Element contains deferred events. */
+    dispatcher_path_t *paths; /*!< Element contains transition path cache, NULL for flat states. */
+    uint8_t pathCount; /*!< Element contains number of cached paths. */
+    uint8_t pathNext; /*!< Element contains next cache entry to replace. */
+    dispatcher_table_t const *table; /*!< Element contains table of the active state, if it is table driven. */
+    dispatcher_wheel_t *wheel; /*!< Element contains timing wheel of the time events, NULL without time events. */
+    dispatcher_coalesce_t *coalesce; /*!< Element contains coalescing state by signal, NULL without coalescing. */
+    uint16_t coalesceCount; /*!< Element contains number of signals in coalesce. */
+    uint8_t overflow; /*!< Element contains dispatcher_overflow_t of posts on a full queue. */
+    dispatcher_portTick_t postTimeout; /*!< Element contains ticks a DISPATCHER_OVERFLOW_BLOCK post waits. */
+    uint32_t drops[DISPATCHER_OVERFLOW_MAX]; /*!< Element contains events lost by posts of every policy. */
+    dispatcher_filter_t *filters; /*!< Element contains signal filters by state, NULL without filters. */
+    uint8_t filterCount; /*!< Element contains number of filters. */
+    dispatcher_filter_t *filter; /*!< Element contains filter of the active state, NULL accepts every signal. */
+    uint32_t filtered; /*!< Element contains posts dropped by the filter of the active state. */
+#if (DISPATCHER_STATS_ENABLE)
+    dispatcher_stats_t stats; /*!< Element contains runtime statistics, dropped is summed from drops. */
+    dispatcher_signalStats_t *signalStats; /*!< Element contains handler time by signal, NULL without it. */
+    uint16_t signalStatsCount; /*!< Element contains number of signals in signalStats. */
+#endif
+#if (DISPATCHER_RECORD_ENABLE)
+    dispatcher_recordWrite_t record; /*!< Element contains recording sink, NULL while not recording. */
+    void *recordArg; /*!< Element contains argument handed to record. */
+    uint64_t recordTime; /*!< Element contains time of the last recorded event in microseconds. */
+#endif
 };
 
+/*! \struct  dispatcher_timeEvent_t
+    \brief   One-shot or periodic time event owned by a dispatcher. On
+             expiry the owner event loop hands the time event itself to the
+             state handlers, no queue slot or copy is used.
+    \example
+    \code{c}
+             static dispatcher_timeEvent_t gBlink;
+
+             dispatcher_TimeEventInit(&gBlink, (dispatcher_base_t *)&gLed, EVENT_SIGNAL_BLINK);
+             DISPATCHER_TIME_EVENT_ARM(&gBlink, 500, 500);
+    \endcode
+*/
+typedef struct
+{
+    dispatcher_eventBase_t base; /*!< Element contains event handed to the state handlers. */
+    dispatcher_wheelNode_t node; /*!< Element contains timing wheel link. */
+    dispatcher_base_t *pDispatcher; /*!< Element contains owner dispatcher. */
+    dispatcher_portTick_t period; /*!< Element contains period in ticks, 0 for one-shot. */
+} dispatcher_timeEvent_t;
+
+/*! \struct  dispatcher_bus_t
+    \brief   Publish / subscribe bus. Every attached dispatcher owns a
+             unique priority, every signal a bitmap of subscribed
+             priorities, so publishing is one table lookup.
+    \example
+    \code{c}
+             static dispatcher_bus_t gBus;
+             static uint32_t gSubscriptions[EVENT_SIGNAL_MAX];
+
+             dispatcher_BusInit(&gBus, gSubscriptions, EVENT_SIGNAL_MAX);
+    \endcode
+*/
+typedef struct
+{
+    dispatcher_base_t *subscribers[DISPATCHER_BUS_MAX_SUBSCRIBERS]; /*!< Element contains dispatchers by priority. */
+    uint32_t *subscriptions; /*!< Element contains subscriber bitmap of every signal. */
+    uint16_t signalCount;    /*!< Element contains number of signals in subscriptions. */
+} dispatcher_bus_t;
+
+/*! \struct  dispatcher_kernel_t
+    \brief   Cooperative kernel running several dispatchers on one task.
+             A post to an attached dispatcher sets its bit in the kernel
+             ready bitmap, the kernel runs events of the highest priority
+             ready dispatcher to completion and sleeps on its waiter when
+             none is ready.
+    \example
+    \code{c}
+             static dispatcher_kernel_t gKernel;
+
+             dispatcher_KernelInit(&gKernel);
+             dispatcher_KernelAttach(&gKernel, (dispatcher_base_t *)&gSensor, 1);
+             dispatcher_KernelAttach(&gKernel, (dispatcher_base_t *)&gControl, 2);
+             while (1)
+             {
+                 DISPATCHER_KERNEL_LOOP(&gKernel, 16, NULL);
+             }
+    \endcode
+*/
+typedef struct
+{
+    dispatcher_base_t *dispatchers[DISPATCHER_KERNEL_MAX_DISPATCHERS]; /*!< Element contains dispatchers by priority. */
+    dispatcher_waiter_t waiter; /*!< Element contains kernel waiter, bit n of its ready bitmap for dispatchers[n]. */
+    uint32_t timed; /*!< Element contains bitmap of dispatchers with a timing wheel. */
+} dispatcher_kernel_t;
+
+/*! \struct  dispatcher_worker_t
+    \brief   Worker of a worker pool, usually one task per core. Every
+             dispatcher has a home worker, a post wakes the home worker.
+*/
+typedef struct
+{
+    dispatcher_waiter_t waiter; /*!< Element contains worker waiter, ready bitmap of the dispatchers homed here. */
+    uint32_t pinned;            /*!< Element contains dispatchers homed here other workers may not steal. */
+    uint32_t steals;            /*!< Element contains events this worker took from dispatchers homed elsewhere. */
+} dispatcher_worker_t;
+
+/*! \struct  dispatcher_workerPool_t
+    \brief   Worker pool scheduling dispatchers on several workers. A
+             dispatcher is only run by the worker holding its busy bit,
+             idle workers steal ready dispatchers which are not pinned.
+    \example
+    \code{c}
+             static dispatcher_worker_t gWorkers[2];
+             static dispatcher_workerPool_t gWorkerPool;
+
+             dispatcher_WorkerPoolInit(&gWorkerPool, gWorkers, 2);
+             dispatcher_WorkerPoolAttach(&gWorkerPool, (dispatcher_base_t *)&gRadio, 3, 0, true);
+             dispatcher_WorkerPoolAttach(&gWorkerPool, (dispatcher_base_t *)&gLogger, 1, DISPATCHER_WORKER_ANY, false);
+    \endcode
+*/
+typedef struct
+{
+    dispatcher_base_t *dispatchers[DISPATCHER_WORKER_POOL_MAX_DISPATCHERS]; /*!< Element contains dispatchers by priority. */
+    uint8_t home[DISPATCHER_WORKER_POOL_MAX_DISPATCHERS]; /*!< Element contains home worker of every dispatcher. */
+    dispatcher_worker_t *workers; /*!< Element contains workers. */
+    uint8_t workerCount;          /*!< Element contains number of workers. */
+    uint32_t busy;                /*!< Element contains bitmap of dispatchers a worker is running. */
+} dispatcher_workerPool_t;
+
+/*! \struct  dispatcher_config_t
+    \brief   Dispatcher configuration used by dispatcher_InitWithConfig.
+    \example
+    \code{c}
+             dispatcher_config_t config = {
+                .itemSize = sizeof(appEvent_t),
+                .itemCount = 16,
+                .queueStorage = pgQueueStorage,
+                .eventStorage = pgEventStorage,
+                .defaultHandler = StateHandler1,
+                .queueType = DISPATCHER_QUEUE_TYPE_SPSC,
+             };
+    \endcode
+*/
+typedef struct
+{
+    uint16_t itemSize; /*!< Element contains size of a event structure in bytes. */
+    uint16_t itemCount; /*!< Element contains max number of events queue can store. */
+    uint8_t *queueStorage; /*!< Element contains pointer to queue storage buffer. */
+    uint8_t *eventStorage; /*!< Element contains pointer to event storage buffer,
+                                may be NULL with ring backends, handlers then get
+                                the event straight from the queue slot. */
+    dispatcher_stateHandler_t defaultHandler; /*!< Element contains default state handler. */
+    dispatcher_queueType_t queueType; /*!< Element contains queue backend,
+                                           ring backends require a DISPATCHER_QUEUE_STORAGE_SIZE
+                                           queueStorage, spsc / mpsc rings a power of two
+                                           itemCount, DISPATCHER_QUEUE_TYPE_SPSC exactly one
+                                           posting context. */
+    dispatcher_lane_t *lanes; /*!< Element contains extra priority lanes, may be NULL,
+                                   lanes[i] is served before lanes[i - 1] and the
+                                   dispatcher queue (priority 0). */
+    uint8_t laneCount; /*!< Element contains number of extra priority lanes,
+                            below DISPATCHER_LANE_MAX. */
+    uint8_t *deferStorage; /*!< Element contains deferred event store buffer, may be NULL,
+                                DISPATCHER_DEFER_STORAGE_SIZE bytes aligned to
+                                DISPATCHER_QUEUE_ALIGN. */
+    uint16_t deferCount; /*!< Element contains max number of deferred events. */
+    dispatcher_path_t *paths; /*!< Element contains transition path cache, may be NULL,
+                                   required for hierarchical states. */
+    uint8_t pathCount; /*!< Element contains number of path cache entries. */
+    dispatcher_wheel_t *wheel; /*!< Element contains timing wheel, may be NULL,
+                                    required for time events. */
+    dispatcher_coalesce_t *coalesce; /*!< Element contains coalescing state of every signal,
+                                          may be NULL, required for dispatcher_Coalesce. */
+    uint16_t coalesceCount; /*!< Element contains number of signals in coalesce. */
+    dispatcher_overflow_t overflow; /*!< Element contains policy of posts on a full queue,
+                                         DISPATCHER_OVERFLOW_BLOCK by default. Dropping queued
+                                         events requires the port queue or mpsc ring backend,
+                                         other posts than dispatcher_Post / dispatcher_PostSized
+                                         only wait with it and fail at once otherwise. */
+    uint32_t postTimeoutMs; /*!< Element contains max wait of a blocking post, 0 for
+                                 DISPATCHER_POST_TIMEOUT_MS, DISPATCHER_WAIT_FOREVER. */
+    dispatcher_signalStats_t *signalStats; /*!< Element contains handler time of every signal, may be
+                                                NULL, ignored without DISPATCHER_STATS_ENABLE. */
+    uint16_t signalStatsCount; /*!< Element contains number of signals in signalStats. */
+    dispatcher_filter_t *filters; /*!< Element contains signal filters of states, may be NULL,
+                                       states without one accept every signal. */
+    uint8_t filterCount; /*!< Element contains number of filters. */
+} dispatcher_config_t;
+
 /*! \def   DISPATCHER_SET_EVENT(pEvent, signal)
     \brief  Set event signal to an event.
     \param pEvent Pointer to event structure.
@@ -203,6 +774,98 @@ struct dispatcher_tagBase
 */
 #define DISPATCHER_TRANSITION(pDispatcher, handler) ((((dispatcher_base_t *)(pDispatcher))->next = (handler)), DISPATCHER_SM_STATUS_TRANSITION)
 
+/*! \def   DISPATCHER_SUPER(pDispatcher, handler)
+    \brief  Pass the event to the superstate, returned by a handler for
+            every signal it does not handle (including DISPATCHER_SIGNAL_NONE,
+            used to ask for the superstate). Top level states return
+            DISPATCHER_SM_STATUS_IGNORED instead.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param handler superstate handler function.
+*/
+#define DISPATCHER_SUPER(pDispatcher, handler) ((((dispatcher_base_t *)(pDispatcher))->next = (handler)), DISPATCHER_SM_STATUS_SUPER)
+
+/*! \def   DISPATCHER_ON(signal, action, target)
+    \brief  Row of a DISPATCHER_STATE_TABLE.
+    \param signal event signal.
+    \param action state handler like function or NULL.
+    \param target transition target state or NULL.
+*/
+#define DISPATCHER_ON(signal, action, target) \
+    [(signal)] = {(dispatcher_stateHandler_t)(action), (dispatcher_stateHandler_t)(target)}
+
+/*! \def   DISPATCHER_STATE_DECLARE(name)
+    \brief  Declare a table driven state, needed when it is a transition
+            target before its DISPATCHER_STATE_TABLE.
+    \param name state handler name.
+*/
+#define DISPATCHER_STATE_DECLARE(name) \
+    uint8_t name(dispatcher_base_t *const pDispatcher, dispatcher_eventBase_t const *const pEvent)
+
+/*! \def   DISPATCHER_STATE_TABLE(name, superState, rowCount, ...)
+    \brief  Define a table driven state handler from a list of DISPATCHER_ON
+            rows. Signals without a row go to the superstate or are ignored,
+            every row is filled so a lookup never branches on a missing
+            row.
+            The handler is used like any other state handler, the event
+            loop runs the table of the active state without calling it.
+    \param name state handler name.
+    \param superState superstate handler or NULL.
+    \param rowCount number of signals, every row signal must be lower.
+    \example
+    \code{c}
+             DISPATCHER_STATE_DECLARE(StateRunning);
+             DISPATCHER_STATE_TABLE(StateIdle, NULL, EVENT_SIGNAL_MAX,
+                                    DISPATCHER_ON(DISPATCHER_SIGNAL_ENTRY, IdleEntry, NULL),
+                                    DISPATCHER_ON(EVENT_SIGNAL_START, StartMotor, StateRunning));
+    \endcode
+*/
+#define DISPATCHER_STATE_TABLE(name, superState, rowCount, ...)                                     \
+    DISPATCHER_STATE_DECLARE(name);                                                                  \
+    static dispatcher_table_t const name##Table;                                                     \
+    DISPATCHER_STATE_DECLARE(name)                                                                   \
+    {                                                                                                \
+        return dispatcher_TableDispatch(pDispatcher, pEvent, &name##Table);                          \
+    }                                                                                                \
+    static uint8_t name##Unhandled(dispatcher_base_t *const pDispatcher,                             \
+                                   dispatcher_eventBase_t const *const pEvent)                       \
+    {                                                                                                \
+        (void)pEvent;                                                                                \
+        if ((dispatcher_stateHandler_t)(superState) == NULL)                                         \
+        {                                                                                            \
+            return DISPATCHER_SM_STATUS_IGNORED;                                                     \
+        }                                                                                            \
+        return DISPATCHER_SUPER(pDispatcher, (dispatcher_stateHandler_t)(superState));               \
+    }                                                                                                \
+    _Pragma("GCC diagnostic push")                                                                   \
+    _Pragma("GCC diagnostic ignored \"-Woverride-init\"")                                            \
+    static dispatcher_tableRow_t const name##Rows[(rowCount)] = {                                    \
+        [0 ...(rowCount) - 1] = {name##Unhandled, NULL},                                             \
+        __VA_ARGS__};                                                                                \
+    _Pragma("GCC diagnostic pop")                                                                    \
+    static dispatcher_table_t const name##Table = {                                                  \
+        .rows = name##Rows,                                                                          \
+        .signalCount = (uint16_t)(rowCount),                                                         \
+        .parent = (dispatcher_stateHandler_t)(superState),                                           \
+        .state = name,                                                                               \
+    }
+
+/*! \def   DISPATCHER_DEFER(pDispatcher)
+    \brief  Keep the event in the deferred event store until a state
+            recalls it, returned by a handler instead of a status.
+    \param pDispatcher Pointer to dispatcher structure.
+*/
+#define DISPATCHER_DEFER(pDispatcher) ((void)(pDispatcher), DISPATCHER_SM_STATUS_DEFERRED)
+
+/*! \def   DISPATCHER_RECALL(pDispatcher)
+    \brief  Replay all deferred events before the next queued event.
+    \param pDispatcher Pointer to dispatcher structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should only be called from state handlers.
+*/
+#define DISPATCHER_RECALL(pDispatcher) \
+    dispatcher_Recall((dispatcher_base_t *)(pDispatcher))
+
 /*! \def   DISPATCHER_INITIALIZE(pDispatcher, eventSize
            , eventCount, pQueueStorage, pEventStorage, pHandler) 
     \brief  Initialize dispatcher. 
@@ -244,6 +907,32 @@ struct dispatcher_tagBase
 #define DISPATCHER_EVENT_LOOP(pDispatcher) \
     dispatcher_EventLoop((dispatcher_base_t *)(pDispatcher))
 
+/*! \def   DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, maxEvents, budgetMs, pProcessed)
+    \brief  Dispatcher event loop, drains up to maxEvents queued events per call.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param maxEvents max number of events handled in one call.
+    \param budgetMs stop once this many milliseconds passed, 0 disables.
+    \param pProcessed Pointer to number of handled events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be called in continious loop.
+*/
+#define DISPATCHER_EVENT_LOOP_BATCH(pDispatcher, maxEvents, budgetMs, pProcessed) \
+    dispatcher_EventLoopBatch((dispatcher_base_t *)(pDispatcher),               \
+                              (uint16_t)(maxEvents),                            \
+                              (uint32_t)(budgetMs),                             \
+                              (uint16_t *)(pProcessed))
+
+/*! \def   DISPATCHER_EVENT_LOOP_TIMEOUT(pDispatcher, timeoutMs)
+    \brief  Dispatcher event loop waiting at most timeoutMs for an event.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param timeoutMs max wait in milliseconds, 0 never blocks.
+    \return uint8_t DISPATCHER_ERR_QUEUE_EMPTY if no event arrived in time,
+            any other values except DISPATCHER_ERR_CLEAR represents failour.
+*/
+#define DISPATCHER_EVENT_LOOP_TIMEOUT(pDispatcher, timeoutMs) \
+    dispatcher_EventLoopTimeout((dispatcher_base_t *)(pDispatcher), (uint32_t)(timeoutMs))
+
 /*! \def   DISPATCHER_POST_EVENT(pDispatcher, pEvent)
     \brief  Post event to dispatcher. 
     \param pDispatcher Pointer to dispatcher structure.
@@ -259,7 +948,8 @@ struct dispatcher_tagBase
     \brief Post event from ISR to dispatcher. 
     \param pDispatcher Pointer to dispatcher structure.
     \param pEvent Pointer to event structure.
-    \param flags Interrupt flags.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
     \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
             failour.
 */
@@ -268,78 +958,1443 @@ struct dispatcher_tagBase
                            (dispatcher_eventBase_t *)(pEvent),     \
                            (int)(flags))
 
+/*! \def   DISPATCHER_POST_EVENT_OVERFLOW(pDispatcher, pEvent, overflow, timeoutMs)
+    \brief  Post event to dispatcher with its own full queue policy.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param overflow dispatcher_overflow_t value.
+    \param timeoutMs max wait of DISPATCHER_OVERFLOW_BLOCK in milliseconds.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR.
+*/
+#define DISPATCHER_POST_EVENT_OVERFLOW(pDispatcher, pEvent, overflow, timeoutMs) \
+    dispatcher_PostOverflow((dispatcher_base_t *)(pDispatcher),                  \
+                            (dispatcher_eventBase_t *)(pEvent),                  \
+                            (dispatcher_overflow_t)(overflow),                   \
+                            (uint32_t)(timeoutMs))
 
-/*! 
-    \fn   uint8_t dispatcher_Init(dispatcher_base_t *const pDispatcher,
-                        uint16_t itemSize,
-                        uint16_t itemCount,
-                        uint8_t *queueStorage,
-                        uint8_t *eventStorage,
-                        dispatcher_stateHandler_t defaultHandler).
-
-    \brief  Initialize dispatcher. 
+/*! \def   DISPATCHER_POST_EVENT_OVERFLOW_FROM_ISR(pDispatcher, pEvent, overflow, flags)
+    \brief  Post event from ISR to dispatcher with its own full queue policy,
+            DISPATCHER_OVERFLOW_BLOCK does not wait.
     \param pDispatcher Pointer to dispatcher structure.
-    \param itemSize size of a event structure in bytes.
-    \param itemCount max number of events queue can store.
-    \param queueStorage Pointer to queue storage buffer.
-    \param eventStorage Pointer to event storage buffer.
-    \param defaultHandler default state handler function.
+    \param pEvent Pointer to event structure.
+    \param overflow dispatcher_overflow_t value.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
     \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
             failour.
 */
-uint8_t dispatcher_Init(dispatcher_base_t *const pDispatcher,
-                        uint16_t itemSize,
-                        uint16_t itemCount,
-                        uint8_t *queueStorage,
-                        uint8_t *eventStorage,
-                        dispatcher_stateHandler_t defaultHandler);
+#define DISPATCHER_POST_EVENT_OVERFLOW_FROM_ISR(pDispatcher, pEvent, overflow, flags) \
+    dispatcher_PostOverflowFromIsr((dispatcher_base_t *)(pDispatcher),                \
+                                   (dispatcher_eventBase_t *)(pEvent),                \
+                                   (dispatcher_overflow_t)(overflow),                 \
+                                   (int)(flags))
 
-/*! \fn   uint8_t dispatcher_Start(dispatcher_base_t *const pDispatcher,
-                                    bool userSignal).
-    \brief  Start dispatcher. 
+/*! \def   DISPATCHER_STATS_GET(pDispatcher, pStats)
+    \brief  Snapshot of the dispatcher runtime statistics.
     \param pDispatcher Pointer to dispatcher structure.
-    \param userSignal any value except 0 post DISPATCHER_SIGNAL_USER 
-                      after DISPATCHER_SIGNAL_ENTRY.
+    \param pStats Pointer to dispatcher_stats_t structure.
     \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
             failour.
 */
-uint8_t dispatcher_Start(dispatcher_base_t *const pDispatcher,
-                         bool userSignal);
+#define DISPATCHER_STATS_GET(pDispatcher, pStats) \
+    dispatcher_StatsGet((dispatcher_base_t *)(pDispatcher), (dispatcher_stats_t *)(pStats))
 
-/*! \fn   uint8_t dispatcher_EventLoop(dispatcher_base_t *const pDispatcher).
-    \brief  Dispatcher event loop. 
+/*! \def   DISPATCHER_STATS_SIGNAL(pDispatcher, signal, pStats)
+    \brief  Snapshot of the handler time of a signal.
     \param pDispatcher Pointer to dispatcher structure.
+    \param signal event signal value.
+    \param pStats Pointer to dispatcher_signalStats_t structure.
     \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
             failour.
-    \warning Should be called in continious loop.
 */
-uint8_t dispatcher_EventLoop(dispatcher_base_t *const pDispatcher);
+#define DISPATCHER_STATS_SIGNAL(pDispatcher, signal, pStats)      \
+    dispatcher_StatsSignal((dispatcher_base_t *)(pDispatcher),    \
+                           (dispatcher_eventSignal_t)(signal),    \
+                           (dispatcher_signalStats_t *)(pStats))
 
+/*! \def   DISPATCHER_POST_EVENT_PRIORITY(pDispatcher, pEvent, priority)
+    \brief  Post event to a priority lane of dispatcher.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param priority lane, 0 is the dispatcher queue.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR.
+*/
+#define DISPATCHER_POST_EVENT_PRIORITY(pDispatcher, pEvent, priority) \
+    dispatcher_PostPriority((dispatcher_base_t *)(pDispatcher),       \
+                            (dispatcher_eventBase_t *)(pEvent),       \
+                            (uint8_t)(priority))
 
-/*! \fn   dispatcher_Post(dispatcher_base_t *const pDispatcher,
-                        dispatcher_eventBase_t const *const pEvent).
-    \brief  Post event to dispatcher. 
+/*! \def   DISPATCHER_POST_EVENT_PRIORITY_FROM_ISR(pDispatcher, pEvent, priority, flags)
+    \brief  Post event from ISR to a priority lane of dispatcher.
     \param pDispatcher Pointer to dispatcher structure.
     \param pEvent Pointer to event structure.
+    \param priority lane, 0 is the dispatcher queue.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
     \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
             failour.
-    \warning Should not be called in ISR or any latency critial opetaion.
 */
-uint8_t dispatcher_Post(dispatcher_base_t *const pDispatcher,
-                        dispatcher_eventBase_t const *const pEvent);
+#define DISPATCHER_POST_EVENT_PRIORITY_FROM_ISR(pDispatcher, pEvent, priority, flags) \
+    dispatcher_PostPriorityFromIsr((dispatcher_base_t *)(pDispatcher),                \
+                                   (dispatcher_eventBase_t *)(pEvent),                \
+                                   (uint8_t)(priority),                               \
+                                   (int)(flags))
 
-/*! \fn   uint8_t dispatcher_PostFromIsr(dispatcher_base_t *const pDispatcher,
-                               dispatcher_eventBase_t const *const pEvent,
-                               int flags)
-    \brief Post event from ISR to dispatcher. 
+/*! \def   DISPATCHER_POST_EVENT_SIZED(pDispatcher, pEvent, size)
+    \brief  Post the first size bytes of an event to dispatcher.
     \param pDispatcher Pointer to dispatcher structure.
     \param pEvent Pointer to event structure.
-    \param flags Interrupt flags.
+    \param size number of valid bytes in the event.
     \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
             failour.
+    \warning Should not be called in ISR or any latency critial opetaion .
 */
-uint8_t dispatcher_PostFromIsr(dispatcher_base_t *const pDispatcher,
-                               dispatcher_eventBase_t const *const pEvent,
-                               int flags);
+#define DISPATCHER_POST_EVENT_SIZED(pDispatcher, pEvent, size)          \
+    dispatcher_PostSized((dispatcher_base_t *)(pDispatcher),             \
+                         (dispatcher_eventBase_t *)(pEvent),             \
+                         (uint16_t)(size))
+
+/*! \def   DISPATCHER_POST_EVENT_SIZED_FROM_ISR(pDispatcher, pEvent, size, flags)
+    \brief Post the first size bytes of an event from ISR to dispatcher.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes in the event.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_POST_EVENT_SIZED_FROM_ISR(pDispatcher, pEvent, size, flags) \
+    dispatcher_PostSizedFromIsr((dispatcher_base_t *)(pDispatcher),            \
+                                (dispatcher_eventBase_t *)(pEvent),            \
+                                (uint16_t)(size),                              \
+                                (int)(flags))
+
+/*! \def   DISPATCHER_POST_BATCH(pDispatcher, pEvents, count, pAccepted)
+    \brief  Post an array of events to dispatcher in one call.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvents Pointer to array of event structures.
+    \param count number of events in the array.
+    \param pAccepted Pointer to number of posted events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR.
+*/
+#define DISPATCHER_POST_BATCH(pDispatcher, pEvents, count, pAccepted) \
+    dispatcher_PostBatch((dispatcher_base_t *)(pDispatcher),          \
+                         (void const *)(pEvents),                     \
+                         (uint16_t)(count),                           \
+                         (uint16_t *)(pAccepted))
+
+/*! \def   DISPATCHER_POST_BATCH_FROM_ISR(pDispatcher, pEvents, count, pAccepted, flags)
+    \brief  Post an array of events from ISR to dispatcher in one call.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvents Pointer to array of event structures.
+    \param count number of events in the array.
+    \param pAccepted Pointer to number of posted events, may be NULL.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_POST_BATCH_FROM_ISR(pDispatcher, pEvents, count, pAccepted, flags) \
+    dispatcher_PostBatchFromIsr((dispatcher_base_t *)(pDispatcher),                   \
+                                (void const *)(pEvents),                              \
+                                (uint16_t)(count),                                    \
+                                (uint16_t *)(pAccepted),                              \
+                                (int)(flags))
+
+/*! \def   DISPATCHER_POST_RESERVE(pDispatcher, ppEvent)
+    \brief  Reserve a queue slot to build an event in place.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param ppEvent Pointer to a event pointer, set to the reserved slot.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_POST_RESERVE(pDispatcher, ppEvent) \
+    dispatcher_PostReserve((dispatcher_base_t *)(pDispatcher), (void **)(ppEvent))
+
+/*! \def   DISPATCHER_POST_COMMIT(pDispatcher, pEvent)
+    \brief  Post an event reserved with DISPATCHER_POST_RESERVE.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to reserved event.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_POST_COMMIT(pDispatcher, pEvent) \
+    dispatcher_PostCommit((dispatcher_base_t *)(pDispatcher), (void *)(pEvent))
+
+/*! \def   DISPATCHER_EVENT_POOL_INIT(pPool, blockSize, blockCount, pStorage)
+    \brief  Initialize an event pool and add it to the pool size classes.
+    \param pPool Pointer to pool structure.
+    \param blockSize max event size of the pool in bytes.
+    \param blockCount number of events in the pool.
+    \param pStorage Pointer to pool storage buffer.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_EVENT_POOL_INIT(pPool, blockSize, blockCount, pStorage) \
+    dispatcher_EventPoolInit((dispatcher_pool_t *)(pPool),                 \
+                             (uint16_t)(blockSize),                        \
+                             (uint16_t)(blockCount),                       \
+                             (uint8_t *)(pStorage))
+
+/*! \def   DISPATCHER_EVENT_NEW(size, ppEvent)
+    \brief  Allocate an event from the smallest pool it fits in.
+    \param size event size in bytes.
+    \param ppEvent Pointer to a event pointer, set to the new event.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_EVENT_NEW(size, ppEvent) \
+    dispatcher_EventNew((uint16_t)(size), (void **)(ppEvent))
+
+/*! \def   DISPATCHER_EVENT_RELEASE(pEvent)
+    \brief  Drop the reference returned by DISPATCHER_EVENT_NEW.
+    \param pEvent Pointer to pool event.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_EVENT_RELEASE(pEvent) \
+    dispatcher_EventRelease((void *)(pEvent))
+
+/*! \def   DISPATCHER_POST_REF(pDispatcher, pEvent)
+    \brief  Post a pool event to dispatcher by reference.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to pool event.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR.
+*/
+#define DISPATCHER_POST_REF(pDispatcher, pEvent) \
+    dispatcher_PostRef((dispatcher_base_t *)(pDispatcher), (void *)(pEvent))
+
+/*! \def   DISPATCHER_POST_REF_FROM_ISR(pDispatcher, pEvent, flags)
+    \brief  Post a pool event from ISR to dispatcher by reference.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to pool event.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_POST_REF_FROM_ISR(pDispatcher, pEvent, flags)  \
+    dispatcher_PostRefFromIsr((dispatcher_base_t *)(pDispatcher), \
+                              (void *)(pEvent),                   \
+                              (int)(flags))
+
+/*! \def   DISPATCHER_SUBSCRIBE(pBus, pDispatcher, signal)
+    \brief  Subscribe an attached dispatcher to a signal.
+    \param pBus Pointer to bus structure.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param signal event signal value.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_SUBSCRIBE(pBus, pDispatcher, signal)          \
+    dispatcher_Subscribe((dispatcher_bus_t *)(pBus),             \
+                         (dispatcher_base_t *)(pDispatcher),     \
+                         (dispatcher_eventSignal_t)(signal))
+
+/*! \def   DISPATCHER_PUBLISH(pBus, pEvent, size, pDelivered)
+    \brief  Copy an event to every subscriber of its signal.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes in the event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR.
+*/
+#define DISPATCHER_PUBLISH(pBus, pEvent, size, pDelivered)       \
+    dispatcher_Publish((dispatcher_bus_t *)(pBus),               \
+                       (dispatcher_eventBase_t *)(pEvent),       \
+                       (uint16_t)(size),                         \
+                       (uint8_t *)(pDelivered))
+
+/*! \def   DISPATCHER_PUBLISH_FROM_ISR(pBus, pEvent, size, pDelivered, flags)
+    \brief  Copy an event to every subscriber of its signal from ISR.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes in the event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_PUBLISH_FROM_ISR(pBus, pEvent, size, pDelivered, flags) \
+    dispatcher_PublishFromIsr((dispatcher_bus_t *)(pBus),                  \
+                              (dispatcher_eventBase_t *)(pEvent),          \
+                              (uint16_t)(size),                            \
+                              (uint8_t *)(pDelivered),                     \
+                              (int)(flags))
+
+/*! \def   DISPATCHER_PUBLISH_REF(pBus, pEvent, pDelivered)
+    \brief  Post a pool event by reference to every subscriber of its signal.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to pool event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR.
+*/
+#define DISPATCHER_PUBLISH_REF(pBus, pEvent, pDelivered) \
+    dispatcher_PublishRef((dispatcher_bus_t *)(pBus), (void *)(pEvent), (uint8_t *)(pDelivered))
+
+/*! \def   DISPATCHER_PUBLISH_REF_FROM_ISR(pBus, pEvent, pDelivered, flags)
+    \brief  Post a pool event by reference to every subscriber of its signal
+            from ISR.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to pool event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_PUBLISH_REF_FROM_ISR(pBus, pEvent, pDelivered, flags) \
+    dispatcher_PublishRefFromIsr((dispatcher_bus_t *)(pBus),             \
+                                 (void *)(pEvent),                       \
+                                 (uint8_t *)(pDelivered),                \
+                                 (int)(flags))
+
+/*! \def   DISPATCHER_KERNEL_LOOP(pKernel, maxEvents, pProcessed)
+    \brief  Kernel event loop, runs up to maxEvents events of the attached
+            dispatchers per call.
+    \param pKernel Pointer to kernel structure.
+    \param maxEvents max number of events handled in one call.
+    \param pProcessed Pointer to number of handled events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be called in continious loop.
+*/
+#define DISPATCHER_KERNEL_LOOP(pKernel, maxEvents, pProcessed)     \
+    dispatcher_KernelLoop((dispatcher_kernel_t *)(pKernel),        \
+                          (uint16_t)(maxEvents),                   \
+                          (uint16_t *)(pProcessed))
+
+/*! \def   DISPATCHER_WORKER_LOOP(pPool, worker, maxEvents, pProcessed)
+    \brief  Worker event loop, runs up to maxEvents events of the pool
+            dispatchers per call.
+    \param pPool Pointer to worker pool structure.
+    \param worker index of the calling worker.
+    \param maxEvents max number of events handled in one call.
+    \param pProcessed Pointer to number of handled events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be called in continious loop, by one task per worker.
+*/
+#define DISPATCHER_WORKER_LOOP(pPool, worker, maxEvents, pProcessed) \
+    dispatcher_WorkerLoop((dispatcher_workerPool_t *)(pPool),        \
+                          (uint8_t)(worker),                         \
+                          (uint16_t)(maxEvents),                     \
+                          (uint16_t *)(pProcessed))
+
+/*! \def   DISPATCHER_COALESCE(pDispatcher, signal, policy, merge)
+    \brief  Set the coalescing policy of a signal.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param signal user signal.
+    \param policy dispatcher_coalescePolicy_t value.
+    \param merge merge handler, required by DISPATCHER_COALESCE_MERGE.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_COALESCE(pDispatcher, signal, policy, merge)   \
+    dispatcher_Coalesce((dispatcher_base_t *)(pDispatcher),       \
+                        (dispatcher_eventSignal_t)(signal),       \
+                        (dispatcher_coalescePolicy_t)(policy),    \
+                        (dispatcher_mergeHandler_t)(merge))
+
+/*! \def   DISPATCHER_TIME_EVENT_ARM(pTimeEvent, timeoutMs, periodMs)
+    \brief  Arm or rearm a time event.
+    \param pTimeEvent Pointer to time event structure.
+    \param timeoutMs time until the first expiry in milliseconds.
+    \param periodMs period in milliseconds, 0 for one-shot.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should only be called from the owner event loop context.
+*/
+#define DISPATCHER_TIME_EVENT_ARM(pTimeEvent, timeoutMs, periodMs)    \
+    dispatcher_TimeEventArm((dispatcher_timeEvent_t *)(pTimeEvent),   \
+                            (uint32_t)(timeoutMs),                    \
+                            (uint32_t)(periodMs))
+
+/*! \def   DISPATCHER_TIME_EVENT_DISARM(pTimeEvent)
+    \brief  Disarm a time event.
+    \param pTimeEvent Pointer to time event structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should only be called from the owner event loop context.
+*/
+#define DISPATCHER_TIME_EVENT_DISARM(pTimeEvent) \
+    dispatcher_TimeEventDisarm((dispatcher_timeEvent_t *)(pTimeEvent))
+
+/*! \def   DISPATCHER_RECORD_START(pDispatcher, write, pArg)
+    \brief  Start recording the events a dispatcher handles.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param write sink of the recording.
+    \param pArg argument handed to write.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_RECORD_START(pDispatcher, write, pArg)        \
+    dispatcher_RecordStart((dispatcher_base_t *)(pDispatcher),   \
+                           (dispatcher_recordWrite_t)(write),    \
+                           (void *)(pArg))
+
+/*! \def   DISPATCHER_REPLAY_EVENT(pDispatcher, pEvent, size)
+    \brief  Hand one recorded event to the state handlers.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event.
+    \param size event size in bytes.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_REPLAY_EVENT(pDispatcher, pEvent, size)       \
+    dispatcher_ReplayEvent((dispatcher_base_t *)(pDispatcher),   \
+                           (void const *)(pEvent),               \
+                           (uint16_t)(size))
+
+/*! \def   DISPATCHER_FILTER_INIT(pFilter, state, learn)
+    \brief  Initialize the signal filter of a state.
+    \param pFilter Pointer to filter structure.
+    \param state state handler the filter belongs to.
+    \param learn true to drop the signals the state ignores.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+#define DISPATCHER_FILTER_INIT(pFilter, state, learn)              \
+    dispatcher_FilterInit((dispatcher_filter_t *)(pFilter),        \
+                          (dispatcher_stateHandler_t)(state),      \
+                          (bool)(learn))
+
+/*! 
+    \fn   uint8_t dispatcher_Init(dispatcher_base_t *const pDispatcher,
+                        uint16_t itemSize,
+                        uint16_t itemCount,
+                        uint8_t *queueStorage,
+                        uint8_t *eventStorage,
+                        dispatcher_stateHandler_t defaultHandler).
+
+    \brief  Initialize dispatcher. 
+    \param pDispatcher Pointer to dispatcher structure.
+    \param itemSize size of a event structure in bytes.
+    \param itemCount max number of events queue can store.
+    \param queueStorage Pointer to queue storage buffer.
+    \param eventStorage Pointer to event storage buffer.
+    \param defaultHandler default state handler function.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_Init(dispatcher_base_t *const pDispatcher,
+                        uint16_t itemSize,
+                        uint16_t itemCount,
+                        uint8_t *queueStorage,
+                        uint8_t *eventStorage,
+                        dispatcher_stateHandler_t defaultHandler);
+
+/*! \fn   uint8_t dispatcher_InitWithConfig(dispatcher_base_t *const pDispatcher,
+                                        dispatcher_config_t const *const pConfig).
+    \brief  Initialize dispatcher with a queue backend and options.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pConfig Pointer to dispatcher configuration.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_InitWithConfig(dispatcher_base_t *const pDispatcher,
+                                  dispatcher_config_t const *const pConfig);
+
+/*! \fn   uint8_t dispatcher_Start(dispatcher_base_t *const pDispatcher,
+                                    bool userSignal).
+    \brief  Start dispatcher. 
+    \param pDispatcher Pointer to dispatcher structure.
+    \param userSignal any value except 0 post DISPATCHER_SIGNAL_USER 
+                      after DISPATCHER_SIGNAL_ENTRY.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_Start(dispatcher_base_t *const pDispatcher,
+                         bool userSignal);
+
+/*! \fn   uint8_t dispatcher_EventLoop(dispatcher_base_t *const pDispatcher).
+    \brief  Dispatcher event loop. 
+    \param pDispatcher Pointer to dispatcher structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be called in continious loop.
+*/
+uint8_t dispatcher_EventLoop(dispatcher_base_t *const pDispatcher);
+
+/*! \fn   uint8_t dispatcher_EventLoopBatch(dispatcher_base_t *const pDispatcher,
+                                        uint16_t maxEvents,
+                                        uint32_t budgetMs,
+                                        uint16_t *pProcessed).
+    \brief  Dispatcher event loop, blocks for the first event then handles
+            events already queued without waiting again, until maxEvents
+            were handled, the queue is empty or budgetMs expired. Every
+            event runs to completion (including transition EXIT / ENTRY)
+            before the next one is taken.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param maxEvents max number of events handled in one call.
+    \param budgetMs stop once this many milliseconds passed since the first
+                    event, 0 disables.
+    \param pProcessed Pointer to number of handled events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour, the batch stops at the first failing event.
+    \warning Should be called in continious loop.
+*/
+uint8_t dispatcher_EventLoopBatch(dispatcher_base_t *const pDispatcher,
+                                  uint16_t maxEvents,
+                                  uint32_t budgetMs,
+                                  uint16_t *pProcessed);
+
+/*! \fn   uint8_t dispatcher_EventLoopTimeout(dispatcher_base_t *const pDispatcher, uint32_t timeoutMs).
+    \brief  Dispatcher event loop handling one event, waits at most
+            timeoutMs for it so the calling task can run idle work between
+            events.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param timeoutMs max wait in milliseconds, 0 never blocks,
+                     DISPATCHER_WAIT_FOREVER like dispatcher_EventLoop.
+    \return uint8_t DISPATCHER_ERR_QUEUE_EMPTY if no event arrived in time,
+            any other values except DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_EventLoopTimeout(dispatcher_base_t *const pDispatcher, uint32_t timeoutMs);
+
+
+/*! \fn   dispatcher_Post(dispatcher_base_t *const pDispatcher,
+                        dispatcher_eventBase_t const *const pEvent).
+    \brief  Post event to dispatcher. 
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR or any latency critial opetaion.
+*/
+uint8_t dispatcher_Post(dispatcher_base_t *const pDispatcher,
+                        dispatcher_eventBase_t const *const pEvent);
+
+/*! \fn   uint8_t dispatcher_PostFromIsr(dispatcher_base_t *const pDispatcher,
+                               dispatcher_eventBase_t const *const pEvent,
+                               int flags)
+    \brief Post event from ISR to dispatcher. 
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_PostFromIsr(dispatcher_base_t *const pDispatcher,
+                               dispatcher_eventBase_t const *const pEvent,
+                               int flags);
+
+/*! \fn   uint8_t dispatcher_PostOverflow(dispatcher_base_t *const pDispatcher,
+                                       dispatcher_eventBase_t const *const pEvent,
+                                       dispatcher_overflow_t overflow,
+                                       uint32_t timeoutMs)
+    \brief  Post event to dispatcher, a full queue is handled by overflow
+            instead of the dispatcher policy. Events lost are counted per
+            policy, see dispatcher_DropCount.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param overflow dispatcher_overflow_t value, dropping queued events
+                    requires the port queue or mpsc ring backend.
+    \param timeoutMs max wait of DISPATCHER_OVERFLOW_BLOCK in milliseconds,
+                     DISPATCHER_WAIT_FOREVER.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour, DISPATCHER_ERR_QUEUE_FULL when the event is dropped.
+    \warning Should not be called in ISR.
+*/
+uint8_t dispatcher_PostOverflow(dispatcher_base_t *const pDispatcher,
+                                dispatcher_eventBase_t const *const pEvent,
+                                dispatcher_overflow_t overflow,
+                                uint32_t timeoutMs);
+
+/*! \fn   uint8_t dispatcher_PostOverflowFromIsr(dispatcher_base_t *const pDispatcher,
+                                              dispatcher_eventBase_t const *const pEvent,
+                                              dispatcher_overflow_t overflow,
+                                              int flags)
+    \brief  Post event from ISR to dispatcher with its own full queue
+            policy, DISPATCHER_OVERFLOW_BLOCK does not wait.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param overflow dispatcher_overflow_t value.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_PostOverflowFromIsr(dispatcher_base_t *const pDispatcher,
+                                       dispatcher_eventBase_t const *const pEvent,
+                                       dispatcher_overflow_t overflow,
+                                       int flags);
+
+/*! \fn   uint32_t dispatcher_DropCount(dispatcher_base_t const *const pDispatcher,
+                                     dispatcher_overflow_t overflow)
+    \brief  Number of events lost by posts using a policy on a full queue :
+            posts failing (block, fail), posted events dropped (drop newest)
+            and queued events dropped (drop oldest, overwrite).
+    \param pDispatcher Pointer to dispatcher structure.
+    \param overflow dispatcher_overflow_t value.
+    \return uint32_t drop count, 0 for invalid arguments.
+*/
+uint32_t dispatcher_DropCount(dispatcher_base_t const *const pDispatcher,
+                              dispatcher_overflow_t overflow);
+
+/*! \fn   uint8_t dispatcher_FilterInit(dispatcher_filter_t *const pFilter,
+                                     dispatcher_stateHandler_t state,
+                                     bool learn)
+    \brief  Initialize the signal filter of a state, a learning filter
+            accepts every signal until the state ignores it, any other
+            only system signals until dispatcher_FilterAccept.
+    \param pFilter Pointer to filter, one of the dispatcher configuration filters.
+    \param state state the filter belongs to.
+    \param learn true to learn the ignored signals.
+    \return uint8_t any other values except DISPATCHER_ERR_CLEAR
+            represents failour.
+    \warning Posts are filtered against the state active at the post, an
+             event posted just before a transition to a state accepting it
+             is lost. Filter only signals which are of no use while the
+             state is active, a learning filter only states which ignore a
+             signal every time (no guards).
+*/
+uint8_t dispatcher_FilterInit(dispatcher_filter_t *const pFilter,
+                              dispatcher_stateHandler_t state,
+                              bool learn);
+
+/*! \fn   uint8_t dispatcher_FilterAccept(dispatcher_filter_t *const pFilter,
+                                       dispatcher_eventSignal_t signal)
+    \brief  Let a filter accept a signal, may be called at any time.
+    \param pFilter Pointer to filter.
+    \param signal accepted signal.
+    \return uint8_t any other values except DISPATCHER_ERR_CLEAR
+            represents failour.
+*/
+uint8_t dispatcher_FilterAccept(dispatcher_filter_t *const pFilter,
+                                dispatcher_eventSignal_t signal);
+
+/*! \fn   uint32_t dispatcher_FilteredCount(dispatcher_base_t const *const pDispatcher)
+    \brief  Number of posts dropped by the filter of the active state.
+    \param pDispatcher Pointer to dispatcher structure.
+    \return uint32_t filtered posts, 0 for a NULL dispatcher.
+*/
+uint32_t dispatcher_FilteredCount(dispatcher_base_t const *const pDispatcher);
+
+/*! \fn   uint8_t dispatcher_StatsGet(dispatcher_base_t const *const pDispatcher,
+                                   dispatcher_stats_t *const pStats)
+    \brief  Copy the runtime statistics of a dispatcher. Counters are
+            updated without locks, a snapshot taken while events flow may
+            mix counters of consecutive events. dropped adds the
+            dispatcher_DropCount of every policy.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pStats Pointer to dispatcher_stats_t structure.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_STATS_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_StatsGet(dispatcher_base_t const *const pDispatcher,
+                            dispatcher_stats_t *const pStats);
+
+/*! \fn   uint8_t dispatcher_StatsSignal(dispatcher_base_t const *const pDispatcher,
+                                      dispatcher_eventSignal_t signal,
+                                      dispatcher_signalStats_t *const pStats)
+    \brief  Copy the handler time statistics of a signal.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param signal event signal value, below the configured signalStatsCount.
+    \param pStats Pointer to dispatcher_signalStats_t structure.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_STATS_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_StatsSignal(dispatcher_base_t const *const pDispatcher,
+                               dispatcher_eventSignal_t signal,
+                               dispatcher_signalStats_t *const pStats);
+
+/*! \fn   uint8_t dispatcher_StatsReset(dispatcher_base_t *const pDispatcher)
+    \brief  Clear the runtime statistics, drop and filtered counts of a dispatcher.
+    \param pDispatcher Pointer to dispatcher structure.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_STATS_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should be called from the event loop context (a state
+             handler), a reset racing the event loop may lose its update.
+*/
+uint8_t dispatcher_StatsReset(dispatcher_base_t *const pDispatcher);
+
+/*! \fn   uint8_t dispatcher_TraceInit(dispatcher_traceRecord_t *const records, uint32_t count)
+    \brief  Hand the record storage to the trace ring, shared by every
+            dispatcher. Tracing stays stopped until dispatcher_TraceStart.
+    \param records record storage.
+    \param count number of records, power of two.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_TRACE_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should not be called while tracing runs.
+*/
+uint8_t dispatcher_TraceInit(dispatcher_traceRecord_t *const records, uint32_t count);
+
+/*! \fn   uint8_t dispatcher_TraceStart(void)
+    \brief  Start recording, records keep going round the ring and
+            overwrite the oldest ones.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_TRACE_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_TraceStart(void);
+
+/*! \fn   uint8_t dispatcher_TraceStop(void)
+    \brief  Stop recording, the ring keeps its records for a dump.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_TRACE_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_TraceStop(void);
+
+/*! \fn   uint8_t dispatcher_TraceDump(dispatcher_traceWrite_t write, void *pArg)
+    \brief  Write the trace ring (dispatcher_traceHeader_t and records,
+            oldest first) to a sink, e.g. a file, a socket or a uart.
+            tools/dispatcher_trace_decode converts a dump to a timeline.
+    \param write sink of the dump.
+    \param pArg argument handed to write.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_TRACE_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should be called with tracing stopped.
+*/
+uint8_t dispatcher_TraceDump(dispatcher_traceWrite_t write, void *pArg);
+
+/*! \fn   void dispatcher_LogDefer(uint8_t level,
+                                 char const *tag,
+                                 char const *format,
+                                 uintptr_t const *args,
+                                 uint8_t argCount)
+    \brief  Store a deferred log record without formatting it, called by
+            the DISPATCHER_LOG_xxx macros with DISPATCHER_LOG_DEFERRED. A
+            full ring loses the record (see dispatcher_LogDropped), before
+            dispatcher_LogInit the record is formatted and written at once.
+    \param level DISPATCHER_LOG_LEVEL_xxx value.
+    \param tag tag string, must outlive the record.
+    \param format format string, must outlive the record.
+    \param args raw arguments.
+    \param argCount number of arguments, at most DISPATCHER_LOG_MAX_ARGS are kept.
+    \warning Should not be called from ISRs.
+*/
+void dispatcher_LogDefer(uint8_t level,
+                         char const *tag,
+                         char const *format,
+                         uintptr_t const *args,
+                         uint8_t argCount);
+
+/*! \fn   uint8_t dispatcher_LogInit(uint8_t *const storage, uint16_t count)
+    \brief  Hand the record storage to the deferred log ring.
+    \param storage Pointer to DISPATCHER_LOG_STORAGE_SIZE(count) bytes aligned
+                   to DISPATCHER_QUEUE_ALIGN.
+    \param count max number of pending records, power of two.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_LOG_DEFERRED, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_LogInit(uint8_t *const storage, uint16_t count);
+
+/*! \fn   uint8_t dispatcher_LogDrain(dispatcher_logSink_t sink,
+                                   void *pArg,
+                                   uint32_t timeoutMs,
+                                   uint16_t *pCount)
+    \brief  Format the pending deferred log records, oldest first, and
+            hand every line to sink. Waits up to timeoutMs for the first
+            record. Records lost since the previous drain are reported with
+            one more line. Usually called in a loop by a low priority task.
+    \param sink line output, NULL writes through the port (console).
+    \param pArg argument handed to sink.
+    \param timeoutMs max wait for the first record, DISPATCHER_WAIT_FOREVER waits forever.
+    \param pCount set to number of records drained, may be NULL.
+    \return uint8_t DISPATCHER_ERR_QUEUE_EMPTY on timeout,
+            DISPATCHER_ERR_NOT_SUPPORTED without DISPATCHER_LOG_DEFERRED,
+            any other values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Only one task may drain.
+*/
+uint8_t dispatcher_LogDrain(dispatcher_logSink_t sink,
+                            void *pArg,
+                            uint32_t timeoutMs,
+                            uint16_t *pCount);
+
+/*! \fn   uint32_t dispatcher_LogDropped(void)
+    \brief  Number of deferred log records lost on a full ring.
+    \return uint32_t lost records, 0 without DISPATCHER_LOG_DEFERRED.
+*/
+uint32_t dispatcher_LogDropped(void);
+
+/*! \fn   uint8_t dispatcher_RecordStart(dispatcher_base_t *const pDispatcher,
+                                      dispatcher_recordWrite_t write,
+                                      void *pArg)
+    \brief  Start recording every event the dispatcher hands to its state
+            handlers (queued events after coalescing, pool events by value,
+            expired time events) to a sink, e.g. a file or a flash
+            partition. The dispatcher_recordHeader_t is written at once.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param write sink of the recording.
+    \param pArg argument handed to write.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_RECORD_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should be called from the event loop context (a state
+             handler) or before the event loop runs.
+*/
+uint8_t dispatcher_RecordStart(dispatcher_base_t *const pDispatcher,
+                               dispatcher_recordWrite_t write,
+                               void *pArg);
+
+/*! \fn   uint8_t dispatcher_RecordStop(dispatcher_base_t *const pDispatcher)
+    \brief  Stop recording, the sink is not called any more.
+    \param pDispatcher Pointer to dispatcher structure.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED without
+            DISPATCHER_RECORD_ENABLE, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should be called from the event loop context (a state
+             handler) or while the event loop does not run.
+*/
+uint8_t dispatcher_RecordStop(dispatcher_base_t *const pDispatcher);
+
+/*! \fn   uint8_t dispatcher_ReplayEvent(dispatcher_base_t *const pDispatcher,
+                                      void const *const pEvent,
+                                      uint16_t length)
+    \brief  Hand one event to the state handlers the way the event loop
+            does, without a queue, then the events recalled meanwhile.
+    \param pDispatcher Pointer to a started dispatcher.
+    \param pEvent Pointer to event, signal included.
+    \param length event size in bytes.
+    \return uint8_t any other values except DISPATCHER_ERR_CLEAR
+            represents failour.
+    \warning Should be called from the task owning the dispatcher, its
+             event loop should not run meanwhile.
+*/
+uint8_t dispatcher_ReplayEvent(dispatcher_base_t *const pDispatcher,
+                               void const *const pEvent,
+                               uint16_t length);
+
+/*! \fn   uint8_t dispatcher_Replay(dispatcher_base_t *const pDispatcher,
+                                 dispatcher_recordRead_t read,
+                                 void *pArg,
+                                 uint8_t *const pBuffer,
+                                 uint16_t size,
+                                 dispatcher_replay_t pace,
+                                 uint32_t *pCount)
+    \brief  Feed a recording to the state handlers of a dispatcher, one
+            dispatcher_ReplayEvent per entry, as fast as possible or with
+            the recorded gaps. Events the handlers post meanwhile are only
+            queued, the recording holds them already.
+    \param pDispatcher Pointer to a started dispatcher.
+    \param read source of the recording.
+    \param pArg argument handed to read.
+    \param pBuffer Pointer to a buffer for one event, aligned like an event.
+    \param size size of pBuffer, at least the largest recorded event.
+    \param pace DISPATCHER_REPLAY_FAST or DISPATCHER_REPLAY_TIMED.
+    \param pCount set to number of events replayed, may be NULL.
+    \return uint8_t DISPATCHER_ERR_INVALID_ARGS on a bad header or an
+            event larger than size, DISPATCHER_ERR_PROCESS_FAIL on a
+            truncated recording, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should be called from the task owning the dispatcher, its
+             event loop should not run meanwhile.
+*/
+uint8_t dispatcher_Replay(dispatcher_base_t *const pDispatcher,
+                          dispatcher_recordRead_t read,
+                          void *pArg,
+                          uint8_t *const pBuffer,
+                          uint16_t size,
+                          dispatcher_replay_t pace,
+                          uint32_t *pCount);
+
+/*! \fn   uint8_t dispatcher_Recall(dispatcher_base_t *const pDispatcher)
+    \brief  Replay the events deferred so far, oldest first, straight from
+            the deferred event store and ahead of every queued event.
+            Usually called on DISPATCHER_SIGNAL_ENTRY of the state able to
+            handle them. A replayed event deferred again goes back to the
+            store and waits for the next recall.
+    \param pDispatcher Pointer to dispatcher structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should only be called from state handlers.
+*/
+uint8_t dispatcher_Recall(dispatcher_base_t *const pDispatcher);
+
+/*! \fn   uint8_t dispatcher_Coalesce(dispatcher_base_t *const pDispatcher,
+                                   dispatcher_eventSignal_t signal,
+                                   dispatcher_coalescePolicy_t policy,
+                                   dispatcher_mergeHandler_t merge)
+    \brief  Set the coalescing policy of a signal. While an event of a
+            coalesced signal is queued, further posts of the signal do not
+            take a queue slot : the newest event replaces the pending one
+            (DISPATCHER_COALESCE_LATEST) or is merged into it
+            (DISPATCHER_COALESCE_MERGE), so the queue holds at most one
+            event per coalesced signal. Pending events live in a registered
+            event pool with blocks of the dispatcher event size.
+            Applies to dispatcher_Post, dispatcher_PostSized and their ISR
+            variants, other posts of the signal are queued as usual.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param signal user signal below the configured coalesceCount.
+    \param policy dispatcher_coalescePolicy_t value.
+    \param merge merge handler, required by DISPATCHER_COALESCE_MERGE.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be done before events of the signal are posted.
+*/
+uint8_t dispatcher_Coalesce(dispatcher_base_t *const pDispatcher,
+                            dispatcher_eventSignal_t signal,
+                            dispatcher_coalescePolicy_t policy,
+                            dispatcher_mergeHandler_t merge);
+
+/*! \fn   uint8_t dispatcher_TimeEventInit(dispatcher_timeEvent_t *const pTimeEvent,
+                                        dispatcher_base_t *const pDispatcher,
+                                        dispatcher_eventSignal_t signal)
+    \brief  Initialize a disarmed time event of a dispatcher initialized
+            with a timing wheel.
+    \param pTimeEvent Pointer to time event structure.
+    \param pDispatcher Pointer to owner dispatcher structure.
+    \param signal user signal handed to the state handlers on expiry.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_TimeEventInit(dispatcher_timeEvent_t *const pTimeEvent,
+                                 dispatcher_base_t *const pDispatcher,
+                                 dispatcher_eventSignal_t signal);
+
+/*! \fn   uint8_t dispatcher_TimeEventArm(dispatcher_timeEvent_t *const pTimeEvent,
+                                       uint32_t timeoutMs,
+                                       uint32_t periodMs)
+    \brief  Arm a time event, an armed one is rearmed, O(1). A periodic
+            time event is rearmed from its expiry, so it does not drift.
+            Timeouts shorter than a tick expire on the next tick.
+    \param pTimeEvent Pointer to time event structure.
+    \param timeoutMs time until the first expiry in milliseconds.
+    \param periodMs period in milliseconds, 0 for one-shot.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should only be called from the owner event loop context (its
+             state handlers) or before the event loop runs.
+*/
+uint8_t dispatcher_TimeEventArm(dispatcher_timeEvent_t *const pTimeEvent,
+                                uint32_t timeoutMs,
+                                uint32_t periodMs);
+
+/*! \fn   uint8_t dispatcher_TimeEventDisarm(dispatcher_timeEvent_t *const pTimeEvent)
+    \brief  Disarm a time event, O(1). An expired time event not yet
+            handled is dropped too, so it never arrives after this call.
+    \param pTimeEvent Pointer to time event structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should only be called from the owner event loop context (its
+             state handlers) or before the event loop runs.
+*/
+uint8_t dispatcher_TimeEventDisarm(dispatcher_timeEvent_t *const pTimeEvent);
+
+/*! \fn   bool dispatcher_TimeEventIsArmed(dispatcher_timeEvent_t const *const pTimeEvent)
+    \brief  Check a time event is armed.
+    \param pTimeEvent Pointer to time event structure.
+    \return bool true if armed or expired and not yet handled.
+*/
+bool dispatcher_TimeEventIsArmed(dispatcher_timeEvent_t const *const pTimeEvent);
+
+/*! \fn   uint8_t dispatcher_TableDispatch(dispatcher_base_t *const pDispatcher,
+                                        dispatcher_eventBase_t const *const pEvent,
+                                        dispatcher_table_t const *const pTable)
+    \brief  Run an event through a table driven state, the body of every
+            DISPATCHER_STATE_TABLE handler.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param pTable Pointer to state table.
+    \return uint8_t dispatcher_smStatus_t of the reaction.
+*/
+uint8_t dispatcher_TableDispatch(dispatcher_base_t *const pDispatcher,
+                                 dispatcher_eventBase_t const *const pEvent,
+                                 dispatcher_table_t const *const pTable);
+
+/*! \fn   uint8_t dispatcher_PostPriority(dispatcher_base_t *const pDispatcher,
+                                       dispatcher_eventBase_t const *const pEvent,
+                                       uint8_t priority)
+    \brief  Post event to a priority lane. The event loop always takes the
+            next event from the highest priority lane holding one, so an
+            urgent event never waits behind lower priority backlog (only
+            behind the event being handled). Events of one lane stay in
+            order.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param priority lane, 0 is the dispatcher queue (same as dispatcher_Post),
+                    1 to laneCount the extra lanes.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should not be called in ISR or any latency critial opetaion.
+*/
+uint8_t dispatcher_PostPriority(dispatcher_base_t *const pDispatcher,
+                                dispatcher_eventBase_t const *const pEvent,
+                                uint8_t priority);
+
+/*! \fn   uint8_t dispatcher_PostPriorityFromIsr(dispatcher_base_t *const pDispatcher,
+                                              dispatcher_eventBase_t const *const pEvent,
+                                              uint8_t priority,
+                                              int flags)
+    \brief Post event from ISR to a priority lane, never blocks.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param priority lane, 0 is the dispatcher queue.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_PostPriorityFromIsr(dispatcher_base_t *const pDispatcher,
+                                       dispatcher_eventBase_t const *const pEvent,
+                                       uint8_t priority,
+                                       int flags);
+
+/*! \fn   uint8_t dispatcher_PostSized(dispatcher_base_t *const pDispatcher,
+                                    dispatcher_eventBase_t const *const pEvent,
+                                    uint16_t size)
+    \brief  Post the first size bytes of an event to dispatcher. With
+            DISPATCHER_QUEUE_TYPE_VARIABLE the event only takes its own size
+            in the queue, so events made of a bare signal should be posted
+            with sizeof(dispatcher_eventBase_t). The handler must only read
+            the fields that were posted.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes, from sizeof(dispatcher_eventBase_t)
+                up to the dispatcher event size.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED for partial events with
+            DISPATCHER_QUEUE_TYPE_DEFAULT, any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should not be called in ISR or any latency critial opetaion.
+*/
+uint8_t dispatcher_PostSized(dispatcher_base_t *const pDispatcher,
+                             dispatcher_eventBase_t const *const pEvent,
+                             uint16_t size);
+
+/*! \fn   uint8_t dispatcher_PostSizedFromIsr(dispatcher_base_t *const pDispatcher,
+                                           dispatcher_eventBase_t const *const pEvent,
+                                           uint16_t size,
+                                           int flags)
+    \brief Post the first size bytes of an event from ISR to dispatcher.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes, from sizeof(dispatcher_eventBase_t)
+                up to the dispatcher event size.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_PostSizedFromIsr(dispatcher_base_t *const pDispatcher,
+                                    dispatcher_eventBase_t const *const pEvent,
+                                    uint16_t size,
+                                    int flags);
+
+/*! \fn   uint8_t dispatcher_PostBatch(dispatcher_base_t *const pDispatcher,
+                                    void const *const pEvents,
+                                    uint16_t count,
+                                    uint16_t *pAccepted)
+    \brief  Post an array of events to dispatcher. Waits up to the post
+            timeout of a DISPATCHER_OVERFLOW_BLOCK dispatcher (not at all
+            with the other policies) for room for the first event, then
+            posts as many of the rest as fit without waiting again, in
+            order. The event loop is woken at most once.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvents Pointer to count events of the dispatcher event size
+                   stored back to back.
+    \param count number of events.
+    \param pAccepted Pointer to number of posted events, may be NULL.
+    \return uint8_t DISPATCHER_ERR_QUEUE_FULL when only part of the array
+            was posted, any other values except DISPATCHER_ERR_CLEAR
+            represents failour.
+    \warning Should not be called in ISR.
+*/
+uint8_t dispatcher_PostBatch(dispatcher_base_t *const pDispatcher,
+                             void const *const pEvents,
+                             uint16_t count,
+                             uint16_t *pAccepted);
+
+/*! \fn   uint8_t dispatcher_PostBatchFromIsr(dispatcher_base_t *const pDispatcher,
+                                           void const *const pEvents,
+                                           uint16_t count,
+                                           uint16_t *pAccepted,
+                                           int flags)
+    \brief  Post an array of events from ISR, never blocks, posts as many
+            as fit in order.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvents Pointer to count events of the dispatcher event size
+                   stored back to back.
+    \param count number of events.
+    \param pAccepted Pointer to number of posted events, may be NULL.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t DISPATCHER_ERR_QUEUE_FULL when only part of the array
+            was posted, any other values except DISPATCHER_ERR_CLEAR
+            represents failour.
+*/
+uint8_t dispatcher_PostBatchFromIsr(dispatcher_base_t *const pDispatcher,
+                                    void const *const pEvents,
+                                    uint16_t count,
+                                    uint16_t *pAccepted,
+                                    int flags);
+
+/*! \fn   uint8_t dispatcher_PostReserve(dispatcher_base_t *const pDispatcher,
+                                      void **ppEvent)
+    \brief  Reserve a slot in a ring queue so the event is constructed in
+            place instead of being copied. The event is not visible to the
+            event loop until dispatcher_PostCommit, every reserved event
+            must be committed.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param ppEvent Pointer to a event pointer, set to the reserved slot.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED with DISPATCHER_QUEUE_TYPE_DEFAULT,
+            any other values except DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should not be called in ISR.
+*/
+uint8_t dispatcher_PostReserve(dispatcher_base_t *const pDispatcher,
+                               void **ppEvent);
+
+/*! \fn   uint8_t dispatcher_PostCommit(dispatcher_base_t *const pDispatcher,
+                                     void *const pEvent)
+    \brief  Post an event reserved with dispatcher_PostReserve.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to reserved event.
+    \return uint8_t DISPATCHER_ERR_INVALID_ARGS for an event with a
+            reserved signal (DISPATCHER_SIGNAL_REF, DISPATCHER_SIGNAL_VOID),
+            its slot is then released by the event loop without dispatch.
+            Any other values except DISPATCHER_ERR_CLEAR represents failour.
+*/
+uint8_t dispatcher_PostCommit(dispatcher_base_t *const pDispatcher,
+                              void *const pEvent);
+
+/*! \fn   uint8_t dispatcher_EventPoolInit(dispatcher_pool_t *const pPool,
+                                        uint16_t blockSize,
+                                        uint16_t blockCount,
+                                        uint8_t *storage)
+    \brief  Initialize an event pool and add it to the pool size classes
+            used by dispatcher_EventNew. Pools must be added in increasing
+            block size order, before any event is allocated.
+    \param pPool Pointer to pool structure.
+    \param blockSize max event size of the pool in bytes.
+    \param blockCount number of events in the pool.
+    \param storage Pointer to a buffer of DISPATCHER_POOL_STORAGE_SIZE bytes
+                   aligned to DISPATCHER_POOL_ALIGN.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_EventPoolInit(dispatcher_pool_t *const pPool,
+                                 uint16_t blockSize,
+                                 uint16_t blockCount,
+                                 uint8_t *storage);
+
+/*! \fn   uint8_t dispatcher_EventNew(uint16_t size, void **ppEvent)
+    \brief  Allocate an event from the smallest pool it fits in, larger
+            pools are tried when that one is empty. The caller owns one
+            reference and must drop it with dispatcher_EventRelease once
+            the event is posted. Safe to call from ISR.
+    \param size event size in bytes.
+    \param ppEvent Pointer to a event pointer, set to the new event.
+    \return uint8_t DISPATCHER_ERR_POOL_EMPTY if every fitting pool is
+            empty, any other values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_EventNew(uint16_t size, void **ppEvent);
+
+/*! \fn   uint8_t dispatcher_EventRelease(void *const pEvent)
+    \brief  Drop a reference to a pool event, the event goes back to its
+            pool with the last reference. Safe to call from ISR.
+    \param pEvent Pointer to pool event.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_EventRelease(void *const pEvent);
+
+/*! \fn   uint8_t dispatcher_PostRef(dispatcher_base_t *const pDispatcher,
+                                  void *const pEvent)
+    \brief  Post a pool event by reference, only a dispatcher_eventRef_t is
+            queued. The event loop drops the reference after the state
+            handler returned, the same event can be posted to any number
+            of dispatchers and must not be modified once posted.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to pool event.
+    \return uint8_t DISPATCHER_ERR_NOT_SUPPORTED if the dispatcher event size
+            can not hold a dispatcher_eventRef_t (the port queue backend
+            needs exactly that size), any other values except
+            DISPATCHER_ERR_CLEAR represents failour.
+    \warning Should not be called in ISR.
+*/
+uint8_t dispatcher_PostRef(dispatcher_base_t *const pDispatcher,
+                           void *const pEvent);
+
+/*! \fn   uint8_t dispatcher_PostRefFromIsr(dispatcher_base_t *const pDispatcher,
+                                         void *const pEvent,
+                                         int flags)
+    \brief  Post a pool event by reference from ISR, never blocks.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param pEvent Pointer to pool event.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_PostRefFromIsr(dispatcher_base_t *const pDispatcher,
+                                  void *const pEvent,
+                                  int flags);
+
+/*! \fn   uint8_t dispatcher_BusInit(dispatcher_bus_t *const pBus,
+                                  uint32_t *subscriptions,
+                                  uint16_t signalCount)
+    \brief  Initialize a bus without any dispatcher attached.
+    \param pBus Pointer to bus structure.
+    \param subscriptions Pointer to signalCount subscriber bitmaps.
+    \param signalCount number of signals, signals from 0 to signalCount - 1
+                       can be subscribed and published.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_BusInit(dispatcher_bus_t *const pBus,
+                           uint32_t *subscriptions,
+                           uint16_t signalCount);
+
+/*! \fn   uint8_t dispatcher_BusAttach(dispatcher_bus_t *const pBus,
+                                    dispatcher_base_t *const pDispatcher,
+                                    uint8_t priority)
+    \brief  Attach a dispatcher to a bus. Published events reach
+            subscribers in decreasing priority order.
+    \param pBus Pointer to bus structure.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param priority unique priority of the dispatcher on this bus, below
+                    DISPATCHER_BUS_MAX_SUBSCRIBERS.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be done before events are published.
+*/
+uint8_t dispatcher_BusAttach(dispatcher_bus_t *const pBus,
+                             dispatcher_base_t *const pDispatcher,
+                             uint8_t priority);
+
+/*! \fn   uint8_t dispatcher_Subscribe(dispatcher_bus_t *const pBus,
+                                    dispatcher_base_t *const pDispatcher,
+                                    dispatcher_eventSignal_t signal)
+    \brief  Subscribe an attached dispatcher to a signal, may be called
+            while other contexts publish.
+    \param pBus Pointer to bus structure.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param signal event signal value.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_Subscribe(dispatcher_bus_t *const pBus,
+                             dispatcher_base_t *const pDispatcher,
+                             dispatcher_eventSignal_t signal);
+
+/*! \fn   uint8_t dispatcher_Unsubscribe(dispatcher_bus_t *const pBus,
+                                      dispatcher_base_t *const pDispatcher,
+                                      dispatcher_eventSignal_t signal)
+    \brief  Unsubscribe an attached dispatcher from a signal, may be called
+            while other contexts publish.
+    \param pBus Pointer to bus structure.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param signal event signal value.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_Unsubscribe(dispatcher_bus_t *const pBus,
+                               dispatcher_base_t *const pDispatcher,
+                               dispatcher_eventSignal_t signal);
+
+/*! \fn   uint8_t dispatcher_Publish(dispatcher_bus_t *const pBus,
+                                  dispatcher_eventBase_t const *const pEvent,
+                                  uint16_t size,
+                                  uint8_t *pDelivered)
+    \brief  Copy the first size bytes of an event to every subscriber of
+            its signal, highest priority first, see dispatcher_PostSized.
+            A subscriber that can not take the event does not stop the
+            delivery to the others.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes in the event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \return uint8_t the first error of a subscriber, DISPATCHER_ERR_CLEAR if
+            every subscriber got the event (or there is none).
+    \warning Should not be called in ISR.
+*/
+uint8_t dispatcher_Publish(dispatcher_bus_t *const pBus,
+                           dispatcher_eventBase_t const *const pEvent,
+                           uint16_t size,
+                           uint8_t *pDelivered);
+
+/*! \fn   uint8_t dispatcher_PublishFromIsr(dispatcher_bus_t *const pBus,
+                                         dispatcher_eventBase_t const *const pEvent,
+                                         uint16_t size,
+                                         uint8_t *pDelivered,
+                                         int flags)
+    \brief  Copy the first size bytes of an event to every subscriber of
+            its signal from ISR, never blocks.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to event structure.
+    \param size number of valid bytes in the event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t the first error of a subscriber, DISPATCHER_ERR_CLEAR if
+            every subscriber got the event (or there is none).
+*/
+uint8_t dispatcher_PublishFromIsr(dispatcher_bus_t *const pBus,
+                                  dispatcher_eventBase_t const *const pEvent,
+                                  uint16_t size,
+                                  uint8_t *pDelivered,
+                                  int flags);
+
+/*! \fn   uint8_t dispatcher_PublishRef(dispatcher_bus_t *const pBus,
+                                     void *const pEvent,
+                                     uint8_t *pDelivered)
+    \brief  Post a pool event by reference to every subscriber of its
+            signal, highest priority first, see dispatcher_PostRef.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to pool event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \return uint8_t the first error of a subscriber, DISPATCHER_ERR_CLEAR if
+            every subscriber got the event (or there is none).
+    \warning Should not be called in ISR.
+*/
+uint8_t dispatcher_PublishRef(dispatcher_bus_t *const pBus,
+                              void *const pEvent,
+                              uint8_t *pDelivered);
+
+/*! \fn   uint8_t dispatcher_PublishRefFromIsr(dispatcher_bus_t *const pBus,
+                                            void *const pEvent,
+                                            uint8_t *pDelivered,
+                                            int flags)
+    \brief  Post a pool event by reference to every subscriber of its
+            signal from ISR, never blocks.
+    \param pBus Pointer to bus structure.
+    \param pEvent Pointer to pool event.
+    \param pDelivered Pointer to number of subscribers reached, may be NULL.
+    \param flags any value except 0 requests a context switch on ISR exit
+                 when a higher priority task was woken.
+    \return uint8_t the first error of a subscriber, DISPATCHER_ERR_CLEAR if
+            every subscriber got the event (or there is none).
+*/
+uint8_t dispatcher_PublishRefFromIsr(dispatcher_bus_t *const pBus,
+                                     void *const pEvent,
+                                     uint8_t *pDelivered,
+                                     int flags);
+
+/*! \fn   uint8_t dispatcher_KernelInit(dispatcher_kernel_t *const pKernel)
+    \brief  Initialize a kernel without any dispatcher attached.
+    \param pKernel Pointer to kernel structure.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_KernelInit(dispatcher_kernel_t *const pKernel);
+
+/*! \fn   uint8_t dispatcher_KernelAttach(dispatcher_kernel_t *const pKernel,
+                                       dispatcher_base_t *const pDispatcher,
+                                       uint8_t priority)
+    \brief  Let a kernel run an initialized dispatcher. Posts to the
+            dispatcher then wake the kernel instead of a task of its own,
+            the kernel also runs its time events.
+            Dispatchers with priority lanes can not be attached.
+    \param pKernel Pointer to kernel structure.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param priority unique priority of the dispatcher in this kernel, below
+                    DISPATCHER_KERNEL_MAX_DISPATCHERS.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be done before events are posted from other contexts,
+             the event loop of an attached dispatcher must not be called.
+*/
+uint8_t dispatcher_KernelAttach(dispatcher_kernel_t *const pKernel,
+                                dispatcher_base_t *const pDispatcher,
+                                uint8_t priority);
+
+/*! \fn   uint8_t dispatcher_KernelLoop(dispatcher_kernel_t *const pKernel,
+                                     uint16_t maxEvents,
+                                     uint16_t *pProcessed)
+    \brief  Kernel event loop. Every event goes to the highest priority
+            dispatcher holding one and runs to completion before the next
+            is picked. Sleeps until the first event arrives, the rest of the
+            batch is what is already queued.
+    \param pKernel Pointer to kernel structure.
+    \param maxEvents max number of events handled in one call.
+    \param pProcessed Pointer to number of handled events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be called in continious loop from one task.
+*/
+uint8_t dispatcher_KernelLoop(dispatcher_kernel_t *const pKernel,
+                              uint16_t maxEvents,
+                              uint16_t *pProcessed);
+
+/*! \fn   uint8_t dispatcher_WorkerPoolInit(dispatcher_workerPool_t *const pPool,
+                                         dispatcher_worker_t *workers,
+                                         uint8_t workerCount)
+    \brief  Initialize a worker pool without any dispatcher attached.
+    \param pPool Pointer to worker pool structure.
+    \param workers Pointer to workerCount workers.
+    \param workerCount number of workers, 1 - DISPATCHER_WORKER_MAX.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+*/
+uint8_t dispatcher_WorkerPoolInit(dispatcher_workerPool_t *const pPool,
+                                  dispatcher_worker_t *workers,
+                                  uint8_t workerCount);
+
+/*! \fn   uint8_t dispatcher_WorkerPoolAttach(dispatcher_workerPool_t *const pPool,
+                                           dispatcher_base_t *const pDispatcher,
+                                           uint8_t priority,
+                                           uint8_t home,
+                                           bool pinned)
+    \brief  Let a worker pool run an initialized dispatcher. Posts wake its
+            home worker, idle workers may steal it unless it is pinned.
+            Dispatchers with priority lanes or a timing wheel can not be
+            attached.
+    \param pPool Pointer to worker pool structure.
+    \param pDispatcher Pointer to dispatcher structure.
+    \param priority unique priority of the dispatcher in this pool, below
+                    DISPATCHER_WORKER_POOL_MAX_DISPATCHERS.
+    \param home home worker index, DISPATCHER_WORKER_ANY spreads dispatchers
+                by priority (priority % workerCount).
+    \param pinned any value except 0 only lets the home worker run it.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be done before the workers run, the event loop of an
+             attached dispatcher must not be called.
+*/
+uint8_t dispatcher_WorkerPoolAttach(dispatcher_workerPool_t *const pPool,
+                                    dispatcher_base_t *const pDispatcher,
+                                    uint8_t priority,
+                                    uint8_t home,
+                                    bool pinned);
+
+/*! \fn   uint8_t dispatcher_WorkerLoop(dispatcher_workerPool_t *const pPool,
+                                     uint8_t worker,
+                                     uint16_t maxEvents,
+                                     uint16_t *pProcessed)
+    \brief  Worker event loop. Runs the highest priority ready dispatcher
+            homed on the worker, steals an unpinned one from another worker
+            when there is none. Every event runs to completion, a
+            dispatcher is never run by two workers at once. Sleeps until
+            the first event arrives, the rest of the batch is what is
+            already queued.
+    \param pPool Pointer to worker pool structure.
+    \param worker index of the calling worker.
+    \param maxEvents max number of events handled in one call.
+    \param pProcessed Pointer to number of handled events, may be NULL.
+    \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+            failour.
+    \warning Should be called in continious loop, by one task per worker.
+*/
+uint8_t dispatcher_WorkerLoop(dispatcher_workerPool_t *const pPool,
+                              uint8_t worker,
+                              uint16_t maxEvents,
+                              uint16_t *pProcessed);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif //__DISPATCHER_H__
\ No newline at end of file
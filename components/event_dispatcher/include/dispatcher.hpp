@@ -0,0 +1,331 @@
+/*! \file   dispatcher.hpp
+    \brief  This file cotains the header only C++17 dispatcher template.
+
+    Details.
+    dispatcher::Dispatcher<Capacity, Events...> is a typed front end of the
+    C queue backends. The queue slot size and the queue storage are computed
+    from the event types at compile time, every slot holds a
+    dispatcher_eventBase_t whose signal is DISPATCHER_SIGNAL_USER plus the
+    index of the event type in Events, followed by the event itself (a
+    tagged union of the event types). The event loop is a template of the
+    handler type, every signal calls the On overload of the handler for its
+    event type, resolved and inlinable at compile time instead of the call
+    through the active state handler pointer of the C dispatcher.
+
+    Events are plain structures without a dispatcher_eventBase_t member,
+    trivially copyable as the queue copies them as bytes. Transitions,
+    hierarchical states, deferral, time events, lanes and the overflow
+    policies stay with the C dispatcher.
+    \example
+    \code{cpp}
+             struct Press { uint8_t button; };
+             struct Tick { uint32_t now; };
+
+             struct Led
+             {
+                 void On(Press const &event);
+                 uint8_t On(Tick const &event); // returns DISPATCHER_SM_STATUS_xxx
+             };
+
+             static dispatcher::Dispatcher<16, Press, Tick> gDispatcher;
+             static Led gLed;
+
+             gDispatcher.Init();
+             gDispatcher.Post(Press{1});
+             gDispatcher.EventLoop(gLed);
+    \endcode
+*/
+
+#ifndef __DISPATCHER_HPP__
+#define __DISPATCHER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <dispatcher.h>
+
+namespace dispatcher
+{
+
+namespace detail
+{
+
+/* index of E in Events, sizeof...(Events) when E is not one of them. */
+template <typename E, typename... Events>
+struct IndexOf : std::integral_constant<std::size_t, 0>
+{
+};
+
+template <typename E, typename First, typename... Rest>
+struct IndexOf<E, First, Rest...>
+    : std::integral_constant<std::size_t, std::is_same<E, First>::value ? 0 : 1 + IndexOf<E, Rest...>::value>
+{
+};
+
+template <typename... Events>
+constexpr std::size_t MaxSize()
+{
+    std::size_t size = 0;
+
+    ((size = (sizeof(Events) > size) ? sizeof(Events) : size), ...);
+    return size;
+}
+
+/* true when Handler has an On overload taking E. */
+template <typename Handler, typename E, typename = void>
+struct HasOn : std::false_type
+{
+};
+
+template <typename Handler, typename E>
+struct HasOn<Handler, E, std::void_t<decltype(std::declval<Handler &>().On(std::declval<E const &>()))>>
+    : std::true_type
+{
+};
+
+} // namespace detail
+
+/*! \class  BasicDispatcher
+    \brief  Typed dispatcher on the Type queue backend, holding up to
+            Capacity events of the Events types.
+*/
+template <dispatcher_queueType_t Type, std::size_t Capacity, typename... Events>
+class BasicDispatcher
+{
+public:
+    /*! \struct  Slot
+        \brief   Queue slot, the signal tags the event type in payload.
+    */
+    struct Slot
+    {
+        dispatcher_eventBase_t base;                                  /*!< Element contains tag signal. */
+        alignas(Events...) unsigned char payload[detail::MaxSize<Events...>()]; /*!< Element contains event. */
+    };
+
+    static_assert(sizeof...(Events) > 0, "dispatcher needs at least one event type");
+    static_assert((std::is_trivially_copyable<Events>::value && ...), "events are copied as bytes by the queue");
+    static_assert(DISPATCHER_SIGNAL_USER + sizeof...(Events) <= UINT16_MAX, "too many event types");
+    static_assert(sizeof(Slot) <= UINT16_MAX, "event too large for a queue slot");
+    static_assert(Capacity > 0 && Capacity <= UINT16_MAX, "invalid capacity");
+    static_assert(Type == DISPATCHER_QUEUE_TYPE_DEFAULT || Type == DISPATCHER_QUEUE_TYPE_VARIABLE ||
+                      (Capacity & (Capacity - 1)) == 0,
+                  "spsc / mpsc ring capacity must be a power of two");
+    static_assert(Type == DISPATCHER_QUEUE_TYPE_DEFAULT || alignof(Slot) <= DISPATCHER_QUEUE_ALIGN,
+                  "ring slots are DISPATCHER_QUEUE_ALIGN aligned, raise it for these events");
+
+    /*! \var    kStorageSize
+        \brief  Size of the queue storage held by the dispatcher.
+    */
+    static constexpr uint32_t kStorageSize = DISPATCHER_QUEUE_STORAGE_SIZE(Type, sizeof(Slot), Capacity);
+
+    BasicDispatcher() = default;
+
+    // after Init the queue points into this object, a copy would share or lose it
+    BasicDispatcher(BasicDispatcher const &) = delete;
+    BasicDispatcher(BasicDispatcher &&) = delete;
+    BasicDispatcher &operator=(BasicDispatcher const &) = delete;
+    BasicDispatcher &operator=(BasicDispatcher &&) = delete;
+
+    /*! \fn   template <typename E> static constexpr dispatcher_eventSignal_t Signal().
+        \brief  Signal of an event type.
+        \return dispatcher_eventSignal_t DISPATCHER_SIGNAL_USER plus the
+                index of E in Events.
+    */
+    template <typename E>
+    static constexpr dispatcher_eventSignal_t Signal()
+    {
+        static_assert(detail::IndexOf<E, Events...>::value < sizeof...(Events), "not an event of this dispatcher");
+        return static_cast<dispatcher_eventSignal_t>(DISPATCHER_SIGNAL_USER + detail::IndexOf<E, Events...>::value);
+    }
+
+    /*! \fn   uint8_t Init().
+        \brief  Initialize the queue in the dispatcher storage.
+        \return uint8_t any values except DISPATCHER_ERR_CLEAR represents
+                failour.
+    */
+    uint8_t Init()
+    {
+        if (dispatcher_WaiterInit(&waiter_) != DISPATCHER_PORT_OK ||
+            dispatcher_QueueInit(&queue_, Type, static_cast<uint16_t>(sizeof(Slot)), static_cast<uint16_t>(Capacity),
+                                 storage_, &waiter_) != DISPATCHER_PORT_OK)
+        {
+            return DISPATCHER_ERR_NOT_INITIALIZED;
+        }
+        return DISPATCHER_ERR_CLEAR;
+    }
+
+    /*! \fn   template <typename E> uint8_t Post(E const &event, uint32_t timeoutMs).
+        \brief  Copy an event to the back of the queue, ring backends build
+                it in place in the reserved slot.
+        \param event event, one of the Events types.
+        \param timeoutMs max wait for free space in milliseconds,
+                         DISPATCHER_WAIT_FOREVER.
+        \return uint8_t DISPATCHER_ERR_QUEUE_FULL on timeout, any other
+                values except DISPATCHER_ERR_CLEAR represents failour.
+    */
+    template <typename E>
+    uint8_t Post(E const &event, uint32_t timeoutMs = DISPATCHER_POST_TIMEOUT_MS)
+    {
+        if (!dispatcher_QueueIsValid(&queue_))
+        {
+            return DISPATCHER_ERR_NOT_INITIALIZED;
+        }
+
+        if constexpr (Type == DISPATCHER_QUEUE_TYPE_SPSC || Type == DISPATCHER_QUEUE_TYPE_MPSC)
+        {
+            void *pItem = nullptr;
+            dispatcher_portStatus_t state = dispatcher_QueueReserve(&queue_, &pItem, Ticks(timeoutMs));
+
+            if (state != DISPATCHER_PORT_OK)
+            {
+                return Error(state);
+            }
+            Fill(*static_cast<Slot *>(pItem), event);
+            dispatcher_QueueCommit(&queue_, pItem);
+            return DISPATCHER_ERR_CLEAR;
+        }
+        else
+        {
+            Slot slot;
+
+            Fill(slot, event);
+            return Error(dispatcher_QueueSendSized(&queue_, &slot, Size<E>(), Ticks(timeoutMs)));
+        }
+    }
+
+    /*! \fn   template <typename E> uint8_t PostFromIsr(E const &event, int *pWoken).
+        \brief  Copy an event to the back of the queue from ISR, never blocks.
+        \param event event, one of the Events types.
+        \param pWoken set to non zero if a higher priority task was woken.
+        \return uint8_t DISPATCHER_ERR_QUEUE_FULL on a full queue, any other
+                values except DISPATCHER_ERR_CLEAR represents failour.
+    */
+    template <typename E>
+    uint8_t PostFromIsr(E const &event, int *pWoken)
+    {
+        if (!dispatcher_QueueIsValid(&queue_))
+        {
+            return DISPATCHER_ERR_NOT_INITIALIZED;
+        }
+
+        Slot slot;
+
+        Fill(slot, event);
+        return Error(dispatcher_QueueSendSizedFromIsr(&queue_, &slot, Size<E>(), pWoken));
+    }
+
+    /*! \fn   template <typename Handler> uint8_t EventLoop(Handler &handler, uint32_t timeoutMs).
+        \brief  Wait for the oldest event and call handler.On with it, in
+                place in the slot for ring backends. Events handler has no
+                On overload for are ignored.
+        \param handler object with On(E const &) overloads returning void
+                       (handled) or a dispatcher_smStatus_t value.
+        \param timeoutMs max wait for an event in milliseconds,
+                         DISPATCHER_WAIT_FOREVER.
+        \return uint8_t DISPATCHER_ERR_QUEUE_EMPTY on timeout, any other
+                values except DISPATCHER_ERR_CLEAR represents failour.
+        \warning Should only be called from one context, the consumer.
+    */
+    template <typename Handler>
+    uint8_t EventLoop(Handler &handler, uint32_t timeoutMs = DISPATCHER_WAIT_FOREVER)
+    {
+        void *pItem = nullptr;
+
+        if (!dispatcher_QueueIsValid(&queue_))
+        {
+            return DISPATCHER_ERR_NOT_INITIALIZED;
+        }
+
+        if (dispatcher_QueueAcquire(&queue_, &slot_, &pItem, Ticks(timeoutMs)) != DISPATCHER_PORT_OK)
+        {
+            return DISPATCHER_ERR_QUEUE_EMPTY;
+        }
+        (void)Dispatch(handler, *static_cast<Slot const *>(pItem), std::index_sequence_for<Events...>{});
+        dispatcher_QueueRelease(&queue_);
+        return DISPATCHER_ERR_CLEAR;
+    }
+
+private:
+    static dispatcher_portTick_t Ticks(uint32_t timeoutMs)
+    {
+        return (timeoutMs == DISPATCHER_WAIT_FOREVER) ? DISPATCHER_PORT_MAX_DELAY
+                                                     : DISPATCHER_PORT_MS_TO_TICKS(timeoutMs);
+    }
+
+    static uint8_t Error(dispatcher_portStatus_t state)
+    {
+        if (state == DISPATCHER_PORT_OK)
+        {
+            return DISPATCHER_ERR_CLEAR;
+        }
+        return (state == DISPATCHER_PORT_FULL) ? DISPATCHER_ERR_QUEUE_FULL : DISPATCHER_ERR_PROCESS_FAIL;
+    }
+
+    /* bytes of a slot holding E, the variable size ring only stores those. */
+    template <typename E>
+    static constexpr uint16_t Size()
+    {
+        return (Type == DISPATCHER_QUEUE_TYPE_VARIABLE) ? static_cast<uint16_t>(offsetof(Slot, payload) + sizeof(E))
+                                                        : static_cast<uint16_t>(sizeof(Slot));
+    }
+
+    template <typename E>
+    static void Fill(Slot &slot, E const &event)
+    {
+        slot.base.sig = Signal<E>();
+        (void)::new (static_cast<void *>(slot.payload)) E(event);
+    }
+
+    template <typename E, typename Handler>
+    static uint8_t Handle(Handler &handler, Slot const &slot)
+    {
+        if constexpr (detail::HasOn<Handler, E>::value)
+        {
+            E const &event = *std::launder(reinterpret_cast<E const *>(slot.payload));
+
+            if constexpr (std::is_void<decltype(handler.On(event))>::value)
+            {
+                handler.On(event);
+                return DISPATCHER_SM_STATUS_HANDLED;
+            }
+            else
+            {
+                return static_cast<uint8_t>(handler.On(event));
+            }
+        }
+        else
+        {
+            (void)handler;
+            (void)slot;
+            return DISPATCHER_SM_STATUS_IGNORED;
+        }
+    }
+
+    /* one compare per event type, folded into a switch by the compiler. */
+    template <typename Handler, std::size_t... I>
+    static uint8_t Dispatch(Handler &handler, Slot const &slot, std::index_sequence<I...>)
+    {
+        uint8_t status = DISPATCHER_SM_STATUS_IGNORED;
+
+        (void)((slot.base.sig == DISPATCHER_SIGNAL_USER + I && ((status = Handle<Events>(handler, slot)), true)) ||
+               ...);
+        return status;
+    }
+
+    alignas(DISPATCHER_QUEUE_ALIGN) uint8_t storage_[kStorageSize];
+    dispatcher_queue_t queue_{}; /* zero until Init, dispatcher_QueueIsValid is false. */
+    dispatcher_waiter_t waiter_;
+    Slot slot_; /* port backend copy of the acquired event. */
+};
+
+/*! \typedef    template <std::size_t Capacity, typename... Events> using Dispatcher
+    \brief      Typed dispatcher on the mpsc ring.
+*/
+template <std::size_t Capacity, typename... Events>
+using Dispatcher = BasicDispatcher<DISPATCHER_QUEUE_TYPE_MPSC, Capacity, Events...>;
+
+} // namespace dispatcher
+
+#endif //__DISPATCHER_HPP__
@@ -0,0 +1,93 @@
+/*! \file   dispatcher_log.h
+    \brief  This file cotains the record and formatter of deferred logging.
+
+    Details.
+    A deferred log call only stores the log level, a tick timestamp, the
+    tag and format string pointers and the raw arguments. Formatting is
+    done later by the context draining the records, so both strings must
+    outlive the record (string literals, static storage) and every argument
+    must fit an uintptr_t : integers of up to 32 bits, pointers and %s of
+    static strings (pointers need an uintptr_t cast).
+*/
+
+#ifndef __DISPATCHER_LOG_H__
+#define __DISPATCHER_LOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    DISPATCHER_LOG_LEVEL_ERROR
+    \brief  Error log level, the lowest level.
+*/
+#define DISPATCHER_LOG_LEVEL_ERROR (1)
+
+/*! \def    DISPATCHER_LOG_LEVEL_INFO
+    \brief  Info log level.
+*/
+#define DISPATCHER_LOG_LEVEL_INFO (2)
+
+/*! \def    DISPATCHER_LOG_LEVEL_DEBUG
+    \brief  Debug log level, the highest level.
+*/
+#define DISPATCHER_LOG_LEVEL_DEBUG (3)
+
+/*! \def    DISPATCHER_LOG_MAX_ARGS
+    \brief  Max number of arguments kept by a deferred log record, further
+            arguments are dropped.
+*/
+#if !defined(DISPATCHER_LOG_MAX_ARGS)
+#define DISPATCHER_LOG_MAX_ARGS (4)
+#endif
+
+/*! \def    DISPATCHER_LOG_LINE_SIZE
+    \brief  Size of the buffer a deferred log record is formatted into.
+*/
+#if !defined(DISPATCHER_LOG_LINE_SIZE)
+#define DISPATCHER_LOG_LINE_SIZE (128)
+#endif
+
+/*! \struct  dispatcher_logRecord_t
+    \brief   One deferred log call.
+*/
+typedef struct
+{
+    dispatcher_portTick_t tick;             /*!< Element contains tick of the call. */
+    uint8_t level;                          /*!< Element contains DISPATCHER_LOG_LEVEL_xxx value. */
+    uint8_t argCount;                       /*!< Element contains number of arguments kept. */
+    char const *tag;                        /*!< Element contains tag string. */
+    char const *format;                     /*!< Element contains format string. */
+    uintptr_t args[DISPATCHER_LOG_MAX_ARGS]; /*!< Element contains raw arguments. */
+} dispatcher_logRecord_t;
+
+/*! \typedef    typedef void (*dispatcher_logSink_t)(uint8_t level, char const *pLine, void *pArg)
+    \brief      Output of formatted deferred log lines.
+*/
+typedef void (*dispatcher_logSink_t)(uint8_t level, char const *pLine, void *pArg);
+
+/*! \fn   uint32_t dispatcher_LogFormat(dispatcher_logRecord_t const *const pRecord,
+                                        char *const pBuffer,
+                                        uint32_t size).
+    \brief  Format a record as "L (tick) tag: message", the layout of the
+            port log functions. Conversions d i u x X o c s p with flags,
+            width, precision and h / l length modifiers are supported,
+            missing arguments print as 0.
+    \param pRecord Pointer to record.
+    \param pBuffer Pointer to line buffer.
+    \param size size of the line buffer, a longer line is truncated.
+    \return uint32_t length of the line.
+*/
+uint32_t dispatcher_LogFormat(dispatcher_logRecord_t const *const pRecord,
+                              char *const pBuffer,
+                              uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_LOG_H__
@@ -0,0 +1,143 @@
+/*! \file   dispatcher_pool.h
+    \brief  This file cotains the fixed block event pools used by dispatcher.
+
+    Details.
+    A pool hands out fixed size blocks from caller supplied storage. Blocks
+    carry a reference count, the block goes back to its pool when the last
+    reference is released, so one event can be queued to many dispatchers
+    by pointer instead of being copied into every queue.
+    Allocation and release are lock free (a tagged free list), both are
+    safe from tasks and ISRs.
+*/
+
+#ifndef __DISPATCHER_POOL_H__
+#define __DISPATCHER_POOL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    DISPATCHER_POOL_ALIGN
+    \brief  Alignment of pool blocks, pool storage must be aligned to it.
+*/
+#if !defined(DISPATCHER_POOL_ALIGN)
+#define DISPATCHER_POOL_ALIGN (8)
+#endif
+
+/*! \def    DISPATCHER_POOL_ALIGN_UP(size)
+    \brief  Round a size up to DISPATCHER_POOL_ALIGN.
+*/
+#define DISPATCHER_POOL_ALIGN_UP(size) \
+    (((uint32_t)(size) + (DISPATCHER_POOL_ALIGN - 1u)) & ~(uint32_t)(DISPATCHER_POOL_ALIGN - 1u))
+
+/*! \def    DISPATCHER_POOL_NIL
+    \brief  Block index marking the end of the free list.
+*/
+#define DISPATCHER_POOL_NIL (0xFFFFu)
+
+/*! \typedef    typedef dispatcher_tagPool dispatcher_pool_t
+    \brief      A type definition for dispatcher_tagPool.
+*/
+typedef struct dispatcher_tagPool dispatcher_pool_t;
+
+/*! \struct  dispatcher_poolBlock_t
+    \brief   Header in front of every pool block, the event follows it.
+*/
+typedef struct
+{
+    dispatcher_pool_t *pPool; /*!< Element contains owning pool. */
+    uint32_t refCount;        /*!< Element contains number of references, 0 while free. */
+    uint16_t next;            /*!< Element contains next free block index. */
+    uint16_t index;           /*!< Element contains own block index. */
+} dispatcher_poolBlock_t;
+
+/*! \def    DISPATCHER_POOL_HEADER_SIZE
+    \brief  Size of the block header, the event starts this many bytes
+            into the block.
+*/
+#define DISPATCHER_POOL_HEADER_SIZE DISPATCHER_POOL_ALIGN_UP(sizeof(dispatcher_poolBlock_t))
+
+/*! \def    DISPATCHER_POOL_STORAGE_SIZE(blockSize, blockCount)
+    \brief  Size in bytes of the storage buffer of a pool with blockCount
+            events of up to blockSize bytes.
+    \example
+    \code{c}
+             static uint8_t pgPoolStorage[DISPATCHER_POOL_STORAGE_SIZE(sizeof(bigEvent_t), 8)]
+                 __attribute__((aligned(DISPATCHER_POOL_ALIGN)));
+    \endcode
+*/
+#define DISPATCHER_POOL_STORAGE_SIZE(blockSize, blockCount) \
+    ((uint32_t)(blockCount) * (DISPATCHER_POOL_HEADER_SIZE + DISPATCHER_POOL_ALIGN_UP(blockSize)))
+
+/*! \struct  dispatcher_tagPool
+    \brief   Fixed block pool. The free list head packs a modification tag
+             in the upper half and the first free block index in the lower
+             half, so a block freed and allocated again between a read
+             and the compare and swap is detected.
+*/
+struct dispatcher_tagPool
+{
+    uint32_t freeHead DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains tag and first free block. */
+    uint16_t blockSize;  /*!< Element contains max event size of a block. */
+    uint16_t blockCount; /*!< Element contains number of blocks. */
+    uint32_t stride;     /*!< Element contains distance between two blocks in storage. */
+    uint8_t *storage;    /*!< Element contains block storage buffer. */
+};
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PoolInit(dispatcher_pool_t *const pPool,
+                                                 uint16_t blockSize,
+                                                 uint16_t blockCount,
+                                                 uint8_t *storage).
+    \brief  Initialize a pool, all blocks start free.
+    \param pPool Pointer to pool.
+    \param blockSize max event size in bytes.
+    \param blockCount number of blocks, less than DISPATCHER_POOL_NIL.
+    \param storage Pointer to a buffer of DISPATCHER_POOL_STORAGE_SIZE bytes
+                   aligned to DISPATCHER_POOL_ALIGN.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_OK on success.
+*/
+dispatcher_portStatus_t dispatcher_PoolInit(dispatcher_pool_t *const pPool,
+                                            uint16_t blockSize,
+                                            uint16_t blockCount,
+                                            uint8_t *storage);
+
+/*! \fn   void *dispatcher_PoolAlloc(dispatcher_pool_t *const pPool).
+    \brief  Take a free block, the caller owns its single reference.
+    \param pPool Pointer to pool.
+    \return void* Pointer to the event area of the block, NULL if the pool
+            is empty.
+*/
+void *dispatcher_PoolAlloc(dispatcher_pool_t *const pPool);
+
+/*! \fn   void dispatcher_PoolRetain(void *const pEvent).
+    \brief  Add a reference to a block.
+    \param pEvent Pointer returned by dispatcher_PoolAlloc.
+*/
+void dispatcher_PoolRetain(void *const pEvent);
+
+/*! \fn   bool dispatcher_PoolRelease(void *const pEvent).
+    \brief  Drop a reference to a block, the block goes back to its pool
+            with the last one.
+    \param pEvent Pointer returned by dispatcher_PoolAlloc.
+    \return bool true if the block was freed.
+*/
+bool dispatcher_PoolRelease(void *const pEvent);
+
+/*! \fn   uint16_t dispatcher_PoolFreeCount(dispatcher_pool_t const *const pPool).
+    \brief  Count free blocks, only a snapshot while other contexts
+            allocate or release.
+    \param pPool Pointer to pool.
+    \return uint16_t number of free blocks.
+*/
+uint16_t dispatcher_PoolFreeCount(dispatcher_pool_t const *const pPool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_POOL_H__
@@ -0,0 +1,411 @@
+/*! \file   dispatcher_port.h
+    \brief  This file cotains the operating system port layer used by dispatcher.
+
+    Details.
+    Dispatcher never calls the RTOS directly, every queue,logging and tick
+    operation goes through the functions declared here. Two backends are
+    provided :
+    - DISPATCHER_PORT_FREERTOS : esp-idf / free-rtos (port/freertos).
+    - DISPATCHER_PORT_LINUX    : native host build on pthreads (port/linux).
+    When no backend is selected by the build system, free-rtos is used for
+    esp-idf builds and linux for everything else.
+*/
+
+#ifndef __DISPATCHER_PORT_H__
+#define __DISPATCHER_PORT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if !defined(DISPATCHER_PORT_FREERTOS) && !defined(DISPATCHER_PORT_LINUX)
+#if defined(ESP_PLATFORM)
+#define DISPATCHER_PORT_FREERTOS
+#else
+#define DISPATCHER_PORT_LINUX
+#endif
+#endif
+
+#if defined(DISPATCHER_PORT_FREERTOS)
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <stdio.h>
+#elif defined(DISPATCHER_PORT_LINUX)
+#include <stdio.h>
+#include <pthread.h>
+#else
+#error "dispatcher : unsupported port"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*--------------------------TICKS------------------------*/
+
+/*! \typedef    typedef uint32_t dispatcher_portTick_t
+    \brief      Represents port tick type used for timeouts.
+*/
+typedef uint32_t dispatcher_portTick_t;
+
+#if defined(DISPATCHER_PORT_FREERTOS)
+
+/*! \def    DISPATCHER_PORT_MAX_DELAY
+    \brief  Timeout value representing wait forever.
+*/
+#define DISPATCHER_PORT_MAX_DELAY ((dispatcher_portTick_t)portMAX_DELAY)
+
+/*! \def    DISPATCHER_PORT_MS_TO_TICKS(ms)
+    \brief  Converts milliseconds to port ticks.
+*/
+#define DISPATCHER_PORT_MS_TO_TICKS(ms) ((dispatcher_portTick_t)pdMS_TO_TICKS(ms))
+
+#else
+
+#define DISPATCHER_PORT_MAX_DELAY ((dispatcher_portTick_t)UINT32_MAX)
+
+/* host port runs a 1 kHz tick. */
+#define DISPATCHER_PORT_MS_TO_TICKS(ms) ((dispatcher_portTick_t)(ms))
+
+#endif
+
+/*--------------------------LOGGING----------------------*/
+
+#if defined(DISPATCHER_PORT_FREERTOS)
+
+/*! \def    DISPATCHER_PORT_LOG_INFO(tag, format, ...)
+    \brief  Port log function in info level.
+*/
+#define DISPATCHER_PORT_LOG_INFO(tag, format, ...) ESP_LOGI(tag, format, ##__VA_ARGS__)
+
+/*! \def    DISPATCHER_PORT_LOG_ERROR(tag, format, ...)
+    \brief  Port log function in error level.
+*/
+#define DISPATCHER_PORT_LOG_ERROR(tag, format, ...) ESP_LOGE(tag, format, ##__VA_ARGS__)
+
+/*! \def    DISPATCHER_PORT_LOG_DEBUG(tag, format, ...)
+    \brief  Port log function in debug level.
+*/
+#define DISPATCHER_PORT_LOG_DEBUG(tag, format, ...) ESP_LOGD(tag, format, ##__VA_ARGS__)
+
+/*! \def    DISPATCHER_PORT_LOG_LINE(line)
+    \brief  Port output of an already formatted log line.
+*/
+#define DISPATCHER_PORT_LOG_LINE(line) (void)printf("%s\n", line)
+
+#else
+
+#define DISPATCHER_PORT_LOG_INFO(tag, format, ...) \
+    (void)fprintf(stderr, "I (%u) %s: " format "\n", (unsigned)dispatcher_PortGetTick(), tag, ##__VA_ARGS__)
+
+#define DISPATCHER_PORT_LOG_ERROR(tag, format, ...) \
+    (void)fprintf(stderr, "E (%u) %s: " format "\n", (unsigned)dispatcher_PortGetTick(), tag, ##__VA_ARGS__)
+
+#define DISPATCHER_PORT_LOG_DEBUG(tag, format, ...) \
+    (void)fprintf(stderr, "D (%u) %s: " format "\n", (unsigned)dispatcher_PortGetTick(), tag, ##__VA_ARGS__)
+
+#define DISPATCHER_PORT_LOG_LINE(line) (void)fprintf(stderr, "%s\n", line)
+
+#endif
+
+/*--------------------------QUEUE------------------------*/
+
+/*! \enum   dispatcher_portStatus_t
+    \brief  Enum represenst result of a port operation.
+*/
+typedef enum
+{
+    DISPATCHER_PORT_OK = 0, /*!< Value representing success. */
+    DISPATCHER_PORT_FULL,   /*!< Value representing queue full (timeout expired). */
+    DISPATCHER_PORT_EMPTY,  /*!< Value representing queue empty (timeout expired). */
+    DISPATCHER_PORT_FAIL,   /*!< Value representing generic failour. */
+} dispatcher_portStatus_t;
+
+/*! \struct  dispatcher_portQueue_t
+    \brief   Port queue object, a fixed size item fifo which
+             lives in caller supplied storage.
+*/
+#if defined(DISPATCHER_PORT_FREERTOS)
+typedef struct
+{
+    QueueHandle_t handle;  /*!< Element contains queue handle. */
+    StaticQueue_t storage; /*!< Element contains queue stack. */
+    uint16_t itemSize;     /*!< Element contains size of an item. */
+} dispatcher_portQueue_t;
+#else
+typedef struct
+{
+    pthread_mutex_t lock;      /*!< Element contains queue lock. */
+    pthread_cond_t notEmpty;   /*!< Element contains consumer condition. */
+    pthread_cond_t notFull;    /*!< Element contains producer condition. */
+    uint8_t *storage;          /*!< Element contains item storage buffer. */
+    uint16_t itemSize;         /*!< Element contains size of an item. */
+    uint16_t itemCount;        /*!< Element contains max number of items. */
+    uint16_t head;             /*!< Element contains index of oldest item. */
+    uint16_t count;            /*!< Element contains number of queued items. */
+} dispatcher_portQueue_t;
+#endif
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueCreate(dispatcher_portQueue_t *const pQueue,
+                                                        uint16_t itemSize,
+                                                        uint16_t itemCount,
+                                                        uint8_t *storage).
+    \brief  Create a queue in caller supplied storage.
+    \param pQueue Pointer to port queue object.
+    \param itemSize size of an item in bytes.
+    \param itemCount max number of items.
+    \param storage Pointer to a buffer of itemSize * itemCount bytes.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_OK on success.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueCreate(dispatcher_portQueue_t *const pQueue,
+                                                   uint16_t itemSize,
+                                                   uint16_t itemCount,
+                                                   uint8_t *storage);
+
+/*! \fn   bool dispatcher_PortQueueIsValid(dispatcher_portQueue_t const *const pQueue).
+    \brief  Check a queue was created.
+    \param pQueue Pointer to port queue object.
+    \return bool true if queue is created.
+*/
+bool dispatcher_PortQueueIsValid(dispatcher_portQueue_t const *const pQueue);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueSend(dispatcher_portQueue_t *const pQueue,
+                                                      void const *const pItem,
+                                                      dispatcher_portTick_t timeout).
+    \brief  Copy an item to the back of the queue.
+    \param pQueue Pointer to port queue object.
+    \param pItem Pointer to item.
+    \param timeout max ticks to wait for free space.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL on timeout.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueSend(dispatcher_portQueue_t *const pQueue,
+                                                 void const *const pItem,
+                                                 dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueSendFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                             void const *const pItem,
+                                                             int *pWoken).
+    \brief  Copy an item to the back of the queue from ISR, never blocks.
+    \param pQueue Pointer to port queue object.
+    \param pItem Pointer to item.
+    \param pWoken set to non zero if a higher priority task was woken.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no space.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueSendFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                        void const *const pItem,
+                                                        int *pWoken);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueSendBatch(dispatcher_portQueue_t *const pQueue,
+                                                           void const *const pItems,
+                                                           uint16_t count,
+                                                           dispatcher_portTick_t timeout,
+                                                           uint16_t *pSent).
+    \brief  Copy consecutive items to the back of the queue, waits for
+            space for the first item only and then copies as many as fit.
+            The consumer is woken once for the whole batch.
+    \param pQueue Pointer to port queue object.
+    \param pItems Pointer to count items stored back to back.
+    \param count number of items.
+    \param timeout max ticks to wait for free space.
+    \param pSent set to number of items copied.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no item was copied.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueSendBatch(dispatcher_portQueue_t *const pQueue,
+                                                      void const *const pItems,
+                                                      uint16_t count,
+                                                      dispatcher_portTick_t timeout,
+                                                      uint16_t *pSent);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueSendBatchFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                                  void const *const pItems,
+                                                                  uint16_t count,
+                                                                  uint16_t *pSent,
+                                                                  int *pWoken).
+    \brief  Copy as many consecutive items as fit from ISR, never blocks.
+    \param pQueue Pointer to port queue object.
+    \param pItems Pointer to count items stored back to back.
+    \param count number of items.
+    \param pSent set to number of items copied.
+    \param pWoken set to non zero if a higher priority task was woken.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no item was copied.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueSendBatchFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                             void const *const pItems,
+                                                             uint16_t count,
+                                                             uint16_t *pSent,
+                                                             int *pWoken);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueReceive(dispatcher_portQueue_t *const pQueue,
+                                                         void *const pItem,
+                                                         dispatcher_portTick_t timeout).
+    \brief  Copy the oldest item out of the queue.
+    \param pQueue Pointer to port queue object.
+    \param pItem Pointer to item buffer.
+    \param timeout max ticks to wait for an item.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY on timeout.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueReceive(dispatcher_portQueue_t *const pQueue,
+                                                    void *const pItem,
+                                                    dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortQueueEvict(dispatcher_portQueue_t *const pQueue,
+                                                       void *const pItem,
+                                                       uint16_t size,
+                                                       int *pWoken).
+    \brief  Drop the oldest item from the producer side, never blocks. Only
+            its first size bytes are copied out. Safe from ISR. Fails for
+            queues of items larger than DISPATCHER_PORT_EVICT_ITEM_MAX.
+    \param pQueue Pointer to port queue object.
+    \param pItem Pointer to a buffer of size bytes.
+    \param size number of bytes to copy, at most the item size.
+    \param pWoken set to non zero if a higher priority task was woken, may be NULL.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY if the queue is empty,
+            DISPATCHER_PORT_FAIL if the items are too large.
+*/
+dispatcher_portStatus_t dispatcher_PortQueueEvict(dispatcher_portQueue_t *const pQueue,
+                                                  void *const pItem,
+                                                  uint16_t size,
+                                                  int *pWoken);
+
+/*! \fn   uint32_t dispatcher_PortQueueCount(dispatcher_portQueue_t *const pQueue).
+    \brief  Number of items waiting in the queue.
+    \param pQueue Pointer to port queue object.
+    \return uint32_t item count.
+    \warning Should not be called in ISR.
+*/
+uint32_t dispatcher_PortQueueCount(dispatcher_portQueue_t *const pQueue);
+
+/*--------------------------SIGNAL-----------------------*/
+
+/*! \struct  dispatcher_portSignal_t
+    \brief   Port signal object, a binary semaphore used to put a consumer
+             to sleep until a producer notifies it. Notifications are not
+             counted, several notifies before a wait wake it only once.
+*/
+#if defined(DISPATCHER_PORT_FREERTOS)
+typedef struct
+{
+    SemaphoreHandle_t handle;  /*!< Element contains semaphore handle. */
+    StaticSemaphore_t storage; /*!< Element contains semaphore stack. */
+} dispatcher_portSignal_t;
+#else
+typedef struct
+{
+    uint32_t word; /*!< Element contains futex word, 1 when notified. */
+} dispatcher_portSignal_t;
+#endif
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortSignalCreate(dispatcher_portSignal_t *const pSignal).
+    \brief  Create a signal in non notified state.
+    \param pSignal Pointer to port signal object.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_OK on success.
+*/
+dispatcher_portStatus_t dispatcher_PortSignalCreate(dispatcher_portSignal_t *const pSignal);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_PortSignalWait(dispatcher_portSignal_t *const pSignal,
+                                                       dispatcher_portTick_t timeout).
+    \brief  Wait for a notification and consume it.
+    \param pSignal Pointer to port signal object.
+    \param timeout max ticks to wait.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY on timeout.
+*/
+dispatcher_portStatus_t dispatcher_PortSignalWait(dispatcher_portSignal_t *const pSignal,
+                                                  dispatcher_portTick_t timeout);
+
+/*! \fn   void dispatcher_PortSignalNotify(dispatcher_portSignal_t *const pSignal).
+    \brief  Notify a signal, wakes the waiting task if any.
+    \param pSignal Pointer to port signal object.
+*/
+void dispatcher_PortSignalNotify(dispatcher_portSignal_t *const pSignal);
+
+/*! \fn   void dispatcher_PortSignalNotifyFromIsr(dispatcher_portSignal_t *const pSignal, int *pWoken).
+    \brief  Notify a signal from ISR.
+    \param pSignal Pointer to port signal object.
+    \param pWoken set to non zero if a higher priority task was woken.
+*/
+void dispatcher_PortSignalNotifyFromIsr(dispatcher_portSignal_t *const pSignal, int *pWoken);
+
+/*--------------------------MISC-------------------------*/
+
+/*! \def    DISPATCHER_PORT_CACHE_LINE_SIZE
+    \brief  Cache line size used to keep producer and consumer data apart.
+*/
+#if !defined(DISPATCHER_PORT_CACHE_LINE_SIZE)
+#if defined(DISPATCHER_PORT_FREERTOS)
+#define DISPATCHER_PORT_CACHE_LINE_SIZE (32)
+#else
+#define DISPATCHER_PORT_CACHE_LINE_SIZE (64)
+#endif
+#endif
+
+/*! \def    DISPATCHER_PORT_CACHE_ALIGNED
+    \brief  Aligns a structure element to its own cache line.
+*/
+#define DISPATCHER_PORT_CACHE_ALIGNED __attribute__((aligned(DISPATCHER_PORT_CACHE_LINE_SIZE)))
+
+/*! \def    DISPATCHER_PORT_EVICT_ITEM_MAX
+    \brief  Largest item size dispatcher_PortQueueEvict supports. A free-rtos
+            queue only hands out whole items, the evicted item goes through a
+            buffer of this size on the stack of the producer (or the ISR).
+*/
+#if !defined(DISPATCHER_PORT_EVICT_ITEM_MAX)
+#if defined(DISPATCHER_PORT_FREERTOS)
+#define DISPATCHER_PORT_EVICT_ITEM_MAX (64u)
+#else
+#define DISPATCHER_PORT_EVICT_ITEM_MAX (UINT16_MAX)
+#endif
+#endif
+
+/*! \fn   void dispatcher_PortBackoff(uint32_t attempt).
+    \brief  Give the cpu away while polling a full lock free queue.
+    \param attempt number of failed attempts so far, used to grow the delay.
+*/
+void dispatcher_PortBackoff(uint32_t attempt);
+
+/*! \fn   dispatcher_portTick_t dispatcher_PortGetTick(void).
+    \brief  Get current tick count.
+    \return dispatcher_portTick_t tick count.
+*/
+dispatcher_portTick_t dispatcher_PortGetTick(void);
+
+/*! \fn   uint32_t dispatcher_PortCycles(void).
+    \brief  Free running cycle counter used to time handlers, cpu cycles
+            on esp-idf and x86 hosts, nanoseconds on other hosts. Only the
+            difference of two readings is meaningful.
+    \return uint32_t counter value.
+*/
+uint32_t dispatcher_PortCycles(void);
+
+/*! \fn   uint32_t dispatcher_PortCyclesPerUs(void).
+    \brief  dispatcher_PortCycles ticks per microsecond, used to turn trace
+            timestamps into time.
+    \return uint32_t ticks per microsecond.
+*/
+uint32_t dispatcher_PortCyclesPerUs(void);
+
+/*! \fn   uint64_t dispatcher_PortTimeUs(void).
+    \brief  Monotonic time in microseconds, used to time event recordings.
+    \return uint64_t microseconds since boot (esp-idf) or an arbitrary start.
+*/
+uint64_t dispatcher_PortTimeUs(void);
+
+/*! \fn   void dispatcher_PortSleepUs(uint32_t us).
+    \brief  Let the calling task sleep for at least us microseconds, what
+            is shorter than a tick is busy waited on esp-idf.
+    \param us microseconds to sleep.
+*/
+void dispatcher_PortSleepUs(uint32_t us);
+
+/*! \fn   void dispatcher_PortYieldFromIsr(int woken).
+    \brief  Request context switch on ISR exit.
+    \param woken value returned by dispatcher_PortQueueSendFromIsr.
+*/
+void dispatcher_PortYieldFromIsr(int woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_PORT_H__
@@ -0,0 +1,503 @@
+/*! \file   dispatcher_queue.h
+    \brief  This file cotains the event queue backends used by dispatcher.
+
+    Details.
+    A dispatcher queue is a fixed item size fifo living in caller supplied
+    storage. The backend is selected at initialization time :
+    - DISPATCHER_QUEUE_TYPE_DEFAULT : port queue (free-rtos queue on target).
+    - DISPATCHER_QUEUE_TYPE_SPSC    : lock free single producer / single
+                                      consumer ring.
+    - DISPATCHER_QUEUE_TYPE_MPSC    : lock free multi producer / single
+                                      consumer ring, every slot carries a
+                                      sequence number so producers only
+                                      contend on one index.
+    - DISPATCHER_QUEUE_TYPE_VARIABLE : lock free multi producer / single
+                                      consumer byte ring, every event only
+                                      takes its own (aligned) size plus a
+                                      length word.
+    Ring backends never block on the producer side hot path, the consumer
+    only falls back to a port signal (dispatcher_waiter_t) when it actually
+    has to sleep.
+*/
+
+#ifndef __DISPATCHER_QUEUE_H__
+#define __DISPATCHER_QUEUE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \enum   dispatcher_queueType_t
+    \brief  Enum represenst all queue backends.
+*/
+typedef enum
+{
+    DISPATCHER_QUEUE_TYPE_DEFAULT = 0, /*!< Value 0 representing port queue backend. */
+    DISPATCHER_QUEUE_TYPE_SPSC = 1,    /*!< Value 1 representing single producer ring backend. */
+    DISPATCHER_QUEUE_TYPE_MPSC = 2,    /*!< Value 2 representing multi producer ring backend. */
+    DISPATCHER_QUEUE_TYPE_VARIABLE = 3, /*!< Value 3 representing variable size ring backend. */
+    DISPATCHER_QUEUE_TYPE_MAX = 4,     /*!< Value 4 representing num of backends. */
+} dispatcher_queueType_t;
+
+/*! \def    DISPATCHER_QUEUE_ALIGN
+    \brief  Alignment of slots in sequenced and variable size ring backends,
+            queue storage must be aligned to it.
+*/
+#if !defined(DISPATCHER_QUEUE_ALIGN)
+#define DISPATCHER_QUEUE_ALIGN (4)
+#endif
+
+/*! \def    DISPATCHER_QUEUE_ALIGN_UP(size)
+    \brief  Round a size up to DISPATCHER_QUEUE_ALIGN.
+*/
+#define DISPATCHER_QUEUE_ALIGN_UP(size) \
+    (((uint32_t)(size) + (DISPATCHER_QUEUE_ALIGN - 1u)) & ~(uint32_t)(DISPATCHER_QUEUE_ALIGN - 1u))
+
+/*! \def    DISPATCHER_QUEUE_SLOT_SIZE(itemSize)
+    \brief  Size of a sequenced slot, a sequence word followed by the item.
+            Also the size of a variable size ring record holding itemSize
+            bytes (length word followed by the item).
+*/
+#define DISPATCHER_QUEUE_SLOT_SIZE(itemSize) \
+    (DISPATCHER_QUEUE_ALIGN_UP(sizeof(uint32_t)) + DISPATCHER_QUEUE_ALIGN_UP(itemSize))
+
+/*! \def    DISPATCHER_QUEUE_POW2(size)
+    \brief  Round a size of 1 to 2^31 bytes up to a power of two.
+*/
+#define DISPATCHER_QUEUE_POW2_OR(value, shift) ((value) | ((value) >> (shift)))
+#define DISPATCHER_QUEUE_POW2(size)                                                                     \
+    (DISPATCHER_QUEUE_POW2_OR(DISPATCHER_QUEUE_POW2_OR(DISPATCHER_QUEUE_POW2_OR(                        \
+         DISPATCHER_QUEUE_POW2_OR(DISPATCHER_QUEUE_POW2_OR((uint32_t)(size) - 1u, 1), 2), 4), 8), 16) + \
+     1u)
+
+/*! \def    DISPATCHER_QUEUE_VAR_CAPACITY(itemSize, itemCount)
+    \brief  Size in bytes of a variable size ring, room for itemCount
+            records of itemSize bytes rounded up to a power of two so the
+            free running ring positions keep mapping to the same bytes when
+            they wrap.
+*/
+#define DISPATCHER_QUEUE_VAR_CAPACITY(itemSize, itemCount) \
+    DISPATCHER_QUEUE_POW2((uint32_t)(itemCount) * DISPATCHER_QUEUE_SLOT_SIZE(itemSize))
+
+/*! \def    DISPATCHER_QUEUE_STORAGE_SIZE(type, itemSize, itemCount)
+    \brief  Size in bytes of the queue storage buffer a backend needs. For
+            DISPATCHER_QUEUE_TYPE_VARIABLE it holds at least itemCount
+            events of itemSize bytes (DISPATCHER_QUEUE_VAR_CAPACITY),
+            smaller events take less room.
+    \example
+    \code{c}
+             static uint8_t pgQueueStorage[DISPATCHER_QUEUE_STORAGE_SIZE(DISPATCHER_QUEUE_TYPE_MPSC,
+                                                                         QUEUE_ITEM_SIZE,
+                                                                         QUEUE_ITEM_COUNT)]
+                 __attribute__((aligned(DISPATCHER_QUEUE_ALIGN)));
+    \endcode
+*/
+#define DISPATCHER_QUEUE_STORAGE_SIZE(type, itemSize, itemCount)  \
+    (((type) == DISPATCHER_QUEUE_TYPE_VARIABLE)                   \
+         ? DISPATCHER_QUEUE_VAR_CAPACITY(itemSize, itemCount)     \
+     : ((type) == DISPATCHER_QUEUE_TYPE_MPSC)                     \
+         ? ((uint32_t)(itemCount) * DISPATCHER_QUEUE_SLOT_SIZE(itemSize)) \
+         : ((uint32_t)(itemCount) * (uint32_t)(itemSize)))
+
+/*! \struct  dispatcher_waiter_t
+    \brief   Sleep / wake object of a consumer. Producers only touch the
+             port signal when the consumer announced it is going to sleep.
+*/
+typedef struct
+{
+    dispatcher_portSignal_t signal; /*!< Element contains port signal. */
+    uint32_t sleeping;              /*!< Element contains non zero while consumer sleeps. */
+    uint32_t ready;                 /*!< Element contains bitmap of lanes that may hold items. */
+} dispatcher_waiter_t;
+
+/*! \struct  dispatcher_spsc_t
+    \brief   Single producer / single consumer ring indices. Both indices
+             are free running, producer and consumer data live on
+             separate cache lines.
+*/
+typedef struct
+{
+    uint32_t head DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains producer index. */
+    uint32_t tailCache;                          /*!< Element contains producer copy of tail. */
+    uint32_t tail DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains consumer index. */
+    uint32_t headCache;                          /*!< Element contains consumer copy of head. */
+} dispatcher_spsc_t;
+
+/*! \struct  dispatcher_mpsc_t
+    \brief   Multi producer / single consumer ring indices. Producers
+             claim a slot with a compare and swap on enqueue, the slot
+             sequence tells the consumer when the item is published. The
+             consumer claims the oldest slot with a compare and swap on
+             dequeue too, so producers can evict the oldest item.
+*/
+typedef struct
+{
+    uint32_t enqueue DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains producers index. */
+    uint32_t dequeue DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains index of the oldest unclaimed item. */
+    uint32_t taken;                                 /*!< Element contains index of the item held by consumer. */
+    uint32_t held;                                  /*!< Element contains non zero while consumer holds an item. */
+} dispatcher_mpsc_t;
+
+/*! \struct  dispatcher_var_t
+    \brief   Variable size ring indices. Both indices are free running
+             byte counts, producers claim bytes with a compare and swap on
+             enqueue, a record is published by setting the ready bit of its
+             length word.
+*/
+typedef struct
+{
+    uint32_t capacity;                              /*!< Element contains storage size in bytes. */
+    uint32_t enqueue DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains producers index. */
+    uint32_t dequeue DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains consumer index. */
+    uint32_t length;                                /*!< Element contains length of the record held by consumer. */
+} dispatcher_var_t;
+
+/*! \struct  dispatcher_queue_t
+    \brief   Dispatcher event queue.
+*/
+typedef struct
+{
+    dispatcher_queueType_t type; /*!< Element contains queue backend. */
+    uint16_t itemSize;           /*!< Element contains size of an item. */
+    uint16_t itemCount;          /*!< Element contains max number of items. */
+    uint16_t slotSize;           /*!< Element contains distance between two items in storage. */
+    uint8_t *storage;            /*!< Element contains item storage buffer. */
+    uint32_t mask;               /*!< Element contains ring index mask (ring backends), byte offset mask of the variable ring. */
+    dispatcher_waiter_t *pWaiter; /*!< Element contains consumer waiter (ring backends and lanes). */
+    uint32_t laneBit;             /*!< Element contains ready bit set on publish, 0 if not a lane. */
+    union
+    {
+        dispatcher_portQueue_t port; /*!< Element contains port queue. */
+        dispatcher_spsc_t spsc;      /*!< Element contains spsc ring. */
+        dispatcher_mpsc_t mpsc;      /*!< Element contains mpsc ring. */
+        dispatcher_var_t var;        /*!< Element contains variable size ring. */
+    } backend; /*!< Element contains backend specific data. */
+} dispatcher_queue_t;
+
+/*! \fn   dispatcher_portStatus_t dispatcher_WaiterInit(dispatcher_waiter_t *const pWaiter).
+    \brief  Initialize a waiter.
+    \param pWaiter Pointer to waiter.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_OK on success.
+*/
+dispatcher_portStatus_t dispatcher_WaiterInit(dispatcher_waiter_t *const pWaiter);
+
+/*! \fn   void dispatcher_WaiterNotify(dispatcher_waiter_t *const pWaiter).
+    \brief  Wake the consumer if it is sleeping, must be called after
+            publishing an item.
+    \param pWaiter Pointer to waiter.
+*/
+void dispatcher_WaiterNotify(dispatcher_waiter_t *const pWaiter);
+
+/*! \fn   void dispatcher_WaiterNotifyFromIsr(dispatcher_waiter_t *const pWaiter, int *pWoken).
+    \brief  Wake the consumer from ISR if it is sleeping.
+    \param pWaiter Pointer to waiter.
+    \param pWoken set to non zero if a higher priority task was woken.
+*/
+void dispatcher_WaiterNotifyFromIsr(dispatcher_waiter_t *const pWaiter, int *pWoken);
+
+/*! \fn   uint32_t dispatcher_WaiterReady(dispatcher_waiter_t *const pWaiter).
+    \brief  Get the bitmap of lanes that may hold items.
+    \param pWaiter Pointer to waiter.
+    \return uint32_t ready bitmap, bit n for lane n.
+*/
+uint32_t dispatcher_WaiterReady(dispatcher_waiter_t *const pWaiter);
+
+/*! \fn   void dispatcher_WaiterClear(dispatcher_waiter_t *const pWaiter, uint32_t bits).
+    \brief  Clear ready bits of lanes found empty, the consumer must look at
+            the lanes once more afterwards.
+    \param pWaiter Pointer to waiter.
+    \param bits lane bits to clear.
+*/
+void dispatcher_WaiterClear(dispatcher_waiter_t *const pWaiter, uint32_t bits);
+
+/*! \fn   void dispatcher_WaiterMark(dispatcher_waiter_t *const pWaiter, uint32_t bits).
+    \brief  Set ready bits of lanes.
+    \param pWaiter Pointer to waiter.
+    \param bits lane bits to set.
+*/
+void dispatcher_WaiterMark(dispatcher_waiter_t *const pWaiter, uint32_t bits);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_WaiterWait(dispatcher_waiter_t *const pWaiter,
+                                                   dispatcher_portTick_t timeout).
+    \brief  Sleep until a lane is marked ready, returns at once if one
+            already is.
+    \param pWaiter Pointer to waiter.
+    \param timeout max ticks to sleep.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY on timeout.
+*/
+dispatcher_portStatus_t dispatcher_WaiterWait(dispatcher_waiter_t *const pWaiter, dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_WaiterWaitExcept(dispatcher_waiter_t *const pWaiter,
+                                                         uint32_t const *pBusy,
+                                                         dispatcher_portTick_t timeout).
+    \brief  Sleep until a lane not set in *pBusy is marked ready, lanes
+            held by another consumer do not keep it awake. Whoever clears
+            a bit of *pBusy while its lane is ready must notify the waiter.
+    \param pWaiter Pointer to waiter.
+    \param pBusy Pointer to bitmap of lanes to ignore, may be NULL.
+    \param timeout max ticks to sleep.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY on timeout.
+*/
+dispatcher_portStatus_t dispatcher_WaiterWaitExcept(dispatcher_waiter_t *const pWaiter,
+                                                    uint32_t const *pBusy,
+                                                    dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueInit(dispatcher_queue_t *const pQueue,
+                                                  dispatcher_queueType_t type,
+                                                  uint16_t itemSize,
+                                                  uint16_t itemCount,
+                                                  uint8_t *storage,
+                                                  dispatcher_waiter_t *pWaiter).
+    \brief  Initialize a queue.
+    \param pQueue Pointer to queue.
+    \param type queue backend.
+    \param itemSize size of an item in bytes, largest item for variable size ring.
+    \param itemCount max number of items, power of two for spsc / mpsc rings.
+    \param storage Pointer to a buffer of DISPATCHER_QUEUE_STORAGE_SIZE bytes.
+    \param pWaiter Pointer to consumer waiter, required by ring backends.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_OK on success.
+*/
+dispatcher_portStatus_t dispatcher_QueueInit(dispatcher_queue_t *const pQueue,
+                                             dispatcher_queueType_t type,
+                                             uint16_t itemSize,
+                                             uint16_t itemCount,
+                                             uint8_t *storage,
+                                             dispatcher_waiter_t *pWaiter);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSetLane(dispatcher_queue_t *const pQueue,
+                                                     uint8_t lane,
+                                                     dispatcher_waiter_t *pWaiter).
+    \brief  Make an initialized queue lane number lane of a consumer. Every
+            publish then sets the lane ready bit in pWaiter and wakes the
+            consumer, also with the port backend. pWaiter replaces the
+            waiter given to dispatcher_QueueInit.
+    \param pQueue Pointer to queue.
+    \param lane lane number, below 32.
+    \param pWaiter Pointer to consumer waiter shared by all its lanes.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_OK on success.
+*/
+dispatcher_portStatus_t dispatcher_QueueSetLane(dispatcher_queue_t *const pQueue,
+                                                uint8_t lane,
+                                                dispatcher_waiter_t *pWaiter);
+
+/*! \fn   bool dispatcher_QueueIsValid(dispatcher_queue_t const *const pQueue).
+    \brief  Check a queue was initialized.
+    \param pQueue Pointer to queue.
+    \return bool true if queue is initialized.
+*/
+bool dispatcher_QueueIsValid(dispatcher_queue_t const *const pQueue);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSend(dispatcher_queue_t *const pQueue,
+                                                  void const *const pItem,
+                                                  dispatcher_portTick_t timeout).
+    \brief  Copy an item to the back of the queue.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to item.
+    \param timeout max ticks to wait for free space.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL on timeout.
+*/
+dispatcher_portStatus_t dispatcher_QueueSend(dispatcher_queue_t *const pQueue,
+                                             void const *const pItem,
+                                             dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSendSized(dispatcher_queue_t *const pQueue,
+                                                       void const *const pItem,
+                                                       uint16_t size,
+                                                       dispatcher_portTick_t timeout).
+    \brief  Copy the first size bytes of an item to the back of the queue.
+            The variable size ring only stores size bytes, the other ring
+            backends leave the rest of the slot undefined and the port
+            backend only accepts size equal to the item size.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to item.
+    \param size number of bytes, at most the item size.
+    \param timeout max ticks to wait for free space.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL on timeout.
+*/
+dispatcher_portStatus_t dispatcher_QueueSendSized(dispatcher_queue_t *const pQueue,
+                                                  void const *const pItem,
+                                                  uint16_t size,
+                                                  dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSendSizedFromIsr(dispatcher_queue_t *const pQueue,
+                                                              void const *const pItem,
+                                                              uint16_t size,
+                                                              int *pWoken).
+    \brief  Copy the first size bytes of an item from ISR, never blocks.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to item.
+    \param size number of bytes, at most the item size.
+    \param pWoken set to non zero if a higher priority task was woken.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no space.
+*/
+dispatcher_portStatus_t dispatcher_QueueSendSizedFromIsr(dispatcher_queue_t *const pQueue,
+                                                         void const *const pItem,
+                                                         uint16_t size,
+                                                         int *pWoken);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSendFromIsr(dispatcher_queue_t *const pQueue,
+                                                         void const *const pItem,
+                                                         int *pWoken).
+    \brief  Copy an item to the back of the queue from ISR, never blocks.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to item.
+    \param pWoken set to non zero if a higher priority task was woken.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no space.
+*/
+dispatcher_portStatus_t dispatcher_QueueSendFromIsr(dispatcher_queue_t *const pQueue,
+                                                    void const *const pItem,
+                                                    int *pWoken);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSendBatch(dispatcher_queue_t *const pQueue,
+                                                       void const *const pItems,
+                                                       uint16_t count,
+                                                       dispatcher_portTick_t timeout,
+                                                       uint16_t *pSent).
+    \brief  Copy consecutive items to the back of the queue, waits for space
+            for at least one item and then copies as many as fit. The
+            consumer is woken at most once.
+    \param pQueue Pointer to queue.
+    \param pItems Pointer to count items stored back to back.
+    \param count number of items.
+    \param timeout max ticks to wait for free space.
+    \param pSent set to number of items copied.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no item was copied.
+*/
+dispatcher_portStatus_t dispatcher_QueueSendBatch(dispatcher_queue_t *const pQueue,
+                                                  void const *const pItems,
+                                                  uint16_t count,
+                                                  dispatcher_portTick_t timeout,
+                                                  uint16_t *pSent);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueSendBatchFromIsr(dispatcher_queue_t *const pQueue,
+                                                              void const *const pItems,
+                                                              uint16_t count,
+                                                              uint16_t *pSent,
+                                                              int *pWoken).
+    \brief  Copy as many consecutive items as fit from ISR, never blocks.
+    \param pQueue Pointer to queue.
+    \param pItems Pointer to count items stored back to back.
+    \param count number of items.
+    \param pSent set to number of items copied.
+    \param pWoken set to non zero if a higher priority task was woken.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL if no item was copied.
+*/
+dispatcher_portStatus_t dispatcher_QueueSendBatchFromIsr(dispatcher_queue_t *const pQueue,
+                                                         void const *const pItems,
+                                                         uint16_t count,
+                                                         uint16_t *pSent,
+                                                         int *pWoken);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueReceive(dispatcher_queue_t *const pQueue,
+                                                     void *const pItem,
+                                                     dispatcher_portTick_t timeout).
+    \brief  Copy the oldest item out of the queue.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to item buffer.
+    \param timeout max ticks to wait for an item.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY on timeout.
+*/
+dispatcher_portStatus_t dispatcher_QueueReceive(dispatcher_queue_t *const pQueue,
+                                                void *const pItem,
+                                                dispatcher_portTick_t timeout);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueReserve(dispatcher_queue_t *const pQueue,
+                                                     void **ppItem,
+                                                     dispatcher_portTick_t timeout).
+    \brief  Claim the next free slot of a ring backend so the producer can
+            build the item in place. The slot is invisible to the consumer
+            until dispatcher_QueueCommit is called, every reserved slot
+            must be committed.
+    \param pQueue Pointer to queue.
+    \param ppItem set to the reserved slot.
+    \param timeout max ticks to wait for free space.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FULL on timeout,
+            DISPATCHER_PORT_FAIL for DISPATCHER_QUEUE_TYPE_DEFAULT.
+*/
+dispatcher_portStatus_t dispatcher_QueueReserve(dispatcher_queue_t *const pQueue,
+                                                void **ppItem,
+                                                dispatcher_portTick_t timeout);
+
+/*! \fn   void dispatcher_QueueCommit(dispatcher_queue_t *const pQueue, void *const pItem).
+    \brief  Publish a slot returned by dispatcher_QueueReserve and wake the
+            consumer if it sleeps.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to reserved slot.
+*/
+void dispatcher_QueueCommit(dispatcher_queue_t *const pQueue, void *const pItem);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueAcquire(dispatcher_queue_t *const pQueue,
+                                                     void *const pStorage,
+                                                     void **ppItem,
+                                                     dispatcher_portTick_t timeout).
+    \brief  Get the oldest item without copying it. Ring backends return a
+            pointer into the queue storage, the port backend copies into
+            pStorage. The item stays valid until dispatcher_QueueRelease.
+            Only the bytes it was sent with are valid, see
+            dispatcher_QueueSendSized.
+    \param pQueue Pointer to queue.
+    \param pStorage Pointer to item buffer, only used by the port backend.
+    \param ppItem set to the item.
+    \param timeout max ticks to wait for an item.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY on timeout.
+*/
+dispatcher_portStatus_t dispatcher_QueueAcquire(dispatcher_queue_t *const pQueue,
+                                                void *const pStorage,
+                                                void **ppItem,
+                                                dispatcher_portTick_t timeout);
+
+/*! \fn   uint16_t dispatcher_QueueItemLength(dispatcher_queue_t const *const pQueue).
+    \brief  Number of bytes of the item returned by the last
+            dispatcher_QueueAcquire, the item size of fixed slot backends.
+    \param pQueue Pointer to queue.
+    \return uint16_t item length in bytes.
+*/
+uint16_t dispatcher_QueueItemLength(dispatcher_queue_t const *const pQueue);
+
+/*! \fn   uint32_t dispatcher_QueueUsed(dispatcher_queue_t *const pQueue).
+    \brief  Number of items in the queue while the consumer holds the item
+            returned by dispatcher_QueueAcquire, that item included. The
+            variable ring counts used bytes instead.
+    \param pQueue Pointer to queue.
+    \return uint32_t items (bytes for the variable ring).
+    \warning Should only be called by the consumer between
+             dispatcher_QueueAcquire and dispatcher_QueueRelease.
+*/
+uint32_t dispatcher_QueueUsed(dispatcher_queue_t *const pQueue);
+
+/*! \fn   void dispatcher_QueueRelease(dispatcher_queue_t *const pQueue).
+    \brief  Give the slot returned by dispatcher_QueueAcquire back to the
+            producers.
+    \param pQueue Pointer to queue.
+*/
+void dispatcher_QueueRelease(dispatcher_queue_t *const pQueue);
+
+/*! \fn   dispatcher_portStatus_t dispatcher_QueueEvict(dispatcher_queue_t *const pQueue,
+                                                   void *const pItem,
+                                                   uint16_t size,
+                                                   int *pWoken).
+    \brief  Drop the oldest item not held by the consumer from the producer
+            side, copying its first size bytes out. Never blocks, safe from
+            ISR. Only the port queue and mpsc ring backends support it.
+    \param pQueue Pointer to queue.
+    \param pItem Pointer to a buffer of size bytes.
+    \param size number of bytes to copy, at most the item size.
+    \param pWoken set to non zero if a higher priority task was woken, may be NULL.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_EMPTY if no item can be
+            dropped, DISPATCHER_PORT_FAIL if the backend does not support it.
+*/
+dispatcher_portStatus_t dispatcher_QueueEvict(dispatcher_queue_t *const pQueue,
+                                              void *const pItem,
+                                              uint16_t size,
+                                              int *pWoken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_QUEUE_H__
@@ -0,0 +1,89 @@
+/*! \file   dispatcher_record.h
+    \brief  This file cotains the format of event recordings.
+
+    Details.
+    A recording is a dispatcher_recordHeader_t followed by one entry per
+    event the dispatcher handed to its state handlers : a
+    dispatcher_recordEntry_t with the microseconds since the previous entry
+    and the event length, then the event bytes (signal included), in the
+    byte order of the target and without padding. Events posted by
+    reference are stored by value, recalled deferred events are left out
+    as the replayed handlers defer and recall them again.
+*/
+
+#ifndef __DISPATCHER_RECORD_H__
+#define __DISPATCHER_RECORD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    DISPATCHER_RECORD_MAGIC
+    \brief  First word of a recording, "DREC" in memory on little endian targets.
+*/
+#define DISPATCHER_RECORD_MAGIC (0x43455244u)
+
+/*! \def    DISPATCHER_RECORD_VERSION
+    \brief  Version of the recording format.
+*/
+#define DISPATCHER_RECORD_VERSION (1u)
+
+/*! \def    DISPATCHER_RECORD_FLAG_TIME
+    \brief  Entry flag, the event is an expired time event.
+*/
+#define DISPATCHER_RECORD_FLAG_TIME (0x01u)
+
+/*! \struct  dispatcher_recordHeader_t
+    \brief   Header of a recording.
+*/
+typedef struct
+{
+    uint32_t magic;     /*!< Element contains DISPATCHER_RECORD_MAGIC. */
+    uint16_t version;   /*!< Element contains DISPATCHER_RECORD_VERSION. */
+    uint16_t entrySize; /*!< Element contains sizeof(dispatcher_recordEntry_t). */
+} dispatcher_recordHeader_t;
+
+/*! \struct  dispatcher_recordEntry_t
+    \brief   Entry in front of every recorded event.
+*/
+typedef struct
+{
+    uint32_t delta;   /*!< Element contains microseconds since the previous entry (or the start). */
+    uint16_t length;  /*!< Element contains number of event bytes following the entry. */
+    uint8_t flags;    /*!< Element contains DISPATCHER_RECORD_FLAG_xxx bits. */
+    uint8_t reserved; /*!< Element contains 0. */
+} dispatcher_recordEntry_t;
+
+/*! \enum   dispatcher_replay_t
+    \brief  Pace of a replay.
+*/
+typedef enum
+{
+    DISPATCHER_REPLAY_FAST = 0, /*!< Events follow each other at once. */
+    DISPATCHER_REPLAY_TIMED,    /*!< Events keep the recorded gaps. */
+    DISPATCHER_REPLAY_MAX,
+} dispatcher_replay_t;
+
+/*! \typedef    typedef void (*dispatcher_recordWrite_t)(void const *pData, uint32_t size, void *pArg)
+    \brief      Sink of a recording, called with the header and then with
+                every entry and its event bytes. Runs in the event loop
+                context, a slow sink slows the event loop down.
+*/
+typedef void (*dispatcher_recordWrite_t)(void const *pData, uint32_t size, void *pArg);
+
+/*! \typedef    typedef uint32_t (*dispatcher_recordRead_t)(void *pData, uint32_t size, void *pArg)
+    \brief      Source of a replay, returns the number of bytes read, less
+                than size only at the end of the recording.
+*/
+typedef uint32_t (*dispatcher_recordRead_t)(void *pData, uint32_t size, void *pArg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_RECORD_H__
@@ -0,0 +1,164 @@
+/*! \file   dispatcher_trace.h
+    \brief  This file cotains the binary event trace ring of the dispatcher.
+
+    Details.
+    Every trace record is 16 bytes : a dispatcher_PortCycles timestamp, the
+    record type, the signal, the low 32 bits of the dispatcher address and
+    one argument (a state handler address, a status or a size). Writers
+    claim a slot with one atomic add, so tasks, ISRs and other cores write
+    concurrently without a lock. The ring never blocks, once full the oldest
+    records are overwritten.
+    A dump is a dispatcher_traceHeader_t followed by the records, oldest
+    first, in the byte order of the target. tools/dispatcher_trace_decode
+    turns it into a timeline for a trace viewer.
+*/
+
+#ifndef __DISPATCHER_TRACE_H__
+#define __DISPATCHER_TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    DISPATCHER_TRACE_MAGIC
+    \brief  First word of a dump, "DTRC" in memory on little endian targets.
+*/
+#define DISPATCHER_TRACE_MAGIC (0x43525444u)
+
+/*! \def    DISPATCHER_TRACE_VERSION
+    \brief  Version of the dump format.
+*/
+#define DISPATCHER_TRACE_VERSION (1u)
+
+/*! \def    DISPATCHER_TRACE_FLAG_ISR
+    \brief  Record flag, written from an ISR.
+*/
+#define DISPATCHER_TRACE_FLAG_ISR (0x01u)
+
+/*! \enum   dispatcher_traceType_t
+    \brief  Trace record types.
+*/
+typedef enum
+{
+    DISPATCHER_TRACE_POST = 1,      /*!< Event posted, arg is the size. */
+    DISPATCHER_TRACE_DROP,          /*!< Event lost on a full queue, arg is the overflow policy (DISPATCHER_OVERFLOW_MAX when rejected by a signal filter). */
+    DISPATCHER_TRACE_DEQUEUE,       /*!< Event taken by the event loop, arg is the length. */
+    DISPATCHER_TRACE_HANDLER_START, /*!< Active state handler called, arg is the handler. */
+    DISPATCHER_TRACE_HANDLER_END,   /*!< Event done, transition included, arg is the status. */
+    DISPATCHER_TRACE_ENTRY,         /*!< State entered, arg is the state handler. */
+    DISPATCHER_TRACE_EXIT,          /*!< State left, arg is the state handler. */
+    DISPATCHER_TRACE_TRANSITION,    /*!< Transition taken, arg is the target state handler. */
+    DISPATCHER_TRACE_MAX,
+} dispatcher_traceType_t;
+
+/*! \struct  dispatcher_traceRecord_t
+    \brief   One trace record.
+*/
+typedef struct
+{
+    uint32_t timestamp;  /*!< Element contains dispatcher_PortCycles at the record. */
+    uint8_t type;        /*!< Element contains dispatcher_traceType_t value. */
+    uint8_t flags;       /*!< Element contains DISPATCHER_TRACE_FLAG_xxx bits. */
+    uint16_t signal;     /*!< Element contains event signal. */
+    uint32_t dispatcher; /*!< Element contains low 32 bits of the dispatcher address. */
+    uint32_t arg;        /*!< Element contains type specific argument. */
+} dispatcher_traceRecord_t;
+
+/*! \struct  dispatcher_traceHeader_t
+    \brief   Header of a dump.
+*/
+typedef struct
+{
+    uint32_t magic;       /*!< Element contains DISPATCHER_TRACE_MAGIC. */
+    uint16_t version;     /*!< Element contains DISPATCHER_TRACE_VERSION. */
+    uint16_t recordSize;  /*!< Element contains sizeof(dispatcher_traceRecord_t). */
+    uint32_t count;       /*!< Element contains number of records following the header. */
+    uint32_t lost;        /*!< Element contains records overwritten before the dump. */
+    uint32_t cyclesPerUs; /*!< Element contains timestamp ticks per microsecond. */
+} dispatcher_traceHeader_t;
+
+/*! \typedef    typedef void (*dispatcher_traceWrite_t)(void const *pData, uint32_t size, void *pArg)
+    \brief      Sink of a dump, called with the header and then with chunks
+                of records.
+*/
+typedef void (*dispatcher_traceWrite_t)(void const *pData, uint32_t size, void *pArg);
+
+/*! \struct  dispatcher_trace_t
+    \brief   Trace ring, head is alone in its cache line as every writer
+             bumps it.
+*/
+typedef struct
+{
+    dispatcher_traceRecord_t *records; /*!< Element contains record storage. */
+    uint32_t mask;                     /*!< Element contains number of records - 1. */
+    uint32_t enabled;                  /*!< Element contains non zero while records are taken. */
+    uint32_t head DISPATCHER_PORT_CACHE_ALIGNED; /*!< Element contains records written so far. */
+} dispatcher_trace_t;
+
+/*! \fn   dispatcher_portStatus_t dispatcher_TraceRingInit(dispatcher_trace_t *const pTrace,
+                                                          dispatcher_traceRecord_t *const records,
+                                                          uint32_t count).
+    \brief  Initialize an empty, stopped ring.
+    \param pTrace Pointer to ring.
+    \param records record storage.
+    \param count number of records, power of two.
+    \return dispatcher_portStatus_t DISPATCHER_PORT_FAIL for invalid arguments.
+*/
+dispatcher_portStatus_t dispatcher_TraceRingInit(dispatcher_trace_t *const pTrace,
+                                                 dispatcher_traceRecord_t *const records,
+                                                 uint32_t count);
+
+/*! \fn   void dispatcher_TraceRingEnable(dispatcher_trace_t *const pTrace, bool enable).
+    \brief  Start or stop taking records.
+    \param pTrace Pointer to ring.
+    \param enable true to start.
+*/
+void dispatcher_TraceRingEnable(dispatcher_trace_t *const pTrace, bool enable);
+
+/*! \fn   void dispatcher_TraceRingWrite(dispatcher_trace_t *const pTrace,
+                                         uint8_t type,
+                                         uint8_t flags,
+                                         uint16_t signal,
+                                         void const *const pDispatcher,
+                                         uint32_t arg).
+    \brief  Add a record, nothing is done while the ring is stopped. Safe
+            from any context.
+    \param pTrace Pointer to ring.
+    \param type dispatcher_traceType_t value.
+    \param flags DISPATCHER_TRACE_FLAG_xxx bits.
+    \param signal event signal.
+    \param pDispatcher dispatcher the record belongs to.
+    \param arg type specific argument.
+*/
+void dispatcher_TraceRingWrite(dispatcher_trace_t *const pTrace,
+                               uint8_t type,
+                               uint8_t flags,
+                               uint16_t signal,
+                               void const *const pDispatcher,
+                               uint32_t arg);
+
+/*! \fn   uint32_t dispatcher_TraceRingDump(dispatcher_trace_t const *const pTrace,
+                                            dispatcher_traceWrite_t write,
+                                            void *pArg).
+    \brief  Write the header and the records, oldest first.
+    \param pTrace Pointer to ring.
+    \param write sink of the dump.
+    \param pArg argument handed to write.
+    \return uint32_t number of records written.
+    \warning The ring should be stopped, a record written during the dump
+             may be torn.
+*/
+uint32_t dispatcher_TraceRingDump(dispatcher_trace_t const *const pTrace,
+                                  dispatcher_traceWrite_t write,
+                                  void *pArg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_TRACE_H__
@@ -0,0 +1,159 @@
+/*! \file   dispatcher_wheel.h
+    \brief  This file cotains the hierarchical timing wheel used by dispatcher
+            time events.
+
+    Details.
+    A wheel has DISPATCHER_WHEEL_LEVELS levels of DISPATCHER_WHEEL_SLOTS
+    slots, every slot of level n spans DISPATCHER_WHEEL_SLOTS^n ticks. A
+    timer is linked into the slot of the level its remaining time falls in,
+    so arming and disarming are O(1). When the lower level wraps, the timers
+    of the next higher slot move down (cascade). Expired timers are moved
+    to an expired list the owner takes them from.
+    Timers further away than the whole wheel wait in the last slot of the
+    top level and are placed again when it cascades.
+    A wheel is not thread safe, it is only used by one context.
+*/
+
+#ifndef __DISPATCHER_WHEEL_H__
+#define __DISPATCHER_WHEEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <dispatcher_port.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*! \def    DISPATCHER_WHEEL_LEVELS
+    \brief  Number of wheel levels.
+*/
+#if !defined(DISPATCHER_WHEEL_LEVELS)
+#define DISPATCHER_WHEEL_LEVELS (4)
+#endif
+
+/*! \def    DISPATCHER_WHEEL_SLOT_BITS
+    \brief  log2 of the number of slots per level, at most 5 (one bit of the
+            level occupancy bitmap per slot).
+*/
+#if !defined(DISPATCHER_WHEEL_SLOT_BITS)
+#define DISPATCHER_WHEEL_SLOT_BITS (5)
+#endif
+
+/*! \def    DISPATCHER_WHEEL_SLOTS
+    \brief  Number of slots per level.
+*/
+#define DISPATCHER_WHEEL_SLOTS (1u << DISPATCHER_WHEEL_SLOT_BITS)
+
+/*! \def    DISPATCHER_WHEEL_NONE
+    \brief  Slot index of a timer which is not armed.
+*/
+#define DISPATCHER_WHEEL_NONE (0xFFFFu)
+
+/*! \def    DISPATCHER_WHEEL_EXPIRED
+    \brief  Slot index of a timer on the expired list.
+*/
+#define DISPATCHER_WHEEL_EXPIRED (0xFFFEu)
+
+/*! \typedef    typedef dispatcher_tagWheelNode dispatcher_wheelNode_t
+    \brief      A type definition for dispatcher_tagWheelNode.
+*/
+typedef struct dispatcher_tagWheelNode dispatcher_wheelNode_t;
+
+/*! \struct  dispatcher_tagWheelNode
+    \brief   Timer linked into a wheel slot. ppPrev points at the pointer
+             linking it in, so it unlinks without knowing its slot head.
+*/
+struct dispatcher_tagWheelNode
+{
+    dispatcher_wheelNode_t *pNext;   /*!< Element contains next timer of the slot. */
+    dispatcher_wheelNode_t **ppPrev; /*!< Element contains pointer linking this timer in. */
+    dispatcher_portTick_t expiry;    /*!< Element contains tick the timer expires at. */
+    uint16_t slot;                   /*!< Element contains level * DISPATCHER_WHEEL_SLOTS + slot,
+                                          DISPATCHER_WHEEL_EXPIRED or DISPATCHER_WHEEL_NONE. */
+};
+
+/*! \struct  dispatcher_wheel_t
+    \brief   Hierarchical timing wheel.
+*/
+typedef struct
+{
+    dispatcher_wheelNode_t *slots[DISPATCHER_WHEEL_LEVELS][DISPATCHER_WHEEL_SLOTS]; /*!< Element contains slot lists. */
+    uint32_t occupied[DISPATCHER_WHEEL_LEVELS]; /*!< Element contains bitmap of non empty slots of every level. */
+    dispatcher_portTick_t now;                  /*!< Element contains last processed tick. */
+    uint32_t armed;                             /*!< Element contains number of timers in slots. */
+    dispatcher_wheelNode_t *expired;            /*!< Element contains expired timers, oldest first. */
+    dispatcher_wheelNode_t **ppExpiredTail;     /*!< Element contains end of the expired list. */
+} dispatcher_wheel_t;
+
+/*! \fn   void dispatcher_WheelInit(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t now).
+    \brief  Initialize an empty wheel.
+    \param pWheel Pointer to wheel.
+    \param now current tick.
+*/
+void dispatcher_WheelInit(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t now);
+
+/*! \fn   void dispatcher_WheelNodeInit(dispatcher_wheelNode_t *const pNode).
+    \brief  Initialize a timer, not armed.
+    \param pNode Pointer to timer.
+*/
+void dispatcher_WheelNodeInit(dispatcher_wheelNode_t *const pNode);
+
+/*! \fn   void dispatcher_WheelArm(dispatcher_wheel_t *const pWheel,
+                                dispatcher_wheelNode_t *const pNode,
+                                dispatcher_portTick_t ticks).
+    \brief  Arm a timer to expire ticks after the last processed tick, an
+            armed or expired timer is rearmed.
+    \param pWheel Pointer to wheel.
+    \param pNode Pointer to initialized timer.
+    \param ticks ticks from now, 0 counts as 1.
+*/
+void dispatcher_WheelArm(dispatcher_wheel_t *const pWheel,
+                         dispatcher_wheelNode_t *const pNode,
+                         dispatcher_portTick_t ticks);
+
+/*! \fn   bool dispatcher_WheelDisarm(dispatcher_wheel_t *const pWheel, dispatcher_wheelNode_t *const pNode).
+    \brief  Disarm a timer, also takes it off the expired list.
+    \param pWheel Pointer to wheel.
+    \param pNode Pointer to timer.
+    \return bool true if the timer was armed or expired.
+*/
+bool dispatcher_WheelDisarm(dispatcher_wheel_t *const pWheel, dispatcher_wheelNode_t *const pNode);
+
+/*! \fn   bool dispatcher_WheelIsArmed(dispatcher_wheelNode_t const *const pNode).
+    \brief  Check a timer is armed or expired and not yet taken.
+    \param pNode Pointer to timer.
+    \return bool true if armed.
+*/
+bool dispatcher_WheelIsArmed(dispatcher_wheelNode_t const *const pNode);
+
+/*! \fn   void dispatcher_WheelAdvance(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t now).
+    \brief  Process all ticks up to now, expired timers go to the expired
+            list. Only visits slots holding timers and cascade points.
+    \param pWheel Pointer to wheel.
+    \param now current tick.
+*/
+void dispatcher_WheelAdvance(dispatcher_wheel_t *const pWheel, dispatcher_portTick_t now);
+
+/*! \fn   dispatcher_wheelNode_t *dispatcher_WheelTakeExpired(dispatcher_wheel_t *const pWheel).
+    \brief  Take the oldest expired timer, it is no longer armed.
+    \param pWheel Pointer to wheel.
+    \return dispatcher_wheelNode_t* Pointer to timer, NULL if none expired.
+*/
+dispatcher_wheelNode_t *dispatcher_WheelTakeExpired(dispatcher_wheel_t *const pWheel);
+
+/*! \fn   dispatcher_portTick_t dispatcher_WheelTimeout(dispatcher_wheel_t const *const pWheel).
+    \brief  Ticks from the last processed tick until the wheel needs to be
+            advanced again, the next expiry or cascade.
+    \param pWheel Pointer to wheel.
+    \return dispatcher_portTick_t 0 if timers expired, DISPATCHER_PORT_MAX_DELAY
+            if none is armed.
+*/
+dispatcher_portTick_t dispatcher_WheelTimeout(dispatcher_wheel_t const *const pWheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__DISPATCHER_WHEEL_H__
@@ -0,0 +1,258 @@
+#include <dispatcher_port.h>
+#include <freertos/task.h>
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+#include <string.h>
+
+dispatcher_portStatus_t dispatcher_PortQueueCreate(dispatcher_portQueue_t *const pQueue,
+                                                   uint16_t itemSize,
+                                                   uint16_t itemCount,
+                                                   uint8_t *storage)
+{
+    pQueue->handle = xQueueCreateStatic(itemCount,
+                                        itemSize,
+                                        storage,
+                                        &pQueue->storage);
+    pQueue->itemSize = itemSize;
+    return (pQueue->handle != NULL) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_FAIL;
+}
+
+bool dispatcher_PortQueueIsValid(dispatcher_portQueue_t const *const pQueue)
+{
+    return pQueue->handle != NULL;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSend(dispatcher_portQueue_t *const pQueue,
+                                                 void const *const pItem,
+                                                 dispatcher_portTick_t timeout)
+{
+    BaseType_t state = xQueueSend(pQueue->handle, pItem, (TickType_t)timeout);
+
+    if (state == pdTRUE)
+    {
+        return DISPATCHER_PORT_OK;
+    }
+    return (state == errQUEUE_FULL) ? DISPATCHER_PORT_FULL : DISPATCHER_PORT_FAIL;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSendFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                        void const *const pItem,
+                                                        int *pWoken)
+{
+    BaseType_t woken = pdFALSE;
+    BaseType_t state = xQueueSendFromISR(pQueue->handle, pItem, &woken);
+
+    if (pWoken != NULL)
+    {
+        *pWoken = (int)woken;
+    }
+
+    if (state == pdTRUE)
+    {
+        return DISPATCHER_PORT_OK;
+    }
+    return (state == errQUEUE_FULL) ? DISPATCHER_PORT_FULL : DISPATCHER_PORT_FAIL;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSendBatch(dispatcher_portQueue_t *const pQueue,
+                                                      void const *const pItems,
+                                                      uint16_t count,
+                                                      dispatcher_portTick_t timeout,
+                                                      uint16_t *pSent)
+{
+    uint8_t const *pItem = pItems;
+    uint16_t itemSize = pQueue->itemSize;
+    uint16_t sent = 0;
+
+    *pSent = 0;
+    if (count == 0)
+    {
+        return DISPATCHER_PORT_OK;
+    }
+
+    /* only the first item may block, the scheduler can not be suspended while waiting. */
+    if (uxQueueSpacesAvailable(pQueue->handle) == 0)
+    {
+        if (xQueueSend(pQueue->handle, pItem, (TickType_t)timeout) != pdTRUE)
+        {
+            return DISPATCHER_PORT_FULL;
+        }
+        pItem += itemSize;
+        sent++;
+    }
+
+    /* a woken consumer only runs once the whole batch is queued. */
+    vTaskSuspendAll();
+    while (sent < count && xQueueSend(pQueue->handle, pItem, 0) == pdTRUE)
+    {
+        pItem += itemSize;
+        sent++;
+    }
+    (void)xTaskResumeAll();
+
+    *pSent = sent;
+    return (sent != 0) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_FULL;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSendBatchFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                             void const *const pItems,
+                                                             uint16_t count,
+                                                             uint16_t *pSent,
+                                                             int *pWoken)
+{
+    uint8_t const *pItem = pItems;
+    uint16_t itemSize = pQueue->itemSize;
+    BaseType_t woken = pdFALSE;
+    uint16_t sent = 0;
+
+    while (sent < count && xQueueSendFromISR(pQueue->handle, pItem, &woken) == pdTRUE)
+    {
+        pItem += itemSize;
+        sent++;
+    }
+
+    if (pWoken != NULL)
+    {
+        *pWoken = (int)woken;
+    }
+    *pSent = sent;
+    return (sent != 0 || count == 0) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_FULL;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueReceive(dispatcher_portQueue_t *const pQueue,
+                                                    void *const pItem,
+                                                    dispatcher_portTick_t timeout)
+{
+    if (xQueueReceive(pQueue->handle, pItem, (TickType_t)timeout) != pdTRUE)
+    {
+        return DISPATCHER_PORT_EMPTY;
+    }
+    return DISPATCHER_PORT_OK;
+}
+
+/*
+ *  A free-rtos queue only hands out whole items, the item is received to a
+ *  fixed buffer on the stack (bounded, this runs in ISRs too) and the prefix
+ *  copied.
+ */
+dispatcher_portStatus_t dispatcher_PortQueueEvict(dispatcher_portQueue_t *const pQueue,
+                                                  void *const pItem,
+                                                  uint16_t size,
+                                                  int *pWoken)
+{
+    uint8_t item[DISPATCHER_PORT_EVICT_ITEM_MAX] __attribute__((aligned(sizeof(void *))));
+    BaseType_t woken = pdFALSE;
+
+    if (pWoken != NULL)
+    {
+        *pWoken = 0;
+    }
+
+    if (pQueue->itemSize > sizeof(item))
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+
+    BaseType_t state = xPortInIsrContext() ? xQueueReceiveFromISR(pQueue->handle, item, &woken)
+                                           : xQueueReceive(pQueue->handle, item, 0);
+
+    if (pWoken != NULL)
+    {
+        *pWoken = (int)woken;
+    }
+
+    if (state != pdTRUE)
+    {
+        return DISPATCHER_PORT_EMPTY;
+    }
+    (void)memcpy(pItem, item, size);
+    return DISPATCHER_PORT_OK;
+}
+
+uint32_t dispatcher_PortQueueCount(dispatcher_portQueue_t *const pQueue)
+{
+    return (uint32_t)uxQueueMessagesWaiting(pQueue->handle);
+}
+
+dispatcher_portTick_t dispatcher_PortGetTick(void)
+{
+    if (xPortInIsrContext())
+    {
+        return (dispatcher_portTick_t)xTaskGetTickCountFromISR();
+    }
+    return (dispatcher_portTick_t)xTaskGetTickCount();
+}
+
+uint32_t dispatcher_PortCycles(void)
+{
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+uint32_t dispatcher_PortCyclesPerUs(void)
+{
+    return esp_rom_get_cpu_ticks_per_us();
+}
+
+uint64_t dispatcher_PortTimeUs(void)
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+void dispatcher_PortSleepUs(uint32_t us)
+{
+    uint32_t tickUs = portTICK_PERIOD_MS * 1000u;
+
+    if (us >= tickUs)
+    {
+        vTaskDelay((TickType_t)(us / tickUs));
+    }
+    esp_rom_delay_us(us % tickUs);
+}
+
+void dispatcher_PortYieldFromIsr(int woken)
+{
+    if (woken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+dispatcher_portStatus_t dispatcher_PortSignalCreate(dispatcher_portSignal_t *const pSignal)
+{
+    pSignal->handle = xSemaphoreCreateBinaryStatic(&pSignal->storage);
+    return (pSignal->handle != NULL) ? DISPATCHER_PORT_OK : DISPATCHER_PORT_FAIL;
+}
+
+dispatcher_portStatus_t dispatcher_PortSignalWait(dispatcher_portSignal_t *const pSignal,
+                                                  dispatcher_portTick_t timeout)
+{
+    if (xSemaphoreTake(pSignal->handle, (TickType_t)timeout) != pdTRUE)
+    {
+        return DISPATCHER_PORT_EMPTY;
+    }
+    return DISPATCHER_PORT_OK;
+}
+
+void dispatcher_PortSignalNotify(dispatcher_portSignal_t *const pSignal)
+{
+    (void)xSemaphoreGive(pSignal->handle);
+}
+
+void dispatcher_PortSignalNotifyFromIsr(dispatcher_portSignal_t *const pSignal, int *pWoken)
+{
+    BaseType_t woken = pdFALSE;
+
+    (void)xSemaphoreGiveFromISR(pSignal->handle, &woken);
+    if (pWoken != NULL)
+    {
+        *pWoken |= (int)woken;
+    }
+}
+
+void dispatcher_PortBackoff(uint32_t attempt)
+{
+    /* a plain yield never reaches a lower priority consumer, always sleep. */
+    (void)attempt;
+    vTaskDelay(1);
+}
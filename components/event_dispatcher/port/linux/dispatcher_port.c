@@ -0,0 +1,402 @@
+#include <dispatcher_port.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*
+ *  Converts a relative timeout in ticks (1 tick = 1 ms) to an absolute
+ *  CLOCK_MONOTONIC deadline as expected by pthread_cond_timedwait.
+ */
+static void PortDeadline(struct timespec *pDeadline, dispatcher_portTick_t timeout)
+{
+    (void)clock_gettime(CLOCK_MONOTONIC, pDeadline);
+    pDeadline->tv_sec += (time_t)(timeout / 1000u);
+    pDeadline->tv_nsec += (long)(timeout % 1000u) * 1000000L;
+    if (pDeadline->tv_nsec >= 1000000000L)
+    {
+        pDeadline->tv_sec += 1;
+        pDeadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/*
+ *  Waits on a condition with the queue lock held, returns false on timeout.
+ */
+static bool PortWait(pthread_cond_t *pCond,
+                     pthread_mutex_t *pLock,
+                     struct timespec const *pDeadline,
+                     dispatcher_portTick_t timeout)
+{
+    if (timeout == 0)
+    {
+        return false;
+    }
+
+    if (timeout == DISPATCHER_PORT_MAX_DELAY)
+    {
+        return pthread_cond_wait(pCond, pLock) == 0;
+    }
+
+    return pthread_cond_timedwait(pCond, pLock, pDeadline) != ETIMEDOUT;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueCreate(dispatcher_portQueue_t *const pQueue,
+                                                   uint16_t itemSize,
+                                                   uint16_t itemCount,
+                                                   uint8_t *storage)
+{
+    pthread_condattr_t attr;
+
+    if (pthread_condattr_init(&attr) != 0)
+    {
+        return DISPATCHER_PORT_FAIL;
+    }
+    (void)pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    if (pthread_mutex_init(&pQueue->lock, NULL) != 0 ||
+        pthread_cond_init(&pQueue->notEmpty, &attr) != 0 ||
+        pthread_cond_init(&pQueue->notFull, &attr) != 0)
+    {
+        (void)pthread_condattr_destroy(&attr);
+        return DISPATCHER_PORT_FAIL;
+    }
+    (void)pthread_condattr_destroy(&attr);
+
+    pQueue->itemSize = itemSize;
+    pQueue->itemCount = itemCount;
+    pQueue->head = 0;
+    pQueue->count = 0;
+    pQueue->storage = storage;
+    return DISPATCHER_PORT_OK;
+}
+
+bool dispatcher_PortQueueIsValid(dispatcher_portQueue_t const *const pQueue)
+{
+    return pQueue->storage != NULL;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSend(dispatcher_portQueue_t *const pQueue,
+                                                 void const *const pItem,
+                                                 dispatcher_portTick_t timeout)
+{
+    struct timespec deadline;
+
+    if (timeout != 0 && timeout != DISPATCHER_PORT_MAX_DELAY)
+    {
+        PortDeadline(&deadline, timeout);
+    }
+
+    (void)pthread_mutex_lock(&pQueue->lock);
+    while (pQueue->count == pQueue->itemCount)
+    {
+        if (!PortWait(&pQueue->notFull, &pQueue->lock, &deadline, timeout) &&
+            pQueue->count == pQueue->itemCount)
+        {
+            (void)pthread_mutex_unlock(&pQueue->lock);
+            return DISPATCHER_PORT_FULL;
+        }
+    }
+
+    uint32_t tail = ((uint32_t)pQueue->head + pQueue->count) % pQueue->itemCount;
+    (void)memcpy(&pQueue->storage[tail * pQueue->itemSize], pItem, pQueue->itemSize);
+    __atomic_store_n(&pQueue->count, (uint16_t)(pQueue->count + 1u), __ATOMIC_RELAXED);
+    (void)pthread_cond_signal(&pQueue->notEmpty);
+    (void)pthread_mutex_unlock(&pQueue->lock);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSendFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                        void const *const pItem,
+                                                        int *pWoken)
+{
+    /* there is no interrupt context on host, behave as a non blocking send. */
+    if (pWoken != NULL)
+    {
+        *pWoken = 0;
+    }
+    return dispatcher_PortQueueSend(pQueue, pItem, 0);
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSendBatch(dispatcher_portQueue_t *const pQueue,
+                                                      void const *const pItems,
+                                                      uint16_t count,
+                                                      dispatcher_portTick_t timeout,
+                                                      uint16_t *pSent)
+{
+    struct timespec deadline;
+    uint8_t const *pItem = pItems;
+    uint16_t sent = 0;
+
+    *pSent = 0;
+    if (count == 0)
+    {
+        return DISPATCHER_PORT_OK;
+    }
+
+    if (timeout != 0 && timeout != DISPATCHER_PORT_MAX_DELAY)
+    {
+        PortDeadline(&deadline, timeout);
+    }
+
+    (void)pthread_mutex_lock(&pQueue->lock);
+    while (pQueue->count == pQueue->itemCount)
+    {
+        if (!PortWait(&pQueue->notFull, &pQueue->lock, &deadline, timeout) &&
+            pQueue->count == pQueue->itemCount)
+        {
+            (void)pthread_mutex_unlock(&pQueue->lock);
+            return DISPATCHER_PORT_FULL;
+        }
+    }
+
+    while (sent < count && pQueue->count < pQueue->itemCount)
+    {
+        uint32_t tail = ((uint32_t)pQueue->head + pQueue->count) % pQueue->itemCount;
+
+        (void)memcpy(&pQueue->storage[tail * pQueue->itemSize], pItem, pQueue->itemSize);
+        pItem += pQueue->itemSize;
+        __atomic_store_n(&pQueue->count, (uint16_t)(pQueue->count + 1u), __ATOMIC_RELAXED);
+        sent++;
+    }
+    (void)pthread_cond_signal(&pQueue->notEmpty);
+    (void)pthread_mutex_unlock(&pQueue->lock);
+
+    *pSent = sent;
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueSendBatchFromIsr(dispatcher_portQueue_t *const pQueue,
+                                                             void const *const pItems,
+                                                             uint16_t count,
+                                                             uint16_t *pSent,
+                                                             int *pWoken)
+{
+    if (pWoken != NULL)
+    {
+        *pWoken = 0;
+    }
+    return dispatcher_PortQueueSendBatch(pQueue, pItems, count, 0, pSent);
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueReceive(dispatcher_portQueue_t *const pQueue,
+                                                    void *const pItem,
+                                                    dispatcher_portTick_t timeout)
+{
+    struct timespec deadline;
+
+    if (timeout != 0 && timeout != DISPATCHER_PORT_MAX_DELAY)
+    {
+        PortDeadline(&deadline, timeout);
+    }
+
+    (void)pthread_mutex_lock(&pQueue->lock);
+    while (pQueue->count == 0)
+    {
+        if (!PortWait(&pQueue->notEmpty, &pQueue->lock, &deadline, timeout) &&
+            pQueue->count == 0)
+        {
+            (void)pthread_mutex_unlock(&pQueue->lock);
+            return DISPATCHER_PORT_EMPTY;
+        }
+    }
+
+    (void)memcpy(pItem, &pQueue->storage[(uint32_t)pQueue->head * pQueue->itemSize], pQueue->itemSize);
+    pQueue->head = (uint16_t)((pQueue->head + 1u) % pQueue->itemCount);
+    __atomic_store_n(&pQueue->count, (uint16_t)(pQueue->count - 1u), __ATOMIC_RELAXED);
+    (void)pthread_cond_signal(&pQueue->notFull);
+    (void)pthread_mutex_unlock(&pQueue->lock);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_PortQueueEvict(dispatcher_portQueue_t *const pQueue,
+                                                  void *const pItem,
+                                                  uint16_t size,
+                                                  int *pWoken)
+{
+    if (pWoken != NULL)
+    {
+        *pWoken = 0;
+    }
+
+    (void)pthread_mutex_lock(&pQueue->lock);
+    if (pQueue->count == 0)
+    {
+        (void)pthread_mutex_unlock(&pQueue->lock);
+        return DISPATCHER_PORT_EMPTY;
+    }
+
+    (void)memcpy(pItem, &pQueue->storage[(uint32_t)pQueue->head * pQueue->itemSize], size);
+    pQueue->head = (uint16_t)((pQueue->head + 1u) % pQueue->itemCount);
+    __atomic_store_n(&pQueue->count, (uint16_t)(pQueue->count - 1u), __ATOMIC_RELAXED);
+    (void)pthread_cond_signal(&pQueue->notFull);
+    (void)pthread_mutex_unlock(&pQueue->lock);
+    return DISPATCHER_PORT_OK;
+}
+
+/*
+ *  count is only changed under the lock, with atomic stores so it can be
+ *  read without it.
+ */
+uint32_t dispatcher_PortQueueCount(dispatcher_portQueue_t *const pQueue)
+{
+    return __atomic_load_n(&pQueue->count, __ATOMIC_RELAXED);
+}
+
+dispatcher_portTick_t dispatcher_PortGetTick(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (dispatcher_portTick_t)((uint64_t)now.tv_sec * 1000u + (uint64_t)now.tv_nsec / 1000000u);
+}
+
+uint32_t dispatcher_PortCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+#endif
+}
+
+/*
+ *  The time stamp counter rate is measured once against the monotonic
+ *  clock over a few milliseconds.
+ */
+uint32_t dispatcher_PortCyclesPerUs(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static uint32_t gCyclesPerUs = 0;
+    uint32_t rate = __atomic_load_n(&gCyclesPerUs, __ATOMIC_RELAXED);
+
+    if (rate == 0)
+    {
+        struct timespec start, now;
+        uint64_t elapsed = 0;
+        uint64_t cycles = __builtin_ia32_rdtsc();
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        while (elapsed < 5000000u)
+        {
+            (void)clock_gettime(CLOCK_MONOTONIC, &now);
+            elapsed = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000000u + (uint64_t)now.tv_nsec -
+                      (uint64_t)start.tv_nsec;
+        }
+        cycles = __builtin_ia32_rdtsc() - cycles;
+        rate = (uint32_t)((cycles * 1000u + elapsed / 2u) / elapsed);
+        rate = (rate != 0) ? rate : 1u;
+        __atomic_store_n(&gCyclesPerUs, rate, __ATOMIC_RELAXED);
+    }
+    return rate;
+#else
+    return 1000u;
+#endif
+}
+
+uint64_t dispatcher_PortTimeUs(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+void dispatcher_PortSleepUs(uint32_t us)
+{
+    struct timespec remaining = {.tv_sec = us / 1000000u, .tv_nsec = (long)(us % 1000000u) * 1000};
+
+    while (nanosleep(&remaining, &remaining) != 0 && errno == EINTR)
+    {
+    }
+}
+
+void dispatcher_PortYieldFromIsr(int woken)
+{
+    (void)woken;
+}
+
+dispatcher_portStatus_t dispatcher_PortSignalCreate(dispatcher_portSignal_t *const pSignal)
+{
+    __atomic_store_n(&pSignal->word, 0u, __ATOMIC_RELAXED);
+    return DISPATCHER_PORT_OK;
+}
+
+dispatcher_portStatus_t dispatcher_PortSignalWait(dispatcher_portSignal_t *const pSignal,
+                                                  dispatcher_portTick_t timeout)
+{
+    struct timespec deadline;
+    struct timespec remaining;
+
+    if (timeout != 0 && timeout != DISPATCHER_PORT_MAX_DELAY)
+    {
+        PortDeadline(&deadline, timeout);
+    }
+
+    while (__atomic_exchange_n(&pSignal->word, 0u, __ATOMIC_ACQUIRE) == 0u)
+    {
+        struct timespec *pRemaining = NULL;
+
+        if (timeout == 0)
+        {
+            return DISPATCHER_PORT_EMPTY;
+        }
+
+        if (timeout != DISPATCHER_PORT_MAX_DELAY)
+        {
+            struct timespec now;
+
+            (void)clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (remaining.tv_nsec < 0)
+            {
+                remaining.tv_sec -= 1;
+                remaining.tv_nsec += 1000000000L;
+            }
+            if (remaining.tv_sec < 0)
+            {
+                return DISPATCHER_PORT_EMPTY;
+            }
+            pRemaining = &remaining;
+        }
+
+        /* sleeps only while the word is still 0, EAGAIN / EINTR simply retry. */
+        (void)syscall(SYS_futex, &pSignal->word, FUTEX_WAIT_PRIVATE, 0u, pRemaining, NULL, 0);
+    }
+    return DISPATCHER_PORT_OK;
+}
+
+void dispatcher_PortSignalNotify(dispatcher_portSignal_t *const pSignal)
+{
+    if (__atomic_exchange_n(&pSignal->word, 1u, __ATOMIC_RELEASE) == 0u)
+    {
+        (void)syscall(SYS_futex, &pSignal->word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+void dispatcher_PortSignalNotifyFromIsr(dispatcher_portSignal_t *const pSignal, int *pWoken)
+{
+    dispatcher_PortSignalNotify(pSignal);
+    (void)pWoken;
+}
+
+void dispatcher_PortBackoff(uint32_t attempt)
+{
+    if (attempt < 64u)
+    {
+        (void)sched_yield();
+    }
+    else
+    {
+        struct timespec pause = {.tv_sec = 0, .tv_nsec = 50000L};
+
+        (void)nanosleep(&pause, NULL);
+    }
+}
@@ -0,0 +1,336 @@
+/*
+ *  Host decoder of dispatcher trace dumps (dispatcher_TraceDump) : reads
+ *  the binary dump and writes a Chrome trace event JSON file, which loads
+ *  in https://ui.perfetto.dev or chrome://tracing.
+ *
+ *  Every dispatcher of the dump is one process of the timeline with two
+ *  rows : the event loop (handler calls as slices, dequeue, ENTRY / EXIT and
+ *  transition as instants) and the posts made to it (post and drop
+ *  instants, ISR posts flagged).
+ *
+ *  Timestamps are 32 bit counter values, they are unwrapped under the
+ *  assumption that consecutive records are less than half a counter period
+ *  apart (about 8 s for a 240 MHz esp32 cycle counter).
+ *
+ *  State handlers are shown by address unless a symbol file maps them to
+ *  names, `nm firmware.elf` output works as is for esp-idf images.
+ */
+
+#include <dispatcher_trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#define DECODE_ROW_LOOP (1)
+#define DECODE_ROW_POSTS (2)
+
+typedef struct
+{
+    uint32_t address;
+    char name[64];
+} decodeSymbol_t;
+
+typedef struct
+{
+    uint32_t dispatcher;
+    uint32_t depth; /* open handler slices of the event loop row. */
+} decodeDispatcher_t;
+
+static decodeSymbol_t *gSymbols = NULL;
+static uint32_t gSymbolCount = 0;
+
+static char const *const gTypeNames[DISPATCHER_TRACE_MAX] = {
+    [DISPATCHER_TRACE_POST] = "post",
+    [DISPATCHER_TRACE_DROP] = "drop",
+    [DISPATCHER_TRACE_DEQUEUE] = "dequeue",
+    [DISPATCHER_TRACE_HANDLER_START] = "handler",
+    [DISPATCHER_TRACE_HANDLER_END] = "handler",
+    [DISPATCHER_TRACE_ENTRY] = "entry",
+    [DISPATCHER_TRACE_EXIT] = "exit",
+    [DISPATCHER_TRACE_TRANSITION] = "transition",
+};
+
+static char const *const gStatusNames[] = {"none", "handled", "ignored", "transition", "deferred", "super"};
+
+static char const *const gPolicyNames[] = {"block", "fail", "drop_newest", "drop_oldest", "overwrite", "filter"};
+
+/*
+ *  Symbol lines are "<hex address> <type> <name>", other lines are
+ *  skipped.
+ */
+static int DecodeSymbols(char const *pPath)
+{
+    FILE *pFile = fopen(pPath, "r");
+    char line[256];
+    uint32_t capacity = 0;
+
+    if (pFile == NULL)
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), pFile) != NULL)
+    {
+        unsigned long long address;
+        char type;
+        char name[64];
+
+        if (sscanf(line, "%llx %c %63s", &address, &type, name) != 3)
+        {
+            continue;
+        }
+        if (gSymbolCount == capacity)
+        {
+            capacity = (capacity == 0) ? 256u : capacity * 2u;
+            gSymbols = realloc(gSymbols, capacity * sizeof(decodeSymbol_t));
+            if (gSymbols == NULL)
+            {
+                fclose(pFile);
+                return -1;
+            }
+        }
+        gSymbols[gSymbolCount].address = (uint32_t)address;
+        (void)snprintf(gSymbols[gSymbolCount].name, sizeof(gSymbols[0].name), "%s", name);
+        gSymbolCount++;
+    }
+    fclose(pFile);
+    return 0;
+}
+
+static char const *DecodeState(uint32_t address, char *pBuffer, size_t size)
+{
+    for (uint32_t i = 0; i < gSymbolCount; i++)
+    {
+        if (gSymbols[i].address == address)
+        {
+            return gSymbols[i].name;
+        }
+    }
+    (void)snprintf(pBuffer, size, "0x%08x", address);
+    return pBuffer;
+}
+
+static char const *DecodeSignal(uint16_t signal, char *pBuffer, size_t size)
+{
+    static char const *const reserved[] = {"NONE", "ENTRY", "EXIT"};
+
+    if (signal < sizeof(reserved) / sizeof(reserved[0]))
+    {
+        return reserved[signal];
+    }
+    (void)snprintf(pBuffer, size, "%u", signal);
+    return pBuffer;
+}
+
+static decodeDispatcher_t *DecodeDispatcher(decodeDispatcher_t **ppDispatchers,
+                                            uint32_t *pCount,
+                                            uint32_t dispatcher,
+                                            FILE *pOut)
+{
+    for (uint32_t i = 0; i < *pCount; i++)
+    {
+        if ((*ppDispatchers)[i].dispatcher == dispatcher)
+        {
+            return &(*ppDispatchers)[i];
+        }
+    }
+
+    decodeDispatcher_t *pGrown = realloc(*ppDispatchers, (*pCount + 1u) * sizeof(decodeDispatcher_t));
+
+    if (pGrown == NULL)
+    {
+        return NULL;
+    }
+    *ppDispatchers = pGrown;
+    pGrown[*pCount] = (decodeDispatcher_t){.dispatcher = dispatcher};
+
+    fprintf(pOut,
+            "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":\"dispatcher 0x%08x\"}},\n"
+            "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%d,\"args\":{\"name\":\"event loop\"}},\n"
+            "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%d,\"args\":{\"name\":\"posts\"}},\n",
+            dispatcher, dispatcher, dispatcher, DECODE_ROW_LOOP, dispatcher, DECODE_ROW_POSTS);
+    return &pGrown[(*pCount)++];
+}
+
+static int DecodeRecords(dispatcher_traceHeader_t const *pHeader,
+                         dispatcher_traceRecord_t const *pRecords,
+                         FILE *pOut)
+{
+    decodeDispatcher_t *pDispatchers = NULL;
+    uint32_t dispatcherCount = 0;
+    uint32_t previous = (pHeader->count != 0) ? pRecords[0].timestamp : 0u;
+    int64_t cycles = 0;
+    uint32_t skipped = 0;
+
+    fprintf(pOut, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"records\":%u,\"lost\":%u,\"cycles_per_us\":%u},\n"
+                  "\"traceEvents\":[\n",
+            pHeader->count, pHeader->lost, pHeader->cyclesPerUs);
+
+    for (uint32_t i = 0; i < pHeader->count; i++)
+    {
+        dispatcher_traceRecord_t const *pRecord = &pRecords[i];
+        decodeDispatcher_t *pDispatcher;
+        char signalBuffer[16], stateBuffer[16];
+
+        // racing writers may leave records a little out of order, the delta is signed
+        cycles += (int32_t)(pRecord->timestamp - previous);
+        previous = pRecord->timestamp;
+
+        if (pRecord->type == 0 || pRecord->type >= DISPATCHER_TRACE_MAX)
+        {
+            skipped++;
+            continue;
+        }
+        pDispatcher = DecodeDispatcher(&pDispatchers, &dispatcherCount, pRecord->dispatcher, pOut);
+        if (pDispatcher == NULL)
+        {
+            free(pDispatchers);
+            return -1;
+        }
+
+        double us = (double)cycles / (double)pHeader->cyclesPerUs;
+        char const *pSignal = DecodeSignal(pRecord->signal, signalBuffer, sizeof(signalBuffer));
+
+        fprintf(pOut, "{\"pid\":%u,\"ts\":%.3f,", pRecord->dispatcher, us);
+        switch (pRecord->type)
+        {
+        case DISPATCHER_TRACE_POST:
+            fprintf(pOut, "\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"post %s\",\"args\":{\"size\":%u,\"isr\":%s}",
+                    DECODE_ROW_POSTS, pSignal, pRecord->arg,
+                    (pRecord->flags & DISPATCHER_TRACE_FLAG_ISR) ? "true" : "false");
+            break;
+        case DISPATCHER_TRACE_DROP:
+            fprintf(pOut, "\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"drop %s\",\"args\":{\"policy\":\"%s\",\"isr\":%s}",
+                    DECODE_ROW_POSTS, pSignal,
+                    (pRecord->arg < sizeof(gPolicyNames) / sizeof(gPolicyNames[0])) ? gPolicyNames[pRecord->arg]
+                                                                                    : "unknown",
+                    (pRecord->flags & DISPATCHER_TRACE_FLAG_ISR) ? "true" : "false");
+            break;
+        case DISPATCHER_TRACE_DEQUEUE:
+            fprintf(pOut, "\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"dequeue %s\",\"args\":{\"length\":%u}",
+                    DECODE_ROW_LOOP, pSignal, pRecord->arg);
+            break;
+        case DISPATCHER_TRACE_HANDLER_START:
+            pDispatcher->depth++;
+            fprintf(pOut, "\"tid\":%d,\"ph\":\"B\",\"name\":\"signal %s\",\"args\":{\"state\":\"%s\"}",
+                    DECODE_ROW_LOOP, pSignal, DecodeState(pRecord->arg, stateBuffer, sizeof(stateBuffer)));
+            break;
+        case DISPATCHER_TRACE_HANDLER_END:
+            // the end of a handler started before the oldest record has no slice
+            if (pDispatcher->depth == 0)
+            {
+                fprintf(pOut, "\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"handler end %s\"",
+                        DECODE_ROW_LOOP, pSignal);
+                break;
+            }
+            pDispatcher->depth--;
+            fprintf(pOut, "\"tid\":%d,\"ph\":\"E\",\"args\":{\"status\":\"%s\"}", DECODE_ROW_LOOP,
+                    (pRecord->arg < sizeof(gStatusNames) / sizeof(gStatusNames[0])) ? gStatusNames[pRecord->arg]
+                                                                                    : "unknown");
+            break;
+        default:
+            fprintf(pOut, "\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s %s\"", DECODE_ROW_LOOP,
+                    gTypeNames[pRecord->type], DecodeState(pRecord->arg, stateBuffer, sizeof(stateBuffer)));
+            break;
+        }
+        fprintf(pOut, "},\n");
+    }
+
+    // closing metadata record, the JSON array has no trailing comma
+    fprintf(pOut, "{\"ph\":\"M\",\"name\":\"trace_end\",\"pid\":0,\"args\":{\"skipped\":%u}}\n]}\n", skipped);
+    fprintf(stderr, "%u records, %u dispatchers, %u lost before the dump, %u skipped, %.3f ms\n",
+            pHeader->count, dispatcherCount, pHeader->lost, skipped,
+            (double)cycles / (double)pHeader->cyclesPerUs / 1000.0);
+    free(pDispatchers);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    char const *pOutPath = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:o:h")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            if (DecodeSymbols(optarg) != 0)
+            {
+                return 1;
+            }
+            break;
+        case 'o':
+            pOutPath = optarg;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [options] dump.bin\n"
+                    "  -s file    symbols, \"<hex address> <type> <name>\" lines (nm output)\n"
+                    "  -o file    output file (default stdout)\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-s symbols] [-o out.json] dump.bin\n", argv[0]);
+        return 1;
+    }
+
+    FILE *pIn = fopen(argv[optind], "rb");
+    dispatcher_traceHeader_t header;
+
+    if (pIn == NULL)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, pIn) != 1 || header.magic != DISPATCHER_TRACE_MAGIC)
+    {
+        fprintf(stderr, "%s: not a dispatcher trace dump (or written by a big endian target)\n", argv[optind]);
+        fclose(pIn);
+        return 1;
+    }
+    if (header.version != DISPATCHER_TRACE_VERSION || header.recordSize != sizeof(dispatcher_traceRecord_t) ||
+        header.cyclesPerUs == 0)
+    {
+        fprintf(stderr, "%s: unsupported dump version %u, record size %u\n", argv[optind], header.version,
+                header.recordSize);
+        fclose(pIn);
+        return 1;
+    }
+
+    dispatcher_traceRecord_t *pRecords = malloc((size_t)header.count * sizeof(dispatcher_traceRecord_t) + 1u);
+
+    if (pRecords == NULL || fread(pRecords, sizeof(dispatcher_traceRecord_t), header.count, pIn) != header.count)
+    {
+        fprintf(stderr, "%s: truncated dump\n", argv[optind]);
+        free(pRecords);
+        fclose(pIn);
+        return 1;
+    }
+    fclose(pIn);
+
+    FILE *pOut = (pOutPath != NULL) ? fopen(pOutPath, "w") : stdout;
+    int ret = -1;
+
+    if (pOut == NULL)
+    {
+        perror(pOutPath);
+    }
+    else
+    {
+        ret = DecodeRecords(&header, pRecords, pOut);
+        if (pOut != stdout)
+        {
+            fclose(pOut);
+        }
+    }
+    free(pRecords);
+    free(gSymbols);
+    return (ret == 0) ? 0 : 1;
+}